@@ -0,0 +1,309 @@
+#include <sstream>
+#include "asm_buffer.h"
+
+using namespace std;
+
+// ==========================================
+// Constructores de operandos
+// ==========================================
+
+Operando opReg(int r, int bits) {
+    Operando o;
+    o.tipo = Operando::REG;
+    o.reg = r;
+    o.bits = bits;
+    return o;
+}
+
+Operando opImm(long v) {
+    Operando o;
+    o.tipo = Operando::IMM;
+    o.imm = v;
+    return o;
+}
+
+Operando opMem(int base, long disp) {
+    Operando o;
+    o.tipo = Operando::MEM;
+    o.reg = base;
+    o.imm = disp;
+    return o;
+}
+
+Operando opRip(int etiqueta) {
+    Operando o;
+    o.tipo = Operando::RIP;
+    o.etiqueta = etiqueta;
+    return o;
+}
+
+Operando opEtiqueta(int etiqueta) {
+    Operando o;
+    o.tipo = Operando::ETIQUETA;
+    o.etiqueta = etiqueta;
+    return o;
+}
+
+Operando opSimbolo(const string& nombre) {
+    Operando o;
+    o.tipo = Operando::SIMBOLO;
+    o.simbolo = nombre;
+    return o;
+}
+
+// ==========================================
+// Nombres de registros y mnemónicos
+// ==========================================
+
+static const char* const REGS64[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                                     "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+static const char* const REGS32[] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                                     "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+static const char* const REGS8[] = {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+                                    "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"};
+
+static const char* nombreRegistro(int reg, int bits) {
+    if (bits == 32) return REGS32[reg & 15];
+    if (bits == 8) return REGS8[reg & 15];
+    return REGS64[reg & 15];
+}
+
+static const char* const MNEMONICOS[] = {
+    "movq", "movabsq", "movl", "movb", "movzbq", "movslq", "leaq",
+    "pushq", "popq",
+    "addq", "subq", "imulq", "cmpq", "incq", "decq", "negq", "idivq", "divq", "cqo",
+    "sete", "setne", "setl", "setle", "setg", "setge",
+    "jmp", "je", "jne", "jl", "jle", "jg", "jge",
+    "cmove", "cmovne", "cmovl", "cmovle", "cmovg", "cmovge",
+    "call", "leave", "ret", "syscall",
+    "", ""
+};
+
+const char* mnemonico(Op op) {
+    return MNEMONICOS[(int)op];
+}
+
+// ==========================================
+// AsmBuffer
+// ==========================================
+
+void AsmBuffer::ins(Op op, Operando a, Operando b) {
+    Instr i;
+    i.op = op;
+    i.a = a;
+    i.b = b;
+    instrs.push_back(i);
+}
+
+void AsmBuffer::directiva(const string& texto) {
+    Instr i;
+    i.op = Op::DIRECTIVA;
+    i.texto = texto;
+    instrs.push_back(i);
+}
+
+int AsmBuffer::etiqueta(const string& nombre) {
+    auto it = porNombre.find(nombre);
+    if (it != porNombre.end()) return it->second;
+    int id = (int)nombres.size();
+    nombres.push_back(nombre);
+    porNombre[nombre] = id;
+    return id;
+}
+
+void AsmBuffer::definir(int etiqueta) {
+    ins(Op::ETIQUETA, opEtiqueta(etiqueta));
+}
+
+// ==========================================
+// Emisor de texto AT&T
+// ==========================================
+
+static void textoOperando(const AsmBuffer& buf, Op op, const Operando& o, string& s) {
+    switch (o.tipo) {
+        case Operando::REG:
+            s += '%';
+            s += nombreRegistro(o.reg, o.bits);
+            break;
+        case Operando::IMM:
+            if (op == Op::MOVABSQ) {
+                ostringstream h;
+                h << "$0x" << hex << (unsigned long)o.imm;
+                s += h.str();
+            } else {
+                s += '$';
+                s += to_string(o.imm);
+            }
+            break;
+        case Operando::MEM:
+            s += to_string(o.imm);
+            s += "(%";
+            s += nombreRegistro(o.reg, 64);
+            s += ')';
+            break;
+        case Operando::RIP:
+            s += buf.nombre(o.etiqueta);
+            s += "(%rip)";
+            break;
+        case Operando::ETIQUETA:
+            s += buf.nombre(o.etiqueta);
+            break;
+        case Operando::SIMBOLO:
+            s += o.simbolo;
+            break;
+        default:
+            break;
+    }
+}
+
+void emitirTexto(const AsmBuffer& buf, ostream& out) {
+    // Todo el archivo se arma en memoria y se escribe de una vez
+    string s;
+    s.reserve(buf.instrs.size() * 24);
+    for (size_t k = 0; k < buf.instrs.size(); ++k) {
+        const Instr& i = buf.instrs[k];
+        if (i.op == Op::ETIQUETA) {
+            s += buf.nombre(i.a.etiqueta);
+            // Etiqueta de datos en la misma línea que su directiva (print_fmt_int: .string ...)
+            const Instr* sig = k + 1 < buf.instrs.size() ? &buf.instrs[k + 1] : nullptr;
+            if (sig && sig->op == Op::DIRECTIVA && sig->texto.rfind(".string", 0) == 0) {
+                s += ": ";
+                s += sig->texto;
+                s += '\n';
+                k++;
+                continue;
+            }
+            s += ":\n";
+            continue;
+        }
+        if (i.op == Op::DIRECTIVA) {
+            s += i.texto;
+            s += '\n';
+            continue;
+        }
+        s += "    ";
+        s += mnemonico(i.op);
+        if (i.a.tipo != Operando::NINGUNO) {
+            s += ' ';
+            textoOperando(buf, i.op, i.a, s);
+        }
+        if (i.b.tipo != Operando::NINGUNO) {
+            s += ", ";
+            textoOperando(buf, i.op, i.b, s);
+        }
+        s += '\n';
+    }
+    out.write(s.data(), (streamsize)s.size());
+}
+
+// ==========================================
+// Lectura de texto AT&T (runtime del ejecutable ELF, pruebas a mano)
+// ==========================================
+
+static string recortar(const string& s) {
+    size_t a = s.find_first_not_of(" \t\r");
+    if (a == string::npos) return "";
+    size_t b = s.find_last_not_of(" \t\r");
+    return s.substr(a, b - a + 1);
+}
+
+static bool registroPorNombre(const string& n, int& reg, int& bits) {
+    for (int r = 0; r < 16; ++r) {
+        if (n == REGS64[r]) { reg = r; bits = 64; return true; }
+        if (n == REGS32[r]) { reg = r; bits = 32; return true; }
+        if (n == REGS8[r])  { reg = r; bits = 8;  return true; }
+    }
+    return false;
+}
+
+static bool leerOperando(AsmBuffer& buf, const string& texto, Operando& op) {
+    string t = recortar(texto);
+    if (t.empty()) return false;
+    if (t[0] == '%') {
+        op.tipo = Operando::REG;
+        return registroPorNombre(t.substr(1), op.reg, op.bits);
+    }
+    if (t[0] == '$') {
+        op.tipo = Operando::IMM;
+        try { op.imm = (long)stoul(t.substr(1), nullptr, 0); } catch (...) {
+            try { op.imm = stol(t.substr(1), nullptr, 0); } catch (...) { return false; }
+        }
+        return true;
+    }
+    size_t par = t.find('(');
+    if (par != string::npos && t.substr(par) == "(%rip)") {
+        op = opRip(buf.etiqueta(t.substr(0, par)));
+        return true;
+    }
+    if (par != string::npos) {
+        int bits;
+        if (t.back() != ')' || t[par + 1] != '%') return false;
+        if (!registroPorNombre(t.substr(par + 2, t.size() - par - 3), op.reg, bits) || bits != 64) return false;
+        op.tipo = Operando::MEM;
+        op.imm = 0;
+        if (par > 0) {
+            try { op.imm = stol(t.substr(0, par), nullptr, 0); } catch (...) { return false; }
+        }
+        return true;
+    }
+    // Destino de salto/llamada: los símbolos @PLT son externos
+    if (t.find('@') != string::npos) op = opSimbolo(t);
+    else op = opEtiqueta(buf.etiqueta(t));
+    return true;
+}
+
+bool AsmBuffer::leerTexto(const string& texto, string& err) {
+    istringstream in(texto);
+    string linea;
+    while (getline(in, linea)) {
+        string l = recortar(linea);
+        if (l.empty()) continue;
+        // "etiqueta:" sola o seguida de una directiva (print_fmt_int: .string ...)
+        size_t dosPuntos = l.find(':');
+        if (dosPuntos != string::npos && l.find_first_of(" \t\"") > dosPuntos) {
+            definir(etiqueta(l.substr(0, dosPuntos)));
+            l = recortar(l.substr(dosPuntos + 1));
+            if (l.empty()) continue;
+        }
+        if (l[0] == '.') {
+            directiva(l);
+            continue;
+        }
+
+        size_t sp = l.find_first_of(" \t");
+        string mnem = l.substr(0, sp);
+        int op = 0;
+        while (op < (int)Op::ETIQUETA && mnem != MNEMONICOS[op]) op++;
+        if (op == (int)Op::ETIQUETA) {
+            err = "instruccion no soportada: " + l;
+            return false;
+        }
+
+        vector<Operando> ops;
+        if (sp != string::npos) {
+            // Separar operandos por comas fuera de paréntesis
+            string resto = l.substr(sp + 1);
+            int prof = 0;
+            string actual;
+            for (char c : resto) {
+                if (c == '(') prof++;
+                if (c == ')') prof--;
+                if (c == ',' && prof == 0) {
+                    ops.emplace_back();
+                    if (!leerOperando(*this, actual, ops.back())) { err = "operando invalido: " + l; return false; }
+                    actual.clear();
+                } else {
+                    actual += c;
+                }
+            }
+            ops.emplace_back();
+            if (!leerOperando(*this, actual, ops.back())) { err = "operando invalido: " + l; return false; }
+        }
+        if (ops.size() > 2) {
+            err = "instruccion no soportada: " + l;
+            return false;
+        }
+        ins((Op)op, ops.size() > 0 ? ops[0] : Operando(), ops.size() > 1 ? ops[1] : Operando());
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef ASM_BUFFER_H
+#define ASM_BUFFER_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ===========================================================
+//  Buffer de instrucciones de máquina (x86-64)
+//  GenCodeVisitor construye aquí una lista de instrucciones (opcode +
+//  operandos estructurados, etiquetas como IDs) en lugar de escribir
+//  texto. Los emisores la consumen: emitirTexto() produce el .s AT&T en
+//  una sola escritura y X86Encoder la codifica a binario. Las pasadas
+//  posteriores (peephole, etc.) pueden inspeccionarla y reescribirla.
+// ===========================================================
+
+// Registros de propósito general (número de codificación x86)
+enum Reg { RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+enum class Op {
+    MOVQ, MOVABSQ, MOVL, MOVB, MOVZBQ, MOVSLQ, LEAQ,
+    PUSHQ, POPQ,
+    ADDQ, SUBQ, IMULQ, CMPQ, INCQ, DECQ, NEGQ, IDIVQ, DIVQ, CQO,
+    SETE, SETNE, SETL, SETLE, SETG, SETGE,
+    JMP, JE, JNE, JL, JLE, JG, JGE,
+    CMOVE, CMOVNE, CMOVL, CMOVLE, CMOVG, CMOVGE,
+    CALL, LEAVE, RET, SYSCALL,
+    ETIQUETA,   // Definición de etiqueta (operando a)
+    DIRECTIVA   // Línea de directiva literal (.data, .global, .string ...)
+};
+
+struct Operando {
+    enum Tipo { NINGUNO, REG, IMM, MEM, RIP, ETIQUETA, SIMBOLO } tipo = NINGUNO;
+    int reg = 0;      // REG: registro; MEM: registro base
+    int bits = 64;    // Ancho del registro (REG)
+    long imm = 0;     // IMM: valor; MEM: desplazamiento
+    int etiqueta = -1; // ETIQUETA / RIP: ID de etiqueta
+    string simbolo;   // SIMBOLO: nombre externo (printf@PLT)
+
+    bool operator==(const Operando& o) const {
+        return tipo == o.tipo && reg == o.reg && bits == o.bits && imm == o.imm &&
+               etiqueta == o.etiqueta && simbolo == o.simbolo;
+    }
+    bool operator!=(const Operando& o) const { return !(*this == o); }
+};
+
+Operando opReg(int r, int bits = 64);
+Operando opImm(long v);
+Operando opMem(int base, long disp);
+Operando opRip(int etiqueta);
+Operando opEtiqueta(int etiqueta);
+Operando opSimbolo(const string& nombre);
+
+struct Instr {
+    Op op;
+    Operando a, b;    // Orden AT&T: a = fuente, b = destino
+    string texto;     // DIRECTIVA
+};
+
+class AsmBuffer {
+public:
+    vector<Instr> instrs;
+
+    void ins(Op op, Operando a = Operando(), Operando b = Operando());
+    void directiva(const string& texto);
+    // ID de la etiqueta con ese nombre (la crea si no existe)
+    int etiqueta(const string& nombre);
+    void definir(int etiqueta);
+    const string& nombre(int etiqueta) const { return nombres[etiqueta]; }
+    int totalEtiquetas() const { return (int)nombres.size(); }
+
+    // Agrega instrucciones leídas de texto AT&T; false si algo no se reconoce
+    bool leerTexto(const string& texto, string& err);
+
+private:
+    vector<string> nombres;
+    unordered_map<string, int> porNombre;
+};
+
+// Mnemónico AT&T de un opcode
+const char* mnemonico(Op op);
+// Emisor de texto: el .s completo en una sola escritura
+void emitirTexto(const AsmBuffer& buf, ostream& out);
+
+#endif // ASM_BUFFER_H
@@ -50,16 +50,17 @@ string Exp::binopToChar(BinaryOp op) {
 // Configuracion de BinaryExp (El cálculo del peso/etiqueta)
 BinaryExp::BinaryExp(Exp* l, Exp* r, BinaryOp o) : left(l), right(r), op(o) {
     // ----- OPTIMIZACION: Lógica Sethi-Ullman -----
-    // Si el hijo izquierdo es una hoja, le damos peso 1 temporalmente para la lógica
-    if (left->hoja == 1) {
-        left->et == 1;
-    }
-    // Lógica de Sethi-Ulman simplificada
-    if (l->et == r->et) {
-        et = l->et + 1;
+    // Una hoja (o constante plegada) a la izquierda ocupa un registro; a la
+    // derecha se usa directamente como operando ($k o -off(%rbp)) y no ocupa ninguno
+    bool hojaIzq = left->hoja == 1 || left->cont == 1;
+    bool hojaDer = right->hoja == 1 || right->cont == 1;
+    int etIzq = hojaIzq ? 1 : l->et;
+    int etDer = hojaDer ? 0 : r->et;
+    if (etIzq == etDer) {
+        et = etIzq + 1;
     }
     else {
-        et = max(l->et, r->et);
+        et = max(etIzq, etDer);
     }
     hoja = 0; // No es hoja
 
@@ -55,6 +55,13 @@ public:
     int cont = 0; // 1 si es constante, 0 si no
     int valor = 0; // El valor pre-calculado si cont=1
 
+    // ---- OPTIMIZACION: Propagación de constantes (--sccp)
+    int claseCont = -1;  // Value::Kind del valor constante (-1 si no se conoce)
+    double valorF = 0;   // Valor si claseCont es FLOAT (valor guarda la vista entera del resto)
+
+    // ---- OPTIMIZACION: Quickening (EvalVisitor)
+    int quick = 0; // Variante especializada elegida en la primera ejecución (0 = sin especializar)
+
     virtual int  accept(Visitor* visitor) = 0;
     virtual ~Exp() = 0;  // Destructor puro → clase abstracta
     static string binopToChar(BinaryOp op);  // Conversión operador → string
@@ -99,6 +106,9 @@ public:
 class IdExp : public Exp {
 public:
     string value;
+    // Cache del quickening para accesos a campos (p.x): índices ya resueltos
+    vector<int> indices;
+    string structCache;   // Tipo del struct raíz con el que se resolvieron (guarda)
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // nuevo
     IdExp(string v);
@@ -0,0 +1,817 @@
+#include <iostream>
+#include <sstream>
+#include "closure_engine.h"
+#include "scev.h"
+#include "licm.h"
+#include "pureza.h"
+#include "pila.h"
+
+using namespace std;
+
+// ==========================================
+// Helpers
+// ==========================================
+
+static vector<string> partesDe(const string& name) {
+    vector<string> parts;
+    string token;
+    istringstream ss(name);
+    while (getline(ss, token, '.')) parts.push_back(token);
+    return parts;
+}
+
+// Misma regla que createDefaultValue en visitor.cpp
+Value ClosureEngine::valorPorDefecto(const string& type) {
+    if (type == "int" || type == "long") return Value::make_int(0);
+    if (type.find("unsigned") != string::npos || type == "uint") return Value::make_unsigned(0);
+    if (type == "bool") return Value::make_bool(false);
+    auto it = structDefs.find(type);
+    if (it != structDefs.end()) {
+        vector<Value> fieldValues;
+        for (const auto& field : it->second) fieldValues.push_back(valorPorDefecto(field.first));
+        return Value::make_struct(fieldValues, type);
+    }
+    return Value::make_int(0);
+}
+
+string ClosureEngine::resolverTipo(const string& type) {
+    string t = type;
+    for (int guard = 0; guard < 16 && typedefs.count(t); ++guard) t = typedefs[t];
+    return t;
+}
+
+// Devuelve el tipo del campo y su índice dentro del struct
+string ClosureEngine::tipoCampo(const string& structName, const string& field, int& index) {
+    auto it = structDefs.find(resolverTipo(structName));
+    if (it == structDefs.end()) {
+        cerr << "Error: '" << structName << "' no es un struct." << endl;
+        exit(1);
+    }
+    const auto& fields = it->second;
+    for (size_t k = 0; k < fields.size(); ++k) {
+        if (fields[k].second == field) {
+            index = (int)k;
+            return fields[k].first;
+        }
+    }
+    cerr << "Error: Campo '" << field << "' no existe en '" << structName << "'" << endl;
+    exit(1);
+}
+
+ClosureEngine::Slot ClosureEngine::declarar(const string& name, const string& type) {
+    Slot s;
+    s.type = type;
+    if (scopes.size() == 1) {
+        // Ámbito global
+        s.global = true;
+        s.index = (int)globals.size();
+        globals.emplace_back();
+    } else {
+        s.index = nextSlot++;
+    }
+    scopes.back()[name] = s;
+    return s;
+}
+
+ClosureEngine::Slot ClosureEngine::buscar(const string& name) {
+    for (int idx = (int)scopes.size() - 1; idx >= 0; --idx) {
+        auto it = scopes[idx].find(name);
+        if (it != scopes[idx].end()) return it->second;
+    }
+    cerr << "Error: Variable '" << name << "' no encontrada." << endl;
+    exit(1);
+}
+
+string ClosureEngine::tipoDeExp(Exp* e) {
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        vector<string> parts = partesDe(id->value);
+        string t = buscar(parts[0]).type;
+        for (size_t k = 1; k < parts.size(); ++k) {
+            int index = 0;
+            t = tipoCampo(t, parts[k], index);
+        }
+        return t;
+    }
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        auto it = funciones.find(fc->name);
+        return it != funciones.end() ? it->second.fd->type : "int";
+    }
+    if (TernaryExp* te = dynamic_cast<TernaryExp*>(e)) return tipoDeExp(te->trueExp);
+    return "int";
+}
+
+// Clase de valor que una expresión produce siempre, o -1 si no se puede
+// garantizar en compilación (floats, structs, ramas de clases distintas)
+int ClosureEngine::kindEstatico(Exp* e) {
+    if (e->claseCont >= 0) return e->claseCont;
+    if (dynamic_cast<NumberExp*>(e)) return Value::INT;
+    if (dynamic_cast<BoolExp*>(e)) return Value::BOOL;
+    if (dynamic_cast<FloatExp*>(e)) return Value::FLOAT;
+    if (dynamic_cast<IdExp*>(e) || dynamic_cast<FcallExp*>(e)) {
+        string t = tipoDeExp(e);
+        string r = resolverTipo(t);
+        if (r == "float" || structDefs.count(r)) return -1;
+        return kindDeTipo(t);
+    }
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        if (b->op == GT_OP || b->op == LT_OP || b->op == GE_OP || b->op == LE_OP ||
+            b->op == EQ_OP || b->op == NE_OP) return Value::INT;
+        int l = kindEstatico(b->left), r = kindEstatico(b->right);
+        if (l < 0 || r < 0) return -1;
+        if (l == Value::FLOAT || r == Value::FLOAT) return Value::FLOAT;
+        if (l == Value::UNSIGNED || r == Value::UNSIGNED) return Value::UNSIGNED;
+        return Value::INT;
+    }
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        int a = kindEstatico(t->trueExp), b = kindEstatico(t->falseExp);
+        return a == b ? a : -1;
+    }
+    return -1;
+}
+
+// Convierte los campos escalares de un struct a la clase declarada de cada campo
+void ClosureEngine::convertirCampos(Value& v, const string& type) {
+    auto it = structDefs.find(resolverTipo(type));
+    if (it == structDefs.end()) return;
+    const auto& fields = it->second;
+    for (size_t k = 0; k < fields.size() && k < v.fields.size(); ++k) {
+        Value& campo = v.fields[k];
+        if (campo.kind == Value::STRUCT) {
+            campo.type_name = fields[k].first;
+            convertirCampos(campo, fields[k].first);
+        } else {
+            convertirEscalar(campo, kindDeTipo(fields[k].first));
+        }
+    }
+}
+
+bool ClosureEngine::esStruct(Exp* e) {
+    return structDefs.count(resolverTipo(tipoDeExp(e))) > 0;
+}
+
+// ==========================================
+// Ejecución
+// ==========================================
+
+void ClosureEngine::ejecutar(Program* program) {
+    globals.clear();
+    funciones.clear();
+    structDefs.clear();
+    typedefs.clear();
+    scopes.clear();
+    if (!program) return;
+
+    cout << "Interprete:" << endl;
+
+    for (StructDec* sd : program->strlist) {
+        vector<pair<string, string>> fields;
+        for (VarDec* vd : sd->VdList)
+            for (const string& name : vd->vars) fields.push_back({vd->type, name});
+        structDefs[sd->nombre] = fields;
+    }
+    for (TypedefDec* td : program->tdlist) typedefs[td->alias] = td->typeName;
+
+    // Registrar todas las funciones antes de compilar (llamadas hacia adelante y recursión)
+    for (FunDec* fd : program->fdlist) funciones[fd->id].fd = fd;
+
+    // Globales: se compilan y ejecutan en orden, igual que EvalVisitor
+    scopes.emplace_back();
+    vector<StmFn> inits;
+    for (VarDec* vd : program->vdlist) inits.push_back(compilarVarDec(vd));
+    for (InstanceDec* ind : program->intdlist) inits.push_back(compilarInstanceDec(ind));
+
+    auto itMain = funciones.find("main");
+    if (itMain == funciones.end()) {
+        cerr << "Error: main no encontrado." << endl;
+        exit(1);
+    }
+    for (auto& par : funciones) {
+        compilarFuncion(par.second);
+        par.second.pura = pureza && pureza->pura(par.second.fd);
+        par.second.memo = TablaMemo(capacidadMemo);
+    }
+
+    for (StmFn& init : inits) init(globalFrame);
+    vector<Value> noArgs;
+    int retInt = 0;
+    llamar(&itMain->second, noArgs, retInt);
+    cout.flush();
+    if (reporteMemo) {
+        for (FunDec* fd : program->fdlist) {
+            const CFun& cf = funciones[fd->id];
+            const TablaMemo& memo = cf.memo;
+            if (!cf.pura || memo.aciertos + memo.fallos == 0) continue;
+            *reporteMemo << "MEMO " << fd->id << ": " << memo.aciertos << " aciertos, " << memo.fallos << " fallos, "
+                         << memo.ocupadas << " entradas" << endl;
+        }
+    }
+    globals.clear();
+}
+
+Value ClosureEngine::llamar(CFun* cf, vector<Value>& args, int& retInt) {
+    if (maxRecursion > 0 && profundidad >= maxRecursion) {
+        cerr << "Error: límite de recursión excedido (" << maxRecursion << " llamadas anidadas) al llamar a "
+             << cf->fd->id << endl;
+        cout.flush();
+        exit(1);
+    }
+    // ----- OPTIMIZACION: Memoización (--memo) -----
+    bool memo = capacidadMemo && cf->pura;
+    vector<Value> clave;
+    if (memo) {
+        for (size_t k = 0; k < cf->paramKinds.size(); ++k) convertirEscalar(args[k], cf->paramKinds[k]);
+        Value r;
+        if (cf->memo.buscar(args, retInt, r)) return r;
+        clave = args;
+    }
+
+    Frame nf;
+    profundidad++;
+    PilaSegmentada::asegurar([&] { ejecutarLlamada(cf, args, nf); });
+    profundidad--;
+    retInt = nf.ret_int;
+    if (nf.ret.kind == Value::STRUCT) return std::move(nf.ret);
+    // Función float: el valor completo si lo dejó un return de función float
+    if (cf->retKind == Value::FLOAT) return nf.ret.kind == Value::FLOAT ? nf.ret : Value::make_float(nf.ret_int);
+    Value r = Value::make_int(nf.ret_int);
+    convertirEscalar(r, cf->retKind);
+    if (memo) cf->memo.guardar(clave, retInt, r);
+    return r;
+}
+
+// Cuerpo de la llamada y, en el mismo frame, las llamadas en cola que
+// programen sus return
+void ClosureEngine::ejecutarLlamada(CFun* cf, vector<Value>& args, Frame& nf) {
+    while (true) {
+        nf.slots.clear();
+        nf.slots.resize(cf->nslots);
+        for (size_t k = 0; k < cf->paramSlots.size(); ++k) {
+            convertirEscalar(args[k], cf->paramKinds[k]);
+            nf.slots[cf->paramSlots[k]] = std::move(args[k]);
+        }
+        cf->body(nf);
+        if (!colaPendiente) return;
+        cf = colaPendiente;
+        colaPendiente = nullptr;
+        args = std::move(argsCola);
+        nf.returning = false;
+    }
+}
+
+// ==========================================
+// Compilación: funciones y sentencias
+// ==========================================
+
+void ClosureEngine::compilarFuncion(CFun& cf) {
+    if (cf.compilada) return;
+    cf.compilada = true;
+    actual = &cf;
+    nextSlot = 0;
+    scopes.resize(1);
+    scopes.emplace_back();
+    cf.retKind = kindDeTipo(cf.fd->type);
+    for (ParamDec* p : cf.fd->params) {
+        cf.paramSlots.push_back(declarar(p->id, p->type).index);
+        cf.paramKinds.push_back(kindDeTipo(p->type));
+    }
+    cf.body = compilarBody(cf.fd->body);
+    cf.nslots = nextSlot;
+    scopes.resize(1);
+    actual = nullptr;
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarBody(Body* b) {
+    scopes.emplace_back();
+    vector<StmFn> decs;
+    for (VarDec* vd : b->declarations) decs.push_back(compilarVarDec(vd));
+    for (InstanceDec* ind : b->intances) decs.push_back(compilarInstanceDec(ind));
+    vector<StmFn> stms;
+    for (Stm* s : b->stmList) stms.push_back(compilarStm(s));
+    scopes.pop_back();
+
+    return [decs, stms](Frame& f) {
+        for (const StmFn& d : decs) d(f);
+        for (const StmFn& s : stms) {
+            s(f);
+            if (f.returning) return;
+        }
+    };
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarVarDec(VarDec* vd) {
+    vector<pair<Slot, Value>> vars;
+    Value def = valorPorDefecto(vd->type);
+    for (const string& var : vd->vars) vars.push_back({declarar(var, vd->type), def});
+    vector<Value>* G = &globals;
+    return [vars, G](Frame& f) {
+        for (const auto& par : vars) {
+            if (par.first.global) (*G)[par.first.index] = par.second;
+            else f.slots[par.first.index] = par.second;
+        }
+    };
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarInstanceDec(InstanceDec* ind) {
+    Value::Kind kind = kindDeTipo(ind->type);
+    string tname = ind->type;
+    vector<pair<Slot, ValFn>> vars;
+    auto itVar = ind->vars.begin();
+    auto itVal = ind->values.begin();
+    for (; itVar != ind->vars.end(); ++itVar, ++itVal) {
+        // El inicializador se compila antes de declarar la variable
+        ValFn init = compilarInit(*itVal);
+        vars.push_back({declarar(*itVar, ind->type), init});
+    }
+    vector<Value>* G = &globals;
+    return [this, vars, kind, tname, G](Frame& f) {
+        for (const auto& par : vars) {
+            Value v = par.second(f);
+            if (v.kind == Value::STRUCT) {
+                v.type_name = tname;
+                convertirCampos(v, tname);
+            } else {
+                convertirEscalar(v, kind);
+            }
+            if (par.first.global) (*G)[par.first.index] = std::move(v);
+            else f.slots[par.first.index] = std::move(v);
+        }
+    };
+}
+
+ClosureEngine::ValFn ClosureEngine::compilarInit(InitData* d) {
+    if (d->e) return compilar(d->e).v;
+    if (d->st) {
+        vector<ValFn> campos;
+        for (Exp* e : d->st->argumentos) campos.push_back(compilar(e).v);
+        return [campos](Frame& f) {
+            vector<Value> fields;
+            fields.reserve(campos.size());
+            for (const ValFn& c : campos) fields.push_back(c(f));
+            return Value::make_struct(fields);
+        };
+    }
+    return [](Frame&) { return Value::make_int(0); };
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarStm(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return compilarAsignacion(a);
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) return compilarPrintf(p);
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return compilarReturn(r);
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) return compilarInstanceDec(ind);
+
+    if (IfStm* is = dynamic_cast<IfStm*>(s)) {
+        // Condición constante (--sccp): solo se compila la rama viva
+        if (is->condition->claseCont >= 0) {
+            Body* viva = valorEntero(valorConstante(is->condition)) ? is->thenBody : is->elseBody;
+            if (!viva) return [](Frame&) {};
+            return compilarBody(viva);
+        }
+        IntFn cond = compilar(is->condition).i;
+        StmFn thenB = compilarBody(is->thenBody);
+        if (!is->elseBody) {
+            return [cond, thenB](Frame& f) { if (cond(f)) thenB(f); };
+        }
+        StmFn elseB = compilarBody(is->elseBody);
+        return [cond, thenB, elseB](Frame& f) {
+            if (cond(f)) thenB(f);
+            else elseB(f);
+        };
+    }
+
+    if (WhileStm* ws = dynamic_cast<WhileStm*>(s)) {
+        if (ws->condition->claseCont >= 0 && !valorEntero(valorConstante(ws->condition))) return [](Frame&) {};
+        StmFn pre = compilarInvariantes(ws);
+        IntFn cond = compilar(ws->condition).i;
+        StmFn body = compilarBody(ws->body);
+        StmFn bucle = [pre, cond, body](Frame& f) {
+            pre(f);
+            while (cond(f)) {
+                body(f);
+                if (f.returning) return;
+            }
+        };
+        const FormaCerrada* fc = scev ? scev->forma(ws) : nullptr;
+        if (!fc) return bucle;
+        function<bool(Frame&)> cerrada = compilarFormaCerrada(fc);
+        return [cerrada, bucle](Frame& f) { if (!cerrada(f)) bucle(f); };
+    }
+
+    if (ForStm* fs = dynamic_cast<ForStm*>(s)) {
+        scopes.emplace_back();
+        StmFn init = fs->init ? compilarStm(fs->init) : StmFn([](Frame&) {});
+        StmFn pre = compilarInvariantes(fs);
+        IntFn cond = compilar(fs->condition).i;
+        StmFn body = compilarBody(fs->body);
+        StmFn step = fs->step ? compilarPaso(fs->step) : StmFn([](Frame&) {});
+        const FormaCerrada* fc = scev ? scev->forma(fs) : nullptr;
+        function<bool(Frame&)> cerrada = fc ? compilarFormaCerrada(fc)
+                                                          : [](Frame&) { return false; };
+        scopes.pop_back();
+        return [init, cerrada, pre, cond, body, step](Frame& f) {
+            init(f);
+            if (cerrada(f)) return;
+            pre(f);
+            while (cond(f)) {
+                body(f);
+                if (f.returning) break;
+                step(f);
+            }
+        };
+    }
+
+    cerr << "Error: sentencia no soportada por el motor de closures." << endl;
+    exit(1);
+}
+
+// Preheader (--licm): cada invariante se compila por su ruta normal y su
+// valor va a un slot propio del frame; las apariciones dentro del bucle,
+// que se compilan después, leen ese slot
+ClosureEngine::StmFn ClosureEngine::compilarInvariantes(Stm* bucle) {
+    if (!licm || licm->invariantes(bucle).empty()) return [](Frame&) {};
+    vector<pair<int, ValFn>> calculos;
+    for (Exp* e : licm->invariantes(bucle)) {
+        ValFn v = compilar(e).v;
+        int idx = nextSlot++;
+        slotsInvariantes[e] = idx;
+        calculos.push_back({idx, v});
+    }
+    return [calculos](Frame& f) {
+        for (const auto& c : calculos) f.slots[c.first] = c.second(f);
+    };
+}
+
+// Forma cerrada (--scev): las variables que nombra se resuelven a slots ahora
+function<bool(Frame&)> ClosureEngine::compilarFormaCerrada(const FormaCerrada* fc) {
+    unordered_map<string, int> slots;
+    auto resolver = [&](const string& var) {
+        Slot s = buscar(var);
+        if (!s.global) slots[var] = s.index;
+    };
+    resolver(fc->contador);
+    for (const TerminoPolinomio& t : fc->limite) for (const string& v : t.factores) resolver(v);
+    for (const Acumulacion& a : fc->acumulaciones) {
+        resolver(a.var);
+        for (const TerminoPolinomio& t : a.terminos) for (const string& v : t.factores) resolver(v);
+    }
+    return [fc, slots](Frame& f) {
+        return EvolucionEscalar::ejecutar(*fc, [&](const string& var) -> Value* {
+            auto it = slots.find(var);
+            return it == slots.end() ? nullptr : &f.slots[it->second];
+        });
+    };
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarAsignacion(AssignStm* s) {
+    ValFn rhs = compilar(s->e).v;
+    vector<string> parts = partesDe(s->id);
+    Slot slot = buscar(parts[0]);
+    vector<Value>* G = &globals;
+
+    // CASO A: Asignación simple
+    if (parts.size() == 1) {
+        // El destino conserva su clase int/unsigned
+        if (slot.global) {
+            int idx = slot.index;
+            return [rhs, G, idx](Frame& f) {
+                Value v = rhs(f);
+                convertirEscalar(v, (*G)[idx].kind);
+                (*G)[idx] = std::move(v);
+            };
+        }
+        int idx = slot.index;
+        return [rhs, idx](Frame& f) {
+            Value v = rhs(f);
+            convertirEscalar(v, f.slots[idx].kind);
+            f.slots[idx] = std::move(v);
+        };
+    }
+
+    // CASO B: Asignación a campo de struct (p.x, rect.centro.y)
+    vector<int> path;
+    string t = slot.type;
+    for (size_t k = 1; k < parts.size(); ++k) {
+        int index = 0;
+        t = tipoCampo(t, parts[k], index);
+        path.push_back(index);
+    }
+    bool global = slot.global;
+    int idx = slot.index;
+    return [rhs, G, global, idx, path](Frame& f) {
+        Value nuevo = rhs(f);
+        Value* cur = global ? &(*G)[idx] : &f.slots[idx];
+        for (size_t k = 0; k + 1 < path.size(); ++k) cur = &cur->fields[path[k]];
+        if (cur->kind != Value::STRUCT) {
+            cerr << "Error: asignacion a campo de un valor que no es struct." << endl;
+            exit(1);
+        }
+        convertirEscalar(nuevo, cur->fields[path.back()].kind);
+        cur->fields[path.back()] = std::move(nuevo);
+    };
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarPaso(StepExp* s) {
+    IdExp* id = dynamic_cast<IdExp*>(s->variable);
+    if (!id) return [](Frame&) {};
+    Slot slot = buscar(id->value);
+    vector<Value>* G = &globals;
+    bool global = slot.global;
+    int idx = slot.index;
+    ValFn amount = (s->type == StepExp::COMPOUND) ? compilar(s->amount).v : ValFn();
+    int delta = (s->type == StepExp::DECREMENT) ? -1 : 1;
+    return [amount, delta, G, global, idx](Frame& f) {
+        Value& v = global ? (*G)[idx] : f.slots[idx];
+        if (v.kind == Value::INT) {
+            int val = v.i;
+            val += amount ? valorEntero(amount(f)) : delta;
+            (global ? (*G)[idx] : f.slots[idx]) = Value::make_int(val);
+            return;
+        }
+        // Contador no int (p. ej. unsigned): misma semántica tipada que EvalVisitor
+        Value actual = v;
+        Value nuevo = operarBinaria(PLUS_OP, actual, amount ? amount(f) : Value::make_int(delta));
+        convertirEscalar(nuevo, actual.kind);
+        (global ? (*G)[idx] : f.slots[idx]) = std::move(nuevo);
+    };
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarPrintf(PrintfStm* s) {
+    // El formato se interpreta una sola vez, con las mismas reglas que EvalVisitor
+    enum Tipo { TEXTO, ARG_D, ARG_U, ARG_F, ARG_LD };
+    struct Segmento { Tipo tipo; string texto; int arg; };
+    vector<Segmento> segs;
+    auto texto = [&segs](const string& t) {
+        if (!segs.empty() && segs.back().tipo == TEXTO) segs.back().texto += t;
+        else segs.push_back({TEXTO, t, -1});
+    };
+
+    const string& fmt = s->format;
+    size_t nargs = s->args.size();
+    size_t argIdx = 0;
+    for (size_t i = 0; i < fmt.size(); i++) {
+        if (fmt[i] == '%' && argIdx < nargs) {
+            int a = (int)argIdx++;
+            if (i+1 < fmt.size() && fmt[i+1] == 'd') { segs.push_back({ARG_D, "", a}); i++; }
+            else if (i+1 < fmt.size() && fmt[i+1] == 'u') { segs.push_back({ARG_U, "", a}); i++; }
+            else if (i+1 < fmt.size() && fmt[i+1] == 'f') { segs.push_back({ARG_F, "", a}); i++; }
+            else if (i+2 < fmt.size() && fmt[i+1] == 'l' && fmt[i+2] == 'd') { segs.push_back({ARG_LD, "", a}); i += 2; }
+            else texto("%");
+        } else if (fmt[i] == '\\') {
+            if (i+1 < fmt.size() && fmt[i+1] == 'n') { texto("\n"); i++; }
+            else texto("\\");
+        } else {
+            texto(string(1, fmt[i]));
+        }
+    }
+
+    vector<ValFn> args;
+    for (Exp* e : s->args) args.push_back(compilar(e).v);
+
+    return [segs, args](Frame& f) {
+        vector<Value> vals;
+        vals.reserve(args.size());
+        for (const ValFn& a : args) vals.push_back(a(f));
+        for (const Segmento& sg : segs) {
+            switch (sg.tipo) {
+                case TEXTO: cout << sg.texto; break;
+                case ARG_D: {
+                    const Value& v = vals[sg.arg];
+                    cout << (v.kind == Value::FLOAT ? v.i : valorEntero(v));
+                    break;
+                }
+                case ARG_U: {
+                    const Value& v = vals[sg.arg];
+                    if (v.kind == Value::UNSIGNED) cout << v.u; else cout << (unsigned)v.i;
+                    break;
+                }
+                case ARG_F: {
+                    const Value& v = vals[sg.arg];
+                    if (v.kind == Value::FLOAT) cout << v.f; else cout << (double)v.i;
+                    break;
+                }
+                case ARG_LD: {
+                    const Value& v = vals[sg.arg];
+                    if (v.kind == Value::FLOAT) cout << v.f; else cout << v.i;
+                    break;
+                }
+            }
+        }
+    };
+}
+
+ClosureEngine::StmFn ClosureEngine::compilarReturn(ReturnStm* s) {
+    if (!s->e) return [](Frame& f) { f.returning = true; };
+    if (esStruct(s->e)) {
+        ValFn v = compilar(s->e).v;
+        return [v](Frame& f) {
+            f.ret = v(f);
+            f.ret_int = 0;
+            f.returning = true;
+        };
+    }
+    if (StmFn cola = compilarCola(s->e)) return cola;
+    if (actual && actual->retKind == Value::FLOAT) {
+        ValFn v = compilar(s->e).v;
+        return [v](Frame& f) {
+            f.ret = v(f);
+            f.ret_int = valorEntero(f.ret);
+            f.returning = true;
+        };
+    }
+    IntFn i = compilar(s->e).i;
+    return [i](Frame& f) {
+        f.ret_int = i(f);
+        f.returning = true;
+    };
+}
+
+// Retorno de una llamada (o de un ternario con llamadas en sus ramas):
+// los argumentos quedan pendientes para llamar(). nullptr si no hay cola
+ClosureEngine::StmFn ClosureEngine::compilarCola(Exp* e) {
+    if (e->claseCont >= 0 || slotsInvariantes.count(e) || !actual || structDefs.count(resolverTipo(actual->fd->type)))
+        return nullptr;
+    if (TernaryExp* te = dynamic_cast<TernaryExp*>(e)) {
+        StmFn t = compilarCola(te->trueExp);
+        StmFn f = compilarCola(te->falseExp);
+        if (!t && !f) return nullptr;
+        auto retorno = [this](Exp* rama) -> StmFn {
+            IntFn i = compilar(rama).i;
+            return [i](Frame& fr) {
+                fr.ret_int = i(fr);
+                fr.returning = true;
+            };
+        };
+        if (!t) t = retorno(te->trueExp);
+        if (!f) f = retorno(te->falseExp);
+        IntFn c = compilar(te->condition).i;
+        return [c, t, f](Frame& fr) { c(fr) ? t(fr) : f(fr); };
+    }
+    FcallExp* fc = dynamic_cast<FcallExp*>(e);
+    if (!fc) return nullptr;
+    auto it = funciones.find(fc->name);
+    if (it == funciones.end() || structDefs.count(resolverTipo(it->second.fd->type))) return nullptr;
+    CFun* cf = &it->second;
+    vector<ValFn> args;
+    for (size_t k = 0; k < cf->fd->params.size(); ++k) args.push_back(compilar(fc->arguments[k]).v);
+    return [this, cf, args](Frame& f) {
+        // Los argumentos pueden hacer otras llamadas: se juntan aparte
+        vector<Value> vals;
+        vals.reserve(args.size());
+        for (const ValFn& a : args) vals.push_back(a(f));
+        argsCola = std::move(vals);
+        colaPendiente = cf;
+        f.ret_int = 0;
+        f.returning = true;
+    };
+}
+
+// ==========================================
+// Compilación: expresiones
+// ==========================================
+
+ClosureEngine::CExp ClosureEngine::compilar(Exp* e) {
+    // Constante propagada (--sccp)
+    if (e->claseCont >= 0) {
+        Value k = valorConstante(e);
+        int ki = valorEntero(k);
+        return { [ki](Frame&) { return ki; }, [k](Frame&) { return k; } };
+    }
+    // Invariante de bucle (--licm): ya calculado en el preheader
+    auto inv = slotsInvariantes.find(e);
+    if (inv != slotsInvariantes.end()) {
+        int idx = inv->second;
+        return { [idx](Frame& f) { return valorEntero(f.slots[idx]); },
+                 [idx](Frame& f) { return f.slots[idx]; } };
+    }
+    if (NumberExp* n = dynamic_cast<NumberExp*>(e)) {
+        int k = n->value;
+        return { [k](Frame&) { return k; }, [k](Frame&) { return Value::make_int(k); } };
+    }
+    if (FloatExp* fe = dynamic_cast<FloatExp*>(e)) {
+        double d = fe->value;
+        return { [d](Frame&) { return (int)d; }, [d](Frame&) { return Value::make_float(d); } };
+    }
+    if (BoolExp* be = dynamic_cast<BoolExp*>(e)) {
+        bool b = be->value;
+        return { [b](Frame&) { return b ? 1 : 0; }, [b](Frame&) { return Value::make_bool(b); } };
+    }
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) return compilarId(id);
+    if (BinaryExp* bin = dynamic_cast<BinaryExp*>(e)) return compilarBinaria(bin);
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) return compilarLlamada(fc);
+    if (TernaryExp* te = dynamic_cast<TernaryExp*>(e)) {
+        IntFn c = compilar(te->condition).i;
+        CExp t = compilar(te->trueExp);
+        CExp f = compilar(te->falseExp);
+        IntFn ti = t.i, fi = f.i;
+        ValFn tv = t.v, fv = f.v;
+        return {
+            [c, ti, fi](Frame& fr) { return c(fr) ? ti(fr) : fi(fr); },
+            [c, tv, fv](Frame& fr) { return c(fr) ? tv(fr) : fv(fr); }
+        };
+    }
+    // StepExp u otros nodos sin valor
+    return { [](Frame&) { return 0; }, [](Frame&) { return Value::make_int(0); } };
+}
+
+ClosureEngine::CExp ClosureEngine::compilarId(IdExp* e) {
+    vector<string> parts = partesDe(e->value);
+    Slot slot = buscar(parts[0]);
+    vector<Value>* G = &globals;
+    int idx = slot.index;
+
+    // CASO 1: Variable simple
+    if (parts.size() == 1) {
+        if (slot.global) {
+            return { [G, idx](Frame&) { return valorEntero((*G)[idx]); },
+                     [G, idx](Frame&) { return (*G)[idx]; } };
+        }
+        return { [idx](Frame& f) { return valorEntero(f.slots[idx]); },
+                 [idx](Frame& f) { return f.slots[idx]; } };
+    }
+
+    // CASO 2: Acceso a campo, con los índices resueltos de antemano
+    vector<int> path;
+    string t = slot.type;
+    for (size_t k = 1; k < parts.size(); ++k) {
+        int index = 0;
+        t = tipoCampo(t, parts[k], index);
+        path.push_back(index);
+    }
+    bool global = slot.global;
+    auto campo = [G, global, idx, path](Frame& f) -> const Value& {
+        const Value* cur = global ? &(*G)[idx] : &f.slots[idx];
+        for (int k : path) {
+            if (cur->kind != Value::STRUCT) {
+                cerr << "Error: acceso a campo de un valor que no es struct." << endl;
+                exit(1);
+            }
+            cur = &cur->fields[k];
+        }
+        return *cur;
+    };
+    return { [campo](Frame& f) { return valorEntero(campo(f)); },
+             [campo](Frame& f) { return campo(f); } };
+}
+
+ClosureEngine::CExp ClosureEngine::compilarBinaria(BinaryExp* e) {
+    int lk = kindEstatico(e->left), rk = kindEstatico(e->right);
+    bool enteros = (lk == Value::INT || lk == Value::BOOL) && (rk == Value::INT || rk == Value::BOOL);
+    if (!enteros) {
+        // Operandos unsigned/float (o de clase desconocida): semántica tipada sobre Value
+        ValFn lv = compilar(e->left).v;
+        ValFn rv = compilar(e->right).v;
+        BinaryOp bop = e->op;
+        ValFn v = [lv, rv, bop](Frame& f) {
+            Value a = lv(f);
+            return operarBinaria(bop, a, rv(f));
+        };
+        return { [v](Frame& f) { return valorEntero(v(f)); }, v };
+    }
+
+    IntFn l = compilar(e->left).i;
+    IntFn r = compilar(e->right).i;
+    IntFn op;
+    // El operador se resuelve aquí: cada closure hace una sola operación
+    switch (e->op) {
+        case PLUS_OP:  op = [l, r](Frame& f) { int a = l(f); return a + r(f); }; break;
+        case MINUS_OP: op = [l, r](Frame& f) { int a = l(f); return a - r(f); }; break;
+        case MUL_OP:   op = [l, r](Frame& f) { int a = l(f); return a * r(f); }; break;
+        case DIV_OP:
+            op = [l, r](Frame& f) {
+                int a = l(f);
+                int b = r(f);
+                if (b == 0) { cerr << "Error: Div 0" << endl; exit(1); }
+                return a / b;
+            };
+            break;
+        case GT_OP: op = [l, r](Frame& f) { int a = l(f); return (int)(a > r(f)); }; break;
+        case LT_OP: op = [l, r](Frame& f) { int a = l(f); return (int)(a < r(f)); }; break;
+        case GE_OP: op = [l, r](Frame& f) { int a = l(f); return (int)(a >= r(f)); }; break;
+        case LE_OP: op = [l, r](Frame& f) { int a = l(f); return (int)(a <= r(f)); }; break;
+        case EQ_OP: op = [l, r](Frame& f) { int a = l(f); return (int)(a == r(f)); }; break;
+        case NE_OP: op = [l, r](Frame& f) { int a = l(f); return (int)(a != r(f)); }; break;
+        default:    op = [l, r](Frame& f) { l(f); r(f); return 0; }; break;
+    }
+    return { op, [op](Frame& f) { return Value::make_int(op(f)); } };
+}
+
+ClosureEngine::CExp ClosureEngine::compilarLlamada(FcallExp* e) {
+    auto it = funciones.find(e->name);
+    if (it == funciones.end()) {
+        cerr << "Error: Funcion no declarada " << e->name << endl;
+        exit(1);
+    }
+    CFun* cf = &it->second;
+    vector<ValFn> args;
+    for (size_t k = 0; k < cf->fd->params.size(); ++k) args.push_back(compilar(e->arguments[k]).v);
+
+    auto invocar = [this, cf, args](Frame& f, int& retInt) {
+        vector<Value> vals;
+        vals.reserve(args.size());
+        for (const ValFn& a : args) vals.push_back(a(f));
+        return llamar(cf, vals, retInt);
+    };
+    return {
+        [invocar](Frame& f) { int r = 0; invocar(f, r); return r; },
+        [invocar](Frame& f) { int r = 0; return invocar(f, r); }
+    };
+}
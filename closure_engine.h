@@ -0,0 +1,137 @@
+#ifndef CLOSURE_ENGINE_H
+#define CLOSURE_ENGINE_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "visitor.h"
+
+using namespace std;
+
+class ExtractorInvariantes;
+class EvolucionEscalar;
+class AnalisisPureza;
+
+// ===========================================================
+//  Motor de ejecución por compilación a closures
+//  El AST (ya verificado por el TypeChecker) se convierte UNA vez en
+//  un árbol de funciones C++ pre-especializadas. Cada closure captura
+//  los slots ya resueltos de sus variables y los closures de sus
+//  operandos, así que en ejecución no hay accept() virtual, ni
+//  búsquedas por nombre en el Environment, ni switch sobre el operador.
+//  La salida debe ser idéntica a la de EvalVisitor.
+// ===========================================================
+
+// Registro de activación de una llamada: las variables viven en slots
+// numerados en tiempo de compilación.
+struct Frame {
+    vector<Value> slots;
+    Value ret;              // Valor devuelto si la función retorna un struct o un float
+    int ret_int = 0;        // Valor devuelto (protocolo entero)
+    bool returning = false;
+};
+
+class ClosureEngine {
+public:
+    using IntFn = function<int(Frame&)>;    // Evalúa una expresión como entero
+    using ValFn = function<Value(Frame&)>;  // Evalúa una expresión como Value
+    using StmFn = function<void(Frame&)>;   // Ejecuta una sentencia
+
+    ClosureEngine() = default;
+    // Compila el programa a closures y lo ejecuta (equivalente a EvalVisitor::evaluar)
+    void ejecutar(Program* program);
+
+    int maxRecursion = 0; // Llamadas anidadas permitidas (0: sin límite)
+    // --memo: entradas de la caché de cada función pura (0: sin memoizar)
+    size_t capacidadMemo = 0;
+    const AnalisisPureza* pureza = nullptr;
+    ostream* reporteMemo = nullptr; // --stats: aciertos y fallos por función
+    // --licm: invariantes de cada bucle, calculados en su preheader
+    const ExtractorInvariantes* licm = nullptr;
+    // --scev: bucles de acumulación en forma cerrada
+    const EvolucionEscalar* scev = nullptr;
+
+private:
+    // Expresión compilada: las dos formas que usa el intérprete
+    struct CExp {
+        IntFn i;
+        ValFn v;
+    };
+
+    // Resolución estática de una variable
+    struct Slot {
+        bool global = false;
+        int index = 0;
+        string type;
+    };
+
+    // Función compilada
+    struct CFun {
+        FunDec* fd = nullptr;
+        int nslots = 0;
+        vector<int> paramSlots;
+        vector<Value::Kind> paramKinds;   // Clase declarada de cada parámetro
+        Value::Kind retKind = Value::INT; // Clase declarada del retorno
+        StmFn body;
+        bool compilada = false;
+        bool pura = false;                // Según AnalisisPureza (--memo)
+        TablaMemo memo;                   // Resultados si la función es pura
+    };
+
+    vector<Value> globals;
+    Frame globalFrame;                                // Contexto de los inicializadores globales
+    unordered_map<string, CFun> funciones;
+    unordered_map<string, vector<pair<string, string>>> structDefs; // Struct -> <tipo, campo>
+    unordered_map<string, string> typedefs;           // alias -> tipo
+
+    // Estado de compilación
+    vector<unordered_map<string, Slot>> scopes;       // Ámbitos léxicos de la función actual
+    int nextSlot = 0;
+    bool enGlobal = false;
+    CFun* actual = nullptr;
+    unordered_map<Exp*, int> slotsInvariantes;         // --licm: slot del frame de cada invariante
+
+    // Recursión profunda: "return g(...)" deja g pendiente y llamar() la
+    // ejecuta en el mismo nivel de C++ (trampolín); el resto de llamadas
+    // corre sobre la pila segmentada (pila.h)
+    CFun* colaPendiente = nullptr;
+    vector<Value> argsCola;
+    int profundidad = 0;
+
+    // Helpers de compilación
+    Value valorPorDefecto(const string& type);
+    string resolverTipo(const string& type);
+    string tipoCampo(const string& structName, const string& field, int& index);
+    Slot declarar(const string& name, const string& type);
+    Slot buscar(const string& name);
+    bool esStruct(Exp* e);
+    int kindEstatico(Exp* e);
+    void convertirCampos(Value& v, const string& type);
+    string tipoDeExp(Exp* e);
+
+    void compilarFuncion(CFun& cf);
+    CExp compilar(Exp* e);
+    CExp compilarId(IdExp* e);
+    CExp compilarBinaria(BinaryExp* e);
+    CExp compilarLlamada(FcallExp* e);
+    ValFn compilarInit(InitData* d);
+    StmFn compilarStm(Stm* s);
+    StmFn compilarBody(Body* b);
+    StmFn compilarVarDec(VarDec* vd);
+    StmFn compilarInstanceDec(InstanceDec* ind);
+    StmFn compilarAsignacion(AssignStm* s);
+    StmFn compilarPaso(StepExp* s);
+    StmFn compilarPrintf(PrintfStm* s);
+    StmFn compilarReturn(ReturnStm* s);
+    StmFn compilarCola(Exp* e);
+    StmFn compilarInvariantes(Stm* bucle);
+    function<bool(Frame&)> compilarFormaCerrada(const FormaCerrada* fc);
+
+    // Ejecuta una llamada ya compilada
+    Value llamar(CFun* cf, vector<Value>& args, int& retInt);
+    void ejecutarLlamada(CFun* cf, vector<Value>& args, Frame& nf);
+};
+
+#endif // CLOSURE_ENGINE_H
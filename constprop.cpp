@@ -0,0 +1,430 @@
+#include <climits>
+#include <cstring>
+#include "constprop.h"
+
+using namespace std;
+
+// ==========================================
+// Retículo
+// ==========================================
+
+PropagadorConstantes::Abstracto PropagadorConstantes::constante(const Value& v) {
+    Abstracto a;
+    a.constante = true;
+    a.valor = v;
+    a.clase = v.kind;
+    return a;
+}
+
+PropagadorConstantes::Abstracto PropagadorConstantes::variable(int clase) {
+    Abstracto a;
+    a.clase = clase;
+    return a;
+}
+
+int PropagadorConstantes::claseDe(const Abstracto& a) {
+    return a.constante ? (int)a.valor.kind : a.clase;
+}
+
+bool PropagadorConstantes::iguales(const Value& a, const Value& b) {
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+        case Value::INT:      return a.i == b.i;
+        case Value::UNSIGNED: return a.u == b.u;
+        case Value::BOOL:     return a.b == b.b;
+        case Value::FLOAT:    return memcmp(&a.f, &b.f, sizeof(double)) == 0; // -0.0 y NaN incluidos
+        default:              return false;
+    }
+}
+
+PropagadorConstantes::Abstracto PropagadorConstantes::juntar(const Abstracto& a, const Abstracto& b) {
+    if (a.constante && b.constante && iguales(a.valor, b.valor)) return a;
+    int ca = claseDe(a), cb = claseDe(b);
+    return variable(ca == cb ? ca : -1);
+}
+
+PropagadorConstantes::Entorno PropagadorConstantes::juntar(const Entorno& a, const Entorno& b) {
+    if (!a.alcanzable) return b;
+    if (!b.alcanzable) return a;
+    Entorno r;
+    for (const auto& par : a.vars) {
+        auto it = b.vars.find(par.first);
+        if (it == b.vars.end()) continue;
+        Abstracto j = juntar(par.second, it->second);
+        if (j.constante || j.clase >= 0) r.vars[par.first] = j;
+    }
+    return r;
+}
+
+bool PropagadorConstantes::iguales(const Entorno& a, const Entorno& b) {
+    if (a.alcanzable != b.alcanzable) return false;
+    if (!a.alcanzable) return true;
+    if (a.vars.size() != b.vars.size()) return false;
+    for (const auto& par : a.vars) {
+        auto it = b.vars.find(par.first);
+        if (it == b.vars.end()) return false;
+        const Abstracto& x = par.second;
+        const Abstracto& y = it->second;
+        if (x.constante != y.constante) return false;
+        if (x.constante ? !iguales(x.valor, y.valor) : x.clase != y.clase) return false;
+    }
+    return true;
+}
+
+// Clase tras convertirEscalar hacia destino (-1: desconocida)
+int PropagadorConstantes::convertirClase(int clase, int destino) {
+    if (clase < 0) return -1;
+    if (clase == Value::INT || clase == Value::UNSIGNED) {
+        if (destino == Value::INT || destino == Value::UNSIGNED) return destino;
+        if (destino < 0) return -1;
+    }
+    return clase;
+}
+
+// Misma prueba que if/while/?: del intérprete (vista entera distinta de 0)
+bool PropagadorConstantes::verdadera(const Abstracto& c) {
+    return valorEntero(c.valor) != 0;
+}
+
+// Una expresión con llamadas no se puede sustituir por su valor (printf)
+static bool tieneLlamada(Exp* e) {
+    if (dynamic_cast<FcallExp*>(e)) return true;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return tieneLlamada(b->left) || tieneLlamada(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        return tieneLlamada(t->condition) || tieneLlamada(t->trueExp) || tieneLlamada(t->falseExp);
+    }
+    return false;
+}
+
+// ==========================================
+// Variables y campos
+// ==========================================
+
+bool PropagadorConstantes::esStruct(const string& tipo) const {
+    return structs.count(tipo) > 0;
+}
+
+// Tipo declarado de una variable o de un camino p.x.y ("" si no se conoce)
+string PropagadorConstantes::tipoDe(const string& nombre) const {
+    size_t pos = nombre.find('.');
+    auto it = tipos.find(nombre.substr(0, pos));
+    if (it == tipos.end()) return "";
+    string tipo = it->second;
+    while (pos != string::npos) {
+        size_t sig = nombre.find('.', pos + 1);
+        string campo = nombre.substr(pos + 1, sig == string::npos ? string::npos : sig - pos - 1);
+        auto st = structs.find(tipo);
+        if (st == structs.end()) return "";
+        tipo = "";
+        for (const auto& f : st->second) {
+            if (f.second == campo) tipo = f.first;
+        }
+        pos = sig;
+    }
+    return tipo;
+}
+
+PropagadorConstantes::Abstracto PropagadorConstantes::buscar(const string& nombre, const Entorno& env) const {
+    auto it = env.vars.find(nombre);
+    if (it == env.vars.end() || globales.count(nombre.substr(0, nombre.find('.')))) return variable(-1);
+    return it->second;
+}
+
+// Quita la variable y todos sus campos
+void PropagadorConstantes::olvidar(const string& nombre, Entorno& env) const {
+    string prefijo = nombre + ".";
+    for (auto it = env.vars.begin(); it != env.vars.end();) {
+        if (it->first == nombre || it->first.compare(0, prefijo.size(), prefijo) == 0) it = env.vars.erase(it);
+        else ++it;
+    }
+}
+
+// Valor por defecto de una declaración sin inicializar (createDefaultValue)
+void PropagadorConstantes::porDefecto(const string& nombre, const string& tipo, Entorno& env) const {
+    if (!esStruct(tipo)) {
+        env.vars[nombre] = constante(createDefaultValue(tipo));
+        return;
+    }
+    for (const auto& campo : structs.at(tipo)) porDefecto(nombre + "." + campo.second, campo.first, env);
+}
+
+// Asignación: el destino conserva su clase int/unsigned (como en AssignStm)
+void PropagadorConstantes::asignar(const string& nombre, const Abstracto& a, Entorno& env) {
+    string raiz = nombre.substr(0, nombre.find('.'));
+    if (globales.count(raiz) || !tipos.count(raiz)) return;
+    if (esStruct(tipoDe(nombre))) {
+        olvidar(nombre, env);
+        return;
+    }
+    int destino = claseDe(buscar(nombre, env));
+    Abstracto r;
+    if (a.constante && (destino >= 0 || a.valor.kind == Value::BOOL || a.valor.kind == Value::FLOAT)) {
+        Value v = a.valor;
+        if (destino >= 0) convertirEscalar(v, (Value::Kind)destino);
+        r = constante(v);
+    } else {
+        r = variable(convertirClase(claseDe(a), destino));
+    }
+    if (r.constante || r.clase >= 0) env.vars[nombre] = r;
+    else env.vars.erase(nombre);
+}
+
+// ==========================================
+// Expresiones
+// ==========================================
+
+PropagadorConstantes::Abstracto PropagadorConstantes::evaluar(Exp* e, Entorno& env) {
+    Abstracto r;
+    if (NumberExp* n = dynamic_cast<NumberExp*>(e)) {
+        r = constante(Value::make_int(n->value));
+    } else if (FloatExp* f = dynamic_cast<FloatExp*>(e)) {
+        r = constante(Value::make_float(f->value));
+    } else if (BoolExp* b = dynamic_cast<BoolExp*>(e)) {
+        r = constante(Value::make_bool(b->value));
+    } else if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        r = buscar(id->value, env);
+    } else if (BinaryExp* bin = dynamic_cast<BinaryExp*>(e)) {
+        Abstracto l = evaluar(bin->left, env);
+        Abstracto d = evaluar(bin->right, env);
+        bool flotante = claseDe(l) == Value::FLOAT || claseDe(d) == Value::FLOAT;
+        bool divCero = bin->op == DIV_OP && !flotante && d.constante && valorEntero(d.valor) == 0;
+        if (l.constante && d.constante && !divCero && mismoAncho(bin->op, l.valor, d.valor)) {
+            r = constante(operarBinaria(bin->op, l.valor, d.valor));
+        } else if (bin->op >= GT_OP && bin->op <= NE_OP) {
+            r = variable(Value::INT);
+        } else if (flotante) {
+            r = variable(Value::FLOAT);
+        } else {
+            int cl = claseDe(l), cd = claseDe(d);
+            if (cl < 0 || cd < 0 || cl == Value::STRUCT || cd == Value::STRUCT) r = variable(-1);
+            else if (cl == Value::UNSIGNED || cd == Value::UNSIGNED) r = variable(Value::UNSIGNED);
+            else r = variable(Value::INT);
+        }
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        Abstracto c = evaluar(t->condition, env);
+        condiciones.push_back(t->condition);
+        if (c.constante) {
+            r = evaluar(verdadera(c) ? t->trueExp : t->falseExp, env);
+        } else {
+            r = juntar(evaluar(t->trueExp, env), evaluar(t->falseExp, env));
+            if (r.constante && tieneLlamada(t->condition)) r = variable(claseDe(r));
+        }
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) evaluar(a, env);
+        r = variable(-1);
+    }
+
+    auto it = observado.find(e);
+    if (it == observado.end()) observado[e] = r;
+    else it->second = juntar(it->second, r);
+    return r;
+}
+
+// ==========================================
+// Sentencias
+// ==========================================
+
+void PropagadorConstantes::ejecutar(Body* b, Entorno& env) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) {
+        for (const string& var : vd->vars) {
+            tipos[var] = vd->type;
+            olvidar(var, env);
+            porDefecto(var, vd->type, env);
+        }
+    }
+    for (InstanceDec* ind : b->intances) instancia(ind, env);
+    for (Stm* s : b->stmList) {
+        if (!env.alcanzable) return;
+        ejecutar(s, env);
+    }
+}
+
+void PropagadorConstantes::instancia(InstanceDec* ind, Entorno& env) {
+    auto itVar = ind->vars.begin();
+    auto itVal = ind->values.begin();
+    for (; itVar != ind->vars.end(); ++itVar, ++itVal) {
+        const string& var = *itVar;
+        InitData* init = *itVal;
+        vector<Abstracto> valores;
+        if (init->e) valores.push_back(evaluar(init->e, env));
+        if (init->st) for (Exp* a : init->st->argumentos) valores.push_back(evaluar(a, env));
+
+        tipos[var] = ind->type;
+        olvidar(var, env);
+        if (esStruct(ind->type)) {
+            // Solo un inicializador {..} deja campos conocidos (convertirCampos)
+            if (!init->st) continue;
+            const auto& campos = structs[ind->type];
+            for (size_t k = 0; k < campos.size() && k < valores.size(); ++k) {
+                if (esStruct(campos[k].first)) continue;
+                const Abstracto& a = valores[k];
+                Value::Kind destino = kindDeTipo(campos[k].first);
+                string nombre = var + "." + campos[k].second;
+                if (a.constante) {
+                    Value v = a.valor;
+                    convertirEscalar(v, destino);
+                    env.vars[nombre] = constante(v);
+                } else if (convertirClase(a.clase, destino) >= 0) {
+                    env.vars[nombre] = variable(convertirClase(a.clase, destino));
+                }
+            }
+        } else if (init->e) {
+            const Abstracto& a = valores[0];
+            Value::Kind destino = kindDeTipo(ind->type);
+            if (a.constante) {
+                Value v = a.valor;
+                convertirEscalar(v, destino);
+                env.vars[var] = constante(v);
+            } else if (convertirClase(a.clase, destino) >= 0) {
+                env.vars[var] = variable(convertirClase(a.clase, destino));
+            }
+        }
+    }
+}
+
+// Paso de un for: misma aritmética que EvalVisitor::visit(StepExp)
+void PropagadorConstantes::paso(StepExp* st, Entorno& env) {
+    IdExp* id = dynamic_cast<IdExp*>(st->variable);
+    if (!id) return;
+    Abstracto delta = constante(Value::make_int(st->type == StepExp::DECREMENT ? -1 : 1));
+    if (st->type == StepExp::COMPOUND) delta = evaluar(st->amount, env);
+
+    const string& nombre = id->value;
+    string raiz = nombre.substr(0, nombre.find('.'));
+    if (globales.count(raiz) || !tipos.count(raiz)) return;
+    Abstracto actual = buscar(nombre, env);
+    Abstracto r;
+    if (actual.constante && delta.constante && mismoAncho(PLUS_OP, actual.valor, delta.valor)) {
+        if (actual.valor.kind == Value::INT) {
+            r = constante(Value::make_int(actual.valor.i + valorEntero(delta.valor)));
+        } else {
+            Value v = operarBinaria(PLUS_OP, actual.valor, delta.valor);
+            convertirEscalar(v, actual.valor.kind);
+            r = constante(v);
+        }
+    } else {
+        int ca = claseDe(actual), cd = claseDe(delta);
+        bool enteros = (ca == Value::INT || ca == Value::UNSIGNED) &&
+                       (cd == Value::INT || cd == Value::UNSIGNED || cd == Value::BOOL);
+        r = variable(enteros ? ca : ca == Value::FLOAT ? ca : -1);
+    }
+    if (r.constante || r.clase >= 0) env.vars[nombre] = r;
+    else env.vars.erase(nombre);
+}
+
+// Punto fijo: la entrada de cada vuelta es el meet de la entrada al bucle
+// con la salida del cuerpo; se sale por la condición falsa
+void PropagadorConstantes::bucle(Exp* cond, Body* body, StepExp* st, Entorno& env) {
+    Entorno entrada = env;
+    Entorno actual = env;
+    for (;;) {
+        Abstracto c = evaluar(cond, actual);
+        condiciones.push_back(cond);
+        Entorno cuerpo;
+        cuerpo.alcanzable = false;
+        if (!c.constante || verdadera(c)) {
+            cuerpo = actual;
+            ejecutar(body, cuerpo);
+            if (st && cuerpo.alcanzable) paso(st, cuerpo);
+        }
+        Entorno nuevo = juntar(entrada, cuerpo);
+        if (iguales(nuevo, actual)) {
+            if (c.constante && verdadera(c)) actual.alcanzable = false; // Solo sale por return
+            env = actual;
+            return;
+        }
+        actual = nuevo;
+    }
+}
+
+void PropagadorConstantes::ejecutar(Stm* s, Entorno& env) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        asignar(a->id, evaluar(a->e, env), env);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        instancia(ind, env);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        Abstracto c = evaluar(i->condition, env);
+        condiciones.push_back(i->condition);
+        if (c.constante) {
+            if (verdadera(c)) ejecutar(i->thenBody, env);
+            else ejecutar(i->elseBody, env);
+        } else {
+            Entorno otra = env;
+            ejecutar(i->thenBody, env);
+            ejecutar(i->elseBody, otra);
+            env = juntar(env, otra);
+        }
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        bucle(w->condition, w->body, nullptr, env);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) ejecutar(f->init, env);
+        bucle(f->condition, f->body, f->step, env);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) evaluar(e, env);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        if (r->e) evaluar(r->e, env);
+        env.alcanzable = false;
+    }
+}
+
+// ==========================================
+// Funciones
+// ==========================================
+
+void PropagadorConstantes::funcion(FunDec* fd) {
+    tipos.clear();
+    observado.clear();
+    condiciones.clear();
+    Entorno env;
+    for (ParamDec* p : fd->params) tipos[p->id] = p->type;
+    ejecutar(fd->body, env);
+
+    // Anotar los nodos que tomaron siempre el mismo valor
+    int constantes = 0;
+    for (const auto& par : observado) {
+        Exp* e = par.first;
+        const Abstracto& a = par.second;
+        if (!a.constante) continue;
+        if (!dynamic_cast<IdExp*>(e) && !dynamic_cast<BinaryExp*>(e) && !dynamic_cast<TernaryExp*>(e)) continue;
+        e->claseCont = a.valor.kind;
+        if (a.valor.kind == Value::FLOAT) {
+            e->valorF = a.valor.f;
+        } else {
+            e->valor = valorEntero(a.valor);
+            if (a.valor.kind != Value::UNSIGNED || a.valor.u <= (unsigned)INT_MAX) e->cont = 1;
+        }
+        constantes++;
+    }
+    if (reporte) {
+        unordered_set<Exp*> decididas;
+        for (Exp* c : condiciones) {
+            if (observado[c].constante) decididas.insert(c);
+        }
+        *reporte << "SCCP " << fd->id << ": " << constantes << " expresiones constantes, "
+                 << decididas.size() << " condiciones constantes" << endl;
+    }
+}
+
+void PropagadorConstantes::preparar(Program* program) {
+    structs.clear();
+    globales.clear();
+    for (StructDec* sd : program->strlist) {
+        vector<pair<string, string>>& campos = structs[sd->nombre];
+        for (VarDec* vd : sd->VdList) {
+            for (const string& var : vd->vars) campos.push_back({vd->type, var});
+        }
+    }
+    for (VarDec* vd : program->vdlist) for (const string& var : vd->vars) globales.insert(var);
+    for (InstanceDec* ind : program->intdlist) for (const string& var : ind->vars) globales.insert(var);
+}
+
+void PropagadorConstantes::propagar(Program* program) {
+    preparar(program);
+    for (FunDec* fd : program->fdlist) funcion(fd);
+}
+
+void PropagadorConstantes::propagar(Program* program, FunDec* fd) {
+    preparar(program);
+    funcion(fd);
+}
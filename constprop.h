@@ -0,0 +1,90 @@
+#ifndef CONSTPROP_H
+#define CONSTPROP_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "visitor.h"
+
+using namespace std;
+
+// ===========================================================
+//  Propagación de constantes condicional (--sccp)
+//  Interpretación abstracta de cada función sobre el AST ya verificado:
+//  cada local escalar (y cada campo "p.x" de un struct local) es una
+//  constante tipada (Value int/unsigned/bool/float) o "variable".
+//  1. Declaraciones y asignaciones convierten igual que el intérprete
+//     (createDefaultValue, kindDeTipo, convertirEscalar) y el plegado usa
+//     operarBinaria: la constante es exactamente el valor que calcularía.
+//     Una operación entera que desborda 32 bits queda variable: el código
+//     generado la calcula en 64 y daría otro valor.
+//  2. Con condición constante solo se recorre la rama viva; si no, se
+//     recorren ambas y se juntan los entornos.
+//  3. Bucles: se itera hasta el punto fijo juntando el entorno de entrada
+//     con el del final del cuerpo (y del paso).
+//  Cada IdExp/BinaryExp/TernaryExp alcanzable guarda el meet de los valores
+//  que tomó; si es constante queda anotado en claseCont/valor/valorF.
+//  cont=1 (inmediato para GenCodeVisitor y el IR) solo si es entero y cabe
+//  en int. Globales y parámetros son siempre variables.
+// ===========================================================
+
+class PropagadorConstantes {
+public:
+    void propagar(Program* program);
+    // Solo una función del programa (copias de --specialize)
+    void propagar(Program* program, FunDec* fd);
+
+    ostream* reporte = nullptr; // --stats: constantes y condiciones por función
+
+private:
+    // Valor abstracto: constante o variable (con su clase, si se conoce)
+    struct Abstracto {
+        bool constante = false;
+        Value valor;
+        int clase = -1; // Value::Kind de una variable; -1: desconocida
+    };
+    // Las claves ausentes son variables de clase desconocida
+    struct Entorno {
+        bool alcanzable = true;
+        unordered_map<string, Abstracto> vars;
+    };
+
+    unordered_map<string, vector<pair<string, string>>> structs; // tipo -> (tipo, campo)
+    unordered_set<string> globales;
+
+    // Estado de la función en curso
+    unordered_map<string, string> tipos;      // Tipo declarado de cada local
+    unordered_map<Exp*, Abstracto> observado; // Meet de lo visto en cada nodo alcanzado
+    vector<Exp*> condiciones;                 // Condiciones de if/while/for/?: alcanzadas
+
+    static Abstracto constante(const Value& v);
+    static Abstracto variable(int clase);
+    static int claseDe(const Abstracto& a);
+    static bool iguales(const Value& a, const Value& b);
+    static Abstracto juntar(const Abstracto& a, const Abstracto& b);
+    static Entorno juntar(const Entorno& a, const Entorno& b);
+    static bool iguales(const Entorno& a, const Entorno& b);
+    static int convertirClase(int clase, int destino);
+    static bool verdadera(const Abstracto& c);
+
+    bool esStruct(const string& tipo) const;
+    string tipoDe(const string& nombre) const;
+    Abstracto buscar(const string& nombre, const Entorno& env) const;
+    void olvidar(const string& nombre, Entorno& env) const;
+    void porDefecto(const string& nombre, const string& tipo, Entorno& env) const;
+    void asignar(const string& nombre, const Abstracto& a, Entorno& env);
+
+    Abstracto evaluar(Exp* e, Entorno& env);
+    void ejecutar(Body* b, Entorno& env);
+    void ejecutar(Stm* s, Entorno& env);
+    void instancia(InstanceDec* ind, Entorno& env);
+    void paso(StepExp* st, Entorno& env);
+    void bucle(Exp* cond, Body* body, StepExp* st, Entorno& env);
+    void funcion(FunDec* fd);
+    void preparar(Program* program);
+};
+
+#endif // CONSTPROP_H
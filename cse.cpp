@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstring>
+#include "cse.h"
+
+using namespace std;
+
+// ==========================================
+// Versiones y números de valor
+// ==========================================
+
+int NumeradorValores::versionDe(const string& nombre) {
+    auto it = version.find(nombre);
+    return it == version.end() ? 0 : it->second;
+}
+
+// Escribir p.x renueva también p (las lecturas de campos llevan la versión de la raíz)
+void NumeradorValores::renovar(const string& nombre) {
+    version[nombre] = ++contador;
+    size_t pos = nombre.find('.');
+    if (pos != string::npos) version[nombre.substr(0, pos)] = ++contador;
+}
+
+bool NumeradorValores::calculado(int numero) const {
+    for (const unordered_set<int>& a : ambitos) {
+        if (a.count(numero)) return true;
+    }
+    return false;
+}
+
+int NumeradorValores::numero(const string& clave) {
+    auto it = claves.find(clave);
+    if (it != claves.end()) return it->second;
+    return claves[clave] = ++contador;
+}
+
+// ==========================================
+// Expresiones
+// ==========================================
+
+int NumeradorValores::valor(Exp* e) {
+    if (NumberExp* n = dynamic_cast<NumberExp*>(e)) return numero("n" + to_string(n->value));
+    if (FloatExp* f = dynamic_cast<FloatExp*>(e)) {
+        long bits;
+        memcpy(&bits, &f->value, sizeof(bits));
+        return numero("f" + to_string(bits));
+    }
+    if (BoolExp* b = dynamic_cast<BoolExp*>(e)) return numero(b->value ? "b1" : "b0");
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        string raiz = id->value.substr(0, id->value.find('.'));
+        return numero("v" + id->value + "#" + to_string(versionDe(id->value)) + "#" + to_string(versionDe(raiz)));
+    }
+    if (BinaryExp* bin = dynamic_cast<BinaryExp*>(e)) {
+        int l = valor(bin->left), r = valor(bin->right);
+        bool conmutativa = bin->op == PLUS_OP || bin->op == MUL_OP || bin->op == EQ_OP || bin->op == NE_OP;
+        if (conmutativa && r < l) swap(l, r);
+        int k = numero("(" + to_string(bin->op) + "," + to_string(l) + "," + to_string(r) + ")");
+        if (bin->cont != 1) {
+            if (calculado(k)) {
+                repetidos.insert(k);
+                reutilizadas++;
+            } else {
+                ambitos.back().insert(k);
+            }
+            nodos[k].push_back(bin);
+        }
+        return k;
+    }
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        valor(t->condition);
+        ambitos.emplace_back();
+        valor(t->trueExp);
+        ambitos.back().clear();
+        valor(t->falseExp);
+        ambitos.pop_back();
+        return ++contador;
+    }
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) valor(a);
+        for (const string& g : globales) renovar(g);
+        return ++contador;
+    }
+    return ++contador;
+}
+
+// ==========================================
+// Sentencias
+// ==========================================
+
+void NumeradorValores::escritas(Body* b, unordered_set<string>& vars) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) vars.insert(v);
+    for (InstanceDec* ind : b->intances) escritas(ind, vars);
+    for (Stm* s : b->stmList) escritas(s, vars);
+}
+
+void NumeradorValores::escritas(Stm* s, unordered_set<string>& vars) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        vars.insert(a->id);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) vars.insert(v);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        escritas(i->thenBody, vars);
+        escritas(i->elseBody, vars);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        escritas(w->body, vars);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) escritas(f->init, vars);
+        escritas(f->body, vars);
+        if (f->step) {
+            if (IdExp* id = dynamic_cast<IdExp*>(f->step->variable)) vars.insert(id->value);
+        }
+    }
+}
+
+void NumeradorValores::ejecutar(Body* b) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) renovar(v);
+    for (InstanceDec* ind : b->intances) ejecutar(ind);
+    for (Stm* s : b->stmList) ejecutar(s);
+}
+
+// La condición se numera con las versiones de la cabecera, que son también
+// las de la salida; lo calculado en el cuerpo no sobrevive a la vuelta
+void NumeradorValores::bucle(Exp* cond, Body* body, StepExp* st) {
+    unordered_set<string> vars;
+    escritas(body, vars);
+    if (st) {
+        if (IdExp* id = dynamic_cast<IdExp*>(st->variable)) vars.insert(id->value);
+    }
+    for (const string& v : vars) renovar(v);
+    for (const string& g : globales) renovar(g);
+    valor(cond);
+    unordered_map<string, int> cabecera = version;
+
+    ambitos.emplace_back();
+    ejecutar(body);
+    if (st) {
+        if (st->amount) valor(st->amount);
+        if (IdExp* id = dynamic_cast<IdExp*>(st->variable)) renovar(id->value);
+    }
+    ambitos.pop_back();
+    version = cabecera;
+}
+
+void NumeradorValores::ejecutar(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        valor(a->e);
+        renovar(a->id);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        auto itVar = ind->vars.begin();
+        auto itVal = ind->values.begin();
+        for (; itVar != ind->vars.end(); ++itVar, ++itVal) {
+            InitData* init = *itVal;
+            if (init->e) valor(init->e);
+            if (init->st) for (Exp* e : init->st->argumentos) valor(e);
+            renovar(*itVar);
+        }
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        valor(i->condition);
+        unordered_set<string> vars;
+        escritas(s, vars);
+        unordered_map<string, int> antes = version;
+        ambitos.emplace_back();
+        ejecutar(i->thenBody);
+        ambitos.back().clear();
+        version = antes;
+        ejecutar(i->elseBody);
+        ambitos.pop_back();
+        // Tras la unión: versiones nuevas para lo que escribe cualquiera de las ramas
+        for (const string& v : vars) renovar(v);
+        for (const string& g : globales) renovar(g);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        bucle(w->condition, w->body, nullptr);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) ejecutar(f->init);
+        bucle(f->condition, f->body, f->step);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) valor(e);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        if (r->e) valor(r->e);
+    }
+}
+
+// ==========================================
+// Funciones
+// ==========================================
+
+void NumeradorValores::funcion(FunDec* fd) {
+    contador = 0;
+    version.clear();
+    claves.clear();
+    ambitos.assign(1, unordered_set<int>());
+    nodos.clear();
+    repetidos.clear();
+    reutilizadas = 0;
+    ejecutar(fd->body);
+
+    // Un temporal por clase repetida, en el orden en que aparecen las clases
+    vector<int> clases(repetidos.begin(), repetidos.end());
+    sort(clases.begin(), clases.end());
+    for (size_t k = 0; k < clases.size(); ++k) {
+        for (Exp* e : nodos[clases[k]]) temporalDe[e] = (int)k;
+    }
+    temporalesDe[fd] = (int)clases.size();
+    if (reporte) {
+        *reporte << "CSE " << fd->id << ": " << reutilizadas << " expresiones reutilizadas, "
+                 << clases.size() << " temporales" << endl;
+    }
+}
+
+int NumeradorValores::temporal(Exp* e) const {
+    auto it = temporalDe.find(e);
+    return it == temporalDe.end() ? -1 : it->second;
+}
+
+int NumeradorValores::temporales(FunDec* fd) const {
+    auto it = temporalesDe.find(fd);
+    return it == temporalesDe.end() ? 0 : it->second;
+}
+
+void NumeradorValores::numerar(Program* program) {
+    globales.clear();
+    for (VarDec* vd : program->vdlist) for (const string& var : vd->vars) globales.insert(var);
+    for (InstanceDec* ind : program->intdlist) for (const string& var : ind->vars) globales.insert(var);
+    for (FunDec* fd : program->fdlist) funcion(fd);
+}
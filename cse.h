@@ -0,0 +1,67 @@
+#ifndef CSE_H
+#define CSE_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  Numeración de valores sobre el AST (--cse)
+//  Cada expresión recibe un número de valor: una variable vale lo mismo
+//  mientras no cambie su versión (AssignStm, StepExp y declaraciones la
+//  renuevan; una llamada renueva los globales) y un BinaryExp es el par
+//  de números de sus operandos (ordenado si el operador conmuta).
+//  Las expresiones ya calculadas se guardan en una tabla con ámbitos que
+//  sigue a la dominancia: las ramas de if/?: y el cuerpo de un bucle
+//  abren ámbito; la condición de un bucle domina al cuerpo y a la salida.
+//  A la entrada de un bucle se renuevan las variables que escribe.
+//  Cada clase que se repite en un camino dominante recibe un temporal del
+//  marco (temporal()); GenCodeVisitor guarda ahí el primer resultado y lo
+//  carga en las siguientes apariciones.
+// ===========================================================
+
+class NumeradorValores {
+public:
+    void numerar(Program* program);
+
+    ostream* reporte = nullptr; // --stats: expresiones reutilizadas por función
+
+    // Resultados por nodo para GenCodeVisitor
+    int temporal(Exp* e) const;        // Temporal de su clase (-1 si no se reutiliza)
+    int temporales(FunDec* fd) const;  // Slots del marco que necesita la función
+
+private:
+    unordered_map<Exp*, int> temporalDe;
+    unordered_map<FunDec*, int> temporalesDe;
+
+    unordered_set<string> globales;
+
+    // Estado de la función en curso
+    int contador = 0;                          // Números y versiones frescos
+    unordered_map<string, int> version;        // Versión actual de cada variable/campo
+    unordered_map<string, int> claves;         // Clave estructural -> número de valor
+    vector<unordered_set<int>> ambitos;        // Valores ya calculados por ámbito
+    unordered_map<int, vector<Exp*>> nodos;    // BinaryExp de cada número
+    unordered_set<int> repetidos;              // Números con una aparición dominada
+    int reutilizadas = 0;
+
+    int versionDe(const string& nombre);
+    void renovar(const string& nombre);
+    bool calculado(int numero) const;
+    int numero(const string& clave);
+
+    int valor(Exp* e);
+    void ejecutar(Body* b);
+    void ejecutar(Stm* s);
+    void bucle(Exp* cond, Body* body, StepExp* st);
+    static void escritas(Body* b, unordered_set<string>& vars);
+    static void escritas(Stm* s, unordered_set<string>& vars);
+    void funcion(FunDec* fd);
+};
+
+#endif // CSE_H
@@ -0,0 +1,245 @@
+#include <climits>
+#include "desenrollado.h"
+#include "induccion.h"
+#include "scev.h"
+#include "scev.h"
+
+using namespace std;
+
+static const int COSTO_ROTAR = 16;      // Condición más cara: no se duplica
+static const int PRESUPUESTO = 64;      // Nodos de cuerpo que puede ocupar el desenrollado
+static const int MAX_COPIAS = 16;       // Vueltas de un desenrollado completo
+
+// ==========================================
+// Análisis del bucle
+// ==========================================
+
+void DesenrolladorBucles::escrituras(Body* b, unordered_set<string>& vars) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) vars.insert(v);
+    for (InstanceDec* ind : b->intances) escrituras(ind, vars);
+    for (Stm* s : b->stmList) escrituras(s, vars);
+}
+
+void DesenrolladorBucles::escrituras(Stm* s, unordered_set<string>& vars) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        vars.insert(a->id.substr(0, a->id.find('.')));
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) vars.insert(v);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        escrituras(i->thenBody, vars);
+        escrituras(i->elseBody, vars);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        escrituras(w->body, vars);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) escrituras(f->init, vars);
+        escrituras(f->body, vars);
+        if (f->step) {
+            if (IdExp* id = dynamic_cast<IdExp*>(f->step->variable)) vars.insert(id->value);
+        }
+    }
+}
+
+// Alguna declaración en el cuerpo o en sus bloques anidados
+bool DesenrolladorBucles::declara(Body* b) {
+    if (!b) return false;
+    if (!b->declarations.empty() || !b->intances.empty() || !b->tdlist.empty()) return true;
+    for (Stm* s : b->stmList) if (declara(s)) return true;
+    return false;
+}
+
+bool DesenrolladorBucles::declara(Stm* s) {
+    if (dynamic_cast<InstanceDec*>(s)) return true;
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return declara(i->thenBody) || declara(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return declara(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) return dynamic_cast<InstanceDec*>(f->init) || declara(f->body);
+    return false;
+}
+
+bool DesenrolladorBucles::constante(Exp* e, long& k) {
+    if (NumberExp* n = dynamic_cast<NumberExp*>(e)) {
+        k = n->value;
+        return true;
+    }
+    if (e->cont == 1) {
+        k = e->valor;
+        return true;
+    }
+    return false;
+}
+
+// ==========================================
+// Costo (nodos del AST)
+// ==========================================
+
+int DesenrolladorBucles::costo(Exp* e) {
+    if (!e || e->cont == 1) return 1;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return 1 + costo(b->left) + costo(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return 2 + costo(t->condition) + costo(t->trueExp) + costo(t->falseExp);
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        int n = 4;
+        for (Exp* a : fc->arguments) n += costo(a);
+        return n;
+    }
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return 2 + (st->amount ? costo(st->amount) : 0);
+    return 1;
+}
+
+int DesenrolladorBucles::costo(Body* b) {
+    if (!b) return 0;
+    int n = 0;
+    for (Stm* s : b->stmList) n += costo(s);
+    return n;
+}
+
+int DesenrolladorBucles::costo(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return 1 + costo(a->e);
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        int n = 0;
+        for (Exp* e : p->args) n += 4 + costo(e);
+        return n;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return 2 + costo(i->condition) + costo(i->thenBody) + costo(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return 3 + 2 * costo(w->condition) + costo(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s))
+        return 3 + (f->init ? costo(f->init) : 0) + 2 * costo(f->condition) + costo(f->body) + costo(f->step);
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return 1 + (r->e ? costo(r->e) : 0);
+    return 1;
+}
+
+void DesenrolladorBucles::declaraciones(Body* b) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) tipos[v] = vd->type;
+    for (InstanceDec* ind : b->intances) declaraciones(ind);
+    for (Stm* s : b->stmList) declaraciones(s);
+}
+
+void DesenrolladorBucles::declaraciones(Stm* s) {
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) tipos[v] = ind->type;
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        declaraciones(i->thenBody);
+        declaraciones(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        declaraciones(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) declaraciones(f->init);
+        declaraciones(f->body);
+    }
+}
+
+bool DesenrolladorBucles::esLocalInt(const string& nombre) const {
+    auto it = tipos.find(nombre);
+    return it != tipos.end() && it->second == "int";
+}
+
+// ==========================================
+// Decisión
+// ==========================================
+
+void DesenrolladorBucles::desenrollar(ForStm* f) {
+    // Contador eliminado por --iv: la condición ya no lee el contador
+    if (factor < 2 || (iv && iv->contador(f)) || !f->step || declara(f->body)) return;
+    IdExp* id = dynamic_cast<IdExp*>(f->step->variable);
+    long paso = 0;
+    if (!id || !esLocalInt(id->value)) return;
+    if (f->step->type == StepExp::INCREMENT) paso = 1;
+    else if (f->step->type == StepExp::DECREMENT) paso = -1;
+    else if (!constante(f->step->amount, paso)) return;
+
+    unordered_set<string> escritas;
+    escrituras(f->body, escritas);
+    if (escritas.count(id->value)) return;
+
+    BinaryExp* c = dynamic_cast<BinaryExp*>(f->condition);
+    IdExp* contador = c ? dynamic_cast<IdExp*>(c->left) : nullptr;
+    if (!contador || contador->value != id->value || c->cont == 1) return;
+    bool hacia = ((c->op == LT_OP || c->op == LE_OP) && paso > 0) ||
+                 ((c->op == GT_OP || c->op == GE_OP) && paso < 0);
+    if (!hacia) return;
+    long limite = 0;
+    bool limiteConstante = constante(c->right, limite);
+    if (!limiteConstante) {
+        IdExp* l = dynamic_cast<IdExp*>(c->right);
+        if (!l || l->value == id->value || !esLocalInt(l->value) || escritas.count(l->value)) return;
+    }
+
+    int vuelta = costo(f->body) + costo(f->step);
+    // Init constante del contador: vueltas conocidas
+    long inicio = 0;
+    bool inicioConstante = false;
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(f->init)) {
+        inicioConstante = ind->vars.size() == 1 && ind->vars.front() == id->value && ind->values.front()->e &&
+                          constante(ind->values.front()->e, inicio);
+    } else if (AssignStm* a = dynamic_cast<AssignStm*>(f->init)) {
+        inicioConstante = a->id == id->value && constante(a->e, inicio);
+    }
+    if (inicioConstante && limiteConstante) {
+        long n = EvolucionEscalar::vueltas(c->op, paso, inicio, limite);
+        if (n <= MAX_COPIAS && n * vuelta <= PRESUPUESTO) {
+            bucles[f].copiasCompletas = (int)n;
+            completos++;
+            return;
+        }
+    }
+
+    int copias = factor;
+    while (copias > 1 && copias * vuelta > PRESUPUESTO) copias--;
+    long desplazamiento = (long)(copias - 1) * paso;
+    if (copias < 2 || desplazamiento < INT_MIN || desplazamiento > INT_MAX) return;
+    bucles[f].factor = copias;
+    bucles[f].paso = (int)paso;
+    parciales++;
+}
+
+void DesenrolladorBucles::recorrer(Body* b) {
+    if (!b) return;
+    for (Stm* s : b->stmList) recorrer(s);
+}
+
+void DesenrolladorBucles::recorrer(Stm* s) {
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        recorrer(i->thenBody);
+        recorrer(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        if (scev && scev->forma(w)) return;
+        if (costo(w->condition) <= COSTO_ROTAR) {
+            bucles[w].rotado = true;
+            rotados++;
+        }
+        recorrer(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (scev && scev->forma(f)) return;
+        desenrollar(f);
+        bool completo = bucles.count(f) && bucles[f].copiasCompletas >= 0;
+        if (!completo && ((iv && iv->contador(f)) || costo(f->condition) <= COSTO_ROTAR)) {
+            bucles[f].rotado = true;
+            rotados++;
+        }
+        recorrer(f->body);
+    }
+}
+
+void DesenrolladorBucles::funcion(FunDec* fd) {
+    tipos.clear();
+    for (ParamDec* p : fd->params) tipos[p->id] = p->type;
+    declaraciones(fd->body);
+    rotados = 0;
+    completos = 0;
+    parciales = 0;
+    recorrer(fd->body);
+    if (reporte) {
+        *reporte << "UNROLL " << fd->id << ": " << rotados << " bucles rotados, " << completos
+                 << " desenrollados por completo, " << parciales << " desenrollados con resto" << endl;
+    }
+}
+
+const BucleDesenrollado* DesenrolladorBucles::bucle(Stm* s) const {
+    auto it = bucles.find(s);
+    return it == bucles.end() ? nullptr : &it->second;
+}
+
+void DesenrolladorBucles::desenrollar(Program* program) {
+    for (FunDec* fd : program->fdlist) funcion(fd);
+}
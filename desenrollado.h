@@ -0,0 +1,87 @@
+#ifndef DESENROLLADO_H
+#define DESENROLLADO_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "ast.h"
+
+using namespace std;
+
+class ReductorInducciones;
+class EvolucionEscalar;
+
+// Decisión sobre un bucle. rotado: condición repetida al final del cuerpo.
+// Desenrollado (solo for): copiasCompletas >= 0 reemplaza el bucle por
+// tantas copias de cuerpo + step; factor > 1 ejecuta factor vueltas por
+// iteración mientras quepan (contador + (factor-1)*paso) y el resto en el
+// bucle rotado
+struct BucleDesenrollado {
+    bool rotado = false;
+    int copiasCompletas = -1;
+    int factor = 0;
+    int paso = 0;
+};
+
+// ===========================================================
+//  Rotación y desenrollado de bucles (--rotate, --unroll[=F])
+//  Rotación: GenCodeVisitor evalúa la condición una vez antes de entrar y
+//  la repite al final del cuerpo con un salto condicional hacia atrás, en
+//  lugar de condición arriba + jmp incondicional (un salto por vuelta en
+//  vez de dos). Se rota si la condición es barata de duplicar.
+//  Desenrollado (solo con --unroll), en un for contado: contador int que
+//  solo cambia el step (constante), condición "i <op> L" hacia L con L
+//  constante o local int que el bucle no escribe, y cuerpo sin
+//  declaraciones (cada una tiene un único slot en el marco):
+//    - con init y L constantes, si vueltas * costo cabe en el presupuesto,
+//      el bucle se reemplaza por sus vueltas copias de cuerpo + step;
+//    - si no, el bucle principal ejecuta F copias por iteración mientras
+//      quepan F vueltas más y el resto va al bucle rotado. F baja hasta
+//      que F * costo cabe en el presupuesto (F < 2: solo rotación).
+//  El costo es el número de nodos del AST (las llamadas y printf pesan
+//  más). Solo lo usa GenCodeVisitor (bucle()); los intérpretes no lo ven.
+// ===========================================================
+
+class DesenrolladorBucles {
+public:
+    void desenrollar(Program* program);
+
+    int factor = 0;             // Vueltas por iteración (0: solo rotar)
+    ostream* reporte = nullptr; // --stats: bucles rotados y desenrollados por función
+    // --iv: un for sin contador (condición sobre la derivada) no se desenrolla
+    const ReductorInducciones* iv = nullptr;
+    // --scev: los bucles en forma cerrada no se generan
+    const EvolucionEscalar* scev = nullptr;
+
+    // Decisión tomada para un WhileStm/ForStm (nullptr: se genera como está)
+    const BucleDesenrollado* bucle(Stm* s) const;
+
+private:
+    unordered_map<Stm*, BucleDesenrollado> bucles;
+
+    // Estado de la función en curso
+    unordered_map<string, string> tipos; // Tipo declarado de cada local
+    int rotados = 0;
+    int completos = 0;
+    int parciales = 0;
+
+    static void escrituras(Body* b, unordered_set<string>& vars);
+    static void escrituras(Stm* s, unordered_set<string>& vars);
+    static bool declara(Body* b);
+    static bool declara(Stm* s);
+    static bool constante(Exp* e, long& k);
+    static int costo(Exp* e);
+    static int costo(Body* b);
+    static int costo(Stm* s);
+    void declaraciones(Body* b);
+    void declaraciones(Stm* s);
+    bool esLocalInt(const string& nombre) const;
+
+    void desenrollar(ForStm* f);
+    void recorrer(Body* b);
+    void recorrer(Stm* s);
+    void funcion(FunDec* fd);
+};
+
+#endif // DESENROLLADO_H
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+#include "elf_writer.h"
+
+using namespace std;
+
+// ==========================================
+// Constantes ELF64 usadas
+// ==========================================
+static const uint16_t ET_REL = 1, ET_EXEC = 2, EM_X86_64 = 62;
+static const uint32_t SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3, SHT_RELA = 4;
+static const uint64_t SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4, SHF_INFO_LINK = 0x40;
+static const uint8_t STB_LOCAL = 0, STB_GLOBAL = 1;
+static const uint8_t STT_NOTYPE = 0, STT_FUNC = 2, STT_SECTION = 3;
+static const uint32_t R_X86_64_PC32 = 2, R_X86_64_PLT32 = 4;
+static const uint32_t PT_LOAD = 1, PT_GNU_STACK = 0x6474e551;
+static const uint64_t BASE_EXE = 0x400000;
+
+// Buffer little-endian
+struct Bytes {
+    vector<uint8_t> b;
+    void u8(uint8_t v) { b.push_back(v); }
+    void u16(uint16_t v) { for (int k = 0; k < 2; ++k) b.push_back((uint8_t)(v >> (8 * k))); }
+    void u32(uint32_t v) { for (int k = 0; k < 4; ++k) b.push_back((uint8_t)(v >> (8 * k))); }
+    void u64(uint64_t v) { for (int k = 0; k < 8; ++k) b.push_back((uint8_t)(v >> (8 * k))); }
+    void datos(const vector<uint8_t>& v) { b.insert(b.end(), v.begin(), v.end()); }
+    void alinear(size_t a) { while (b.size() % a) b.push_back(0); }
+};
+
+// Tabla de cadenas (.strtab / .shstrtab)
+struct Cadenas {
+    vector<uint8_t> b{0};
+    uint32_t agregar(const string& s) {
+        uint32_t pos = (uint32_t)b.size();
+        b.insert(b.end(), s.begin(), s.end());
+        b.push_back(0);
+        return pos;
+    }
+};
+
+static void cabecera(Bytes& out, uint16_t tipo, uint64_t entrada, uint64_t phoff, uint16_t phnum,
+                     uint64_t shoff, uint16_t shnum, uint16_t shstrndx) {
+    const uint8_t ident[16] = {0x7F, 'E', 'L', 'F', 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    for (uint8_t c : ident) out.u8(c);
+    out.u16(tipo);
+    out.u16(EM_X86_64);
+    out.u32(1);
+    out.u64(entrada);
+    out.u64(phoff);
+    out.u64(shoff);
+    out.u32(0);
+    out.u16(64);
+    out.u16(phnum ? 56 : 0);
+    out.u16(phnum);
+    out.u16(shnum ? 64 : 0);
+    out.u16(shnum);
+    out.u16(shstrndx);
+}
+
+static void seccion(Bytes& out, uint32_t nombre, uint32_t tipo, uint64_t flags, uint64_t offset,
+                    uint64_t tam, uint32_t link, uint32_t info, uint64_t alin, uint64_t entsize) {
+    out.u32(nombre);
+    out.u32(tipo);
+    out.u64(flags);
+    out.u64(0);
+    out.u64(offset);
+    out.u64(tam);
+    out.u32(link);
+    out.u32(info);
+    out.u64(alin);
+    out.u64(entsize);
+}
+
+static bool guardar(const Bytes& out, const string& ruta, string& err) {
+    ofstream f(ruta, ios::binary);
+    if (!f.is_open()) {
+        err = "no se pudo crear " + ruta;
+        return false;
+    }
+    f.write((const char*)out.b.data(), out.b.size());
+    return true;
+}
+
+// ==========================================
+// Objeto reubicable
+// ==========================================
+
+bool escribirObjetoElf(const X86Encoder& enc, const string& ruta, string& err) {
+    // Índices de sección
+    enum { S_NULL, S_TEXT, S_DATA, S_RELA, S_SYMTAB, S_STRTAB, S_SHSTRTAB, S_NOTE, S_TOTAL };
+
+    struct Simbolo {
+        string nombre;
+        uint8_t info;
+        uint16_t shndx;
+        uint64_t valor;
+    };
+    const vector<string>& globales = enc.globales();
+    auto esGlobal = [&](const string& n) { return find(globales.begin(), globales.end(), n) != globales.end(); };
+
+    // Locales: secciones y todas las etiquetas no globales (como hace as)
+    vector<Simbolo> locales = {
+        {"", (uint8_t)((STB_LOCAL << 4) | STT_SECTION), S_TEXT, 0},
+        {"", (uint8_t)((STB_LOCAL << 4) | STT_SECTION), S_DATA, 0}
+    };
+    vector<Simbolo> publicos;
+    vector<pair<size_t, string>> texto, datos;
+    for (const auto& e : enc.etiquetasTexto()) texto.push_back({e.second, e.first});
+    for (const auto& e : enc.etiquetasDeDatos()) datos.push_back({e.second, e.first});
+    sort(texto.begin(), texto.end());
+    sort(datos.begin(), datos.end());
+    for (const auto& e : texto) {
+        if (esGlobal(e.second)) publicos.push_back({e.second, (uint8_t)((STB_GLOBAL << 4) | STT_FUNC), S_TEXT, e.first});
+        else locales.push_back({e.second, (uint8_t)((STB_LOCAL << 4) | STT_NOTYPE), S_TEXT, e.first});
+    }
+    for (const auto& e : datos)
+        locales.push_back({e.second, (uint8_t)((STB_LOCAL << 4) | STT_NOTYPE), S_DATA, e.first});
+
+    // Externos: símbolos indefinidos globales
+    vector<string> externos;
+    for (const auto& p : enc.pendientes()) {
+        if (enc.etiquetaDatos(p.simbolo) >= 0) continue;
+        if (!p.llamada) {
+            err = "referencia rip-relativa a simbolo externo: " + p.simbolo;
+            return false;
+        }
+        if (find(externos.begin(), externos.end(), p.simbolo) == externos.end()) externos.push_back(p.simbolo);
+    }
+    for (const string& e : externos) publicos.push_back({e, (uint8_t)((STB_GLOBAL << 4) | STT_NOTYPE), 0, 0});
+
+    // .symtab / .strtab
+    Cadenas strtab;
+    Bytes symtab;
+    for (int k = 0; k < 24; ++k) symtab.u8(0); // Símbolo nulo
+    unordered_map<string, uint32_t> indiceExterno;
+    uint32_t idx = 1;
+    auto agregar = [&](const Simbolo& s) {
+        symtab.u32(s.nombre.empty() ? 0 : strtab.agregar(s.nombre));
+        symtab.u8(s.info);
+        symtab.u8(0);
+        symtab.u16(s.shndx);
+        symtab.u64(s.valor);
+        symtab.u64(0);
+        if (s.shndx == 0) indiceExterno[s.nombre] = idx;
+        idx++;
+    };
+    for (const Simbolo& s : locales) agregar(s);
+    uint32_t primerGlobal = idx;
+    for (const Simbolo& s : publicos) agregar(s);
+
+    // .rela.text (el símbolo de sección .data es el índice 2)
+    Bytes rela;
+    for (const auto& p : enc.pendientes()) {
+        long d = enc.etiquetaDatos(p.simbolo);
+        uint64_t sym, tipo;
+        int64_t addend;
+        if (d >= 0) { sym = 2; tipo = R_X86_64_PC32; addend = d - 4; }
+        else { sym = indiceExterno[p.simbolo]; tipo = R_X86_64_PLT32; addend = -4; }
+        rela.u64(p.pos);
+        rela.u64((sym << 32) | tipo);
+        rela.u64((uint64_t)addend);
+    }
+
+    Cadenas shstr;
+    uint32_t nText = shstr.agregar(".text"), nData = shstr.agregar(".data");
+    uint32_t nRela = shstr.agregar(".rela.text"), nSym = shstr.agregar(".symtab");
+    uint32_t nStr = shstr.agregar(".strtab"), nShstr = shstr.agregar(".shstrtab");
+    uint32_t nNote = shstr.agregar(".note.GNU-stack");
+
+    // Disposición del archivo
+    Bytes out;
+    out.b.resize(64);
+    out.alinear(16);
+    uint64_t offText = out.b.size(); out.datos(enc.codigo());
+    out.alinear(16);
+    uint64_t offData = out.b.size(); out.datos(enc.datos());
+    out.alinear(8);
+    uint64_t offRela = out.b.size(); out.datos(rela.b);
+    out.alinear(8);
+    uint64_t offSym = out.b.size(); out.datos(symtab.b);
+    uint64_t offStr = out.b.size(); out.datos(strtab.b);
+    uint64_t offShstr = out.b.size(); out.datos(shstr.b);
+    out.alinear(8);
+    uint64_t offSh = out.b.size();
+
+    seccion(out, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    seccion(out, nText, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, offText, enc.codigo().size(), 0, 0, 16, 0);
+    seccion(out, nData, SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, offData, enc.datos().size(), 0, 0, 16, 0);
+    seccion(out, nRela, SHT_RELA, SHF_INFO_LINK, offRela, rela.b.size(), S_SYMTAB, S_TEXT, 8, 24);
+    seccion(out, nSym, SHT_SYMTAB, 0, offSym, symtab.b.size(), S_STRTAB, primerGlobal, 8, 24);
+    seccion(out, nStr, SHT_STRTAB, 0, offStr, strtab.b.size(), 0, 0, 1, 0);
+    seccion(out, nShstr, SHT_STRTAB, 0, offShstr, shstr.b.size(), 0, 0, 1, 0);
+    seccion(out, nNote, SHT_PROGBITS, 0, offSh, 0, 0, 0, 1, 0);
+
+    Bytes cab;
+    cabecera(cab, ET_REL, 0, 0, 0, offSh, S_TOTAL, S_SHSTRTAB);
+    copy(cab.b.begin(), cab.b.end(), out.b.begin());
+    return guardar(out, ruta, err);
+}
+
+// ==========================================
+// Ejecutable estático
+// ==========================================
+
+// _start llama a main y sale con su valor; printf imprime %rsi como
+// entero con signo seguido de '\n' (write en la pila)
+static const char* RUNTIME =
+    ".text\n"
+    "_start:\n"
+    "    call main\n"
+    "    movq %rax, %rdi\n"
+    "    movq $60, %rax\n"
+    "    syscall\n"
+    "printf:\n"
+    "    pushq %rbp\n"
+    "    movq %rsp, %rbp\n"
+    "    subq $32, %rsp\n"
+    "    movq %rsi, %rax\n"
+    "    leaq -1(%rbp), %rdi\n"
+    "    movb $10, (%rdi)\n"
+    "    movq $1, %r8\n"
+    "    movq $0, %r9\n"
+    "    cmpq $0, %rax\n"
+    "    jge .rt_digitos\n"
+    "    negq %rax\n"
+    "    movq $1, %r9\n"
+    ".rt_digitos:\n"
+    "    movq $0, %rdx\n"
+    "    movq $10, %rcx\n"
+    "    divq %rcx\n"
+    "    addq $48, %rdx\n"
+    "    decq %rdi\n"
+    "    movb %dl, (%rdi)\n"
+    "    incq %r8\n"
+    "    cmpq $0, %rax\n"
+    "    jne .rt_digitos\n"
+    "    cmpq $0, %r9\n"
+    "    je .rt_escribir\n"
+    "    decq %rdi\n"
+    "    movb $45, (%rdi)\n"
+    "    incq %r8\n"
+    ".rt_escribir:\n"
+    "    movq %rdi, %rsi\n"
+    "    movq %r8, %rdx\n"
+    "    movq $1, %rdi\n"
+    "    movq $1, %rax\n"
+    "    syscall\n"
+    "    leave\n"
+    "    ret\n";
+
+bool escribirEjecutableElf(const AsmBuffer& codigo, const string& ruta, string& err) {
+    AsmBuffer buf = codigo;
+    if (!buf.leerTexto(RUNTIME, err)) return false;
+    X86Encoder enc;
+    vector<uint8_t> imagen;
+    if (!enc.ensamblar(buf) || !enc.enlazarLocal({}, imagen)) {
+        err = enc.error();
+        return false;
+    }
+
+    // Un solo PT_LOAD (R+X) con cabeceras, código y datos de solo lectura
+    const uint64_t offCodigo = 64 + 2 * 56;
+    Bytes out;
+    cabecera(out, ET_EXEC, BASE_EXE + offCodigo + enc.etiqueta("_start"), 64, 2, 0, 0, 0);
+    uint64_t total = offCodigo + imagen.size();
+    out.u32(PT_LOAD); out.u32(5);
+    out.u64(0); out.u64(BASE_EXE); out.u64(BASE_EXE);
+    out.u64(total); out.u64(total); out.u64(0x1000);
+    out.u32(PT_GNU_STACK); out.u32(6);
+    out.u64(0); out.u64(0); out.u64(0); out.u64(0); out.u64(0); out.u64(16);
+    out.datos(imagen);
+
+    if (!guardar(out, ruta, err)) return false;
+    chmod(ruta.c_str(), 0755);
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef ELF_WRITER_H
+#define ELF_WRITER_H
+
+#include <string>
+#include "x86_encoder.h"
+
+using namespace std;
+
+// ===========================================================
+//  Emisión directa de ELF64 (x86-64) sin as/ld
+//  - Objeto reubicable (.o): .text, .data, .rela.text, .symtab y
+//    .strtab; printf queda como símbolo indefinido (R_X86_64_PLT32) y
+//    las referencias a .data como R_X86_64_PC32. Se enlaza con gcc/ld.
+//  - Ejecutable estático: el código se enlaza con un runtime mínimo
+//    (_start y un printf que solo implementa el "%ld\n" que emite
+//    GenCodeVisitor, ambos con syscalls), sin libc.
+// ===========================================================
+
+// enc debe venir de ensamblar() sin enlazar
+bool escribirObjetoElf(const X86Encoder& enc, const string& ruta, string& err);
+// codigo es el buffer de GenCodeVisitor
+bool escribirEjecutableElf(const AsmBuffer& codigo, const string& ruta, string& err);
+
+#endif // ELF_WRITER_H
@@ -48,6 +48,15 @@ public:
         ribs.back()[var] = value;
     }
 
+    // Agrega una variable tomando el valor por movimiento (sin copiarlo)
+    void add_var(const string& var, T&& value) {
+        if (ribs.empty()) {
+            cerr << "[Error] Environment sin niveles: no se pueden agregar variables.\n";
+            exit(EXIT_FAILURE);
+        }
+        ribs.back()[var] = std::move(value);
+    }
+
     // Agrega una variable con valor por defecto (solo si T es numérico o tiene constructor por defecto)
     void add_var(const string& var) {
         if (ribs.empty()) {
@@ -90,6 +99,14 @@ public:
         return ribs[idx].at(x);
     }
 
+    // Devuelve un puntero al valor almacenado (sin copiarlo), o nullptr si no existe.
+    // El puntero sigue siendo válido mientras exista el nivel que contiene la variable.
+    T* lookup_ptr(const string& x) {
+        int idx = search_rib(x);
+        if (idx < 0) return nullptr;
+        return &ribs[idx].at(x);
+    }
+
     // Busca y devuelve el valor en una referencia. Devuelve true si existe.
     bool lookup(const string& x, T& v) const {
         int idx = search_rib(x);
@@ -0,0 +1,431 @@
+#include <algorithm>
+#include "especializacion.h"
+#include "constprop.h"
+#include "visitor.h"
+
+using namespace std;
+
+static const int MIN_SITIOS = 2;  // Sitios con el mismo patrón
+static const int MAX_COPIAS = 4;  // Copias por función
+
+// ==========================================
+// Medidas
+// ==========================================
+
+// Nodos que genera: de un if o ?: con condición constante solo la rama viva
+int EspecializadorFunciones::costo(Exp* e) {
+    if (!e || e->cont == 1) return 1;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return 1 + costo(b->left) + costo(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        if (t->condition->cont == 1) return costo(t->condition->valor != 0 ? t->trueExp : t->falseExp);
+        return 2 + costo(t->condition) + costo(t->trueExp) + costo(t->falseExp);
+    }
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        int n = 4;
+        for (Exp* a : fc->arguments) n += costo(a);
+        return n;
+    }
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return 2 + (st->amount ? costo(st->amount) : 0);
+    return 1;
+}
+
+int EspecializadorFunciones::costo(Body* b) {
+    if (!b) return 0;
+    int n = 0;
+    for (VarDec* vd : b->declarations) n += vd->vars.size();
+    for (InstanceDec* ind : b->intances) n += costo(ind);
+    for (Stm* s : b->stmList) n += costo(s);
+    return n;
+}
+
+int EspecializadorFunciones::costo(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return 1 + costo(a->e);
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        int n = 0;
+        for (InitData* init : ind->values) n += 1 + (init->e ? costo(init->e) : 0);
+        return n;
+    }
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        int n = 0;
+        for (Exp* e : p->args) n += 4 + costo(e);
+        return n;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        if (i->condition->cont == 1) return costo(i->condition->valor != 0 ? i->thenBody : i->elseBody);
+        return 2 + costo(i->condition) + costo(i->thenBody) + costo(i->elseBody);
+    }
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        if (w->condition->cont == 1 && w->condition->valor == 0) return 0;
+        return 3 + costo(w->condition) + costo(w->body);
+    }
+    if (ForStm* f = dynamic_cast<ForStm*>(s))
+        return 3 + (f->init ? costo(f->init) : 0) + costo(f->condition) + costo(f->body) + costo(f->step);
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return 1 + (r->e ? costo(r->e) : 0);
+    return 1;
+}
+
+// Nodos que la propagación dejó constantes: condiciones decididas,
+// operaciones plegadas y variables leídas como inmediatos
+int EspecializadorFunciones::plegadas(Exp* e) {
+    if (!e) return 0;
+    if (e->cont == 1) return dynamic_cast<NumberExp*>(e) || dynamic_cast<BoolExp*>(e) ? 0 : 1;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return plegadas(b->left) + plegadas(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return plegadas(t->condition) + plegadas(t->trueExp) + plegadas(t->falseExp);
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        int n = 0;
+        for (Exp* a : fc->arguments) n += plegadas(a);
+        return n;
+    }
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return plegadas(st->amount);
+    return 0;
+}
+
+int EspecializadorFunciones::plegadas(Body* b) {
+    if (!b) return 0;
+    int n = 0;
+    for (InstanceDec* ind : b->intances) n += plegadas(ind);
+    for (Stm* s : b->stmList) n += plegadas(s);
+    return n;
+}
+
+int EspecializadorFunciones::plegadas(Stm* s) {
+    // Una condición constante cuenta aunque sea un IdExp
+    auto condicion = [](Exp* c) { return c->cont == 1 ? 1 : plegadas(c); };
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return plegadas(a->e);
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        int n = 0;
+        for (InitData* init : ind->values) n += plegadas(init->e);
+        return n;
+    }
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        int n = 0;
+        for (Exp* e : p->args) n += plegadas(e);
+        return n;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s))
+        return condicion(i->condition) + plegadas(i->thenBody) + plegadas(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return condicion(w->condition) + plegadas(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s))
+        return (f->init ? plegadas(f->init) : 0) + condicion(f->condition) + plegadas(f->step) + plegadas(f->body);
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return plegadas(r->e);
+    return 0;
+}
+
+// ==========================================
+// Copia de la función
+// ==========================================
+
+// Lo que la propagación de constantes sabe del original vale en la copia.
+// Las anotaciones de --licm no se copian: la copia no tiene preheaders
+Exp* EspecializadorFunciones::clonar(Exp* e) {
+    if (!e) return nullptr;
+    Exp* c = nullptr;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        c = new IdExp(id->value);
+    } else if (NumberExp* n = dynamic_cast<NumberExp*>(e)) {
+        c = new NumberExp(n->value);
+    } else if (FloatExp* f = dynamic_cast<FloatExp*>(e)) {
+        c = new FloatExp(f->value);
+    } else if (BoolExp* b = dynamic_cast<BoolExp*>(e)) {
+        c = new BoolExp(b->value);
+    } else if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        c = new BinaryExp(clonar(b->left), clonar(b->right), b->op);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        TernaryExp* n = new TernaryExp();
+        n->condition = clonar(t->condition);
+        n->trueExp = clonar(t->trueExp);
+        n->falseExp = clonar(t->falseExp);
+        c = n;
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        vector<Exp*> args;
+        for (Exp* a : fc->arguments) args.push_back(clonar(a));
+        c = new FcallExp(fc->name, args);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        c = new StepExp(clonar(st->variable), st->type, clonar(st->amount));
+    }
+    c->cont = e->cont;
+    c->valor = e->valor;
+    c->claseCont = e->claseCont;
+    c->valorF = e->valorF;
+    return c;
+}
+
+InstanceDec* EspecializadorFunciones::clonar(InstanceDec* ind) {
+    InstanceDec* c = new InstanceDec();
+    c->type = ind->type;
+    c->vars = ind->vars;
+    for (InitData* d : ind->values) {
+        InitData* n = new InitData();
+        n->e = clonar(d->e);
+        n->st = nullptr;
+        if (d->st) {
+            n->st = new StructInit();
+            for (Exp* a : d->st->argumentos) n->st->argumentos.push_back(clonar(a));
+        }
+        c->values.push_back(n);
+    }
+    return c;
+}
+
+Body* EspecializadorFunciones::clonar(Body* b) {
+    if (!b) return nullptr;
+    Body* c = new Body();
+    for (TypedefDec* td : b->tdlist) c->tdlist.push_back(new TypedefDec(td->typeName, td->alias));
+    for (VarDec* vd : b->declarations) {
+        VarDec* n = new VarDec();
+        n->type = vd->type;
+        n->vars = vd->vars;
+        c->declarations.push_back(n);
+    }
+    for (InstanceDec* ind : b->intances) c->intances.push_back(clonar(ind));
+    for (Stm* s : b->stmList) c->stmList.push_back(clonar(s));
+    return c;
+}
+
+Stm* EspecializadorFunciones::clonar(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return new AssignStm(a->id, clonar(a->e));
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) return clonar(ind);
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        list<Exp*> args;
+        for (Exp* e : p->args) args.push_back(clonar(e));
+        return new PrintfStm(p->format, args);
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return new IfStm(clonar(i->condition), clonar(i->thenBody), clonar(i->elseBody));
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return new WhileStm(clonar(w->condition), clonar(w->body));
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        StepExp* step = f->step ? static_cast<StepExp*>(clonar(f->step)) : nullptr;
+        return new ForStm(f->init ? clonar(f->init) : nullptr, clonar(f->condition), step, clonar(f->body));
+    }
+    ReturnStm* r = static_cast<ReturnStm*>(s);
+    return new ReturnStm(clonar(r->e));
+}
+
+// Parámetros fijos como locales inicializados al entrar. Van primeros en
+// intances: los inicializadores del cuerpo pueden leerlos y corren antes
+// que cualquier sentencia
+FunDec* EspecializadorFunciones::copiar(const Patron& p) {
+    FunDec* fd = p.fd;
+    // Los nombres con '.' son campos de struct (y --inline los usa de prefijo)
+    string nombre;
+    do nombre = fd->id + "_esp" + to_string(++siguiente); while (funciones.count(nombre));
+    FunDec* copia = new FunDec(fd->type, nombre, {}, clonar(fd->body));
+    auto inicio = copia->body->intances.begin();
+    size_t k = 0;
+    for (size_t i = 0; i < fd->params.size(); ++i) {
+        ParamDec* param = fd->params[i];
+        if (k < p.fijos.size() && p.fijos[k].first == (int)i) {
+            InstanceDec* ind = new InstanceDec();
+            ind->type = param->type;
+            ind->vars.push_back(param->id);
+            InitData* d = new InitData();
+            d->e = new NumberExp(p.fijos[k].second);
+            d->st = nullptr;
+            ind->values.push_back(d);
+            copia->body->intances.insert(inicio, ind);
+            k++;
+        } else {
+            copia->params.push_back(new ParamDec(param->type, param->id));
+        }
+    }
+    return copia;
+}
+
+// ==========================================
+// Sitios de llamada
+// ==========================================
+
+void EspecializadorFunciones::llamadas(Exp* e, const function<void(FcallExp*)>& f) {
+    if (!e) return;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        llamadas(b->left, f);
+        llamadas(b->right, f);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        llamadas(t->condition, f);
+        llamadas(t->trueExp, f);
+        llamadas(t->falseExp, f);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        llamadas(st->amount, f);
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) llamadas(a, f);
+        f(fc);
+    }
+}
+
+void EspecializadorFunciones::llamadas(Body* b, const function<void(FcallExp*)>& f) {
+    if (!b) return;
+    for (InstanceDec* ind : b->intances) llamadas(ind, f);
+    for (Stm* s : b->stmList) llamadas(s, f);
+}
+
+void EspecializadorFunciones::llamadas(Stm* s, const function<void(FcallExp*)>& f) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        llamadas(a->e, f);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* d : ind->values) {
+            llamadas(d->e, f);
+            if (d->st) for (Exp* a : d->st->argumentos) llamadas(a, f);
+        }
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* a : p->args) llamadas(a, f);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        llamadas(i->condition, f);
+        llamadas(i->thenBody, f);
+        llamadas(i->elseBody, f);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        llamadas(w->condition, f);
+        llamadas(w->body, f);
+    } else if (ForStm* fs = dynamic_cast<ForStm*>(s)) {
+        if (fs->init) llamadas(fs->init, f);
+        llamadas(fs->condition, f);
+        llamadas(fs->step, f);
+        llamadas(fs->body, f);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        llamadas(r->e, f);
+    }
+}
+
+// Argumentos constantes de la llamada para parámetros int, unsigned o
+// bool (nullptr si la función no se puede especializar)
+FunDec* EspecializadorFunciones::constantes(FcallExp* fc, vector<pair<int, int>>& fijos) const {
+    fijos.clear();
+    auto it = funciones.find(fc->name);
+    if (it == funciones.end()) return nullptr;
+    FunDec* fd = it->second;
+    if (fd->id == "main" || !fd->body || fd->params.size() != fc->arguments.size()) return nullptr;
+    for (size_t i = 0; i < fd->params.size(); ++i) {
+        Exp* a = fc->arguments[i];
+        Value::Kind kind = kindDeTipo(fd->params[i]->type);
+        if (a->cont != 1 || a->claseCont == Value::FLOAT || dynamic_cast<FloatExp*>(a)) continue;
+        if (kind != Value::INT && kind != Value::UNSIGNED && kind != Value::BOOL) continue;
+        fijos.push_back({(int)i, a->valor});
+    }
+    return fd;
+}
+
+string EspecializadorFunciones::clave(FunDec* fd, int pos, int valor) {
+    return fd->id + "/" + to_string(pos) + "=" + to_string(valor);
+}
+
+// Todos los argumentos fijos del patrón están entre los de la llamada
+bool EspecializadorFunciones::incluido(const vector<pair<int, int>>& patron, const vector<pair<int, int>>& fijos) {
+    for (const auto& f : patron) if (find(fijos.begin(), fijos.end(), f) == fijos.end()) return false;
+    return true;
+}
+
+void EspecializadorFunciones::especializar(Program* program) {
+    funciones.clear();
+    patrones.clear();
+    porFuncion.clear();
+    unordered_map<string, int> argumentos; // "f/1=3" -> sitios con ese argumento constante
+    for (FunDec* fd : program->fdlist) funciones[fd->id] = fd;
+
+    // Argumentos constantes repetidos, y de cada llamada los suyos como candidato
+    int total = 0;
+    vector<pair<int, int>> fijos;
+    for (FunDec* fd : program->fdlist) {
+        total += costo(fd->body);
+        llamadas(fd->body, [&](FcallExp* fc) {
+            FunDec* g = constantes(fc, fijos);
+            if (g) for (const auto& f : fijos) argumentos[clave(g, f.first, f.second)]++;
+        });
+    }
+    for (FunDec* fd : program->fdlist) {
+        llamadas(fd->body, [&](FcallExp* fc) {
+            FunDec* g = constantes(fc, fijos);
+            if (!g) return;
+            string k = g->id;
+            vector<pair<int, int>> repetidos;
+            for (const auto& f : fijos) {
+                string a = clave(g, f.first, f.second);
+                if (argumentos[a] < MIN_SITIOS) continue;
+                repetidos.push_back(f);
+                k += a.substr(g->id.size());
+            }
+            if (repetidos.empty() || patrones.count(k)) return;
+            Patron& p = patrones[k];
+            p.fd = g;
+            p.fijos = repetidos;
+            p.primero = (int)patrones.size();
+            porFuncion[g].push_back(&p);
+        });
+    }
+    // Sitios de cada patrón: llamadas que fijan al menos sus argumentos
+    for (FunDec* fd : program->fdlist) {
+        llamadas(fd->body, [&](FcallExp* fc) {
+            FunDec* g = constantes(fc, fijos);
+            if (!g || fijos.empty()) return;
+            for (Patron* p : porFuncion[g]) if (incluido(p->fijos, fijos)) p->sitios++;
+        });
+    }
+
+    // Los patrones más repetidos primero; a igualdad, los que fijan más
+    vector<Patron*> orden;
+    for (auto& p : patrones) if (p.second.sitios >= MIN_SITIOS) orden.push_back(&p.second);
+    sort(orden.begin(), orden.end(), [](Patron* a, Patron* b) {
+        if (a->sitios != b->sitios) return a->sitios > b->sitios;
+        if (a->fijos.size() != b->fijos.size()) return a->fijos.size() > b->fijos.size();
+        return a->primero < b->primero;
+    });
+
+    int presupuesto = total * crecimiento / 100;
+    int usado = 0;
+    unordered_map<FunDec*, int> copias;
+    PropagadorConstantes propagador;
+    for (Patron* p : orden) {
+        if (copias[p->fd] >= MAX_COPIAS) continue;
+        FunDec* copia = copiar(*p);
+        propagador.propagar(program, copia);
+        int c = costo(copia->body);
+        int ganancia = plegadas(copia->body) - plegadas(p->fd->body);
+        if (ganancia <= 0 || usado + c > presupuesto) {
+            delete copia;
+            continue;
+        }
+        usado += c;
+        copias[p->fd]++;
+        p->copia = copia;
+        auto pos = find(program->fdlist.begin(), program->fdlist.end(), p->fd);
+        program->fdlist.insert(++pos, copia);
+        funciones[copia->id] = copia;
+        if (reporte) {
+            *reporte << "ESPECIALIZACION " << copia->id << ": " << p->fd->id << "(";
+            size_t k = 0;
+            for (size_t i = 0; i < p->fd->params.size(); ++i) {
+                if (i) *reporte << ", ";
+                if (k < p->fijos.size() && p->fijos[k].first == (int)i) *reporte << p->fijos[k++].second;
+                else *reporte << "_";
+            }
+            *reporte << ") en " << p->sitios << " sitios, " << ganancia << " nodos constantes más, costo " << c << endl;
+        }
+    }
+
+    // Redirigir cada llamada (las de las copias incluidas) a la copia que
+    // fija más de sus argumentos, sin los argumentos fijos
+    int redirigidas = 0;
+    for (FunDec* fd : program->fdlist) {
+        llamadas(fd->body, [&](FcallExp* fc) {
+            FunDec* g = constantes(fc, fijos);
+            if (!g || fijos.empty()) return;
+            Patron* mejor = nullptr;
+            for (Patron* p : porFuncion[g]) {
+                if (!p->copia || !incluido(p->fijos, fijos)) continue;
+                if (!mejor || p->fijos.size() > mejor->fijos.size()) mejor = p;
+            }
+            if (!mejor) return;
+            vector<Exp*> args;
+            size_t j = 0;
+            for (size_t i = 0; i < fc->arguments.size(); ++i) {
+                if (j < mejor->fijos.size() && mejor->fijos[j].first == (int)i) j++;
+                else args.push_back(fc->arguments[i]);
+            }
+            fc->name = mejor->copia->id;
+            fc->arguments = args;
+            redirigidas++;
+        });
+    }
+    if (reporte && usado) {
+        *reporte << "ESPECIALIZACION: " << redirigidas << " llamadas redirigidas, crecimiento " << usado << " de "
+                 << presupuesto << " nodos" << endl;
+    }
+}
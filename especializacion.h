@@ -0,0 +1,81 @@
+#ifndef ESPECIALIZACION_H
+#define ESPECIALIZACION_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  Especialización de funciones (--specialize[=N])
+//  Una función llamada desde varios sitios con los mismos argumentos
+//  constantes se copia con esos parámetros fijos:
+//      dibujar(x, 1); ... dibujar(y, 1);   =>   dibujar_esp1(x); ... dibujar_esp1(y);
+//  En la copia cada parámetro fijo pasa a ser un local asignado al
+//  principio ("modo = 1;") y la propagación de constantes (--sccp) corre
+//  sobre ella: las condiciones que quedan decididas solo generan su rama
+//  viva.
+//  Patrón de un sitio: posiciones y valores de sus argumentos constantes
+//  (parámetros int, unsigned o bool) que aparecen en al menos MIN_SITIOS
+//  sitios. Un patrón cubre las llamadas que fijan al menos esos
+//  argumentos; se especializa si cubre MIN_SITIOS sitios y en la copia
+//  quedan más nodos constantes que en el original (condiciones,
+//  operaciones, lecturas del parámetro como inmediato). Cada llamada va
+//  a la copia que fija más de sus argumentos. Costo: nodos vivos de la copia; el
+//  total no pasa del N% de los nodos del programa (100 por defecto) y
+//  cada función tiene a lo sumo MAX_COPIAS copias.
+//  Después se redirigen todos los sitios con el patrón, también los de
+//  las copias (recursión que mantiene el argumento fijo).
+//  Corre tras el intérprete: solo lo ve la generación de código.
+// ===========================================================
+
+static const int CRECIMIENTO_ESPECIALIZACION = 100;
+
+class EspecializadorFunciones {
+public:
+    void especializar(Program* program);
+
+    int crecimiento = CRECIMIENTO_ESPECIALIZACION; // % de los nodos del programa
+    ostream* reporte = nullptr; // --stats: copias creadas
+
+private:
+    struct Patron {
+        FunDec* fd = nullptr;
+        vector<pair<int, int>> fijos; // (posición del parámetro, valor)
+        int sitios = 0;
+        int primero = 0;              // Orden de aparición (desempate)
+        FunDec* copia = nullptr;
+    };
+    unordered_map<string, FunDec*> funciones;
+    unordered_map<string, Patron> patrones; // "f/1=3/2=0" -> patrón
+    unordered_map<FunDec*, vector<Patron*>> porFuncion;
+    int siguiente = 0; // Numera las copias (f_espN)
+
+    static int costo(Exp* e);
+    static int costo(Body* b);
+    static int costo(Stm* s);
+    static int plegadas(Exp* e);
+    static int plegadas(Body* b);
+    static int plegadas(Stm* s);
+
+    static Exp* clonar(Exp* e);
+    static Body* clonar(Body* b);
+    static Stm* clonar(Stm* s);
+    static InstanceDec* clonar(InstanceDec* ind);
+
+    // Cada llamada, después de las de sus argumentos
+    static void llamadas(Exp* e, const function<void(FcallExp*)>& f);
+    static void llamadas(Body* b, const function<void(FcallExp*)>& f);
+    static void llamadas(Stm* s, const function<void(FcallExp*)>& f);
+
+    FunDec* constantes(FcallExp* fc, vector<pair<int, int>>& fijos) const;
+    static string clave(FunDec* fd, int pos, int valor);
+    static bool incluido(const vector<pair<int, int>>& patron, const vector<pair<int, int>>& fijos);
+    FunDec* copiar(const Patron& p);
+};
+
+#endif // ESPECIALIZACION_H
@@ -0,0 +1,691 @@
+#include <algorithm>
+#include "expansion.h"
+
+using namespace std;
+
+static const int DIMINUTA = 12;        // Se expande siempre
+static const int EN_BUCLE = 40;        // Dentro de un bucle
+static const int UNICA = 120;          // Única llamada del programa
+static const int CRECIMIENTO = 400;    // Nodos expandidos por función
+static const int MAX_PROFUNDIDAD = 3;  // Expansiones dentro de lo expandido
+
+static string raizDe(const string& nombre) {
+    return nombre.substr(0, nombre.find('.'));
+}
+
+// ==========================================
+// Análisis de las funciones
+// ==========================================
+
+void ExpansorEnLinea::nombres(Exp* e, unordered_set<string>& vars) {
+    if (!e) return;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        vars.insert(raizDe(id->value));
+    } else if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        nombres(b->left, vars);
+        nombres(b->right, vars);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        nombres(t->condition, vars);
+        nombres(t->trueExp, vars);
+        nombres(t->falseExp, vars);
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) nombres(a, vars);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        nombres(st->variable, vars);
+        nombres(st->amount, vars);
+    }
+}
+
+void ExpansorEnLinea::nombres(Body* b, unordered_set<string>& vars) {
+    if (!b) return;
+    for (InstanceDec* ind : b->intances) nombres(ind, vars);
+    for (Stm* s : b->stmList) nombres(s, vars);
+}
+
+void ExpansorEnLinea::nombres(Stm* s, unordered_set<string>& vars) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        vars.insert(raizDe(a->id));
+        nombres(a->e, vars);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* init : ind->values) {
+            if (init->e) nombres(init->e, vars);
+            if (init->st) for (Exp* e : init->st->argumentos) nombres(e, vars);
+        }
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) nombres(e, vars);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        nombres(i->condition, vars);
+        nombres(i->thenBody, vars);
+        nombres(i->elseBody, vars);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        nombres(w->condition, vars);
+        nombres(w->body, vars);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) nombres(f->init, vars);
+        nombres(f->condition, vars);
+        nombres(f->step, vars);
+        nombres(f->body, vars);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        nombres(r->e, vars);
+    }
+}
+
+void ExpansorEnLinea::escrituras(Body* b, unordered_set<string>& vars) {
+    if (!b) return;
+    for (Stm* s : b->stmList) escrituras(s, vars);
+}
+
+void ExpansorEnLinea::escrituras(Stm* s, unordered_set<string>& vars) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        vars.insert(raizDe(a->id));
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        escrituras(i->thenBody, vars);
+        escrituras(i->elseBody, vars);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        escrituras(w->body, vars);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) escrituras(f->init, vars);
+        escrituras(f->body, vars);
+        if (f->step) {
+            if (IdExp* id = dynamic_cast<IdExp*>(f->step->variable)) vars.insert(raizDe(id->value));
+        }
+    }
+}
+
+// Locales con su tipo; soloInt queda en false si hay algo que la copia no
+// sabe declarar (structs, typedef, for con varias variables)
+void ExpansorEnLinea::locales(Body* b, unordered_map<string, string>& tipos, bool& soloInt) {
+    if (!b) return;
+    if (!b->tdlist.empty()) soloInt = false;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) tipos[v] = vd->type;
+    for (InstanceDec* ind : b->intances) {
+        for (const string& v : ind->vars) tipos[v] = ind->type;
+        for (InitData* init : ind->values) if (!init->e || init->st) soloInt = false;
+    }
+    for (Stm* s : b->stmList) locales(s, tipos, soloInt);
+}
+
+void ExpansorEnLinea::locales(Stm* s, unordered_map<string, string>& tipos, bool& soloInt) {
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        locales(i->thenBody, tipos, soloInt);
+        locales(i->elseBody, tipos, soloInt);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        locales(w->body, tipos, soloInt);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (InstanceDec* ind = dynamic_cast<InstanceDec*>(f->init)) {
+            for (const string& v : ind->vars) tipos[v] = ind->type;
+            if (ind->vars.size() != 1 || !ind->values.front()->e || ind->values.front()->st) soloInt = false;
+        }
+        locales(f->body, tipos, soloInt);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) tipos[v] = ind->type;
+        soloInt = false;
+    }
+}
+
+void ExpansorEnLinea::contarLlamadas(Exp* e, unordered_map<string, int>& cuenta) {
+    if (!e) return;
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        cuenta[fc->name]++;
+        for (Exp* a : fc->arguments) contarLlamadas(a, cuenta);
+    } else if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        contarLlamadas(b->left, cuenta);
+        contarLlamadas(b->right, cuenta);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        contarLlamadas(t->condition, cuenta);
+        contarLlamadas(t->trueExp, cuenta);
+        contarLlamadas(t->falseExp, cuenta);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        contarLlamadas(st->amount, cuenta);
+    }
+}
+
+void ExpansorEnLinea::contarLlamadas(Body* b, unordered_map<string, int>& cuenta) {
+    if (!b) return;
+    for (InstanceDec* ind : b->intances) contarLlamadas(ind, cuenta);
+    for (Stm* s : b->stmList) contarLlamadas(s, cuenta);
+}
+
+void ExpansorEnLinea::contarLlamadas(Stm* s, unordered_map<string, int>& cuenta) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        contarLlamadas(a->e, cuenta);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* init : ind->values) {
+            if (init->e) contarLlamadas(init->e, cuenta);
+            if (init->st) for (Exp* e : init->st->argumentos) contarLlamadas(e, cuenta);
+        }
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) contarLlamadas(e, cuenta);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        contarLlamadas(i->condition, cuenta);
+        contarLlamadas(i->thenBody, cuenta);
+        contarLlamadas(i->elseBody, cuenta);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        contarLlamadas(w->condition, cuenta);
+        contarLlamadas(w->body, cuenta);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) contarLlamadas(f->init, cuenta);
+        contarLlamadas(f->condition, cuenta);
+        contarLlamadas(f->step, cuenta);
+        contarLlamadas(f->body, cuenta);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        contarLlamadas(r->e, cuenta);
+    }
+}
+
+bool ExpansorEnLinea::hayLlamada(Exp* e) {
+    unordered_map<string, int> cuenta;
+    contarLlamadas(e, cuenta);
+    return !cuenta.empty();
+}
+
+bool ExpansorEnLinea::hayPrintf(Body* b) {
+    if (!b) return false;
+    for (Stm* s : b->stmList) if (hayPrintf(s)) return true;
+    return false;
+}
+
+bool ExpansorEnLinea::hayPrintf(Stm* s) {
+    if (dynamic_cast<PrintfStm*>(s)) return true;
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return hayPrintf(i->thenBody) || hayPrintf(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return hayPrintf(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) return hayPrintf(f->body);
+    return false;
+}
+
+// Costo: nodos del AST (llamadas y printf pesan más)
+int ExpansorEnLinea::costo(Exp* e) {
+    if (!e || e->cont == 1) return 1;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return 1 + costo(b->left) + costo(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return 2 + costo(t->condition) + costo(t->trueExp) + costo(t->falseExp);
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        int n = 4;
+        for (Exp* a : fc->arguments) n += costo(a);
+        return n;
+    }
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return 2 + (st->amount ? costo(st->amount) : 0);
+    return 1;
+}
+
+int ExpansorEnLinea::costo(Body* b) {
+    if (!b) return 0;
+    int n = 0;
+    for (VarDec* vd : b->declarations) n += vd->vars.size();
+    for (InstanceDec* ind : b->intances) n += costo(ind);
+    for (Stm* s : b->stmList) n += costo(s);
+    return n;
+}
+
+int ExpansorEnLinea::costo(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return 1 + costo(a->e);
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        int n = 0;
+        for (InitData* init : ind->values) n += 1 + (init->e ? costo(init->e) : 0);
+        return n;
+    }
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        int n = 0;
+        for (Exp* e : p->args) n += 4 + costo(e);
+        return n;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return 2 + costo(i->condition) + costo(i->thenBody) + costo(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return 3 + costo(w->condition) + costo(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s))
+        return 3 + (f->init ? costo(f->init) : 0) + costo(f->condition) + costo(f->body) + costo(f->step);
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return 1 + (r->e ? costo(r->e) : 0);
+    return 1;
+}
+
+// ==========================================
+// Returns como asignaciones al resultado
+// ==========================================
+
+// Todo camino de la lista acaba en return (los bucles no cuentan)
+bool ExpansorEnLinea::termina(const list<Stm*>& stms) {
+    for (Stm* s : stms) {
+        if (dynamic_cast<ReturnStm*>(s)) return true;
+        IfStm* i = dynamic_cast<IfStm*>(s);
+        if (i && i->elseBody && termina(i->thenBody->stmList) && termina(i->elseBody->stmList)) return true;
+    }
+    return false;
+}
+
+bool ExpansorEnLinea::hayReturn(Body* b) {
+    if (!b) return false;
+    for (Stm* s : b->stmList) if (hayReturn(s)) return true;
+    return false;
+}
+
+bool ExpansorEnLinea::hayReturn(Stm* s) {
+    if (dynamic_cast<ReturnStm*>(s)) return true;
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return hayReturn(i->thenBody) || hayReturn(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return hayReturn(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) return hayReturn(f->body);
+    return false;
+}
+
+// "return e" => "resultado = e" y lo que sigue a un if con una rama que
+// termina pasa a la otra rama. Falla con returns dentro de bucles o en
+// ramas que no cierran todos sus caminos
+bool ExpansorEnLinea::estructurar(list<Stm*>& stms, const string& resultado) {
+    for (auto it = stms.begin(); it != stms.end(); ++it) {
+        if (ReturnStm* r = dynamic_cast<ReturnStm*>(*it)) {
+            if (!r->e) return false;
+            *it = new AssignStm(resultado, r->e);
+            r->e = nullptr;
+            delete r;
+            for (auto k = next(it); k != stms.end(); k = stms.erase(k)) delete *k;
+            return true;
+        }
+        IfStm* i = dynamic_cast<IfStm*>(*it);
+        if (!i) {
+            if (hayReturn(*it)) return false;
+            continue;
+        }
+        if (!hayReturn(i)) continue;
+        bool terminaThen = termina(i->thenBody->stmList);
+        bool terminaElse = i->elseBody && termina(i->elseBody->stmList);
+        if (!terminaThen && !terminaElse) return false;
+        list<Stm*> resto;
+        resto.splice(resto.end(), stms, next(it), stms.end());
+        if (terminaThen && terminaElse) {
+            for (Stm* s : resto) delete s;
+        } else {
+            if (!i->elseBody) i->elseBody = new Body();
+            Body* sigue = terminaThen ? i->elseBody : i->thenBody;
+            sigue->stmList.splice(sigue->stmList.end(), resto);
+        }
+        return estructurar(i->thenBody->stmList, resultado) && estructurar(i->elseBody->stmList, resultado);
+    }
+    return true;
+}
+
+// ==========================================
+// Copia del cuerpo
+// ==========================================
+
+// Argumento sustituido (IdExp o NumberExp de la función que llama)
+Exp* ExpansorEnLinea::copiar(Exp* e) {
+    Exp* c;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) c = new IdExp(id->value);
+    else c = new NumberExp(static_cast<NumberExp*>(e)->value);
+    c->cont = e->cont;
+    c->valor = e->valor;
+    c->claseCont = e->claseCont;
+    c->valorF = e->valorF;
+    return c;
+}
+
+Exp* ExpansorEnLinea::clonar(Exp* e) {
+    if (!e) return nullptr;
+    Exp* c = nullptr;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        auto s = sustituciones.find(id->value);
+        if (s != sustituciones.end()) return copiar(s->second);
+        string raiz = raizDe(id->value);
+        auto r = renombres.find(raiz);
+        c = new IdExp(r == renombres.end() ? id->value : r->second + id->value.substr(raiz.size()));
+    } else if (NumberExp* n = dynamic_cast<NumberExp*>(e)) {
+        c = new NumberExp(n->value);
+    } else if (FloatExp* f = dynamic_cast<FloatExp*>(e)) {
+        c = new FloatExp(f->value);
+    } else if (BoolExp* b = dynamic_cast<BoolExp*>(e)) {
+        c = new BoolExp(b->value);
+    } else if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        c = new BinaryExp(clonar(b->left), clonar(b->right), b->op);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        TernaryExp* n = new TernaryExp();
+        n->condition = clonar(t->condition);
+        n->trueExp = clonar(t->trueExp);
+        n->falseExp = clonar(t->falseExp);
+        c = n;
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        vector<Exp*> args;
+        for (Exp* a : fc->arguments) args.push_back(clonar(a));
+        c = new FcallExp(fc->name, args);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        c = new StepExp(clonar(st->variable), st->type, clonar(st->amount));
+    }
+    // Lo que la propagación de constantes sabe del original vale en la copia
+    c->cont = e->cont;
+    c->valor = e->valor;
+    c->claseCont = e->claseCont;
+    c->valorF = e->valorF;
+    return c;
+}
+
+// Las declaraciones pasan a ser asignaciones (las variables renombradas se
+// declaran en la función que llama)
+Body* ExpansorEnLinea::clonar(Body* b) {
+    if (!b) return nullptr;
+    auto nombre = [&](const string& v) {
+        auto r = renombres.find(v);
+        return r == renombres.end() ? v : r->second;
+    };
+    Body* c = new Body();
+    for (VarDec* vd : b->declarations)
+        for (const string& v : vd->vars) c->stmList.push_back(new AssignStm(nombre(v), new NumberExp(0)));
+    for (InstanceDec* ind : b->intances) {
+        auto val = ind->values.begin();
+        for (const string& v : ind->vars) c->stmList.push_back(new AssignStm(nombre(v), clonar((*val++)->e)));
+    }
+    for (Stm* s : b->stmList) c->stmList.push_back(clonar(s));
+    return c;
+}
+
+Stm* ExpansorEnLinea::clonar(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        string raiz = raizDe(a->id);
+        auto r = renombres.find(raiz);
+        string id = r == renombres.end() ? a->id : r->second + a->id.substr(raiz.size());
+        return new AssignStm(id, clonar(a->e));
+    }
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        // Init de un for: una sola variable int
+        const string& v = ind->vars.front();
+        auto r = renombres.find(v);
+        return new AssignStm(r == renombres.end() ? v : r->second, clonar(ind->values.front()->e));
+    }
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        list<Exp*> args;
+        for (Exp* e : p->args) args.push_back(clonar(e));
+        return new PrintfStm(p->format, args);
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return new IfStm(clonar(i->condition), clonar(i->thenBody), clonar(i->elseBody));
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return new WhileStm(clonar(w->condition), clonar(w->body));
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        StepExp* step = f->step ? static_cast<StepExp*>(clonar(f->step)) : nullptr;
+        return new ForStm(f->init ? clonar(f->init) : nullptr, clonar(f->condition), step, clonar(f->body));
+    }
+    ReturnStm* r = static_cast<ReturnStm*>(s);
+    return new ReturnStm(clonar(r->e));
+}
+
+void ExpansorEnLinea::analizar(Program* program) {
+    funciones.clear();
+    unordered_map<string, int> cuenta;
+    unordered_map<string, unordered_map<string, int>> llama;
+    for (FunDec* fd : program->fdlist) {
+        contarLlamadas(fd->body, cuenta);
+        contarLlamadas(fd->body, llama[fd->id]);
+    }
+    for (FunDec* fd : program->fdlist) {
+        Candidata& c = funciones[fd->id];
+        c.fd = fd;
+        c.costo = costo(fd->body);
+        c.llamadas = cuenta[fd->id];
+        c.imprime = hayPrintf(fd->body);
+
+        unordered_map<string, string> tipos;
+        bool soloInt = fd->type == "int";
+        for (ParamDec* p : fd->params) {
+            tipos[p->id] = p->type;
+            if (p->type != "int") soloInt = false;
+        }
+        locales(fd->body, tipos, soloInt);
+        for (auto& t : tipos) if (t.second != "int") soloInt = false;
+        unordered_set<string> usadas;
+        nombres(fd->body, usadas);
+        for (const string& v : usadas) if (!tipos.count(v)) soloInt = false; // Global
+        if (fd->id == "main" || !soloInt || !termina(fd->body->stmList)) continue;
+
+        // Las copias salen del cuerpo sin expandir; se prueba con una
+        renombres.clear();
+        sustituciones.clear();
+        c.plantilla = clonar(fd->body);
+        Body* prueba = clonar(c.plantilla);
+        c.valida = estructurar(prueba->stmList, "$");
+        delete prueba;
+        escrituras(fd->body, c.escritas);
+        for (auto& t : tipos) {
+            bool esParametro = false;
+            for (ParamDec* p : fd->params) esParametro = esParametro || p->id == t.first;
+            if (!esParametro) c.locales.push_back(t.first);
+        }
+        sort(c.locales.begin(), c.locales.end());
+    }
+    // printf en lo que llama (las funciones desconocidas pueden imprimir)
+    for (bool cambio = true; cambio;) {
+        cambio = false;
+        for (auto& f : funciones) {
+            if (f.second.imprime) continue;
+            for (auto& l : llama[f.first]) {
+                auto g = funciones.find(l.first);
+                if (g == funciones.end() || g->second.imprime) {
+                    f.second.imprime = cambio = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// ==========================================
+// Expansión
+// ==========================================
+
+bool ExpansorEnLinea::conviene(const string& nombre) const {
+    auto it = funciones.find(nombre);
+    if (it == funciones.end() || !it->second.valida) return false;
+    const Candidata& c = it->second;
+    if (nombre == actual->id || find(pila.begin(), pila.end(), nombre) != pila.end()) return false;
+    if ((int)pila.size() >= MAX_PROFUNDIDAD) return false;
+    int limite = c.llamadas == 1 ? UNICA : bucles > 0 ? EN_BUCLE : DIMINUTA;
+    return c.costo <= limite && crecimiento + c.costo <= CRECIMIENTO;
+}
+
+// Sentencias que calculan call en 'resultado' (vacío: un temporal nuevo)
+string ExpansorEnLinea::expandirLlamada(FcallExp* call, const string& resultado, list<Stm*>& antes) {
+    Candidata& c = funciones[call->name];
+    FunDec* fd = c.fd;
+    string prefijo = fd->id + "$" + to_string(++siguiente);
+    auto declarar = [&](const string& v) {
+        nuevas->vars.push_back(v);
+        enteros.insert(v);
+    };
+    string destino = resultado;
+    if (destino.empty()) {
+        destino = prefijo;
+        declarar(destino);
+    }
+
+    renombres.clear();
+    sustituciones.clear();
+    for (size_t k = 0; k < fd->params.size(); ++k) {
+        const string& p = fd->params[k]->id;
+        Exp* arg = call->arguments[k];
+        IdExp* id = dynamic_cast<IdExp*>(arg);
+        bool directo = dynamic_cast<NumberExp*>(arg) || (id && enteros.count(id->value));
+        if (directo && !c.escritas.count(p)) {
+            sustituciones[p] = arg;
+            continue;
+        }
+        string v = prefijo + "$" + p;
+        declarar(v);
+        renombres[p] = v;
+        antes.push_back(new AssignStm(v, arg));
+    }
+    for (const string& l : c.locales) {
+        string v = prefijo + "$" + l;
+        declarar(v);
+        renombres[l] = v;
+    }
+    Body* copia = clonar(c.plantilla);
+    estructurar(copia->stmList, destino);
+    for (auto& s : sustituciones) delete s.second;
+    call->arguments.clear();
+    list<Stm*> cuerpo;
+    cuerpo.splice(cuerpo.end(), copia->stmList);
+    delete copia;
+
+    c.expandida = true;
+    crecimiento += c.costo;
+    expandidas++;
+    pila.push_back(fd->id);
+    expandir(cuerpo);
+    pila.pop_back();
+    antes.splice(antes.end(), cuerpo);
+    return destino;
+}
+
+// Expande las llamadas de e en orden de evaluación hasta la primera que no
+// puede adelantarse
+void ExpansorEnLinea::adelantar(Exp*& e, bool& barrera, bool sinPrintf, list<Stm*>& antes) {
+    if (!e || barrera || e->cont == 1) return;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        adelantar(b->left, barrera, sinPrintf, antes);
+        adelantar(b->right, barrera, sinPrintf, antes);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        adelantar(t->condition, barrera, sinPrintf, antes);
+        if (hayLlamada(t->trueExp) || hayLlamada(t->falseExp)) barrera = true;
+    } else if (FcallExp* call = dynamic_cast<FcallExp*>(e)) {
+        for (Exp*& a : call->arguments) adelantar(a, barrera, sinPrintf, antes);
+        if (barrera) return;
+        if (!conviene(call->name) || (sinPrintf && funciones[call->name].imprime)) {
+            barrera = true;
+            return;
+        }
+        e = new IdExp(expandirLlamada(call, "", antes));
+        delete call;
+    }
+}
+
+// Devuelve true si s queda absorbida por la expansión ("x = f(...)")
+bool ExpansorEnLinea::adelantar(Stm* s, list<Stm*>& antes) {
+    bool barrera = false;
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        FcallExp* call = dynamic_cast<FcallExp*>(a->e);
+        if (call && a->e->cont != 1 && enteros.count(a->id)) {
+            for (Exp*& arg : call->arguments) adelantar(arg, barrera, false, antes);
+            if (barrera || !conviene(call->name)) return false;
+            expandirLlamada(call, a->id, antes);
+            return true;
+        }
+        adelantar(a->e, barrera, false, antes);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        // Cada argumento se imprime antes de evaluar el siguiente
+        bool primero = true;
+        for (Exp*& e : p->args) {
+            adelantar(e, barrera, !primero, antes);
+            primero = false;
+        }
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        adelantar(r->e, barrera, false, antes);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        adelantar(i->condition, barrera, false, antes);
+        expandir(i->thenBody);
+        expandir(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        bucles++;
+        expandir(w->body);
+        bucles--;
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        // El init se ejecuta una vez antes del bucle
+        if (AssignStm* a = dynamic_cast<AssignStm*>(f->init)) adelantar(a->e, barrera, false, antes);
+        else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(f->init)) {
+            for (InitData* init : ind->values) if (init->e) adelantar(init->e, barrera, false, antes);
+        }
+        bucles++;
+        expandir(f->body);
+        bucles--;
+    }
+    return false;
+}
+
+void ExpansorEnLinea::expandir(list<Stm*>& stms) {
+    for (auto it = stms.begin(); it != stms.end();) {
+        list<Stm*> antes;
+        bool absorbida = adelantar(*it, antes);
+        stms.splice(it, antes);
+        if (absorbida) {
+            delete *it;
+            it = stms.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ExpansorEnLinea::expandir(Body* b) {
+    if (!b) return;
+    // Una declaración int con llamada en el init (y las que la siguen, para
+    // conservar el orden) pasa a ser declaración + asignación
+    auto desde = b->intances.begin();
+    while (desde != b->intances.end() && !any_of((*desde)->values.begin(), (*desde)->values.end(),
+                                                 [](InitData* i) { return i->e && hayLlamada(i->e); }))
+        ++desde;
+    bool convertir = desde != b->intances.end();
+    for (auto it = desde; it != b->intances.end(); ++it) {
+        if ((*it)->type != "int") convertir = false;
+        for (InitData* init : (*it)->values) if (!init->e || init->st) convertir = false;
+    }
+    if (convertir) {
+        list<Stm*> asignaciones;
+        for (auto it = desde; it != b->intances.end(); ++it) {
+            VarDec* vd = new VarDec();
+            vd->type = "int";
+            vd->vars = (*it)->vars;
+            b->declarations.push_back(vd);
+            auto val = (*it)->values.begin();
+            for (const string& v : (*it)->vars) {
+                asignaciones.push_back(new AssignStm(v, (*val)->e));
+                (*val++)->e = nullptr;
+            }
+            delete *it;
+        }
+        b->intances.erase(desde, b->intances.end());
+        b->stmList.splice(b->stmList.begin(), asignaciones);
+    }
+    expandir(b->stmList);
+}
+
+void ExpansorEnLinea::funcion(FunDec* fd) {
+    actual = fd;
+    enteros.clear();
+    unordered_map<string, string> tipos;
+    bool soloInt = true;
+    for (ParamDec* p : fd->params) tipos[p->id] = p->type;
+    locales(fd->body, tipos, soloInt);
+    for (auto& t : tipos) if (t.second == "int") enteros.insert(t.first);
+    nuevas = new VarDec();
+    nuevas->type = "int";
+    pila.clear();
+    bucles = 0;
+    crecimiento = 0;
+    expandidas = 0;
+    expandir(fd->body);
+    if (nuevas->vars.empty()) delete nuevas;
+    else fd->body->declarations.push_back(nuevas);
+    if (reporte) *reporte << "INLINE " << fd->id << ": " << expandidas << " llamadas expandidas" << endl;
+}
+
+void ExpansorEnLinea::expandir(Program* program) {
+    analizar(program);
+    for (FunDec* fd : program->fdlist) funcion(fd);
+
+    // Las expandidas que ya nadie llama se eliminan
+    vector<string> eliminadas;
+    for (bool cambio = true; cambio;) {
+        cambio = false;
+        unordered_map<string, int> cuenta;
+        for (FunDec* fd : program->fdlist) contarLlamadas(fd->body, cuenta);
+        for (auto it = program->fdlist.begin(); it != program->fdlist.end();) {
+            FunDec* fd = *it;
+            if (funciones[fd->id].expandida && !cuenta.count(fd->id)) {
+                eliminadas.push_back(fd->id);
+                delete fd;
+                it = program->fdlist.erase(it);
+                cambio = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& f : funciones) delete f.second.plantilla;
+    if (reporte && !eliminadas.empty()) {
+        *reporte << "INLINE: eliminadas";
+        for (const string& f : eliminadas) *reporte << " " << f;
+        *reporte << endl;
+    }
+}
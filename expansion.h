@@ -0,0 +1,111 @@
+#ifndef EXPANSION_H
+#define EXPANSION_H
+
+#include <list>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  Expansión en línea de llamadas (--inline)
+//  Una llamada a una función int pequeña se reemplaza por su cuerpo antes
+//  de la sentencia que la contiene:
+//      x = f(a, b) + 1;   =>   f$1$p = a; ...cuerpo...; f$1 = e; x = f$1 + 1;
+//  Parámetros y locales del callee se renombran a f$N$var (declarados al
+//  principio de la función que llama) y cada return pasa a ser una
+//  asignación al resultado f$N: los returns deben cerrar todos los
+//  caminos sin estar dentro de un bucle; un if cuya rama termina absorbe
+//  el resto de la lista en la otra rama. Un argumento constante o variable
+//  que el callee no escribe se sustituye directamente; "x = f(...)"
+//  asigna a x sin temporal.
+//  Solo se adelantan llamadas que se evalúan siempre y antes que
+//  cualquier otro efecto de la sentencia: la primera llamada que no se
+//  expande (o una dentro de una rama de ternario) corta la búsqueda, no
+//  se tocan las condiciones de while/for ni el step, y en printf solo
+//  callees sin printf a partir del segundo argumento.
+//  Candidatas: tipo int en retorno, parámetros y locales, sin globales.
+//  Modelo de costo (nodos del cuerpo): siempre si es diminuta, más
+//  dentro de bucles y más aún si es la única llamada del programa (el
+//  original desaparece); con tope de crecimiento por función, de
+//  profundidad (expansiones dentro de lo expandido) y sin expandir una
+//  función dentro de sí misma. Las funciones expandidas que quedan sin
+//  llamadas se eliminan del programa.
+//  Corre tras el intérprete: solo lo ve la generación de código.
+// ===========================================================
+
+class ExpansorEnLinea {
+public:
+    void expandir(Program* program);
+
+    ostream* reporte = nullptr; // --stats: llamadas expandidas por función
+
+private:
+    struct Candidata {
+        FunDec* fd = nullptr;
+        bool valida = false;
+        int costo = 0;
+        int llamadas = 0;   // Sitios de llamada en todo el programa
+        bool imprime = false; // Contiene printf (directo o en lo que llama)
+        bool expandida = false;
+        unordered_set<string> escritas; // Parámetros que el cuerpo escribe
+        vector<string> locales;
+        Body* plantilla = nullptr; // Cuerpo original, sin declaraciones
+    };
+    unordered_map<string, Candidata> funciones;
+    int siguiente = 0; // Numera las copias (f$N)
+
+    // Estado de la función que llama
+    FunDec* actual = nullptr;
+    VarDec* nuevas = nullptr;     // Declaraciones de los renombrados
+    unordered_set<string> enteros; // Locales int de la función
+    vector<string> pila;          // Funciones expandidas en curso
+    int bucles = 0;
+    int crecimiento = 0;
+    int expandidas = 0;
+
+    // Copia en curso: nombre del callee -> renombrado o argumento
+    unordered_map<string, string> renombres;
+    unordered_map<string, Exp*> sustituciones;
+
+    static void nombres(Exp* e, unordered_set<string>& vars);
+    static void nombres(Body* b, unordered_set<string>& vars);
+    static void nombres(Stm* s, unordered_set<string>& vars);
+    static void escrituras(Body* b, unordered_set<string>& vars);
+    static void escrituras(Stm* s, unordered_set<string>& vars);
+    static void locales(Body* b, unordered_map<string, string>& tipos, bool& soloInt);
+    static void locales(Stm* s, unordered_map<string, string>& tipos, bool& soloInt);
+    static void contarLlamadas(Exp* e, unordered_map<string, int>& cuenta);
+    static void contarLlamadas(Body* b, unordered_map<string, int>& cuenta);
+    static void contarLlamadas(Stm* s, unordered_map<string, int>& cuenta);
+    static bool hayLlamada(Exp* e);
+    static bool hayPrintf(Body* b);
+    static bool hayPrintf(Stm* s);
+    static int costo(Exp* e);
+    static int costo(Body* b);
+    static int costo(Stm* s);
+    static bool termina(const list<Stm*>& stms);
+    static bool hayReturn(Body* b);
+    static bool hayReturn(Stm* s);
+    static bool estructurar(list<Stm*>& stms, const string& resultado);
+
+    Exp* copiar(Exp* e);
+    Exp* clonar(Exp* e);
+    Body* clonar(Body* b);
+    Stm* clonar(Stm* s);
+    void analizar(Program* program);
+
+    bool conviene(const string& nombre) const;
+    string expandirLlamada(FcallExp* call, const string& resultado, list<Stm*>& antes);
+    void adelantar(Exp*& e, bool& barrera, bool sinPrintf, list<Stm*>& antes);
+    bool adelantar(Stm* s, list<Stm*>& antes);
+    void expandir(list<Stm*>& stms);
+    void expandir(Body* b);
+    void funcion(FunDec* fd);
+};
+
+#endif // EXPANSION_H
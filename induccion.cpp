@@ -0,0 +1,340 @@
+#include <climits>
+#include "induccion.h"
+#include "licm.h"
+
+using namespace std;
+
+// ==========================================
+// Análisis del bucle
+// ==========================================
+
+void ReductorInducciones::escrituras(Body* b, unordered_set<string>& vars) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) vars.insert(v);
+    for (InstanceDec* ind : b->intances) escrituras(ind, vars);
+    for (Stm* s : b->stmList) escrituras(s, vars);
+}
+
+void ReductorInducciones::escrituras(Stm* s, unordered_set<string>& vars) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        vars.insert(a->id.substr(0, a->id.find('.')));
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) vars.insert(v);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        escrituras(i->thenBody, vars);
+        escrituras(i->elseBody, vars);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        escrituras(w->body, vars);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) escrituras(f->init, vars);
+        escrituras(f->body, vars);
+        if (f->step) {
+            if (IdExp* id = dynamic_cast<IdExp*>(f->step->variable)) vars.insert(id->value);
+        }
+    }
+}
+
+// Apariciones de var como lectura (las variables de los StepExp se escriben)
+int ReductorInducciones::lecturas(Exp* e, const string& var) {
+    if (!e) return 0;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) return id->value == var ? 1 : 0;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return lecturas(b->left, var) + lecturas(b->right, var);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return lecturas(t->condition, var) + lecturas(t->trueExp, var) + lecturas(t->falseExp, var);
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        int n = 0;
+        for (Exp* a : fc->arguments) n += lecturas(a, var);
+        return n;
+    }
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return lecturas(st->amount, var);
+    return 0;
+}
+
+int ReductorInducciones::lecturas(Body* b, const string& var) {
+    if (!b) return 0;
+    int n = 0;
+    for (InstanceDec* ind : b->intances) n += lecturas(ind, var);
+    for (Stm* s : b->stmList) n += lecturas(s, var);
+    return n;
+}
+
+int ReductorInducciones::lecturas(Stm* s, const string& var) {
+    int n = 0;
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        n = lecturas(a->e, var);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* init : ind->values) {
+            if (init->e) n += lecturas(init->e, var);
+            if (init->st) for (Exp* e : init->st->argumentos) n += lecturas(e, var);
+        }
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        n = lecturas(i->condition, var) + lecturas(i->thenBody, var) + lecturas(i->elseBody, var);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        n = lecturas(w->condition, var) + lecturas(w->body, var);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        n = (f->init ? lecturas(f->init, var) : 0) + lecturas(f->condition, var) +
+            lecturas(f->body, var) + lecturas(f->step, var);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) n += lecturas(e, var);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        n = lecturas(r->e, var);
+    }
+    return n;
+}
+
+bool ReductorInducciones::constante(Exp* e, long& k) {
+    if (NumberExp* n = dynamic_cast<NumberExp*>(e)) {
+        k = n->value;
+        return true;
+    }
+    if (e->cont == 1) {
+        k = e->valor;
+        return true;
+    }
+    return false;
+}
+
+void ReductorInducciones::declaraciones(Body* b) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) tipos[v] = vd->type;
+    for (InstanceDec* ind : b->intances) declaraciones(ind);
+    for (Stm* s : b->stmList) declaraciones(s);
+}
+
+void ReductorInducciones::declaraciones(Stm* s) {
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) tipos[v] = ind->type;
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        declaraciones(i->thenBody);
+        declaraciones(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        declaraciones(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) declaraciones(f->init);
+        declaraciones(f->body);
+    }
+}
+
+bool ReductorInducciones::esLocalInt(const string& nombre) const {
+    auto it = tipos.find(nombre);
+    return it != tipos.end() && it->second == "int";
+}
+
+// Factor constante (factor * paso debe caber en un inmediato de 32 bits)
+// o variable int que el bucle no escribe, con paso ±1
+bool ReductorInducciones::factorValido(Exp* f, string& clave) const {
+    long k;
+    if (constante(f, k)) {
+        long incremento = k * paso;
+        if (incremento < INT_MIN || incremento > INT_MAX) return false;
+        clave = "k" + to_string(k);
+        return true;
+    }
+    IdExp* id = dynamic_cast<IdExp*>(f);
+    if (!id || id->value == base || (paso != 1 && paso != -1)) return false;
+    if (!esLocalInt(id->value) || escritas.count(id->value)) return false;
+    clave = "v" + id->value;
+    return true;
+}
+
+// ==========================================
+// Reducción
+// ==========================================
+
+void ReductorInducciones::reducir(Exp* e, int& cuenta) {
+    if (!e || e->cont == 1 || e->claseCont >= 0 || (licm && licm->temporal(e) >= 0) || temporalDe.count(e)) return;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        if (b->op == MUL_OP) {
+            IdExp* izq = dynamic_cast<IdExp*>(b->left);
+            IdExp* der = dynamic_cast<IdExp*>(b->right);
+            Exp* factor = nullptr;
+            if (izq && izq->value == base) factor = b->right;
+            else if (der && der->value == base) factor = b->left;
+            string clave;
+            if (factor && factorValido(factor, clave)) {
+                auto it = grupos.find(clave);
+                if (it == grupos.end()) {
+                    it = grupos.emplace(clave, (int)derivadas->size()).first;
+                    derivadas->push_back({base, paso, factor, usados++});
+                }
+                temporalDe[b] = (*derivadas)[it->second].temporal;
+                cuenta++;
+                return;
+            }
+        }
+        reducir(b->left, cuenta);
+        reducir(b->right, cuenta);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        reducir(t->condition, cuenta);
+        reducir(t->trueExp, cuenta);
+        reducir(t->falseExp, cuenta);
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) reducir(a, cuenta);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        reducir(st->amount, cuenta);
+    }
+}
+
+void ReductorInducciones::reducir(Body* b, int& cuenta) {
+    if (!b) return;
+    for (InstanceDec* ind : b->intances) reducir(ind, cuenta);
+    for (Stm* s : b->stmList) reducir(s, cuenta);
+}
+
+void ReductorInducciones::reducir(Stm* s, int& cuenta) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        reducir(a->e, cuenta);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* init : ind->values) {
+            if (init->e) reducir(init->e, cuenta);
+            if (init->st) for (Exp* e : init->st->argumentos) reducir(e, cuenta);
+        }
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        reducir(i->condition, cuenta);
+        reducir(i->thenBody, cuenta);
+        reducir(i->elseBody, cuenta);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        reducir(w->condition, cuenta);
+        reducir(w->body, cuenta);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) reducir(f->init, cuenta);
+        reducir(f->condition, cuenta);
+        reducir(f->body, cuenta);
+        reducir(f->step, cuenta);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) reducir(e, cuenta);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        reducir(r->e, cuenta);
+    }
+}
+
+// for (int i = c0; i <op> N; paso) cuyo cuerpo solo lee i en multiplicaciones
+// reducidas: la condición pasa a la derivada de factor constante positivo.
+// Los valores que recorre la derivada deben caber en int (modo JIT)
+void ReductorInducciones::eliminarContador(ForStm* f) {
+    if (reducidasCuerpo == 0 || reducidasCuerpo != lecturas(f->body, base)) return;
+    InstanceDec* init = dynamic_cast<InstanceDec*>(f->init);
+    if (!init || init->vars.size() != 1 || init->vars.front() != base) return;
+    long inicio;
+    InitData* valor = init->values.front();
+    if (!valor || !valor->e || !constante(valor->e, inicio)) return;
+
+    BinaryExp* cond = dynamic_cast<BinaryExp*>(f->condition);
+    if (!cond || cond->cont == 1 || cond->claseCont >= 0) return;
+    IdExp* id = dynamic_cast<IdExp*>(cond->left);
+    long limite;
+    if (!id || id->value != base || !constante(cond->right, limite)) return;
+    bool sube = (cond->op == LT_OP || cond->op == LE_OP) && paso > 0;
+    bool baja = (cond->op == GT_OP || cond->op == GE_OP) && paso < 0;
+    if (!sube && !baja) return;
+
+    for (const InduccionDerivada& d : *derivadas) {
+        long k;
+        if (!constante(d.factor, k) || k <= 0) continue;
+        for (long v : {inicio * k, limite * k, (limite + paso) * k}) {
+            if (v < INT_MIN || v > INT_MAX) return;
+        }
+        contadores[f] = {d.temporal, limite * k};
+        eliminados++;
+        return;
+    }
+}
+
+void ReductorInducciones::bucle(Exp* cond, Body* body, Stm* ultimo, vector<InduccionDerivada>& lista) {
+    escritas.clear();
+    if (body) {
+        for (VarDec* vd : body->declarations) for (const string& v : vd->vars) escritas.insert(v);
+        for (InstanceDec* ind : body->intances) escrituras(ind, escritas);
+        for (Stm* s : body->stmList) if (s != ultimo) escrituras(s, escritas);
+    }
+    // La base cambia solo en su step (o en la última sentencia)
+    if (escritas.count(base) || !esLocalInt(base) || globales.count(base)) return;
+    grupos.clear();
+    derivadas = &lista;
+    int enCondicion = 0;
+    reducir(cond, enCondicion);
+    reducidasCuerpo = 0;
+    if (body) {
+        for (InstanceDec* ind : body->intances) reducir(ind, reducidasCuerpo);
+        for (Stm* s : body->stmList) if (s != ultimo) reducir(s, reducidasCuerpo);
+    }
+    reducidas += enCondicion + reducidasCuerpo;
+}
+
+void ReductorInducciones::recorrer(Body* b) {
+    if (!b) return;
+    for (Stm* s : b->stmList) recorrer(s);
+}
+
+void ReductorInducciones::recorrer(Stm* s) {
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        recorrer(i->thenBody);
+        recorrer(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        // while (...) { ...; i = i +/- c; }
+        AssignStm* ultimo = w->body->stmList.empty() ? nullptr : dynamic_cast<AssignStm*>(w->body->stmList.back());
+        BinaryExp* suma = ultimo ? dynamic_cast<BinaryExp*>(ultimo->e) : nullptr;
+        IdExp* id = suma ? dynamic_cast<IdExp*>(suma->left) : nullptr;
+        NumberExp* c = suma ? dynamic_cast<NumberExp*>(suma->right) : nullptr;
+        if (id && c && id->value == ultimo->id && (suma->op == PLUS_OP || suma->op == MINUS_OP)) {
+            base = id->value;
+            paso = suma->op == PLUS_OP ? c->value : -c->value;
+            bucle(w->condition, w->body, ultimo, deBucle[w]);
+        }
+        recorrer(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        IdExp* id = f->step ? dynamic_cast<IdExp*>(f->step->variable) : nullptr;
+        long c = 0;
+        bool simple = id && (f->step->type != StepExp::COMPOUND || constante(f->step->amount, c));
+        if (simple) {
+            base = id->value;
+            paso = f->step->type == StepExp::INCREMENT ? 1 : f->step->type == StepExp::DECREMENT ? -1 : (int)c;
+            bucle(f->condition, f->body, nullptr, deBucle[f]);
+            if (!deBucle[f].empty()) eliminarContador(f);
+        }
+        recorrer(f->body);
+    }
+}
+
+void ReductorInducciones::funcion(FunDec* fd) {
+    tipos.clear();
+    for (ParamDec* p : fd->params) tipos[p->id] = p->type;
+    declaraciones(fd->body);
+    usados = 0;
+    reducidas = 0;
+    eliminados = 0;
+    recorrer(fd->body);
+    temporalesDe[fd] = usados;
+    if (reporte) {
+        *reporte << "IV " << fd->id << ": " << reducidas << " multiplicaciones reducidas, " << usados
+                 << " temporales, " << eliminados << " contadores eliminados" << endl;
+    }
+}
+
+int ReductorInducciones::temporal(Exp* e) const {
+    auto it = temporalDe.find(e);
+    return it == temporalDe.end() ? -1 : it->second;
+}
+
+const vector<InduccionDerivada>& ReductorInducciones::inducciones(Stm* bucle) const {
+    static const vector<InduccionDerivada> ninguna;
+    auto it = deBucle.find(bucle);
+    return it == deBucle.end() ? ninguna : it->second;
+}
+
+const ContadorEliminado* ReductorInducciones::contador(ForStm* f) const {
+    auto it = contadores.find(f);
+    return it == contadores.end() ? nullptr : &it->second;
+}
+
+int ReductorInducciones::temporales(FunDec* fd) const {
+    auto it = temporalesDe.find(fd);
+    return it == temporalesDe.end() ? 0 : it->second;
+}
+
+void ReductorInducciones::reducir(Program* program) {
+    globales.clear();
+    for (VarDec* vd : program->vdlist) for (const string& var : vd->vars) globales.insert(var);
+    for (InstanceDec* ind : program->intdlist) for (const string& var : ind->vars) globales.insert(var);
+    for (FunDec* fd : program->fdlist) funcion(fd);
+}
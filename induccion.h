@@ -0,0 +1,107 @@
+#ifndef INDUCCION_H
+#define INDUCCION_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+class ExtractorInvariantes;
+
+// Variable de inducción derivada: su temporal vale base * factor y avanza
+// factor * paso en cada vuelta. El factor es una constante o una variable
+// que el bucle no escribe (entonces el paso es 1 o -1)
+struct InduccionDerivada {
+    string base;     // Variable de inducción básica
+    int paso;        // Incremento de la base por vuelta
+    Exp* factor;     // NumberExp, constante (cont=1) o IdExp invariante
+    int temporal;    // Slot del marco (temporal() de las multiplicaciones que reemplaza)
+};
+
+// Contador eliminado de un for: la condición compara el temporal con el
+// límite escalado y el step ya no actualiza la variable básica
+struct ContadorEliminado {
+    int temporal;
+    long limite;
+};
+
+// ===========================================================
+//  Variables de inducción y reducción de fuerza (--iv)
+//  Variable de inducción básica: un local int que el bucle solo cambia en
+//  un punto y en una constante por vuelta (el StepExp de un ForStm, o la
+//  última sentencia "i = i +/- c" de un WhileStm).
+//  Cada multiplicación base * factor dentro del bucle (condición, cuerpo
+//  y bucles anidados) pasa a ser una variable de inducción derivada: un
+//  temporal del marco que se inicializa en el preheader y avanza factor *
+//  paso donde avanza la base, en lugar de un imulq por vuelta. Las
+//  multiplicaciones con la misma base y factor comparten temporal.
+//  El factor es una constante o una variable invariante (con paso ±1).
+//  Contador redundante: en un for que declara su contador con valor
+//  constante, compara con un límite constante y solo lo usa en
+//  multiplicaciones reducidas, la condición pasa a comparar la derivada
+//  con limite * factor y el contador deja de actualizarse.
+//  Solo lo usa GenCodeVisitor; el intérprete ejecuta el AST original.
+// ===========================================================
+
+class ReductorInducciones {
+public:
+    void reducir(Program* program);
+
+    ostream* reporte = nullptr; // --stats: multiplicaciones reducidas por función
+    // --licm: los invariantes ya se leen de su temporal y no se reducen
+    const ExtractorInvariantes* licm = nullptr;
+
+    // Resultados por nodo para GenCodeVisitor y --rotate/--unroll
+    int temporal(Exp* e) const;                                     // -1 si no se reemplaza
+    const vector<InduccionDerivada>& inducciones(Stm* bucle) const; // Vacía si no tiene
+    const ContadorEliminado* contador(ForStm* f) const;             // nullptr si se conserva
+    int temporales(FunDec* fd) const;                               // Slots del marco de la función
+
+private:
+    unordered_map<Exp*, int> temporalDe;
+    unordered_map<Stm*, vector<InduccionDerivada>> deBucle;
+    unordered_map<ForStm*, ContadorEliminado> contadores;
+    unordered_map<FunDec*, int> temporalesDe;
+
+    unordered_set<string> globales;
+
+    // Estado de la función en curso
+    unordered_map<string, string> tipos; // Tipo declarado de cada local
+    int usados = 0;     // Temporales asignados
+    int reducidas = 0;
+    int eliminados = 0;
+
+    // Estado del bucle en curso
+    string base;
+    int paso = 0;
+    unordered_set<string> escritas;
+    unordered_map<string, int> grupos; // Clave del factor -> índice en 'derivadas'
+    vector<InduccionDerivada>* derivadas = nullptr;
+    int reducidasCuerpo = 0;
+
+    static void escrituras(Body* b, unordered_set<string>& vars);
+    static void escrituras(Stm* s, unordered_set<string>& vars);
+    static int lecturas(Exp* e, const string& var);
+    static int lecturas(Body* b, const string& var);
+    static int lecturas(Stm* s, const string& var);
+    static bool constante(Exp* e, long& k);
+    void declaraciones(Body* b);
+    void declaraciones(Stm* s);
+
+    bool esLocalInt(const string& nombre) const;
+    bool factorValido(Exp* f, string& clave) const;
+    void reducir(Exp* e, int& cuenta);
+    void reducir(Body* b, int& cuenta);
+    void reducir(Stm* s, int& cuenta);
+    void eliminarContador(ForStm* f);
+    void bucle(Exp* cond, Body* body, Stm* ultimo, vector<InduccionDerivada>& lista);
+    void recorrer(Body* b);
+    void recorrer(Stm* s);
+    void funcion(FunDec* fd);
+};
+
+#endif // INDUCCION_H
@@ -0,0 +1,860 @@
+#include <algorithm>
+#include "ir.h"
+
+using namespace std;
+
+// ==========================================
+// Valores e instrucciones
+// ==========================================
+
+bool IrValor::operator==(const IrValor& o) const {
+    if (tipo != o.tipo) return false;
+    if (tipo == TEMP) return temp == o.temp;
+    if (tipo == CONST) return k == o.k;
+    return true;
+}
+
+IrValor irTemp(int t) {
+    IrValor v;
+    v.tipo = IrValor::TEMP;
+    v.temp = t;
+    return v;
+}
+
+IrValor irConst(long k) {
+    IrValor v;
+    v.tipo = IrValor::CONST;
+    v.k = k;
+    return v;
+}
+
+bool esTerminador(IrOp op) {
+    return op == IrOp::SALTO || op == IrOp::SALTO_COND || op == IrOp::RETORNO;
+}
+
+bool esPura(IrOp op) {
+    switch (op) {
+        case IrOp::LLAMADA: case IrOp::IMPRIMIR: case IrOp::ESCRIBIR:
+        case IrOp::SALTO: case IrOp::SALTO_COND: case IrOp::RETORNO:
+            return false;
+        default:
+            return true;
+    }
+}
+
+int IrFuncion::nuevoTemp(const string& nombre) {
+    temps.push_back(nombre);
+    return (int)temps.size() - 1;
+}
+
+// ==========================================
+// Construcción desde el AST
+// ==========================================
+
+static bool contieneFloat(Exp* e) {
+    if (!e) return false;
+    if (dynamic_cast<FloatExp*>(e)) return true;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return contieneFloat(b->left) || contieneFloat(b->right);
+    return false;
+}
+
+static bool opBinario(BinaryOp op, IrOp& r) {
+    switch (op) {
+        case PLUS_OP:  r = IrOp::SUMA; return true;
+        case MINUS_OP: r = IrOp::RESTA; return true;
+        case MUL_OP:   r = IrOp::MULT; return true;
+        case DIV_OP:   r = IrOp::DIV; return true;
+        case EQ_OP:    r = IrOp::IGUAL; return true;
+        case NE_OP:    r = IrOp::DISTINTO; return true;
+        case LT_OP:    r = IrOp::MENOR; return true;
+        case LE_OP:    r = IrOp::MENOR_IGUAL; return true;
+        case GT_OP:    r = IrOp::MAYOR; return true;
+        case GE_OP:    r = IrOp::MAYOR_IGUAL; return true;
+        default:       return false;
+    }
+}
+
+class ConstructorIR {
+public:
+    ConstructorIR(IrFuncion& f, const unordered_set<string>& escalares, const unordered_map<string, int>& aridad)
+        : f(f), escalares(escalares), aridad(aridad) {}
+    bool construir(FunDec* fd, string& motivo);
+
+private:
+    IrFuncion& f;
+    const unordered_set<string>& escalares;
+    const unordered_map<string, int>& aridad;
+    int actual = -1; // Bloque en construcción (-1: tras un terminador)
+    vector<unordered_map<string, int>> ambitos;
+    string motivo;
+    int ocultas = 0;
+
+    bool falla(const string& m) {
+        if (motivo.empty()) motivo = m;
+        return false;
+    }
+    bool escalar(const string& tipo) const { return escalares.count(tipo) > 0; }
+    int nuevoBloque();
+    void emitir(const IrInstr& i);
+    void saltar(int destino);
+    void saltarSi(IrValor c, int verdadero, int falso);
+    int buscar(const string& nombre) const;
+    int declarar(const string& nombre);
+    IrValor leer(int var);
+    void escribir(int var, IrValor v);
+    bool expresion(Exp* e, IrValor& r);
+    bool paso(StepExp* st);
+    bool sentencia(Stm* s);
+    bool cuerpo(Body* b);
+};
+
+int ConstructorIR::nuevoBloque() {
+    f.bloques.emplace_back();
+    return (int)f.bloques.size() - 1;
+}
+
+void ConstructorIR::emitir(const IrInstr& i) {
+    // Código tras un return/salto: bloque nuevo (inalcanzable, calcularCfg lo quita)
+    if (actual < 0) actual = nuevoBloque();
+    f.bloques[actual].instrs.push_back(i);
+    if (esTerminador(i.op)) actual = -1;
+}
+
+void ConstructorIR::saltar(int destino) {
+    if (actual < 0) return;
+    IrInstr i;
+    i.op = IrOp::SALTO;
+    i.bloques = {destino};
+    emitir(i);
+}
+
+void ConstructorIR::saltarSi(IrValor c, int verdadero, int falso) {
+    if (c.tipo == IrValor::CONST) {
+        saltar(c.k != 0 ? verdadero : falso);
+        return;
+    }
+    IrInstr i;
+    i.op = IrOp::SALTO_COND;
+    i.args = {c};
+    i.bloques = {verdadero, falso};
+    emitir(i);
+}
+
+int ConstructorIR::buscar(const string& nombre) const {
+    for (auto it = ambitos.rbegin(); it != ambitos.rend(); ++it) {
+        auto v = it->find(nombre);
+        if (v != it->end()) return v->second;
+    }
+    return -1;
+}
+
+int ConstructorIR::declarar(const string& nombre) {
+    f.variables.push_back(nombre);
+    int var = (int)f.variables.size() - 1;
+    ambitos.back()[nombre] = var;
+    return var;
+}
+
+IrValor ConstructorIR::leer(int var) {
+    IrInstr i;
+    i.op = IrOp::LEER;
+    i.dst = f.nuevoTemp();
+    i.var = var;
+    emitir(i);
+    return irTemp(i.dst);
+}
+
+void ConstructorIR::escribir(int var, IrValor v) {
+    IrInstr i;
+    i.op = IrOp::ESCRIBIR;
+    i.var = var;
+    i.args = {v};
+    emitir(i);
+}
+
+bool ConstructorIR::expresion(Exp* e, IrValor& r) {
+    if (contieneFloat(e)) return falla("expresion float");
+    if (e->cont == 1) {
+        r = irConst(e->valor);
+        return true;
+    }
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        if (id->value.find('.') != string::npos) return falla("campo de struct " + id->value);
+        int var = buscar(id->value);
+        if (var < 0) return falla("variable global " + id->value);
+        r = leer(var);
+        return true;
+    }
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        IrInstr i;
+        if (!opBinario(b->op, i.op)) return falla("operador " + Exp::binopToChar(b->op));
+        IrValor a, c;
+        if (!expresion(b->left, a) || !expresion(b->right, c)) return false;
+        i.dst = f.nuevoTemp();
+        i.args = {a, c};
+        emitir(i);
+        r = irTemp(i.dst);
+        return true;
+    }
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        if (t->condition->cont == 1) return expresion(t->condition->valor != 0 ? t->trueExp : t->falseExp, r);
+        // El resultado pasa por una celda oculta: mem2reg la convierte en phi
+        f.variables.push_back("tern" + to_string(ocultas++));
+        int var = (int)f.variables.size() - 1;
+        IrValor c, x;
+        if (!expresion(t->condition, c)) return false;
+        int bv = nuevoBloque(), bf = nuevoBloque(), fin = nuevoBloque();
+        saltarSi(c, bv, bf);
+        actual = bv;
+        if (!expresion(t->trueExp, x)) return false;
+        escribir(var, x);
+        saltar(fin);
+        actual = bf;
+        if (!expresion(t->falseExp, x)) return false;
+        escribir(var, x);
+        saltar(fin);
+        actual = fin;
+        r = leer(var);
+        return true;
+    }
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        auto it = aridad.find(fc->name);
+        if (it == aridad.end()) return falla("llamada a " + fc->name + " (firma no soportada)");
+        if (it->second != (int)fc->arguments.size()) return falla("llamada a " + fc->name + " con otra aridad");
+        IrInstr i;
+        i.op = IrOp::LLAMADA;
+        i.funcion = fc->name;
+        for (Exp* a : fc->arguments) {
+            IrValor v;
+            if (!expresion(a, v)) return false;
+            i.args.push_back(v);
+        }
+        i.dst = f.nuevoTemp();
+        emitir(i);
+        r = irTemp(i.dst);
+        return true;
+    }
+    return falla("expresion no soportada");
+}
+
+bool ConstructorIR::paso(StepExp* st) {
+    IdExp* id = dynamic_cast<IdExp*>(st->variable);
+    if (!id || id->value.find('.') != string::npos) return falla("paso de for no escalar");
+    int var = buscar(id->value);
+    if (var < 0) return falla("variable global " + id->value);
+    // Igual que GenCodeVisitor: += y -= suman la cantidad
+    IrValor delta = irConst(st->type == StepExp::DECREMENT ? -1 : 1);
+    if (st->type == StepExp::COMPOUND && !expresion(st->amount, delta)) return false;
+    IrInstr i;
+    i.op = IrOp::SUMA;
+    i.args = {leer(var), delta};
+    i.dst = f.nuevoTemp();
+    emitir(i);
+    escribir(var, irTemp(i.dst));
+    return true;
+}
+
+bool ConstructorIR::sentencia(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        if (a->id.find('.') != string::npos) return falla("campo de struct " + a->id);
+        int var = buscar(a->id);
+        if (var < 0) return falla("variable global " + a->id);
+        IrValor v;
+        if (!expresion(a->e, v)) return false;
+        escribir(var, v);
+        return true;
+    }
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        if (!escalar(ind->type)) return falla("tipo " + ind->type);
+        auto val = ind->values.begin();
+        for (const string& nombre : ind->vars) {
+            InitData* d = *val++;
+            if (!d->e) return falla("inicializador de struct");
+            IrValor v;
+            if (!expresion(d->e, v)) return false;
+            escribir(declarar(nombre), v);
+        }
+        return true;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        if (i->condition->cont == 1) return cuerpo(i->condition->valor != 0 ? i->thenBody : i->elseBody);
+        IrValor c;
+        if (!expresion(i->condition, c)) return false;
+        int bt = nuevoBloque(), fin = nuevoBloque();
+        int be = i->elseBody ? nuevoBloque() : fin;
+        saltarSi(c, bt, be);
+        actual = bt;
+        if (!cuerpo(i->thenBody)) return false;
+        saltar(fin);
+        if (i->elseBody) {
+            actual = be;
+            if (!cuerpo(i->elseBody)) return false;
+            saltar(fin);
+        }
+        actual = fin;
+        return true;
+    }
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        int cab = nuevoBloque(), bc = nuevoBloque(), fin = nuevoBloque();
+        saltar(cab);
+        actual = cab;
+        IrValor c;
+        if (!expresion(w->condition, c)) return false;
+        saltarSi(c, bc, fin);
+        actual = bc;
+        if (!cuerpo(w->body)) return false;
+        saltar(cab);
+        actual = fin;
+        return true;
+    }
+    if (ForStm* fs = dynamic_cast<ForStm*>(s)) {
+        ambitos.emplace_back();
+        if (fs->init && !sentencia(fs->init)) return false;
+        int cab = nuevoBloque(), bc = nuevoBloque(), fin = nuevoBloque();
+        saltar(cab);
+        actual = cab;
+        IrValor c;
+        if (!expresion(fs->condition, c)) return false;
+        saltarSi(c, bc, fin);
+        actual = bc;
+        if (!cuerpo(fs->body)) return false;
+        if (fs->step && !paso(fs->step)) return false;
+        saltar(cab);
+        actual = fin;
+        ambitos.pop_back();
+        return true;
+    }
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) {
+            IrInstr i;
+            i.op = IrOp::IMPRIMIR;
+            i.args.emplace_back();
+            if (!expresion(e, i.args[0])) return false;
+            emitir(i);
+        }
+        return true;
+    }
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        IrInstr i;
+        i.op = IrOp::RETORNO;
+        i.args = {irConst(0)};
+        if (r->e && !expresion(r->e, i.args[0])) return false;
+        emitir(i);
+        return true;
+    }
+    return falla("sentencia no soportada");
+}
+
+bool ConstructorIR::cuerpo(Body* b) {
+    if (!b) return true;
+    ambitos.emplace_back();
+    for (VarDec* vd : b->declarations) {
+        if (!escalar(vd->type)) return falla("tipo " + vd->type);
+        for (const string& nombre : vd->vars) escribir(declarar(nombre), irConst(0));
+    }
+    for (InstanceDec* ind : b->intances) if (!sentencia(ind)) return false;
+    for (Stm* s : b->stmList) if (!sentencia(s)) return false;
+    ambitos.pop_back();
+    return true;
+}
+
+bool ConstructorIR::construir(FunDec* fd, string& m) {
+    f.nombre = fd->id;
+    if (!escalar(fd->type)) falla("retorno " + fd->type);
+    if (fd->params.size() > 6) falla("mas de 6 parametros");
+    for (ParamDec* p : fd->params) if (!escalar(p->type)) falla("parametro " + p->type);
+    if (!motivo.empty()) {
+        m = motivo;
+        return false;
+    }
+
+    ambitos.emplace_back();
+    actual = nuevoBloque();
+    for (size_t k = 0; k < fd->params.size(); ++k) {
+        const string& nombre = fd->params[k]->id;
+        IrInstr i;
+        i.op = IrOp::PARAM;
+        i.dst = f.nuevoTemp(nombre);
+        i.var = (int)k;
+        emitir(i);
+        escribir(declarar(nombre), irTemp(i.dst));
+        f.params.push_back(nombre);
+    }
+    if (!cuerpo(fd->body)) {
+        m = motivo;
+        return false;
+    }
+    // Sin return explícito se devuelve 0 (como el intérprete)
+    if (actual >= 0) {
+        IrInstr i;
+        i.op = IrOp::RETORNO;
+        i.args = {irConst(0)};
+        emitir(i);
+    }
+    return true;
+}
+
+bool construirIR(FunDec* fd, const unordered_set<string>& escalares,
+                 const unordered_map<string, int>& aridad, IrFuncion& f, string& motivo) {
+    f = IrFuncion();
+    ConstructorIR c(f, escalares, aridad);
+    return c.construir(fd, motivo);
+}
+
+// ==========================================
+// CFG y dominadores
+// ==========================================
+
+void IrFuncion::calcularCfg() {
+    // Saltos condicionales con destino único o condición constante
+    for (IrBloque& b : bloques) {
+        IrInstr& t = b.instrs.back();
+        if (t.op != IrOp::SALTO_COND) continue;
+        int destino = -1;
+        if (t.bloques[0] == t.bloques[1]) destino = t.bloques[0];
+        else if (t.args[0].tipo == IrValor::CONST) destino = t.bloques[t.args[0].k != 0 ? 0 : 1];
+        if (destino < 0) continue;
+        t.op = IrOp::SALTO;
+        t.args.clear();
+        t.bloques = {destino};
+    }
+
+    // Alcanzables desde la entrada (en orden de índice, para numerar estable)
+    int n = (int)bloques.size();
+    vector<char> alcanzable(n, 0);
+    vector<int> pila = {0};
+    alcanzable[0] = 1;
+    while (!pila.empty()) {
+        int b = pila.back();
+        pila.pop_back();
+        for (int s : bloques[b].instrs.back().bloques) {
+            if (!alcanzable[s]) {
+                alcanzable[s] = 1;
+                pila.push_back(s);
+            }
+        }
+    }
+    vector<int> nuevoId(n, -1);
+    vector<IrBloque> quedan;
+    for (int b = 0; b < n; ++b) {
+        if (!alcanzable[b]) continue;
+        nuevoId[b] = (int)quedan.size();
+        quedan.push_back(move(bloques[b]));
+    }
+    bloques = move(quedan);
+
+    for (IrBloque& b : bloques) {
+        b.preds.clear();
+        b.succs.clear();
+        for (IrInstr& i : b.instrs) {
+            if (i.op == IrOp::PHI) {
+                // Se descartan las entradas de predecesores eliminados
+                vector<IrValor> args;
+                vector<int> preds;
+                for (size_t k = 0; k < i.args.size(); ++k) {
+                    if (nuevoId[i.bloques[k]] < 0) continue;
+                    args.push_back(i.args[k]);
+                    preds.push_back(nuevoId[i.bloques[k]]);
+                }
+                i.args = args;
+                i.bloques = preds;
+            } else if (esTerminador(i.op)) {
+                for (int& s : i.bloques) s = nuevoId[s];
+            }
+        }
+    }
+    for (int b = 0; b < (int)bloques.size(); ++b) {
+        bloques[b].succs = bloques[b].instrs.back().bloques;
+        for (int s : bloques[b].succs) bloques[s].preds.push_back(b);
+    }
+}
+
+vector<int> IrFuncion::ordenRPO() const {
+    int n = (int)bloques.size();
+    vector<int> post;
+    vector<char> visto(n, 0);
+    // DFS iterativo: (bloque, sucesores ya visitados). Se recorren del último
+    // al primero para que el destino verdadero quede justo tras el salto
+    vector<pair<int, size_t>> pila = {{0, 0}};
+    visto[0] = 1;
+    while (!pila.empty()) {
+        int b = pila.back().first;
+        size_t& k = pila.back().second;
+        const vector<int>& succs = bloques[b].succs;
+        if (k < succs.size()) {
+            int s = succs[succs.size() - 1 - k++];
+            if (!visto[s]) {
+                visto[s] = 1;
+                pila.push_back({s, 0});
+            }
+        } else {
+            post.push_back(b);
+            pila.pop_back();
+        }
+    }
+    reverse(post.begin(), post.end());
+    return post;
+}
+
+void IrFuncion::calcularDominadores() {
+    vector<int> rpo = ordenRPO();
+    vector<int> num(bloques.size(), -1);
+    for (size_t k = 0; k < rpo.size(); ++k) num[rpo[k]] = (int)k;
+    idom.assign(bloques.size(), -1);
+    idom[0] = 0;
+    auto interseca = [&](int a, int b) {
+        while (a != b) {
+            while (num[a] > num[b]) a = idom[a];
+            while (num[b] > num[a]) b = idom[b];
+        }
+        return a;
+    };
+    bool cambio = true;
+    while (cambio) {
+        cambio = false;
+        for (size_t k = 1; k < rpo.size(); ++k) {
+            int b = rpo[k];
+            int nuevo = -1;
+            for (int p : bloques[b].preds) {
+                if (idom[p] < 0) continue;
+                nuevo = nuevo < 0 ? p : interseca(p, nuevo);
+            }
+            if (idom[b] != nuevo) {
+                idom[b] = nuevo;
+                cambio = true;
+            }
+        }
+    }
+}
+
+bool IrFuncion::domina(int a, int b) const {
+    while (true) {
+        if (a == b) return true;
+        if (b == 0) return false;
+        b = idom[b];
+    }
+}
+
+// ==========================================
+// mem2reg
+// ==========================================
+
+static void resolver(IrValor& v, const vector<IrValor>& reemplazo) {
+    while (v.tipo == IrValor::TEMP && v.temp < (int)reemplazo.size() &&
+           reemplazo[v.temp].tipo != IrValor::NINGUNO)
+        v = reemplazo[v.temp];
+}
+
+void reemplazarUsos(IrFuncion& f, const vector<IrValor>& reemplazo) {
+    for (IrBloque& b : f.bloques)
+        for (IrInstr& i : b.instrs)
+            for (IrValor& a : i.args) resolver(a, reemplazo);
+}
+
+// Renombrado de Cytron: recorre el árbol de dominadores con una pila de
+// definiciones por variable
+struct Renombrador {
+    IrFuncion& f;
+    vector<vector<int>> hijos;
+    vector<vector<IrValor>> pilas;
+    vector<IrValor> reemplazo; // Temporal de un LEER -> valor que leyó
+    unordered_map<string, int> versiones;
+
+    explicit Renombrador(IrFuncion& f) : f(f) {}
+
+    IrValor tope(int var) const {
+        // Sin escritura previa: las variables empiezan en 0
+        return pilas[var].empty() ? irConst(0) : pilas[var].back();
+    }
+
+    string version(int var) {
+        return f.variables[var] + "." + to_string(++versiones[f.variables[var]]);
+    }
+
+    void bloque(int b) {
+        vector<int> empujadas;
+        vector<IrInstr> quedan;
+        for (IrInstr& i : f.bloques[b].instrs) {
+            if (i.op != IrOp::PHI) for (IrValor& a : i.args) resolver(a, reemplazo);
+            if (i.op == IrOp::LEER) {
+                reemplazo[i.dst] = tope(i.var);
+                continue;
+            }
+            if (i.op == IrOp::ESCRIBIR || (i.op == IrOp::PHI && i.var >= 0)) {
+                IrValor v = i.op == IrOp::PHI ? irTemp(i.dst) : i.args[0];
+                if (v.tipo == IrValor::TEMP && f.temps[v.temp].empty()) f.temps[v.temp] = version(i.var);
+                pilas[i.var].push_back(v);
+                empujadas.push_back(i.var);
+                if (i.op == IrOp::ESCRIBIR) continue;
+            }
+            quedan.push_back(i);
+        }
+        f.bloques[b].instrs = move(quedan);
+
+        for (int s : f.bloques[b].succs) {
+            for (IrInstr& phi : f.bloques[s].instrs) {
+                if (phi.op != IrOp::PHI) break;
+                if (phi.var < 0) continue;
+                for (size_t k = 0; k < phi.bloques.size(); ++k)
+                    if (phi.bloques[k] == b) phi.args[k] = tope(phi.var);
+            }
+        }
+        for (int h : hijos[b]) bloque(h);
+        for (int var : empujadas) pilas[var].pop_back();
+    }
+};
+
+void mem2reg(IrFuncion& f) {
+    f.calcularCfg();
+    f.calcularDominadores();
+    int n = (int)f.bloques.size();
+    int nv = (int)f.variables.size();
+
+    // Fronteras de dominancia
+    vector<vector<int>> frontera(n);
+    for (int b = 0; b < n; ++b) {
+        if (f.bloques[b].preds.size() < 2) continue;
+        for (int p : f.bloques[b].preds) {
+            for (int r = p; r != f.idom[b]; r = f.idom[r]) {
+                if (find(frontera[r].begin(), frontera[r].end(), b) == frontera[r].end())
+                    frontera[r].push_back(b);
+            }
+        }
+    }
+
+    // Phis en la frontera iterada de los bloques que escriben cada variable
+    vector<vector<int>> escrituras(nv);
+    for (int b = 0; b < n; ++b) {
+        for (const IrInstr& i : f.bloques[b].instrs) {
+            if (i.op != IrOp::ESCRIBIR) continue;
+            vector<int>& e = escrituras[i.var];
+            if (e.empty() || e.back() != b) e.push_back(b);
+        }
+    }
+    for (int var = 0; var < nv; ++var) {
+        vector<char> conPhi(n, 0), enLista(n, 0);
+        vector<int> lista = escrituras[var];
+        for (int b : lista) enLista[b] = 1;
+        while (!lista.empty()) {
+            int b = lista.back();
+            lista.pop_back();
+            for (int d : frontera[b]) {
+                if (conPhi[d]) continue;
+                conPhi[d] = 1;
+                IrInstr phi;
+                phi.op = IrOp::PHI;
+                phi.var = var;
+                phi.dst = f.nuevoTemp();
+                phi.bloques = f.bloques[d].preds;
+                phi.args.resize(phi.bloques.size());
+                f.bloques[d].instrs.insert(f.bloques[d].instrs.begin(), phi);
+                if (!enLista[d]) {
+                    enLista[d] = 1;
+                    lista.push_back(d);
+                }
+            }
+        }
+    }
+
+    Renombrador ren(f);
+    ren.hijos.resize(n);
+    for (int b = 1; b < n; ++b) ren.hijos[f.idom[b]].push_back(b);
+    ren.pilas.resize(nv);
+    ren.reemplazo.resize(f.temps.size());
+    ren.bloque(0);
+    for (IrBloque& b : f.bloques)
+        for (IrInstr& i : b.instrs)
+            if (i.op == IrOp::PHI) i.var = -1;
+
+    // Phis triviales: todos sus argumentos son el mismo valor (o ella misma)
+    bool cambio = true;
+    while (cambio) {
+        cambio = false;
+        vector<IrValor> reemplazo(f.temps.size());
+        for (IrBloque& b : f.bloques) {
+            for (size_t k = 0; k < b.instrs.size();) {
+                IrInstr& phi = b.instrs[k];
+                if (phi.op != IrOp::PHI) break;
+                IrValor unico;
+                bool trivial = true;
+                for (IrValor a : phi.args) {
+                    resolver(a, reemplazo);
+                    if (a.tipo == IrValor::TEMP && a.temp == phi.dst) continue;
+                    if (unico.tipo == IrValor::NINGUNO) unico = a;
+                    else if (a != unico) trivial = false;
+                }
+                if (!trivial) {
+                    k++;
+                    continue;
+                }
+                reemplazo[phi.dst] = unico.tipo == IrValor::NINGUNO ? irConst(0) : unico;
+                b.instrs.erase(b.instrs.begin() + k);
+                cambio = true;
+            }
+        }
+        reemplazarUsos(f, reemplazo);
+    }
+    eliminarMuertas(f);
+}
+
+// ==========================================
+// Numeración de valores
+// ==========================================
+
+static string claveValor(const IrValor& v) {
+    return v.tipo == IrValor::CONST ? "$" + to_string(v.k) : "%" + to_string(v.temp);
+}
+
+// Tabla con ámbitos: al recorrer el árbol de dominadores en preorden, la
+// tabla solo contiene operaciones de bloques que dominan al actual
+struct Numerador {
+    IrFuncion& f;
+    vector<vector<int>> hijos;
+    vector<IrValor> reemplazo;
+    unordered_map<string, int> tabla;
+    int eliminadas = 0;
+
+    explicit Numerador(IrFuncion& f) : f(f) {}
+
+    void bloque(int b) {
+        vector<string> agregadas;
+        for (IrInstr& i : f.bloques[b].instrs) {
+            for (IrValor& a : i.args) resolver(a, reemplazo);
+            if (i.op < IrOp::SUMA || i.op > IrOp::MAYOR_IGUAL) continue;
+            string a = claveValor(i.args[0]), c = claveValor(i.args[1]);
+            bool conmutativa = i.op == IrOp::SUMA || i.op == IrOp::MULT ||
+                               i.op == IrOp::IGUAL || i.op == IrOp::DISTINTO;
+            if (conmutativa && c < a) swap(a, c);
+            string clave = to_string((int)i.op) + " " + a + " " + c;
+            auto it = tabla.find(clave);
+            if (it != tabla.end()) {
+                reemplazo[i.dst] = irTemp(it->second);
+                eliminadas++;
+            } else {
+                tabla[clave] = i.dst;
+                agregadas.push_back(clave);
+            }
+        }
+        for (int h : hijos[b]) bloque(h);
+        for (const string& clave : agregadas) tabla.erase(clave);
+    }
+};
+
+int numerarValores(IrFuncion& f) {
+    f.calcularDominadores();
+    Numerador num(f);
+    num.hijos.resize(f.bloques.size());
+    for (size_t b = 1; b < f.bloques.size(); ++b) num.hijos[f.idom[b]].push_back((int)b);
+    num.reemplazo.resize(f.temps.size());
+    num.bloque(0);
+    // Las phis pueden usar valores de bloques visitados después
+    reemplazarUsos(f, num.reemplazo);
+    eliminarMuertas(f);
+    return num.eliminadas;
+}
+
+int eliminarMuertas(IrFuncion& f) {
+    // Marcar y barrer: vive lo que usa una instrucción con efectos, transitivamente
+    vector<const IrInstr*> def(f.temps.size(), nullptr);
+    vector<char> vivo(f.temps.size(), 0);
+    vector<int> lista;
+    auto marcar = [&](const IrInstr& i) {
+        for (const IrValor& a : i.args) {
+            if (a.tipo == IrValor::TEMP && !vivo[a.temp]) {
+                vivo[a.temp] = 1;
+                lista.push_back(a.temp);
+            }
+        }
+    };
+    for (const IrBloque& b : f.bloques) {
+        for (const IrInstr& i : b.instrs) {
+            if (i.dst >= 0) def[i.dst] = &i;
+            if (!esPura(i.op)) marcar(i);
+        }
+    }
+    while (!lista.empty()) {
+        int t = lista.back();
+        lista.pop_back();
+        if (def[t]) marcar(*def[t]);
+    }
+    int quitadas = 0;
+    for (IrBloque& b : f.bloques) {
+        vector<IrInstr> quedan;
+        for (IrInstr& i : b.instrs) {
+            if (esPura(i.op) && i.dst >= 0 && !vivo[i.dst]) {
+                quitadas++;
+                continue;
+            }
+            quedan.push_back(move(i));
+        }
+        b.instrs = move(quedan);
+    }
+    return quitadas;
+}
+
+// ==========================================
+// Volcado textual
+// ==========================================
+
+static const char* const MNEMONICOS_IR[] = {
+    "copy", "add", "sub", "mul", "div",
+    "eq", "ne", "lt", "le", "gt", "ge",
+    "param", "call", "print", "load", "store", "phi", "jmp", "br", "ret"
+};
+
+static string textoValor(const IrFuncion& f, const IrValor& v) {
+    if (v.tipo == IrValor::CONST) return to_string(v.k);
+    if (v.tipo == IrValor::TEMP) return "%" + (f.temps[v.temp].empty() ? to_string(v.temp) : f.temps[v.temp]);
+    return "?";
+}
+
+void volcarIR(const IrFuncion& f, ostream& out) {
+    out << "funcion " << f.nombre << "(";
+    for (size_t k = 0; k < f.params.size(); ++k) out << (k ? ", " : "") << f.params[k];
+    out << ")\n";
+    for (size_t b = 0; b < f.bloques.size(); ++b) {
+        const IrBloque& bl = f.bloques[b];
+        out << "b" << b << ":";
+        if (!bl.preds.empty()) {
+            out << "    ; preds";
+            for (int p : bl.preds) out << " b" << p;
+        }
+        out << "\n";
+        for (const IrInstr& i : bl.instrs) {
+            out << "    ";
+            if (i.dst >= 0) out << textoValor(f, irTemp(i.dst)) << " = ";
+            out << MNEMONICOS_IR[(int)i.op];
+            switch (i.op) {
+                case IrOp::PARAM:
+                    out << " " << i.var;
+                    break;
+                case IrOp::LLAMADA:
+                    out << " " << i.funcion << "(";
+                    for (size_t k = 0; k < i.args.size(); ++k) out << (k ? ", " : "") << textoValor(f, i.args[k]);
+                    out << ")";
+                    break;
+                case IrOp::LEER:
+                    out << " " << f.variables[i.var];
+                    break;
+                case IrOp::ESCRIBIR:
+                    out << " " << f.variables[i.var] << ", " << textoValor(f, i.args[0]);
+                    break;
+                case IrOp::PHI:
+                    for (size_t k = 0; k < i.args.size(); ++k)
+                        out << (k ? ", [" : " [") << textoValor(f, i.args[k]) << ", b" << i.bloques[k] << "]";
+                    break;
+                case IrOp::SALTO:
+                    out << " b" << i.bloques[0];
+                    break;
+                case IrOp::SALTO_COND:
+                    out << " " << textoValor(f, i.args[0]) << ", b" << i.bloques[0] << ", b" << i.bloques[1];
+                    break;
+                default:
+                    for (size_t k = 0; k < i.args.size(); ++k) out << (k ? ", " : " ") << textoValor(f, i.args[k]);
+                    break;
+            }
+            out << "\n";
+        }
+    }
+    out << "\n";
+}
@@ -0,0 +1,108 @@
+#ifndef IR_H
+#define IR_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  IR de tres direcciones en forma SSA
+//  Cada función es una lista de bloques básicos (bloques[0] es la
+//  entrada); cada bloque termina en SALTO, SALTO_COND o RETORNO y sus
+//  phis van al inicio. Los temporales (%n) se definen una sola vez.
+//
+//  Construcción:
+//  1. construirIR baja el FunDec ya verificado a IR con las variables
+//     escalares como celdas (LEER/ESCRIBIR), con ámbitos léxicos.
+//  2. mem2reg promueve las celdas a temporales SSA: phis en la frontera
+//     de dominancia iterada y renombrado sobre el árbol de dominadores
+//     (Cytron et al.); luego elimina phis triviales y código muerto.
+//  Solo se bajan funciones enteras (int/long/bool/unsigned y sus typedef,
+//  hasta 6 parámetros): structs, floats y globales quedan para el
+//  generador sobre el AST.
+// ===========================================================
+
+enum class IrOp {
+    COPIA,                                              // %d = a
+    SUMA, RESTA, MULT, DIV,                             // %d = a op b
+    IGUAL, DISTINTO, MENOR, MENOR_IGUAL, MAYOR, MAYOR_IGUAL, // %d = a cmp b (0/1)
+    PARAM,      // %d = parámetro número var
+    LLAMADA,    // %d = funcion(args...)
+    IMPRIMIR,   // printf("%ld\n", a)
+    LEER,       // %d = variable var          (solo antes de mem2reg)
+    ESCRIBIR,   // variable var = a           (solo antes de mem2reg)
+    PHI,        // %d = phi(args[k] desde bloques[k])
+    SALTO,      // goto bloques[0]
+    SALTO_COND, // if a != 0 goto bloques[0] else goto bloques[1]
+    RETORNO     // return a
+};
+
+// Operando: temporal o constante
+struct IrValor {
+    enum Tipo { NINGUNO, TEMP, CONST } tipo = NINGUNO;
+    int temp = -1;
+    long k = 0;
+    bool operator==(const IrValor& o) const;
+    bool operator!=(const IrValor& o) const { return !(*this == o); }
+};
+IrValor irTemp(int t);
+IrValor irConst(long k);
+
+struct IrInstr {
+    IrOp op;
+    int dst = -1;          // Temporal definido (-1 si no define)
+    vector<IrValor> args;
+    int var = -1;          // LEER/ESCRIBIR/PHI: variable; PARAM: índice
+    string funcion;        // LLAMADA
+    vector<int> bloques;   // Destinos del terminador o predecesores de la phi
+};
+
+struct IrBloque {
+    vector<IrInstr> instrs;
+    vector<int> preds, succs; // Calculados por calcularCfg
+};
+
+struct IrFuncion {
+    string nombre;
+    vector<string> params;
+    vector<IrBloque> bloques;
+    vector<string> variables;  // Celdas de la construcción (nombre fuente)
+    vector<string> temps;      // Nombre de cada temporal para el volcado ("" = %n)
+    vector<int> idom;          // Dominador inmediato (calcularDominadores)
+
+    int nuevoTemp(const string& nombre = "");
+    // Sucesores/predecesores desde los terminadores; quita bloques inalcanzables
+    void calcularCfg();
+    vector<int> ordenRPO() const;
+    // Cooper-Harvey-Kennedy sobre el RPO (requiere calcularCfg)
+    void calcularDominadores();
+    bool domina(int a, int b) const;
+};
+
+bool esTerminador(IrOp op);
+// Instrucción sin efectos: se puede quitar si su resultado no se usa
+bool esPura(IrOp op);
+
+// Baja fd a IR (aún no SSA). escalares: tipos enteros (incluye sus typedef);
+// aridad: funciones escalares del programa y su número de parámetros.
+// Devuelve false con el motivo si la función no se puede bajar.
+bool construirIR(FunDec* fd, const unordered_set<string>& escalares,
+                 const unordered_map<string, int>& aridad, IrFuncion& f, string& motivo);
+// Promueve las variables a SSA
+void mem2reg(IrFuncion& f);
+// Quita instrucciones puras cuyo resultado no se usa; devuelve cuántas
+int eliminarMuertas(IrFuncion& f);
+// Reemplaza usos de temporales según reemplazo (indexado por temporal)
+void reemplazarUsos(IrFuncion& f, const vector<IrValor>& reemplazo);
+// Numeración de valores sobre el árbol de dominadores: una operación con los
+// mismos operandos que otra que la domina usa su resultado. Devuelve cuántas
+int numerarValores(IrFuncion& f);
+
+void volcarIR(const IrFuncion& f, ostream& out);
+
+#endif // IR_H
@@ -0,0 +1,563 @@
+#include <algorithm>
+#include <climits>
+#include "ir_codegen.h"
+
+using namespace std;
+
+static const vector<int> CALLEE_SAVED = {RBX, R12, R13, R14, R15};
+static const vector<int> CALLER_SAVED = {RSI, RDI, R8, R9, R10, R11};
+static const vector<int> REGS_ARGUMENTOS = {RDI, RSI, RDX, RCX, R8, R9};
+
+static bool cabeEn32(long v) {
+    return v >= INT_MIN && v <= INT_MAX;
+}
+
+static bool esComparacion(IrOp op) {
+    return op >= IrOp::IGUAL && op <= IrOp::MAYOR_IGUAL;
+}
+
+// Salto condicional / setcc de cada comparación
+static Op saltoDe(IrOp op) {
+    switch (op) {
+        case IrOp::IGUAL:       return Op::JE;
+        case IrOp::DISTINTO:    return Op::JNE;
+        case IrOp::MENOR:       return Op::JL;
+        case IrOp::MENOR_IGUAL: return Op::JLE;
+        case IrOp::MAYOR:       return Op::JG;
+        default:                return Op::JGE;
+    }
+}
+
+static Op setDe(IrOp op) {
+    return (Op)((int)Op::SETE + ((int)saltoDe(op) - (int)Op::JE));
+}
+
+static Op inverso(Op salto) {
+    switch (salto) {
+        case Op::JE:  return Op::JNE;
+        case Op::JNE: return Op::JE;
+        case Op::JL:  return Op::JGE;
+        case Op::JLE: return Op::JG;
+        case Op::JG:  return Op::JLE;
+        default:      return Op::JL;
+    }
+}
+
+// a < b  <=>  b > a
+static IrOp espejo(IrOp op) {
+    switch (op) {
+        case IrOp::MENOR:       return IrOp::MAYOR;
+        case IrOp::MENOR_IGUAL: return IrOp::MAYOR_IGUAL;
+        case IrOp::MAYOR:       return IrOp::MENOR;
+        case IrOp::MAYOR_IGUAL: return IrOp::MENOR_IGUAL;
+        default:                return op;
+    }
+}
+
+// ==========================================
+// Tipos y funciones que el IR puede bajar
+// ==========================================
+
+static void typedefsLocales(Body* b, vector<TypedefDec*>& tds) {
+    if (!b) return;
+    for (TypedefDec* td : b->tdlist) tds.push_back(td);
+    for (Stm* s : b->stmList) {
+        if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+            typedefsLocales(i->thenBody, tds);
+            typedefsLocales(i->elseBody, tds);
+        } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+            typedefsLocales(w->body, tds);
+        } else if (ForStm* fs = dynamic_cast<ForStm*>(s)) {
+            typedefsLocales(fs->body, tds);
+        }
+    }
+}
+
+GeneradorIR::GeneradorIR(Program* program) {
+    escalares = {"int", "long", "bool", "unsigned int", "uint", "void"};
+    // Alias de tipos enteros (hasta que no aparezcan nuevos)
+    vector<TypedefDec*> tds(program->tdlist.begin(), program->tdlist.end());
+    for (FunDec* fd : program->fdlist) typedefsLocales(fd->body, tds);
+    bool cambio = true;
+    while (cambio) {
+        cambio = false;
+        for (TypedefDec* td : tds) {
+            if (escalares.count(td->typeName) && !escalares.count(td->alias)) {
+                escalares.insert(td->alias);
+                cambio = true;
+            }
+        }
+    }
+    for (FunDec* fd : program->fdlist) {
+        bool ok = escalares.count(fd->type) > 0 && fd->params.size() <= REGS_ARGUMENTOS.size();
+        for (ParamDec* p : fd->params) ok = ok && escalares.count(p->type) > 0;
+        if (ok) aridad[fd->id] = (int)fd->params.size();
+    }
+}
+
+// ==========================================
+// Salida de SSA y asignación de registros
+// ==========================================
+
+void GeneradorIR::separarAristasCriticas() {
+    int n = (int)f.bloques.size();
+    for (int p = 0; p < n; ++p) {
+        if (f.bloques[p].succs.size() < 2) continue;
+        for (size_t k = 0; k < 2; ++k) {
+            int s = f.bloques[p].instrs.back().bloques[k];
+            if (f.bloques[s].preds.size() < 2 || f.bloques[s].instrs.front().op != IrOp::PHI) continue;
+            // Bloque puente p -> nuevo -> s, donde irán las copias de las phis
+            int nuevo = (int)f.bloques.size();
+            for (IrInstr& phi : f.bloques[s].instrs) {
+                if (phi.op != IrOp::PHI) break;
+                for (int& pred : phi.bloques) if (pred == p) pred = nuevo;
+            }
+            f.bloques[p].instrs.back().bloques[k] = nuevo;
+            IrInstr salto;
+            salto.op = IrOp::SALTO;
+            salto.bloques = {s};
+            f.bloques.emplace_back();
+            f.bloques.back().instrs.push_back(salto);
+        }
+    }
+    f.calcularCfg();
+}
+
+void GeneradorIR::asignarRegistros() {
+    int n = (int)f.bloques.size();
+    int nt = (int)f.temps.size();
+
+    // Vida por bloque: usos expuestos (sin phis) y definiciones
+    vector<vector<int>> usados(n), definidos(n);
+    for (int b = 0; b < n; ++b) {
+        vector<char> def(nt, 0);
+        for (const IrInstr& i : f.bloques[b].instrs) {
+            if (i.op != IrOp::PHI) {
+                for (const IrValor& a : i.args)
+                    if (a.tipo == IrValor::TEMP && !def[a.temp]) usados[b].push_back(a.temp);
+            }
+            if (i.dst >= 0) {
+                def[i.dst] = 1;
+                definidos[b].push_back(i.dst);
+            }
+        }
+    }
+    vector<vector<char>> entrada(n, vector<char>(nt, 0)), salida(n, vector<char>(nt, 0));
+    bool cambio = true;
+    while (cambio) {
+        cambio = false;
+        for (auto it = orden.rbegin(); it != orden.rend(); ++it) {
+            int b = *it;
+            vector<char> out(nt, 0);
+            for (int s : f.bloques[b].succs) {
+                for (int t = 0; t < nt; ++t) out[t] |= entrada[s][t];
+                for (const IrInstr& phi : f.bloques[s].instrs) {
+                    if (phi.op != IrOp::PHI) break;
+                    for (size_t k = 0; k < phi.args.size(); ++k)
+                        if (phi.bloques[k] == b && phi.args[k].tipo == IrValor::TEMP) out[phi.args[k].temp] = 1;
+                }
+            }
+            vector<char> in = out;
+            for (int d : definidos[b]) in[d] = 0;
+            for (int u : usados[b]) in[u] = 1;
+            if (in != entrada[b] || out != salida[b]) {
+                entrada[b] = move(in);
+                salida[b] = move(out);
+                cambio = true;
+            }
+        }
+    }
+
+    // Intervalos sobre el orden de emisión (cada instrucción ocupa 2 posiciones)
+    vector<int> inicio(nt, INT_MAX), fin(nt, -1), iniBloque(n), finBloque(n);
+    vector<int> llamadas;
+    auto extender = [&](int t, int p) {
+        inicio[t] = min(inicio[t], p);
+        fin[t] = max(fin[t], p);
+    };
+    int pos = 0;
+    for (int b : orden) {
+        iniBloque[b] = pos;
+        pos += 2 * (int)f.bloques[b].instrs.size();
+        finBloque[b] = pos - 2;
+    }
+    for (int b : orden) {
+        for (int t = 0; t < nt; ++t) {
+            if (entrada[b][t]) extender(t, iniBloque[b]);
+            if (salida[b][t]) extender(t, finBloque[b]);
+        }
+        int p = iniBloque[b];
+        for (const IrInstr& i : f.bloques[b].instrs) {
+            if (i.op == IrOp::PHI) {
+                // Todas las phis del bloque se definen juntas, al entrar; sus
+                // argumentos se leen en la copia al final de cada predecesor
+                extender(i.dst, iniBloque[b]);
+                for (size_t k = 0; k < i.args.size(); ++k)
+                    if (i.args[k].tipo == IrValor::TEMP) extender(i.args[k].temp, finBloque[i.bloques[k]]);
+            } else {
+                for (const IrValor& a : i.args) if (a.tipo == IrValor::TEMP) extender(a.temp, p);
+                if (i.dst >= 0) extender(i.dst, p);
+            }
+            if (i.op == IrOp::LLAMADA || i.op == IrOp::IMPRIMIR) llamadas.push_back(p);
+            p += 2;
+        }
+    }
+
+    struct Intervalo {
+        int temp, inicio, fin;
+        bool cruzaLlamada;
+        int registro;
+    };
+    vector<Intervalo> lista;
+    for (int t = 0; t < nt; ++t) {
+        if (fin[t] < 0) continue;
+        bool cruza = false;
+        for (int c : llamadas) cruza = cruza || (inicio[t] < c && c < fin[t]);
+        lista.push_back({t, inicio[t], fin[t], cruza, -1});
+    }
+    sort(lista.begin(), lista.end(), [](const Intervalo& a, const Intervalo& b) {
+        return a.inicio != b.inicio ? a.inicio < b.inicio : a.temp < b.temp;
+    });
+
+    // Pistas: el argumento de una phi quiere el registro de su destino (la
+    // copia desaparece) y el resultado de a op b el de a si a muere ahí
+    vector<vector<int>> pistas(nt);
+    for (const IrBloque& bl : f.bloques) {
+        for (const IrInstr& i : bl.instrs) {
+            if (i.op == IrOp::PHI) {
+                for (const IrValor& a : i.args) if (a.tipo == IrValor::TEMP) pistas[a.temp].push_back(i.dst);
+            } else if (i.op == IrOp::SUMA || i.op == IrOp::RESTA || i.op == IrOp::MULT || i.op == IrOp::COPIA) {
+                if (i.args[0].tipo == IrValor::TEMP) pistas[i.dst].push_back(i.args[0].temp);
+            }
+        }
+    }
+    vector<int> registroDe(nt, -1);
+
+    // Linear scan (Poletto-Sarkar): sin registro libre se deja en la pila el
+    // intervalo activo compatible que termina más tarde. Un intervalo que
+    // termina donde empieza otro le cede el registro: cada instrucción lee
+    // sus operandos antes de escribir el destino
+    vector<char> libre(16, 0);
+    for (int r : CALLEE_SAVED) libre[r] = 1;
+    for (int r : CALLER_SAVED) libre[r] = 1;
+    auto aceptable = [](const Intervalo& iv, int r) {
+        return !iv.cruzaLlamada || find(CALLEE_SAVED.begin(), CALLEE_SAVED.end(), r) != CALLEE_SAVED.end();
+    };
+    vector<Intervalo*> activos;
+    for (Intervalo& iv : lista) {
+        for (size_t k = 0; k < activos.size();) {
+            if (activos[k]->fin <= iv.inicio) {
+                libre[activos[k]->registro] = 1;
+                activos.erase(activos.begin() + k);
+            } else {
+                k++;
+            }
+        }
+        for (int t : pistas[iv.temp]) {
+            int r = registroDe[t];
+            if (iv.registro < 0 && r >= 0 && libre[r] && aceptable(iv, r)) iv.registro = r;
+        }
+        if (!iv.cruzaLlamada) for (int r : CALLER_SAVED) if (iv.registro < 0 && libre[r]) iv.registro = r;
+        for (int r : CALLEE_SAVED) if (iv.registro < 0 && libre[r]) iv.registro = r;
+        if (iv.registro < 0) {
+            Intervalo* ultimo = nullptr;
+            for (Intervalo* a : activos)
+                if (aceptable(iv, a->registro) && (!ultimo || a->fin > ultimo->fin)) ultimo = a;
+            if (!ultimo || ultimo->fin <= iv.fin) continue;
+            iv.registro = ultimo->registro;
+            ultimo->registro = -1;
+            registroDe[ultimo->temp] = -1;
+            activos.erase(find(activos.begin(), activos.end(), ultimo));
+        } else {
+            libre[iv.registro] = 0;
+        }
+        registroDe[iv.temp] = iv.registro;
+        activos.push_back(&iv);
+    }
+
+    // Ubicaciones: slots de spill y, debajo, los callee-saved usados
+    ubic.assign(nt, Operando());
+    int slots = 0;
+    guardados.clear();
+    for (const Intervalo& iv : lista) {
+        if (iv.registro >= 0) ubic[iv.temp] = opReg(iv.registro);
+        else ubic[iv.temp] = opMem(RBP, -8 * (long)++slots);
+    }
+    for (int r : CALLEE_SAVED) {
+        for (const Intervalo& iv : lista) {
+            if (iv.registro == r) {
+                guardados.push_back(r);
+                break;
+            }
+        }
+    }
+    baseGuardados = -8 * (slots + 1);
+    espacio = (8 * (slots + (int)guardados.size()) + 15) & ~15;
+
+    if (reporte) {
+        int enPila = slots, phis = 0, instrs = 0;
+        for (const IrBloque& b : f.bloques) {
+            instrs += (int)b.instrs.size();
+            for (const IrInstr& i : b.instrs) phis += i.op == IrOp::PHI;
+        }
+        *reporte << "IR " << f.nombre << ": " << f.bloques.size() << " bloques, " << instrs
+                 << " instrucciones, " << phis << " phis, " << lista.size() - enPila
+                 << " temporales en registros, " << enPila << " en pila";
+        if (cse) *reporte << ", " << reutilizadas << " expresiones reutilizadas";
+        *reporte << endl;
+    }
+}
+
+// ==========================================
+// Movimientos
+// ==========================================
+
+void GeneradorIR::moverOp(const Operando& src, const Operando& dst) {
+    if (src == dst) return;
+    if (src.tipo == Operando::MEM && dst.tipo == Operando::MEM) {
+        codigo->ins(Op::MOVQ, src, opReg(RCX));
+        codigo->ins(Op::MOVQ, opReg(RCX), dst);
+        return;
+    }
+    codigo->ins(Op::MOVQ, src, dst);
+}
+
+void GeneradorIR::mover(const IrValor& v, const Operando& dst) {
+    if (v.tipo == IrValor::TEMP) {
+        moverOp(ubic[v.temp], dst);
+        return;
+    }
+    if (cabeEn32(v.k)) {
+        codigo->ins(Op::MOVQ, opImm(v.k), dst);
+    } else if (dst.tipo == Operando::REG) {
+        codigo->ins(Op::MOVABSQ, opImm(v.k), dst);
+    } else {
+        codigo->ins(Op::MOVABSQ, opImm(v.k), opReg(RCX));
+        codigo->ins(Op::MOVQ, opReg(RCX), dst);
+    }
+}
+
+// Operando fuente de una instrucción: $imm32, registro o memoria
+Operando GeneradorIR::fuente(const IrValor& v, int trabajo) {
+    if (v.tipo == IrValor::TEMP) return ubic[v.temp];
+    if (cabeEn32(v.k)) return opImm(v.k);
+    codigo->ins(Op::MOVABSQ, opImm(v.k), opReg(trabajo));
+    return opReg(trabajo);
+}
+
+// El valor en un registro (el suyo o el de trabajo)
+Operando GeneradorIR::aRegistro(const IrValor& v, int trabajo) {
+    if (v.tipo == IrValor::TEMP && ubic[v.temp].tipo == Operando::REG) return ubic[v.temp];
+    mover(v, opReg(trabajo));
+    return opReg(trabajo);
+}
+
+GeneradorIR::Copia GeneradorIR::copia(const Operando& dst, const IrValor& v) const {
+    return Copia{dst, v, v.tipo == IrValor::TEMP ? ubic[v.temp] : Operando()};
+}
+
+// Copia paralela: primero las copias cuyo destino nadie más lee; en un
+// ciclo se guarda un destino en %rax y sus lectores pasan a leer de ahí
+void GeneradorIR::moverParalelo(vector<Copia> pendientes) {
+    pendientes.erase(remove_if(pendientes.begin(), pendientes.end(), [](const Copia& c) {
+        return c.valor.tipo == IrValor::TEMP && c.src == c.dst;
+    }), pendientes.end());
+    auto leido = [&](const Operando& o, size_t salvo) {
+        for (size_t k = 0; k < pendientes.size(); ++k)
+            if (k != salvo && pendientes[k].valor.tipo == IrValor::TEMP && pendientes[k].src == o) return true;
+        return false;
+    };
+    while (!pendientes.empty()) {
+        size_t k = 0;
+        while (k < pendientes.size() && leido(pendientes[k].dst, k)) k++;
+        if (k == pendientes.size()) {
+            Operando d = pendientes[0].dst;
+            codigo->ins(Op::MOVQ, d, opReg(RAX));
+            for (Copia& c : pendientes)
+                if (c.valor.tipo == IrValor::TEMP && c.src == d) c.src = opReg(RAX);
+            continue;
+        }
+        const Copia& c = pendientes[k];
+        if (c.valor.tipo == IrValor::TEMP) moverOp(c.src, c.dst);
+        else mover(c.valor, c.dst);
+        pendientes.erase(pendientes.begin() + k);
+    }
+}
+
+// ==========================================
+// Emisión
+// ==========================================
+
+void GeneradorIR::emitirRetorno(const IrValor& v) {
+    mover(v, opReg(RAX));
+    for (size_t k = 0; k < guardados.size(); ++k)
+        codigo->ins(Op::MOVQ, opMem(RBP, baseGuardados - 8 * (long)k), opReg(guardados[k]));
+    codigo->ins(Op::LEAVE);
+    codigo->ins(Op::RET);
+}
+
+// Salto a verdadero si cond, si no a falso; el bloque siguiente no necesita jmp
+void GeneradorIR::emitirSalto(Op cond, int verdadero, int falso, size_t pos) {
+    int siguiente = pos + 1 < orden.size() ? orden[pos + 1] : -1;
+    if (verdadero == siguiente) {
+        codigo->ins(inverso(cond), opEtiqueta(etiquetas[falso]));
+        return;
+    }
+    codigo->ins(cond, opEtiqueta(etiquetas[verdadero]));
+    if (falso != siguiente) codigo->ins(Op::JMP, opEtiqueta(etiquetas[falso]));
+}
+
+// Comparación cuyo único uso es el salto condicional que la sigue
+bool GeneradorIR::comparacionFusionable(const IrBloque& b, size_t k) const {
+    const IrInstr& c = b.instrs[k];
+    if (!esComparacion(c.op) || k + 2 != b.instrs.size()) return false;
+    const IrInstr& t = b.instrs.back();
+    return t.op == IrOp::SALTO_COND && t.args[0] == irTemp(c.dst) && usos[c.dst] == 1;
+}
+
+void GeneradorIR::emitirBloque(size_t pos) {
+    int b = orden[pos];
+    const IrBloque& bl = f.bloques[b];
+    if (b != 0) codigo->definir(etiquetas[b]);
+    Op fusion = Op::JMP; // Salto de una comparación fusionada
+
+    for (size_t k = 0; k + 1 < bl.instrs.size(); ++k) {
+        const IrInstr& i = bl.instrs[k];
+        Operando d = i.dst >= 0 ? ubic[i.dst] : Operando();
+        switch (i.op) {
+            case IrOp::PHI:
+            case IrOp::PARAM:
+                break;
+            case IrOp::COPIA:
+                mover(i.args[0], d);
+                break;
+            case IrOp::SUMA: case IrOp::RESTA: case IrOp::MULT: {
+                IrValor a = i.args[0], c = i.args[1];
+                bool conmuta = i.op != IrOp::RESTA;
+                Operando r = d.tipo == Operando::REG ? d : opReg(RAX);
+                // Si el segundo operando ya está en el destino, se opera al revés o en %rax
+                if (c.tipo == IrValor::TEMP && ubic[c.temp] == r && !(a == c)) {
+                    if (conmuta) swap(a, c);
+                    else r = opReg(RAX);
+                }
+                mover(a, r);
+                Op op = i.op == IrOp::SUMA ? Op::ADDQ : i.op == IrOp::RESTA ? Op::SUBQ : Op::IMULQ;
+                codigo->ins(op, fuente(c, RCX), r);
+                moverOp(r, d);
+                break;
+            }
+            case IrOp::DIV:
+                mover(i.args[0], opReg(RAX));
+                codigo->ins(Op::CQO);
+                codigo->ins(Op::IDIVQ, aRegistro(i.args[1], RCX));
+                moverOp(opReg(RAX), d);
+                break;
+            case IrOp::IGUAL: case IrOp::DISTINTO: case IrOp::MENOR:
+            case IrOp::MENOR_IGUAL: case IrOp::MAYOR: case IrOp::MAYOR_IGUAL: {
+                IrValor a = i.args[0], c = i.args[1];
+                IrOp op = i.op;
+                if (a.tipo == IrValor::CONST && c.tipo == IrValor::TEMP) {
+                    swap(a, c);
+                    op = espejo(op);
+                }
+                Operando izq = aRegistro(a, RAX);
+                codigo->ins(Op::CMPQ, fuente(c, RCX), izq);
+                if (comparacionFusionable(bl, k)) {
+                    fusion = saltoDe(op);
+                    break;
+                }
+                codigo->ins(setDe(op), opReg(RAX, 8));
+                codigo->ins(Op::MOVZBQ, opReg(RAX, 8), opReg(RAX));
+                moverOp(opReg(RAX), d);
+                break;
+            }
+            case IrOp::LLAMADA: {
+                vector<Copia> copias;
+                for (size_t a = 0; a < i.args.size(); ++a) copias.push_back(copia(opReg(REGS_ARGUMENTOS[a]), i.args[a]));
+                moverParalelo(copias);
+                codigo->ins(Op::MOVL, opImm(0), opReg(RAX, 32));
+                codigo->ins(Op::CALL, opEtiqueta(codigo->etiqueta(i.funcion)));
+                if (usos[i.dst] > 0) moverOp(opReg(RAX), d);
+                break;
+            }
+            case IrOp::IMPRIMIR:
+                mover(i.args[0], opReg(RSI));
+                codigo->ins(Op::LEAQ, opRip(codigo->etiqueta("print_fmt_int")), opReg(RDI));
+                codigo->ins(Op::MOVL, opImm(0), opReg(RAX, 32));
+                codigo->ins(Op::CALL, opSimbolo("printf@PLT"));
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Copias de las phis del sucesor (con aristas críticas partidas, es único)
+    const IrInstr& t = bl.instrs.back();
+    if (t.op == IrOp::SALTO) {
+        vector<Copia> copias;
+        for (const IrInstr& phi : f.bloques[t.bloques[0]].instrs) {
+            if (phi.op != IrOp::PHI) break;
+            for (size_t k = 0; k < phi.args.size(); ++k)
+                if (phi.bloques[k] == b) copias.push_back(copia(ubic[phi.dst], phi.args[k]));
+        }
+        moverParalelo(copias);
+    }
+
+    switch (t.op) {
+        case IrOp::SALTO:
+            if (pos + 1 >= orden.size() || orden[pos + 1] != t.bloques[0])
+                codigo->ins(Op::JMP, opEtiqueta(etiquetas[t.bloques[0]]));
+            break;
+        case IrOp::SALTO_COND:
+            if (fusion == Op::JMP) {
+                codigo->ins(Op::CMPQ, opImm(0), aRegistro(t.args[0], RAX));
+                fusion = Op::JNE;
+            }
+            emitirSalto(fusion, t.bloques[0], t.bloques[1], pos);
+            break;
+        default:
+            emitirRetorno(t.args[0]);
+            break;
+    }
+}
+
+bool GeneradorIR::generar(FunDec* fd, AsmBuffer& buf) {
+    string motivo;
+    if (!construirIR(fd, escalares, aridad, f, motivo)) {
+        if (reporte) *reporte << "IR " << fd->id << ": se genera desde el AST (" << motivo << ")" << endl;
+        return false;
+    }
+    mem2reg(f);
+    reutilizadas = cse ? numerarValores(f) : 0;
+    if (volcado) volcarIR(f, *volcado);
+
+    codigo = &buf;
+    separarAristasCriticas();
+    orden = f.ordenRPO();
+    usos.assign(f.temps.size(), 0);
+    for (const IrBloque& b : f.bloques)
+        for (const IrInstr& i : b.instrs)
+            for (const IrValor& a : i.args)
+                if (a.tipo == IrValor::TEMP) usos[a.temp]++;
+    asignarRegistros();
+
+    etiquetas.assign(f.bloques.size(), -1);
+    for (size_t b = 1; b < f.bloques.size(); ++b)
+        etiquetas[b] = codigo->etiqueta(".L" + f.nombre + "_" + to_string(b));
+
+    // Prólogo: marco, callee-saved y parámetros a sus ubicaciones
+    codigo->definir(codigo->etiqueta(f.nombre));
+    codigo->ins(Op::PUSHQ, opReg(RBP));
+    codigo->ins(Op::MOVQ, opReg(RSP), opReg(RBP));
+    if (espacio > 0) codigo->ins(Op::SUBQ, opImm(espacio), opReg(RSP));
+    for (size_t k = 0; k < guardados.size(); ++k)
+        codigo->ins(Op::MOVQ, opReg(guardados[k]), opMem(RBP, baseGuardados - 8 * (long)k));
+    vector<Copia> params;
+    for (const IrInstr& i : f.bloques[0].instrs)
+        if (i.op == IrOp::PARAM && usos[i.dst] > 0)
+            params.push_back(Copia{ubic[i.dst], irTemp(i.dst), opReg(REGS_ARGUMENTOS[i.var])});
+    moverParalelo(params);
+
+    for (size_t pos = 0; pos < orden.size(); ++pos) emitirBloque(pos);
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef IR_CODEGEN_H
+#define IR_CODEGEN_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "asm_buffer.h"
+#include "ir.h"
+
+using namespace std;
+
+// ===========================================================
+//  Generador de código desde el IR SSA (--backend=ir)
+//  1. Salida de SSA: se parten las aristas críticas que llegan a bloques
+//     con phis y cada predecesor hace una copia paralela de los argumentos.
+//  2. Vida: live-in/live-out por bloque (los argumentos de una phi se usan
+//     al final del predecesor) y un intervalo por temporal sobre el RPO.
+//  3. Linear scan: los intervalos que cruzan una llamada van a callee-saved
+//     (%rbx, %r12-%r15); el resto prefiere caller-saved (%rsi, %rdi,
+//     %r8-%r11). %rax, %rcx y %rdx quedan como registros de trabajo.
+//  4. Selección: operaciones de dos direcciones sobre el registro destino y
+//     comparaciones fusionadas con el salto condicional que las consume.
+//  La convención de llamada es la de GenCodeVisitor, así que las funciones
+//  que el IR no baja (structs, floats, globales) las sigue generando él.
+// ===========================================================
+
+class GeneradorIR {
+public:
+    explicit GeneradorIR(Program* program);
+    // Emite fd en codigo desde el IR; false si no se puede bajar
+    bool generar(FunDec* fd, AsmBuffer& codigo);
+
+    ostream* volcado = nullptr; // --dump-ir: IR de cada función tras mem2reg
+    ostream* reporte = nullptr; // --stats: bloques, phis y registros por función
+    bool cse = false;           // --cse: numeración de valores sobre el SSA
+
+private:
+    unordered_set<string> escalares;
+    unordered_map<string, int> aridad;
+
+    // Estado de la función en curso
+    IrFuncion f;
+    AsmBuffer* codigo = nullptr;
+    vector<Operando> ubic;     // Registro o slot de cada temporal
+    vector<int> usos;          // Usos de cada temporal
+    vector<int> guardados;     // Callee-saved usados
+    int espacio = 0;           // Bytes reservados bajo %rbp
+    int baseGuardados = 0;     // Offset del primer callee-saved guardado
+    int reutilizadas = 0;      // Operaciones quitadas por la numeración de valores
+    vector<int> orden;         // Bloques en orden de emisión
+    vector<int> etiquetas;     // Etiqueta de cada bloque
+
+    void separarAristasCriticas();
+    void asignarRegistros();
+    void emitirBloque(size_t pos);
+    void emitirRetorno(const IrValor& v);
+    void emitirSalto(Op cond, int verdadero, int falso, size_t pos);
+    bool comparacionFusionable(const IrBloque& b, size_t k) const;
+    Operando aRegistro(const IrValor& v, int trabajo);
+    Operando fuente(const IrValor& v, int trabajo);
+    void mover(const IrValor& v, const Operando& dst);
+    void moverOp(const Operando& src, const Operando& dst);
+    // Copia de una copia paralela: src es la ubicación de valor si es temporal
+    struct Copia {
+        Operando dst;
+        IrValor valor;
+        Operando src;
+    };
+    Copia copia(const Operando& dst, const IrValor& v) const;
+    void moverParalelo(vector<Copia> pendientes);
+};
+
+#endif // IR_CODEGEN_H
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+#include "jit.h"
+#include "visitor.h"
+#include "x86_encoder.h"
+
+using namespace std;
+
+// ==========================================
+// Elegibilidad: solo código entero que GenCodeVisitor traduce con la
+// misma semántica que EvalVisitor
+// ==========================================
+
+static bool tipoEntero(const string& t) {
+    return t == "int" || t == "long";
+}
+
+// Todos los nombres declarados en el cuerpo (incluidos bloques anidados e init de for)
+static void recogerNombres(Body* b, unordered_set<string>& vars);
+
+static void recogerNombres(Stm* s, unordered_set<string>& vars) {
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) vars.insert(v);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        recogerNombres(i->thenBody, vars);
+        recogerNombres(i->elseBody, vars);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        recogerNombres(w->body, vars);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) recogerNombres(f->init, vars);
+        recogerNombres(f->body, vars);
+    }
+}
+
+static void recogerNombres(Body* b, unordered_set<string>& vars) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) vars.insert(v);
+    for (InstanceDec* ind : b->intances) recogerNombres(ind, vars);
+    for (Stm* s : b->stmList) recogerNombres(s, vars);
+}
+
+static bool expElegible(Exp* e, const unordered_set<string>& vars, vector<FcallExp*>& llamadas) {
+    if (!e) return false;
+    if (dynamic_cast<NumberExp*>(e) || dynamic_cast<BoolExp*>(e)) return true;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) return vars.count(id->value) > 0;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        switch (b->op) {
+            case PLUS_OP: case MINUS_OP: case MUL_OP:
+            case GT_OP: case LT_OP: case GE_OP: case LE_OP: case EQ_OP: case NE_OP:
+                break;
+            case DIV_OP:
+                // El intérprete aborta en división por 0; en nativo sería SIGFPE
+                if (b->right->cont != 1 || b->right->valor == 0 || b->right->valor == -1) return false;
+                break;
+            default:
+                return false;
+        }
+        return expElegible(b->left, vars, llamadas) && expElegible(b->right, vars, llamadas);
+    }
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        return expElegible(t->condition, vars, llamadas) &&
+               expElegible(t->trueExp, vars, llamadas) &&
+               expElegible(t->falseExp, vars, llamadas);
+    }
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) if (!expElegible(a, vars, llamadas)) return false;
+        llamadas.push_back(fc);
+        return true;
+    }
+    return false;
+}
+
+static bool bodyElegible(Body* b, const unordered_set<string>& vars, vector<FcallExp*>& llamadas);
+
+static bool stmElegible(Stm* s, const unordered_set<string>& vars, vector<FcallExp*>& llamadas) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s))
+        return vars.count(a->id) > 0 && expElegible(a->e, vars, llamadas);
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        if (!tipoEntero(ind->type)) return false;
+        for (InitData* d : ind->values)
+            if (!d->e || !expElegible(d->e, vars, llamadas)) return false;
+        return true;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        return expElegible(i->condition, vars, llamadas) && bodyElegible(i->thenBody, vars, llamadas) &&
+               (!i->elseBody || bodyElegible(i->elseBody, vars, llamadas));
+    }
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s))
+        return expElegible(w->condition, vars, llamadas) && bodyElegible(w->body, vars, llamadas);
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init && !stmElegible(f->init, vars, llamadas)) return false;
+        if (!f->step || !expElegible(f->condition, vars, llamadas)) return false;
+        IdExp* id = dynamic_cast<IdExp*>(f->step->variable);
+        if (!id || !vars.count(id->value)) return false;
+        if (f->step->type == StepExp::COMPOUND && !expElegible(f->step->amount, vars, llamadas)) return false;
+        return bodyElegible(f->body, vars, llamadas);
+    }
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return r->e && expElegible(r->e, vars, llamadas);
+    return false; // printf y cualquier otra sentencia quedan en el intérprete
+}
+
+static bool bodyElegible(Body* b, const unordered_set<string>& vars, vector<FcallExp*>& llamadas) {
+    if (!b->tdlist.empty()) return false;
+    for (VarDec* vd : b->declarations) if (!tipoEntero(vd->type)) return false;
+    for (InstanceDec* ind : b->intances) if (!stmElegible(ind, vars, llamadas)) return false;
+    for (Stm* s : b->stmList) if (!stmElegible(s, vars, llamadas)) return false;
+    return true;
+}
+
+// Llamadas en posición de cola (return f(...), también en las ramas de un
+// ternario): GenCodeVisitor las genera como saltos, no crecen la pila
+static void llamadasEnCola(Exp* e, unordered_set<FcallExp*>& cola) {
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        cola.insert(fc);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        llamadasEnCola(t->trueExp, cola);
+        llamadasEnCola(t->falseExp, cola);
+    }
+}
+
+static void llamadasEnCola(Body* b, unordered_set<FcallExp*>& cola);
+
+static void llamadasEnCola(Stm* s, unordered_set<FcallExp*>& cola) {
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        if (r->e) llamadasEnCola(r->e, cola);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        llamadasEnCola(i->thenBody, cola);
+        llamadasEnCola(i->elseBody, cola);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        llamadasEnCola(w->body, cola);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        llamadasEnCola(f->body, cola);
+    }
+}
+
+static void llamadasEnCola(Body* b, unordered_set<FcallExp*>& cola) {
+    if (!b) return;
+    for (Stm* s : b->stmList) llamadasEnCola(s, cola);
+}
+
+// ==========================================
+// TieredJit
+// ==========================================
+
+TieredJit::TieredJit(Program* program, long umbral) : program(program), umbral(umbral) {
+    if (program) for (FunDec* fd : program->fdlist) funciones[fd->id] = fd;
+}
+
+TieredJit::~TieredJit() {
+    for (auto& b : buffers) liberarMemoria(b.first, b.second);
+}
+
+TieredJit::Perfil* TieredJit::perfil(FunDec* fd) {
+    return &perfiles[fd];
+}
+
+bool TieredJit::preparar(FunDec* fd, Perfil* p) {
+    if (p->estado == COMPILADO) return true;
+    if (p->estado == NO_ELEGIBLE) return false;
+    if (p->llamadas + p->saltos < umbral) return false;
+    return compilar(fd);
+}
+
+// Agrega fd y todas las funciones que llama a la unidad de compilación
+bool TieredJit::elegible(FunDec* fd, vector<FunDec*>& unidad) {
+    if (find(unidad.begin(), unidad.end(), fd) != unidad.end()) return true;
+    if (perfiles[fd].estado == NO_ELEGIBLE) return false;
+    if (fd->id == "main" || !tipoEntero(fd->type) || fd->params.size() > 6) return false;
+
+    unordered_set<string> vars;
+    for (ParamDec* p : fd->params) {
+        if (!tipoEntero(p->type)) return false;
+        vars.insert(p->id);
+    }
+    recogerNombres(fd->body, vars);
+
+    vector<FcallExp*> llamadas;
+    if (!bodyElegible(fd->body, vars, llamadas)) return false;
+
+    unidad.push_back(fd); // Antes de las llamadas: permite recursión
+    for (FcallExp* fc : llamadas) {
+        auto it = funciones.find(fc->name);
+        if (it == funciones.end() || it->second->params.size() != fc->arguments.size()) return false;
+        if (!elegible(it->second, unidad)) return false;
+    }
+    return true;
+}
+
+// Recursión (directa o mutua) con alguna llamada fuera de cola: en nativo
+// crecería la pila del hilo sin el límite de --max-recursion ni la pila
+// segmentada del intérprete, así que esas unidades siguen interpretadas
+bool TieredJit::recursionSinCola(const vector<FunDec*>& unidad) {
+    unordered_map<FunDec*, vector<FunDec*>> llama;
+    vector<pair<FunDec*, FunDec*>> sinCola;
+    for (FunDec* f : unidad) {
+        unordered_set<string> vars;
+        for (ParamDec* p : f->params) vars.insert(p->id);
+        recogerNombres(f->body, vars);
+        vector<FcallExp*> llamadas;
+        bodyElegible(f->body, vars, llamadas);
+        unordered_set<FcallExp*> cola;
+        llamadasEnCola(f->body, cola);
+        for (FcallExp* fc : llamadas) {
+            FunDec* g = funciones[fc->name];
+            llama[f].push_back(g);
+            if (!cola.count(fc)) sinCola.push_back({f, g});
+        }
+    }
+    for (auto& arista : sinCola) {
+        // ¿g vuelve a llamar a f?
+        vector<FunDec*> pendientes = {arista.second};
+        unordered_set<FunDec*> vistas;
+        while (!pendientes.empty()) {
+            FunDec* g = pendientes.back();
+            pendientes.pop_back();
+            if (g == arista.first) return true;
+            if (!vistas.insert(g).second) continue;
+            for (FunDec* h : llama[g]) pendientes.push_back(h);
+        }
+    }
+    return false;
+}
+
+bool TieredJit::compilar(FunDec* fd) {
+    vector<FunDec*> unidad;
+    if (!elegible(fd, unidad) || recursionSinCola(unidad)) {
+        perfiles[fd].estado = NO_ELEGIBLE;
+        return false;
+    }
+
+    // Código de la unidad con la selección de instrucciones de GenCodeVisitor
+    // (sus mensajes DEBUG a cerr se descartan)
+    ostringstream descartado;
+    streambuf* oldCerr = cerr.rdbuf(descartado.rdbuf());
+    GenCodeVisitor gen(descartado);
+    gen.enteros32 = true;
+    gen.licm = licm;
+    // La recursión en cola de la unidad se vuelve un bucle en código nativo
+    gen.llamadasCola = true;
+    gen.conocerFunciones(unidad);
+    for (FunDec* f : unidad) f->accept(&gen);
+    cerr.rdbuf(oldCerr);
+
+    X86Encoder enc;
+    vector<uint8_t> imagen;
+    if (!enc.ensamblar(gen.buffer()) || !enc.enlazarLocal({}, imagen)) {
+        perfiles[fd].estado = NO_ELEGIBLE;
+        return false;
+    }
+
+    // Copiar a memoria ejecutable (W^X: primero escribible, luego solo ejecución)
+    void* mem = cargarEnMemoria(imagen);
+    if (!mem) {
+        perfiles[fd].estado = NO_ELEGIBLE;
+        return false;
+    }
+    buffers.push_back({mem, imagen.size()});
+
+    for (FunDec* f : unidad) {
+        Perfil& p = perfiles[f];
+        p.entrada = (uint8_t*)mem + enc.etiqueta(f->id);
+        p.estado = COMPILADO;
+        totalCompiladas++;
+    }
+    return true;
+}
+
+long TieredJit::invocar(void* entrada, const vector<long>& a) {
+    switch (a.size()) {
+        case 0: return ((long (*)())entrada)();
+        case 1: return ((long (*)(long))entrada)(a[0]);
+        case 2: return ((long (*)(long, long))entrada)(a[0], a[1]);
+        case 3: return ((long (*)(long, long, long))entrada)(a[0], a[1], a[2]);
+        case 4: return ((long (*)(long, long, long, long))entrada)(a[0], a[1], a[2], a[3]);
+        case 5: return ((long (*)(long, long, long, long, long))entrada)(a[0], a[1], a[2], a[3], a[4]);
+        default: return ((long (*)(long, long, long, long, long, long))entrada)(a[0], a[1], a[2], a[3], a[4], a[5]);
+    }
+}
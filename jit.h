@@ -0,0 +1,67 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+class ExtractorInvariantes;
+
+// ===========================================================
+//  Ejecución por niveles (tiered)
+//  Las funciones empiezan interpretadas por EvalVisitor, que cuenta
+//  llamadas y saltos hacia atrás de sus bucles. Cuando una función
+//  supera el umbral se genera su código con GenCodeVisitor (modo
+//  enteros32, misma aritmética de int que el intérprete), se ensambla
+//  en memoria con X86Encoder y se copia a un buffer ejecutable (mmap).
+//  Desde entonces las llamadas a esa función saltan directo al código
+//  nativo. Solo son elegibles funciones puramente enteras: parámetros,
+//  locales y retorno int/long, sin printf, structs, floats, globales ni
+//  divisiones que puedan fallar; las funciones a las que llaman deben
+//  ser elegibles también (se compilan en la misma unidad). La recursión
+//  solo se compila si todas sus llamadas están en cola (son saltos).
+// ===========================================================
+
+class TieredJit {
+public:
+    enum Estado { FRIO, COMPILADO, NO_ELEGIBLE };
+
+    // Contadores y estado de una función
+    struct Perfil {
+        long llamadas = 0;
+        long saltos = 0;            // Iteraciones de bucle (back-edges)
+        Estado estado = FRIO;
+        void* entrada = nullptr;    // Código nativo, si estado == COMPILADO
+    };
+
+    TieredJit(Program* program, long umbral);
+    ~TieredJit();
+
+    Perfil* perfil(FunDec* fd);
+    // true si la función tiene (o acaba de obtener) código nativo
+    bool preparar(FunDec* fd, Perfil* p);
+    // Llama al código nativo con hasta 6 argumentos enteros
+    static long invocar(void* entrada, const vector<long>& args);
+
+    int compiladas() const { return totalCompiladas; }
+
+    // --licm: el código nativo también calcula los invariantes en el preheader
+    const ExtractorInvariantes* licm = nullptr;
+
+private:
+    Program* program;
+    long umbral;
+    int totalCompiladas = 0;
+    unordered_map<FunDec*, Perfil> perfiles;
+    unordered_map<string, FunDec*> funciones;
+    vector<pair<void*, size_t>> buffers;   // Memoria ejecutable reservada
+
+    bool elegible(FunDec* fd, vector<FunDec*>& unidad);
+    bool recursionSinCola(const vector<FunDec*>& unidad);
+    bool compilar(FunDec* fd);
+};
+
+#endif // JIT_H
@@ -0,0 +1,242 @@
+#include "licm.h"
+
+using namespace std;
+
+// ==========================================
+// Análisis del bucle
+// ==========================================
+
+static string raizDe(const string& nombre) {
+    return nombre.substr(0, nombre.find('.'));
+}
+
+void ExtractorInvariantes::escrituras(Body* b, unordered_set<string>& vars) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) vars.insert(v);
+    for (InstanceDec* ind : b->intances) escrituras(ind, vars);
+    for (Stm* s : b->stmList) escrituras(s, vars);
+}
+
+void ExtractorInvariantes::escrituras(Stm* s, unordered_set<string>& vars) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        vars.insert(raizDe(a->id));
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) vars.insert(v);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        escrituras(i->thenBody, vars);
+        escrituras(i->elseBody, vars);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        escrituras(w->body, vars);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) escrituras(f->init, vars);
+        escrituras(f->body, vars);
+        if (f->step) {
+            if (IdExp* id = dynamic_cast<IdExp*>(f->step->variable)) vars.insert(raizDe(id->value));
+        }
+    }
+}
+
+bool ExtractorInvariantes::hayLlamada(Exp* e) {
+    if (!e) return false;
+    if (dynamic_cast<FcallExp*>(e)) return true;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return hayLlamada(b->left) || hayLlamada(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return hayLlamada(t->condition) || hayLlamada(t->trueExp) || hayLlamada(t->falseExp);
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return hayLlamada(st->amount);
+    return false;
+}
+
+bool ExtractorInvariantes::hayLlamada(Body* b) {
+    if (!b) return false;
+    for (InstanceDec* ind : b->intances) if (hayLlamada(ind)) return true;
+    for (Stm* s : b->stmList) if (hayLlamada(s)) return true;
+    return false;
+}
+
+bool ExtractorInvariantes::hayLlamada(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return hayLlamada(a->e);
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* init : ind->values) {
+            if (init->e && hayLlamada(init->e)) return true;
+            if (init->st) for (Exp* e : init->st->argumentos) if (hayLlamada(e)) return true;
+        }
+        return false;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s))
+        return hayLlamada(i->condition) || hayLlamada(i->thenBody) || hayLlamada(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return hayLlamada(w->condition) || hayLlamada(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s))
+        return (f->init && hayLlamada(f->init)) || hayLlamada(f->condition) || hayLlamada(f->step) ||
+               hayLlamada(f->body);
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) if (hayLlamada(e)) return true;
+        return false;
+    }
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return hayLlamada(r->e);
+    return false;
+}
+
+// Divisor que no puede provocar un error al adelantar la división
+bool ExtractorInvariantes::divisorSeguro(Exp* e) {
+    if (NumberExp* n = dynamic_cast<NumberExp*>(e)) return n->value != 0;
+    return e->cont == 1 && e->valor != 0 && e->valor != -1;
+}
+
+// ==========================================
+// Invariantes
+// ==========================================
+
+bool ExtractorInvariantes::invariante(Exp* e) const {
+    if (temporalDe.count(e) || e->cont == 1 || e->claseCont >= 0) return true;
+    if (dynamic_cast<NumberExp*>(e) || dynamic_cast<BoolExp*>(e) || dynamic_cast<FloatExp*>(e)) return true;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        string raiz = raizDe(id->value);
+        return !escritas.count(raiz) && !(llamadas && globales.count(raiz));
+    }
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        switch (b->op) {
+            case PLUS_OP: case MINUS_OP: case MUL_OP:
+            case GT_OP: case LT_OP: case GE_OP: case LE_OP: case EQ_OP: case NE_OP:
+                break;
+            case DIV_OP:
+                if (!divisorSeguro(b->right)) return false;
+                break;
+            default:
+                return false;
+        }
+        return invariante(b->left) && invariante(b->right);
+    }
+    return false;
+}
+
+void ExtractorInvariantes::marcar(Exp* e) {
+    temporalDe[e] = usados++;
+    destino->push_back(e);
+}
+
+// Marca los subárboles invariantes máximos de e. Solo una lectura de campo
+// que es operando de un BinaryExp es con seguridad un escalar.
+void ExtractorInvariantes::mover(Exp* e, bool operando) {
+    if (!e || temporalDe.count(e) || e->cont == 1 || e->claseCont >= 0) return;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        if (invariante(b)) {
+            marcar(b);
+            return;
+        }
+        mover(b->left, true);
+        mover(b->right, true);
+    } else if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        if (operando && id->value.find('.') != string::npos && invariante(id)) marcar(id);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        mover(t->condition, true);
+        mover(t->trueExp, false);
+        mover(t->falseExp, false);
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) mover(a, false);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        mover(st->amount, true);
+    }
+}
+
+void ExtractorInvariantes::mover(Body* b) {
+    if (!b) return;
+    for (InstanceDec* ind : b->intances) mover(ind);
+    for (Stm* s : b->stmList) mover(s);
+}
+
+void ExtractorInvariantes::mover(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        mover(a->e, false);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* init : ind->values) {
+            if (init->e) mover(init->e, false);
+            if (init->st) for (Exp* e : init->st->argumentos) mover(e, false);
+        }
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        mover(i->condition, true);
+        mover(i->thenBody);
+        mover(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        mover(w->condition, true);
+        mover(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) mover(f->init);
+        mover(f->condition, true);
+        mover(f->body);
+        mover(f->step, true);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) mover(e, true);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        mover(r->e, false);
+    }
+}
+
+// ==========================================
+// Bucles
+// ==========================================
+
+void ExtractorInvariantes::bucle(Exp* cond, Body* body, StepExp* st, vector<Exp*>& invariantes) {
+    bucles++;
+    escritas.clear();
+    escrituras(body, escritas);
+    if (st) {
+        if (IdExp* id = dynamic_cast<IdExp*>(st->variable)) escritas.insert(raizDe(id->value));
+    }
+    llamadas = hayLlamada(cond) || hayLlamada(body) || hayLlamada(st);
+    destino = &invariantes;
+    mover(cond, true);
+    mover(body);
+    mover(st, true);
+    // Después, los bucles anidados sobre lo que quedó
+    recorrer(body);
+}
+
+void ExtractorInvariantes::recorrer(Body* b) {
+    if (!b) return;
+    for (Stm* s : b->stmList) recorrer(s);
+}
+
+void ExtractorInvariantes::recorrer(Stm* s) {
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        recorrer(i->thenBody);
+        recorrer(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        bucle(w->condition, w->body, nullptr, deBucle[w]);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        bucle(f->condition, f->body, f->step, deBucle[f]);
+    }
+}
+
+void ExtractorInvariantes::funcion(FunDec* fd) {
+    usados = 0;
+    bucles = 0;
+    recorrer(fd->body);
+    temporalesDe[fd] = usados;
+    if (reporte) {
+        *reporte << "LICM " << fd->id << ": " << usados << " expresiones invariantes en "
+                 << bucles << " bucles" << endl;
+    }
+}
+
+int ExtractorInvariantes::temporal(Exp* e) const {
+    auto it = temporalDe.find(e);
+    return it == temporalDe.end() ? -1 : it->second;
+}
+
+const vector<Exp*>& ExtractorInvariantes::invariantes(Stm* bucle) const {
+    static const vector<Exp*> ninguno;
+    auto it = deBucle.find(bucle);
+    return it == deBucle.end() ? ninguno : it->second;
+}
+
+int ExtractorInvariantes::temporales(FunDec* fd) const {
+    auto it = temporalesDe.find(fd);
+    return it == temporalesDe.end() ? 0 : it->second;
+}
+
+void ExtractorInvariantes::extraer(Program* program) {
+    globales.clear();
+    for (VarDec* vd : program->vdlist) for (const string& var : vd->vars) globales.insert(var);
+    for (InstanceDec* ind : program->intdlist) for (const string& var : ind->vars) globales.insert(var);
+    for (FunDec* fd : program->fdlist) funcion(fd);
+}
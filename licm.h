@@ -0,0 +1,76 @@
+#ifndef LICM_H
+#define LICM_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  Movimiento de código invariante de bucles (--licm)
+//  En cada WhileStm/ForStm se buscan los subárboles máximos que valen lo
+//  mismo en todas las iteraciones: BinaryExp cuyas variables no se
+//  escriben en el bucle (AssignStm, StepExp, declaraciones del cuerpo y
+//  de bucles anidados) y lecturas de campo "p.x" usadas como operando.
+//  Una llamada en el bucle puede escribir globales: entonces ningún
+//  global es invariante. Las expresiones con llamadas no se mueven nunca
+//  y la división solo con divisor constante (el preheader se ejecuta
+//  aunque el bucle dé cero vueltas).
+//  Cada invariante recibe un temporal de la función (temporal()) y se
+//  agrega a la lista del bucle (invariantes()); GenCodeVisitor, EvalVisitor y el motor
+//  de closures la calculan una vez antes de la cabecera (tras el init
+//  del for) y dentro del bucle solo leen el temporal. Los bucles se
+//  recorren de fuera hacia dentro: lo invariante en el externo ya no se
+//  recalcula en el preheader del interno.
+// ===========================================================
+
+class ExtractorInvariantes {
+public:
+    void extraer(Program* program);
+
+    ostream* reporte = nullptr; // --stats: invariantes movidos por función
+
+    // Resultados por nodo para los intérpretes y el generador
+    int temporal(Exp* e) const;                         // -1 si no es invariante
+    const vector<Exp*>& invariantes(Stm* bucle) const;  // Vacía si no tiene
+    int temporales(FunDec* fd) const;                   // Slots del marco de la función
+
+private:
+    unordered_map<Exp*, int> temporalDe;
+    unordered_map<Stm*, vector<Exp*>> deBucle;
+    unordered_map<FunDec*, int> temporalesDe;
+
+    unordered_set<string> globales;
+
+    // Estado de la función en curso
+    int usados = 0;     // Temporales asignados
+    int bucles = 0;
+
+    // Estado del bucle en curso
+    unordered_set<string> escritas; // Raíces de las variables que escribe
+    bool llamadas = false;          // Contiene alguna llamada
+    vector<Exp*>* destino = nullptr;
+
+    static void escrituras(Body* b, unordered_set<string>& vars);
+    static void escrituras(Stm* s, unordered_set<string>& vars);
+    static bool hayLlamada(Exp* e);
+    static bool hayLlamada(Body* b);
+    static bool hayLlamada(Stm* s);
+    static bool divisorSeguro(Exp* e);
+
+    bool invariante(Exp* e) const;
+    void marcar(Exp* e);
+    void mover(Exp* e, bool operando);
+    void mover(Body* b);
+    void mover(Stm* s);
+    void bucle(Exp* cond, Body* body, StepExp* st, vector<Exp*>& invariantes);
+    void recorrer(Body* b);
+    void recorrer(Stm* s);
+    void funcion(FunDec* fd);
+};
+
+#endif // LICM_H
@@ -1,26 +1,160 @@
+#include <climits>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include "scanner.h"
 #include "parser.h"
 #include "ast.h"
 #include "TypeChecker.h"
 #include "visitor.h"
+#include "closure_engine.h"
+#include "jit.h"
+#include "native_runner.h"
+#include "elf_writer.h"
+#include "peephole.h"
+#include "ir_codegen.h"
+#include "constprop.h"
+#include "cse.h"
+#include "licm.h"
+#include "induccion.h"
+#include "scev.h"
+#include "desenrollado.h"
+#include "expansion.h"
+#include "pila.h"
+#include "pureza.h"
+#include "plegado.h"
+#include "especializacion.h"
 
 using namespace std;
 
 int main(int argc, const char* argv[]) {
-    // Verificar número de argumentos
-    if (argc != 2) {
+    // Separar opciones (--opcion) del archivo de entrada
+    string archivo;
+    string motor = "eval"; // Motor del intérprete: eval | closure
+    bool tiered = false;   // Compilar a nativo las funciones calientes (solo eval)
+    long umbralJit = 1000; // Llamadas + iteraciones antes de compilar
+    bool runNative = false; // Ejecutar el código generado en el propio proceso
+    string emitir = "asm";  // Salida del backend: asm (.s) | obj (.o ELF) | exe (ELF estático)
+    bool peephole = false;  // Optimizador peephole sobre el código generado
+    bool regalloc = false;  // Locales escalares en registros (linear scan)
+    bool stats = false;     // Reportes de las optimizaciones en cerr
+    string backend = "ast"; // Generador: ast (GenCodeVisitor) | ir (IR SSA, con respaldo en el AST)
+    bool dumpIr = false;    // Volcar el IR de cada función en outputs/<base>.ir
+    bool sccp = false;      // Propagación de constantes antes de interpretar y generar
+    bool cse = false;       // Reutilizar subexpresiones repetidas en el código generado
+    bool licm = false;      // Sacar de los bucles las expresiones invariantes
+    bool iv = false;        // Reducción de fuerza sobre variables de inducción
+    bool scev = false;      // Bucles de acumulación en forma cerrada
+    bool enLinea = false;   // Expandir en línea las llamadas a funciones pequeñas
+    bool tco = false;       // Llamadas en cola como saltos en el código generado
+    bool rotar = false;     // Condición de los bucles al final del cuerpo
+    int desenrollar = 0;    // Vueltas por iteración de los bucles contados (0: no)
+    long maxRecursion = LIMITE_RECURSION; // Llamadas anidadas en el intérprete (0: sin límite)
+    long memo = 0;          // Entradas de la caché de funciones puras en el intérprete (0: no)
+    long ctfe = 0;          // Combustible por llamada pura evaluada al compilar (0: no)
+    int especializar = 0;   // Crecimiento permitido (%) al especializar funciones (0: no)
+    int cmov = -1;          // Costo máximo de las ramas convertidas a cmovcc (-1: no)
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--engine=", 0) == 0) {
+            motor = arg.substr(9);
+        } else if (arg == "--tiered") {
+            tiered = true;
+        } else if (arg.rfind("--jit-threshold=", 0) == 0) {
+            umbralJit = atol(arg.c_str() + 16);
+        } else if (arg == "--run-native") {
+            runNative = true;
+        } else if (arg.rfind("--emit=", 0) == 0) {
+            emitir = arg.substr(7);
+        } else if (arg == "--peephole") {
+            peephole = true;
+        } else if (arg == "--regalloc") {
+            regalloc = true;
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg.rfind("--backend=", 0) == 0) {
+            backend = arg.substr(10);
+        } else if (arg == "--dump-ir") {
+            dumpIr = true;
+        } else if (arg == "--sccp") {
+            sccp = true;
+        } else if (arg == "--cse") {
+            cse = true;
+        } else if (arg == "--licm") {
+            licm = true;
+        } else if (arg == "--iv") {
+            iv = true;
+        } else if (arg == "--scev") {
+            scev = true;
+        } else if (arg == "--inline") {
+            enLinea = true;
+        } else if (arg == "--tco") {
+            tco = true;
+        } else if (arg == "--rotate") {
+            rotar = true;
+        } else if (arg == "--unroll") {
+            rotar = true;
+            desenrollar = 4;
+        } else if (arg.rfind("--unroll=", 0) == 0) {
+            rotar = true;
+            desenrollar = atoi(arg.c_str() + 9);
+        } else if (arg == "--memo") {
+            memo = CAPACIDAD_MEMO;
+        } else if (arg.rfind("--memo=", 0) == 0) {
+            memo = atol(arg.c_str() + 7);
+        } else if (arg == "--specialize") {
+            especializar = CRECIMIENTO_ESPECIALIZACION;
+        } else if (arg.rfind("--specialize=", 0) == 0) {
+            especializar = atoi(arg.c_str() + 13);
+        } else if (arg == "--cmov") {
+            cmov = COSTO_SELECCION;
+        } else if (arg.rfind("--cmov=", 0) == 0) {
+            cmov = atoi(arg.c_str() + 7);
+        } else if (arg == "--ctfe") {
+            ctfe = COMBUSTIBLE_PLEGADO;
+        } else if (arg.rfind("--ctfe=", 0) == 0) {
+            ctfe = atol(arg.c_str() + 7);
+        } else if (arg.rfind("--max-recursion=", 0) == 0) {
+            maxRecursion = atol(arg.c_str() + 16);
+        } else if (arg.rfind("--", 0) == 0) {
+            cout << "Opción desconocida: " << arg << endl;
+            return 1;
+        } else if (archivo.empty()) {
+            archivo = arg;
+        } else {
+            archivo.clear();
+            break;
+        }
+    }
+
+    // Verificar argumentos
+    bool emitirValido = emitir == "asm" || emitir == "obj" || emitir == "exe";
+    bool backendValido = backend == "ast" || backend == "ir";
+    if (archivo.empty() || (motor != "eval" && motor != "closure") || (tiered && motor != "eval") || !emitirValido ||
+        !backendValido || (dumpIr && backend != "ir") || desenrollar < 0 || maxRecursion < 0 || maxRecursion > INT_MAX ||
+        memo < 0 || memo > (1L << 24) || ctfe < 0 ||
+        especializar < 0 || cmov < -1) {
         cout << "Número incorrecto de argumentos.\n";
-        cout << "Uso: " << argv[0] << " <archivo_de_entrada>" << endl;
+        cout << "Uso: " << argv[0] << " [--engine=eval|closure] [--tiered [--jit-threshold=N]] [--run-native] [--emit=asm|obj|exe] [--peephole] [--regalloc] [--backend=ast|ir [--dump-ir]] [--sccp] [--cse] [--licm] [--iv] [--scev] [--inline] [--rotate] [--unroll[=F]] [--tco] [--max-recursion=N] [--memo[=N]] [--ctfe[=N]] [--specialize[=N]] [--cmov[=N]] [--stats] <archivo_de_entrada>" << endl;
         return 1;
     }
 
+    // El backend IR baja cada función desde sus expresiones: las anotaciones
+    // de estos pases solo llegan a las funciones que genera el AST (respaldo)
+    auto avisoIr = [&](bool activo, const char* opcion) {
+        if (activo && backend == "ir")
+            cerr << "Aviso: " << opcion << " no se aplica a las funciones que baja --backend=ir" << endl;
+    };
+    avisoIr(licm, "--licm");
+    avisoIr(iv, "--iv");
+    avisoIr(scev, "--scev");
+    avisoIr(rotar, desenrollar ? "--unroll" : "--rotate");
+
     // Abrir archivo de entrada
-    ifstream infile(argv[1]);
+    ifstream infile(archivo);
     if (!infile.is_open()) {
-        cout << "No se pudo abrir el archivo: " << argv[1] << endl;
+        cout << "No se pudo abrir el archivo: " << archivo << endl;
         return 1;
     }
 
@@ -37,7 +171,7 @@ int main(int argc, const char* argv[]) {
 
     // Ejecutar scanner en un scanner separado para generar archivo de tokens
     Scanner scanner_for_tokens(input.c_str());
-    ejecutar_scanner(&scanner_for_tokens, string(argv[1]));
+    ejecutar_scanner(&scanner_for_tokens, archivo);
 
     // Crear instancias de Parser
     Parser parser(&scanner2);
@@ -58,7 +192,7 @@ int main(int argc, const char* argv[]) {
     }
 
     // Obtener el nombre base del archivo de entrada
-    string inputFile(argv[1]);
+    string inputFile(archivo);
     string baseName = inputFile;
     size_t lastSlash = baseName.find_last_of("/\\");
     if (lastSlash != string::npos) {
@@ -101,30 +235,179 @@ int main(int argc, const char* argv[]) {
     TypeChecker checker;
     checker.typecheck(ast);
 
-    // Ejecutar y guardar la salida del PrintVisitor y EvalVisitor
+    // Anotar las constantes propagadas (las usan el intérprete y el generador)
+    if (sccp) {
+        PropagadorConstantes propagador;
+        if (stats) propagador.reporte = &cerr;
+        propagador.propagar(ast);
+    }
+
+    // Bucles de acumulación en forma cerrada (intérpretes y generador)
+    EvolucionEscalar evolucion;
+    if (scev) {
+        if (stats) evolucion.reporte = &cerr;
+        evolucion.analizar(ast);
+    }
+    const EvolucionEscalar* formas = scev ? &evolucion : nullptr;
+
+    // Marcar los invariantes de bucle (preheader en el intérprete y en el generador)
+    ExtractorInvariantes extractor;
+    if (licm) {
+        if (stats) extractor.reporte = &cerr;
+        extractor.extraer(ast);
+    }
+    const ExtractorInvariantes* invariantes = licm ? &extractor : nullptr;
+
+    // Funciones puras: el intérprete memoiza sus llamadas y el generador
+    // emite como constantes las que tienen argumentos constantes
+    AnalisisPureza pureza;
+    if (memo || ctfe) {
+        if (stats) pureza.reporte = &cerr;
+        pureza.analizar(ast);
+    }
+
+    // Ejecutar y guardar la salida del PrintVisitor y del intérprete
     PrintVisitor impresion;
-    EvalVisitor evaluador;
-    // Redirigir la salida al archivo y ejecutar ambos visitantes: primero Print, luego Eval
+    // Redirigir la salida al archivo y ejecutar ambos: primero Print, luego el intérprete
     streambuf* oldCout = cout.rdbuf(outfileInterprete.rdbuf());
     impresion.imprimir(ast);
-    // Ejecutar el evaluador para volcar los resultados del intérprete bajo la impresión
-    evaluador.evaluar(ast);
+    // Ejecutar el intérprete elegido para volcar sus resultados bajo la impresión
+    if (motor == "closure") {
+        ClosureEngine closures;
+        closures.maxRecursion = (int)maxRecursion;
+        closures.capacidadMemo = memo;
+        closures.pureza = &pureza;
+        closures.licm = invariantes;
+        closures.scev = formas;
+        if (stats) closures.reporteMemo = &cerr;
+        closures.ejecutar(ast);
+    } else {
+        EvalVisitor evaluador;
+        TieredJit jit(ast, umbralJit);
+        jit.licm = invariantes;
+        if (tiered) evaluador.usarJit(&jit);
+        evaluador.usarInvariantes(invariantes);
+        evaluador.usarFormasCerradas(formas);
+        evaluador.limitarRecursion((int)maxRecursion);
+        evaluador.memoizar(memo, &pureza, stats ? &cerr : nullptr);
+        evaluador.evaluar(ast);
+    }
     // Restaurar la salida estándar
     cout.rdbuf(oldCout);
     outfileInterprete.close();
     
-    // Generar código ensamblador
-    string asmOutput = "outputs/" + baseName + ".s";
-    ofstream outfileAsm(asmOutput);
-    if (!outfileAsm.is_open()) {
-        cerr << "Error al crear el archivo de salida ensamblador: " << asmOutput << endl;
-        return 1;
+    // Generar código: lista de instrucciones que luego consume cada emisor
+    GenCodeVisitor codigo(cout);
+    codigo.usarRegistros = regalloc;
+    if (stats) codigo.reporteRegistros = &cerr;
+    codigo.llamadasCola = tco;
+    if (tco && stats) codigo.reporteCola = &cerr;
+    codigo.umbralSeleccion = cmov;
+    codigo.licm = invariantes;
+    codigo.scev = formas;
+    if (cmov >= 0 && stats) codigo.reporteSeleccion = &cerr;
+    if (ctfe) {
+        PlegadoLlamadas plegado;
+        plegado.combustible = ctfe;
+        plegado.pureza = &pureza;
+        if (stats) plegado.reporte = &cerr;
+        plegado.plegar(ast);
+    }
+    if (especializar) {
+        EspecializadorFunciones especializador;
+        especializador.crecimiento = especializar;
+        if (stats) especializador.reporte = &cerr;
+        especializador.especializar(ast);
+    }
+    if (enLinea) {
+        ExpansorEnLinea expansor;
+        if (stats) expansor.reporte = &cerr;
+        expansor.expandir(ast);
+    }
+    NumeradorValores numerador;
+    if (cse) {
+        if (stats) numerador.reporte = &cerr;
+        numerador.numerar(ast);
+        codigo.numeracion = &numerador;
+    }
+    ReductorInducciones reductor;
+    if (iv) {
+        reductor.licm = invariantes;
+        if (stats) reductor.reporte = &cerr;
+        reductor.reducir(ast);
+        codigo.iv = &reductor;
+    }
+    DesenrolladorBucles desenrollador;
+    if (rotar) {
+        desenrollador.factor = desenrollar;
+        if (iv) desenrollador.iv = &reductor;
+        desenrollador.scev = formas;
+        if (stats) desenrollador.reporte = &cerr;
+        desenrollador.desenrollar(ast);
+        codigo.desenrollado = &desenrollador;
+    }
+    GeneradorIR generadorIR(ast);
+    generadorIR.cse = cse;
+    ofstream volcadoIR;
+    if (backend == "ir") {
+        codigo.generadorIR = &generadorIR;
+        if (stats) generadorIR.reporte = &cerr;
+        if (dumpIr) {
+            volcadoIR.open("outputs/" + baseName + ".ir");
+            generadorIR.volcado = &volcadoIR;
+        }
+    }
+    codigo.generarCodigo(ast);  // Usar el mismo AST que ya tenemos
+    if (volcadoIR.is_open()) volcadoIR.close();
+    if (peephole) {
+        Peephole mirilla;
+        mirilla.optimizar(codigo.buffer());
+        if (stats) mirilla.reporte(cerr);
+    }
+
+    if (emitir == "asm") {
+        string asmOutput = "outputs/" + baseName + ".s";
+        ofstream outfileAsm(asmOutput);
+        if (!outfileAsm.is_open()) {
+            cerr << "Error al crear el archivo de salida ensamblador: " << asmOutput << endl;
+            return 1;
+        }
+        cout << "Generando código ensamblador en " << asmOutput << endl;
+        emitirTexto(codigo.buffer(), outfileAsm);
+        outfileAsm.close();
+    } else {
+        // ELF directo, sin as/ld
+        string err;
+        bool ok;
+        string salida;
+        if (emitir == "obj") {
+            salida = "outputs/" + baseName + ".o";
+            cout << "Generando objeto ELF en " << salida << endl;
+            X86Encoder enc;
+            ok = enc.ensamblar(codigo.buffer()) && escribirObjetoElf(enc, salida, err);
+            if (err.empty()) err = enc.error();
+        } else {
+            salida = "outputs/" + baseName;
+            cout << "Generando ejecutable ELF en " << salida << endl;
+            ok = escribirEjecutableElf(codigo.buffer(), salida, err);
+        }
+        if (!ok) {
+            cerr << "Error al generar " << salida << ": " << err << endl;
+            return 1;
+        }
+    }
+
+    // Ejecutar el código generado sin toolchain externo
+    if (runNative) {
+        NativeRunner nativo;
+        int retorno = 0;
+        cout.flush();
+        if (!nativo.ejecutar(codigo.buffer(), ast, retorno)) {
+            cerr << "Error en --run-native: " << nativo.error() << endl;
+            return 1;
+        }
+        return retorno;
     }
-    
-    cout << "Generando código ensamblador en " << asmOutput << endl;
-    GenCodeVisitor codigo(outfileAsm);
-    codigo.generar(ast);  // Usar el mismo AST que ya tenemos
-    outfileAsm.close();
     
     return 0;
 }
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+#include "native_runner.h"
+#include "x86_encoder.h"
+
+using namespace std;
+
+// Símbolos de la libc que el código generado puede llamar
+static unordered_map<string, uint64_t> externosLibc() {
+    return {
+        {"printf", (uint64_t)(void*)&printf}
+    };
+}
+
+// Una línea "inicio tamaño nombre" (hex) por función, formato de perf
+static void escribirPerfMap(const X86Encoder& enc, Program* program, void* base) {
+    vector<pair<long, string>> funciones;
+    for (FunDec* fd : program->fdlist) {
+        long off = enc.etiqueta(fd->id);
+        if (off >= 0) funciones.push_back({off, fd->id});
+    }
+    sort(funciones.begin(), funciones.end());
+
+    ofstream map("/tmp/perf-" + to_string(getpid()) + ".map", ios::app);
+    if (!map.is_open()) return;
+    for (size_t k = 0; k < funciones.size(); ++k) {
+        long fin = (k + 1 < funciones.size()) ? funciones[k + 1].first : (long)enc.codigo().size();
+        map << hex << (uint64_t)base + funciones[k].first << " " << (fin - funciones[k].first)
+            << " " << funciones[k].second << dec << "\n";
+    }
+}
+
+bool NativeRunner::ejecutar(const AsmBuffer& codigo, Program* program, int& retorno) {
+    X86Encoder enc;
+    vector<uint8_t> imagen;
+    if (!enc.ensamblar(codigo) || !enc.enlazarLocal(externosLibc(), imagen)) {
+        err = enc.error();
+        return false;
+    }
+    long entrada = enc.etiqueta("main");
+    if (entrada < 0) {
+        err = "main no encontrado";
+        return false;
+    }
+
+    void* mem = cargarEnMemoria(imagen);
+    if (!mem) {
+        err = "no se pudo reservar memoria ejecutable";
+        return false;
+    }
+    escribirPerfMap(enc, program, mem);
+
+    retorno = (int)((long (*)())((uint8_t*)mem + entrada))();
+    fflush(stdout);
+    liberarMemoria(mem, imagen.size());
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef NATIVE_RUNNER_H
+#define NATIVE_RUNNER_H
+
+#include <string>
+#include "ast.h"
+#include "asm_buffer.h"
+
+using namespace std;
+
+// ===========================================================
+//  Modo --run-native
+//  Codifica en memoria el buffer de GenCodeVisitor (X86Encoder), enlaza
+//  printf@PLT y las llamadas entre funciones dentro del propio proceso,
+//  y ejecuta main directamente: sin gcc/as/ld ni archivos temporales.
+//  Deja /tmp/perf-<pid>.map para que perf pueda simbolizar el código.
+// ===========================================================
+
+class NativeRunner {
+public:
+    // Ejecuta main del código generado; retorno = valor de main
+    bool ejecutar(const AsmBuffer& codigo, Program* program, int& retorno);
+    const string& error() const { return err; }
+
+private:
+    string err;
+};
+
+#endif // NATIVE_RUNNER_H
@@ -0,0 +1,342 @@
+#include <iomanip>
+#include <unordered_set>
+#include "peephole.h"
+
+using namespace std;
+
+// ==========================================
+// Registros leídos / escritos por una instrucción
+// ==========================================
+
+static bool esReg(const Operando& o, int r) {
+    return o.tipo == Operando::REG && o.reg == r;
+}
+
+// Operando registro o memoria que depende de r
+static bool usaRegistro(const Operando& o, int r) {
+    return (o.tipo == Operando::REG || o.tipo == Operando::MEM) && o.reg == r;
+}
+
+static bool esSalto(Op op) {
+    return op == Op::JMP || op == Op::JE || op == Op::JNE || op == Op::JL ||
+           op == Op::JLE || op == Op::JG || op == Op::JGE;
+}
+
+static bool esSetcc(Op op) {
+    return op == Op::SETE || op == Op::SETNE || op == Op::SETL ||
+           op == Op::SETLE || op == Op::SETG || op == Op::SETGE;
+}
+
+static bool lee(const Instr& i, int r) {
+    // Registros base de operandos de memoria
+    if (i.a.tipo == Operando::MEM && i.a.reg == r) return true;
+    if (i.b.tipo == Operando::MEM && i.b.reg == r) return true;
+    switch (i.op) {
+        case Op::MOVQ: case Op::MOVL: case Op::MOVB: case Op::MOVZBQ: case Op::MOVSLQ:
+        case Op::PUSHQ:
+            return esReg(i.a, r);
+        case Op::ADDQ: case Op::SUBQ: case Op::IMULQ: case Op::CMPQ:
+        // cmovcc puede no escribir: el destino también se lee
+        case Op::CMOVE: case Op::CMOVNE: case Op::CMOVL: case Op::CMOVLE: case Op::CMOVG: case Op::CMOVGE:
+            return esReg(i.a, r) || esReg(i.b, r);
+        case Op::INCQ: case Op::DECQ: case Op::NEGQ:
+            return esReg(i.a, r);
+        case Op::IDIVQ: case Op::DIVQ:
+            return esReg(i.a, r) || r == RAX || r == RDX;
+        case Op::CQO:
+            return r == RAX;
+        case Op::CALL:
+            return r == RAX || r == RDI || r == RSI || r == RDX || r == RCX || r == R8 || r == R9;
+        case Op::SYSCALL:
+            return r == RAX || r == RDI || r == RSI || r == RDX || r == R10 || r == R8 || r == R9;
+        case Op::RET:
+            return true; // Conservador: valores de retorno (incluidos structs)
+        case Op::LEAVE:
+            return r == RBP;
+        default:
+            // setcc escribe solo 8 bits: el resto del registro se conserva
+            return esSetcc(i.op) && esReg(i.a, r);
+    }
+}
+
+static bool escribe(const Instr& i, int r) {
+    switch (i.op) {
+        case Op::MOVQ: case Op::MOVL: case Op::MOVABSQ: case Op::MOVZBQ: case Op::MOVSLQ: case Op::LEAQ:
+        case Op::ADDQ: case Op::SUBQ: case Op::IMULQ:
+        case Op::CMOVE: case Op::CMOVNE: case Op::CMOVL: case Op::CMOVLE: case Op::CMOVG: case Op::CMOVGE:
+            return esReg(i.b, r);
+        case Op::POPQ: case Op::INCQ: case Op::DECQ: case Op::NEGQ:
+            return esReg(i.a, r);
+        case Op::IDIVQ: case Op::DIVQ:
+            return r == RAX || r == RDX;
+        case Op::CQO:
+            return r == RDX;
+        case Op::CALL:
+            return r == RAX || r == RCX || r == RDX || r == RSI || r == RDI ||
+                   r == R8 || r == R9 || r == R10 || r == R11;
+        default:
+            return false;
+    }
+}
+
+// Código de condición negado: setl -> jge, ...
+static Op saltoContrario(Op setcc) {
+    switch (setcc) {
+        case Op::SETE: return Op::JNE;
+        case Op::SETNE: return Op::JE;
+        case Op::SETL: return Op::JGE;
+        case Op::SETLE: return Op::JG;
+        case Op::SETG: return Op::JLE;
+        default: return Op::JL; // SETGE
+    }
+}
+
+static Op saltoDirecto(Op setcc) {
+    switch (setcc) {
+        case Op::SETE: return Op::JE;
+        case Op::SETNE: return Op::JNE;
+        case Op::SETL: return Op::JL;
+        case Op::SETLE: return Op::JLE;
+        case Op::SETG: return Op::JG;
+        default: return Op::JGE; // SETGE
+    }
+}
+
+static bool cabeEn32(long v) {
+    return v >= -2147483648L && v <= 2147483647L;
+}
+
+// ==========================================
+// Peephole
+// ==========================================
+
+Peephole::Peephole() : tabla(TOTAL_PATRONES) {
+    tabla[OPERANDO_SIMPLE].nombre = "operando-simple";       // push/movq X/movq %rax,%rcx/pop
+    tabla[OPERANDO_INMEDIATO].nombre = "operando-inmediato"; // movq $k,%rcx; op %rcx,%rax
+    tabla[OPERANDO_MEMORIA].nombre = "operando-memoria";     // movq M,%rcx; op %rcx,%rax
+    tabla[COMPARAR_Y_SALTAR].nombre = "comparar-y-saltar";   // cmp; setX; movzbq; cmpq $0; je
+    tabla[GUARDAR_RECARGAR].nombre = "guardar-recargar";     // movq %r,M; movq M,%r
+    tabla[PUSH_POP].nombre = "push-pop";                     // pushq %x; popq %y
+    tabla[SALTO_SIGUIENTE].nombre = "salto-siguiente";       // jmp L; L:
+    tabla[INMEDIATO_A_MEMORIA].nombre = "inmediato-a-memoria"; // movq $k,%rax; movq %rax,M
+}
+
+// %rcx es temporal del generador: basta recorrer el bloque actual. Si es
+// argumento de una llamada, el generador lo carga (popq) justo antes del call.
+bool Peephole::rcxMuerto(const vector<Instr>& v, size_t desde) const {
+    for (size_t k = desde; k < v.size(); ++k) {
+        const Instr& i = v[k];
+        if (i.op == Op::CALL) return true;
+        if (lee(i, RCX)) return false;
+        if (escribe(i, RCX)) return true;
+        if (i.op == Op::ETIQUETA || esSalto(i.op)) return true;
+    }
+    return true;
+}
+
+// %rax sí puede vivir entre bloques: se siguen los saltos (acotado)
+bool Peephole::raxMuerto(const vector<Instr>& v, const vector<long>& pos, size_t desde) const {
+    vector<size_t> pendientes = {desde};
+    unordered_set<size_t> vistos;
+    int presupuesto = 256;
+    while (!pendientes.empty()) {
+        size_t k = pendientes.back();
+        pendientes.pop_back();
+        for (; k < v.size(); ++k) {
+            if (--presupuesto < 0) return false;
+            const Instr& i = v[k];
+            if (i.op == Op::ETIQUETA) {
+                if (!vistos.insert(k).second) break;
+                continue;
+            }
+            if (i.op == Op::DIRECTIVA) return false;
+            if (lee(i, RAX)) return false;
+            if (escribe(i, RAX)) break;
+            if (esSalto(i.op)) {
+                if (i.a.tipo != Operando::ETIQUETA || pos[i.a.etiqueta] < 0) return false;
+                pendientes.push_back((size_t)pos[i.a.etiqueta]);
+                if (i.op == Op::JMP) break;
+            }
+        }
+        if (k >= v.size()) return false;
+    }
+    return true;
+}
+
+bool Peephole::pasada(AsmBuffer& buf) {
+    const vector<Instr>& v = buf.instrs;
+    vector<Instr> r;
+    r.reserve(v.size());
+    bool cambio = false;
+    vector<long> pos(buf.totalEtiquetas(), -1);
+    for (size_t k = 0; k < v.size(); ++k)
+        if (v[k].op == Op::ETIQUETA) pos[v[k].a.etiqueta] = (long)k;
+
+    auto hay = [&](size_t i, size_t n) { return i + n <= v.size(); };
+    auto acierto = [&](Id p, long quitadas) {
+        tabla[p].aciertos++;
+        eliminadas += quitadas;
+        cambio = true;
+    };
+
+    size_t i = 0;
+    while (i < v.size()) {
+        const Instr& x = v[i];
+
+        // pushq %rax; movq X, %rax; movq %rax, %rcx; popq %rax  =>  movq X, %rcx
+        if (hay(i, 4) && x.op == Op::PUSHQ && esReg(x.a, RAX) &&
+            (v[i + 1].op == Op::MOVQ || v[i + 1].op == Op::MOVABSQ) && esReg(v[i + 1].b, RAX) &&
+            !usaRegistro(v[i + 1].a, RSP) &&
+            v[i + 2].op == Op::MOVQ && esReg(v[i + 2].a, RAX) && esReg(v[i + 2].b, RCX) &&
+            v[i + 3].op == Op::POPQ && esReg(v[i + 3].a, RAX)) {
+            Instr m = v[i + 1];
+            m.b = opReg(RCX);
+            r.push_back(m);
+            acierto(OPERANDO_SIMPLE, 3);
+            i += 4;
+            continue;
+        }
+        // pushq %rax; movq X, %rax; popq %rcx  =>  movq %rax, %rcx; movq X, %rax
+        if (hay(i, 3) && x.op == Op::PUSHQ && esReg(x.a, RAX) &&
+            (v[i + 1].op == Op::MOVQ || v[i + 1].op == Op::MOVABSQ) && esReg(v[i + 1].b, RAX) &&
+            !usaRegistro(v[i + 1].a, RSP) && !usaRegistro(v[i + 1].a, RCX) &&
+            v[i + 2].op == Op::POPQ && esReg(v[i + 2].a, RCX)) {
+            Instr m;
+            m.op = Op::MOVQ;
+            m.a = opReg(RAX);
+            m.b = opReg(RCX);
+            r.push_back(m);
+            r.push_back(v[i + 1]);
+            acierto(OPERANDO_SIMPLE, 1);
+            i += 3;
+            continue;
+        }
+
+        // movq $k|M, %rcx; op %rcx, %rax  =>  op $k|M, %rax
+        if (hay(i, 2) && x.op == Op::MOVQ && esReg(x.b, RCX) &&
+            (x.a.tipo == Operando::IMM || (x.a.tipo == Operando::MEM && x.a.reg != RCX)) &&
+            (v[i + 1].op == Op::ADDQ || v[i + 1].op == Op::SUBQ ||
+             v[i + 1].op == Op::CMPQ || v[i + 1].op == Op::IMULQ) &&
+            esReg(v[i + 1].a, RCX) && esReg(v[i + 1].b, RAX) &&
+            (x.a.tipo == Operando::MEM || cabeEn32(x.a.imm)) && rcxMuerto(v, i + 2)) {
+            Instr m = v[i + 1];
+            m.a = x.a;
+            r.push_back(m);
+            acierto(x.a.tipo == Operando::IMM ? OPERANDO_INMEDIATO : OPERANDO_MEMORIA, 1);
+            i += 2;
+            continue;
+        }
+
+        // movq %rax, %rcx; movq $k|M, %rax; addq|imulq %rcx, %rax  =>  addq|imulq $k|M, %rax
+        if (hay(i, 3) && x.op == Op::MOVQ && esReg(x.a, RAX) && esReg(x.b, RCX) &&
+            v[i + 1].op == Op::MOVQ && esReg(v[i + 1].b, RAX) &&
+            ((v[i + 1].a.tipo == Operando::IMM && cabeEn32(v[i + 1].a.imm)) ||
+             (v[i + 1].a.tipo == Operando::MEM && v[i + 1].a.reg != RCX && v[i + 1].a.reg != RAX)) &&
+            (v[i + 2].op == Op::ADDQ || v[i + 2].op == Op::IMULQ) &&
+            esReg(v[i + 2].a, RCX) && esReg(v[i + 2].b, RAX) && rcxMuerto(v, i + 3)) {
+            Instr m = v[i + 2];
+            m.a = v[i + 1].a;
+            r.push_back(m);
+            acierto(v[i + 1].a.tipo == Operando::IMM ? OPERANDO_INMEDIATO : OPERANDO_MEMORIA, 2);
+            i += 3;
+            continue;
+        }
+
+        // movq $k, %rax; movq %rax, M  =>  movq $k, M   (si %rax no se usa después)
+        if (hay(i, 2) && x.op == Op::MOVQ && x.a.tipo == Operando::IMM && cabeEn32(x.a.imm) &&
+            esReg(x.b, RAX) && v[i + 1].op == Op::MOVQ && esReg(v[i + 1].a, RAX) &&
+            v[i + 1].b.tipo == Operando::MEM && v[i + 1].b.reg != RAX && raxMuerto(v, pos, i + 2)) {
+            Instr m = v[i + 1];
+            m.a = x.a;
+            r.push_back(m);
+            acierto(INMEDIATO_A_MEMORIA, 1);
+            i += 2;
+            continue;
+        }
+
+        // cmpq A, B; setX %al; movzbq %al, %rax; cmpq $0, %rax; je|jne L  =>  cmpq A, B; jcc L
+        if (hay(i, 5) && x.op == Op::CMPQ && esSetcc(v[i + 1].op) && esReg(v[i + 1].a, RAX) &&
+            v[i + 2].op == Op::MOVZBQ && esReg(v[i + 2].a, RAX) && esReg(v[i + 2].b, RAX) &&
+            v[i + 3].op == Op::CMPQ && v[i + 3].a.tipo == Operando::IMM && v[i + 3].a.imm == 0 &&
+            esReg(v[i + 3].b, RAX) &&
+            (v[i + 4].op == Op::JE || v[i + 4].op == Op::JNE) && v[i + 4].a.tipo == Operando::ETIQUETA) {
+            // %rax (0/1) desaparece: no debe leerse ni al caer ni en el destino
+            Instr salto = v[i + 4];
+            salto.op = v[i + 4].op == Op::JE ? saltoContrario(v[i + 1].op) : saltoDirecto(v[i + 1].op);
+            long objetivo = pos[salto.a.etiqueta];
+            if (objetivo >= 0 && raxMuerto(v, pos, i + 5) && raxMuerto(v, pos, (size_t)objetivo)) {
+                r.push_back(x);
+                r.push_back(salto);
+                acierto(COMPARAR_Y_SALTAR, 3);
+                i += 5;
+                continue;
+            }
+        }
+
+        // movq %r, M; movq M, %s  =>  movq %r, M [; movq %r, %s]
+        if (hay(i, 2) && x.op == Op::MOVQ && x.a.tipo == Operando::REG && x.b.tipo == Operando::MEM &&
+            v[i + 1].op == Op::MOVQ && v[i + 1].a == x.b && v[i + 1].b.tipo == Operando::REG &&
+            x.b.reg != x.a.reg) {
+            r.push_back(x);
+            if (!esReg(v[i + 1].b, x.a.reg)) {
+                Instr m = v[i + 1];
+                m.a = x.a;
+                r.push_back(m);
+                acierto(GUARDAR_RECARGAR, 0);
+            } else {
+                acierto(GUARDAR_RECARGAR, 1);
+            }
+            i += 2;
+            continue;
+        }
+
+        // pushq %x; popq %y  =>  movq %x, %y (o nada)
+        if (hay(i, 2) && x.op == Op::PUSHQ && x.a.tipo == Operando::REG &&
+            v[i + 1].op == Op::POPQ && v[i + 1].a.tipo == Operando::REG) {
+            if (x.a.reg != v[i + 1].a.reg) {
+                Instr m;
+                m.op = Op::MOVQ;
+                m.a = x.a;
+                m.b = v[i + 1].a;
+                r.push_back(m);
+                acierto(PUSH_POP, 1);
+            } else {
+                acierto(PUSH_POP, 2);
+            }
+            i += 2;
+            continue;
+        }
+
+        // jmp L seguido solo de etiquetas entre las que está L
+        if (x.op == Op::JMP && x.a.tipo == Operando::ETIQUETA) {
+            size_t k = i + 1;
+            bool llega = false;
+            while (k < v.size() && v[k].op == Op::ETIQUETA) {
+                if (v[k].a.etiqueta == x.a.etiqueta) llega = true;
+                k++;
+            }
+            if (llega) {
+                acierto(SALTO_SIGUIENTE, 1);
+                i++;
+                continue;
+            }
+        }
+
+        r.push_back(x);
+        i++;
+    }
+    buf.instrs.swap(r);
+    return cambio;
+}
+
+long Peephole::optimizar(AsmBuffer& buf) {
+    long antes = eliminadas;
+    while (pasada(buf)) {}
+    return eliminadas - antes;
+}
+
+void Peephole::reporte(ostream& out) const {
+    out << "Peephole: " << eliminadas << " instrucciones eliminadas" << endl;
+    for (const Patron& p : tabla)
+        out << "  " << left << setw(20) << p.nombre << right << p.aciertos << endl;
+}
@@ -0,0 +1,49 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "asm_buffer.h"
+
+using namespace std;
+
+// ===========================================================
+//  Optimizador peephole sobre el AsmBuffer de GenCodeVisitor
+//  Recorre ventanas cortas de instrucciones y reemplaza los patrones
+//  típicos del generador (spill push/pop de un operando simple, setcc +
+//  movzbq + cmpq $0 + je, guardar y recargar el mismo slot, saltos al
+//  siguiente bloque) por secuencias equivalentes más cortas. Repite
+//  hasta que ningún patrón aplica y cuenta los aciertos de cada uno.
+//
+//  Supone el invariante del generador: %rcx es temporal, siempre se
+//  escribe antes de leerse y no vive a través de saltos ni llamadas.
+// ===========================================================
+
+class Peephole {
+public:
+    struct Patron {
+        string nombre;
+        long aciertos = 0;
+    };
+
+    Peephole();
+    // Optimiza el buffer en su lugar; devuelve cuántas instrucciones eliminó
+    long optimizar(AsmBuffer& buf);
+    const vector<Patron>& patrones() const { return tabla; }
+    void reporte(ostream& out) const;
+
+private:
+    enum Id { OPERANDO_SIMPLE, OPERANDO_INMEDIATO, OPERANDO_MEMORIA, COMPARAR_Y_SALTAR,
+              GUARDAR_RECARGAR, PUSH_POP, SALTO_SIGUIENTE, INMEDIATO_A_MEMORIA, TOTAL_PATRONES };
+
+    vector<Patron> tabla;
+    long eliminadas = 0;
+
+    bool pasada(AsmBuffer& buf);
+    bool rcxMuerto(const vector<Instr>& v, size_t desde) const;
+    // pos: índice de cada etiqueta dentro de v (-1 si no está definida)
+    bool raxMuerto(const vector<Instr>& v, const vector<long>& pos, size_t desde) const;
+};
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,87 @@
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <iostream>
+#include <vector>
+#include "pila.h"
+
+using namespace std;
+
+static const size_t MARGEN = 256 * 1024;        // Pila libre que necesita una llamada interpretada
+static const size_t SEGMENTO = 64 * 1024 * 1024; // Reservado sin comprometer: solo ocupa lo que se toca
+static const size_t MAX_LIBRES = 4;             // Segmentos que se guardan para reutilizar
+
+char* PilaSegmentada::limite = nullptr;
+
+static vector<char*> libres;
+static const function<void()>* pendiente = nullptr;
+
+static void entrada() {
+    (*pendiente)();
+}
+
+// Límite de la pila del hilo: lo que informa pthread, acotado por RLIMIT_STACK
+static char* limiteDelHilo() {
+    pthread_attr_t attr;
+    void* base = nullptr;
+    size_t tam = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        pthread_attr_getstack(&attr, &base, &tam);
+        pthread_attr_destroy(&attr);
+    }
+    char* aqui = (char*)__builtin_frame_address(0);
+    if (!base || aqui < (char*)base || aqui > (char*)base + tam) {
+        // Sin información: la pila por defecto de 8 MB desde aquí
+        return aqui - 8 * 1024 * 1024 + MARGEN;
+    }
+    struct rlimit rl;
+    char* inicio = (char*)base + tam;
+    if (getrlimit(RLIMIT_STACK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < tam)
+        base = inicio - rl.rlim_cur;
+    return (char*)base + MARGEN;
+}
+
+void PilaSegmentada::enSegmento(const function<void()>& f) {
+    char marca;
+    if (!limite) {
+        limite = limiteDelHilo();
+        if (&marca > limite) {
+            f();
+            return;
+        }
+    }
+
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    char* seg = nullptr;
+    if (!libres.empty()) {
+        seg = libres.back();
+        libres.pop_back();
+    } else {
+        void* m = mmap(nullptr, SEGMENTO, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (m == MAP_FAILED) {
+            cerr << "Error: sin memoria para la pila del intérprete" << endl;
+            exit(1);
+        }
+        seg = (char*)m;
+        // Página de guarda: un desborde falla en lugar de pisar otra memoria
+        mprotect(seg, pagina, PROT_NONE);
+    }
+
+    ucontext_t anterior, nuevo;
+    getcontext(&nuevo);
+    nuevo.uc_stack.ss_sp = seg + pagina;
+    nuevo.uc_stack.ss_size = SEGMENTO - pagina;
+    nuevo.uc_link = &anterior;
+    makecontext(&nuevo, entrada, 0);
+
+    char* limiteAnterior = limite;
+    limite = seg + pagina + MARGEN;
+    pendiente = &f;
+    swapcontext(&anterior, &nuevo);
+    limite = limiteAnterior;
+
+    if (libres.size() < MAX_LIBRES) libres.push_back(seg);
+    else munmap(seg, SEGMENTO);
+}
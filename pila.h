@@ -0,0 +1,36 @@
+#ifndef PILA_H
+#define PILA_H
+
+#include <functional>
+
+using namespace std;
+
+// ===========================================================
+//  Pila segmentada de los intérpretes
+//  Cada llamada interpretada anida varios marcos de C++ (visitas o
+//  closures). Antes de entrar en una se mira cuánta pila nativa queda:
+//  si es menos que el margen, la llamada corre en un segmento nuevo
+//  reservado con mmap (cambiando de contexto con ucontext) y al terminar
+//  se vuelve al segmento anterior. Así la profundidad de la recursión
+//  interpretada la limita la memoria y no la pila del hilo.
+// ===========================================================
+
+// Llamadas anidadas que permiten los intérpretes por defecto (--max-recursion)
+static const int LIMITE_RECURSION = 500000;
+
+class PilaSegmentada {
+public:
+    // Ejecuta f con al menos el margen de pila libre
+    template <typename F>
+    static void asegurar(F&& f) {
+        char marca;
+        if (limite && &marca > limite) f();
+        else enSegmento(function<void()>(f));
+    }
+
+private:
+    static char* limite; // Dirección más baja utilizable del segmento en curso (+ margen)
+    static void enSegmento(const function<void()>& f);
+};
+
+#endif // PILA_H
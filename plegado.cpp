@@ -0,0 +1,114 @@
+#include "plegado.h"
+
+using namespace std;
+
+// Ejecuta la llamada si se puede y la anota como constante
+bool PlegadoLlamadas::evaluar(FcallExp* fc) {
+    auto it = funciones.find(fc->name);
+    if (it == funciones.end() || !pureza || !pureza->pura(it->second)) return false;
+    FunDec* fd = it->second;
+    if (fd->params.size() != fc->arguments.size()) return false;
+    vector<int> args;
+    string clave = fc->name + "(";
+    for (Exp* a : fc->arguments) {
+        if (a->cont != 1 || a->claseCont == Value::FLOAT || dynamic_cast<FloatExp*>(a)) return false;
+        args.push_back(a->valor);
+        clave += to_string(a->valor) + ",";
+    }
+    clave += ")";
+
+    auto r = resultados.find(clave);
+    if (r == resultados.end()) {
+        Resultado res;
+        long gasolina = min(combustible, presupuesto);
+        long inicial = gasolina;
+        int ret = 0;
+        Value valor;
+        if (gasolina > 0 && interprete.evaluarLlamada(fd, args, gasolina, ret, valor)) {
+            // El generador usa la vista entera del retorno: debe coincidir
+            // con el valor convertido al tipo de la función
+            bool cabe = valor.kind != Value::UNSIGNED || valor.u <= (unsigned)INT_MAX;
+            if (cabe && valor.kind != Value::STRUCT && valor.kind != Value::FLOAT && valorEntero(valor) == ret) {
+                res.plegada = true;
+                res.valor = ret;
+            }
+        } else {
+            abandonadas++;
+        }
+        presupuesto -= inicial - gasolina;
+        r = resultados.emplace(clave, res).first;
+    }
+    if (!r->second.plegada) return false;
+    fc->cont = 1;
+    fc->valor = r->second.valor;
+    fc->claseCont = kindDeTipo(fd->type);
+    return true;
+}
+
+void PlegadoLlamadas::exp(Exp* e) {
+    if (!e || e->cont == 1) return;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        exp(b->left);
+        exp(b->right);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        exp(t->condition);
+        exp(t->trueExp);
+        exp(t->falseExp);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        exp(st->amount);
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) exp(a);
+        if (evaluar(fc)) plegadas++;
+    }
+}
+
+void PlegadoLlamadas::stm(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        exp(a->e);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* a : p->args) exp(a);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* d : ind->values) {
+            if (d->e) exp(d->e);
+            if (d->st) for (Exp* a : d->st->argumentos) exp(a);
+        }
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        exp(i->condition);
+        body(i->thenBody);
+        body(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        exp(w->condition);
+        body(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) stm(f->init);
+        exp(f->condition);
+        exp(f->step);
+        body(f->body);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        exp(r->e);
+    }
+}
+
+void PlegadoLlamadas::body(Body* b) {
+    if (!b) return;
+    for (InstanceDec* ind : b->intances) stm(ind);
+    for (Stm* s : b->stmList) stm(s);
+}
+
+void PlegadoLlamadas::plegar(Program* program) {
+    funciones.clear();
+    resultados.clear();
+    for (FunDec* fd : program->fdlist) funciones[fd->id] = fd;
+    interprete.prepararEvaluacion(program);
+    interprete.limitarRecursion(PROFUNDIDAD_PLEGADO);
+    presupuesto = PRESUPUESTO_PLEGADO;
+
+    for (FunDec* fd : program->fdlist) {
+        plegadas = abandonadas = 0;
+        body(fd->body);
+        if (reporte && (plegadas || abandonadas)) {
+            *reporte << "CTFE " << fd->id << ": " << plegadas << " llamadas evaluadas en compilación, " << abandonadas
+                     << " abandonadas" << endl;
+        }
+    }
+}
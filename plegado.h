@@ -0,0 +1,62 @@
+#ifndef PLEGADO_H
+#define PLEGADO_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "visitor.h"
+#include "pureza.h"
+
+using namespace std;
+
+// ===========================================================
+//  Evaluación en compilación de llamadas (--ctfe)
+//  Una llamada a una función pura (AnalisisPureza) cuyos argumentos son
+//  todos constantes se ejecuta con el intérprete al compilar y el
+//  generador la emite como inmediato:
+//      x = cuadrado(12) + fib(20);   =>   x = 144 + 6765;
+//  Se recorre de adentro hacia afuera, así que f(g(3)) se pliega entero.
+//  Cada evaluación tiene un combustible (sentencias ejecutadas) y todo
+//  el programa un presupuesto; si se agota, o la llamada dividiría entre
+//  cero o pasaría de PROFUNDIDAD_PLEGADO llamadas anidadas, se deja como
+//  llamada normal. Los resultados se recuerdan por función y argumentos.
+//  El intérprete calcula en 32 bits y el código generado en 64: si una
+//  operación entera desborda 32 bits la evaluación se abandona (como
+//  --sccp). Un resultado unsigned mayor que INT_MAX tampoco se pliega.
+//  Corre tras el intérprete: solo lo ve la generación de código.
+// ===========================================================
+
+static const long COMBUSTIBLE_PLEGADO = 1000000;  // Por llamada (--ctfe=N)
+static const long PRESUPUESTO_PLEGADO = 50000000; // Para todo el programa
+static const int PROFUNDIDAD_PLEGADO = 10000;
+
+class PlegadoLlamadas {
+public:
+    void plegar(Program* program);
+
+    long combustible = COMBUSTIBLE_PLEGADO;
+    ostream* reporte = nullptr; // --stats: llamadas plegadas por función
+    // Solo se evalúan llamadas a las funciones puras de este análisis
+    const AnalisisPureza* pureza = nullptr;
+
+private:
+    struct Resultado {
+        bool plegada = false;
+        int valor = 0;
+    };
+    EvalVisitor interprete;
+    unordered_map<string, FunDec*> funciones;
+    unordered_map<string, Resultado> resultados; // "f(1,2)" -> resultado
+    long presupuesto = 0;
+    int plegadas = 0;
+    int abandonadas = 0;
+
+    bool evaluar(FcallExp* fc);
+    void exp(Exp* e);
+    void stm(Stm* s);
+    void body(Body* b);
+};
+
+#endif // PLEGADO_H
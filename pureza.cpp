@@ -0,0 +1,105 @@
+#include "pureza.h"
+
+using namespace std;
+
+// ==========================================
+// Análisis
+// ==========================================
+
+bool AnalisisPureza::escalar(const string& type) const {
+    string t = type;
+    for (int guard = 0; guard < 16 && typedefs.count(t); ++guard) t = typedefs.at(t);
+    return t == "int" || t == "long" || t == "bool" || t == "uint" || t.find("unsigned") != string::npos;
+}
+
+// Nombre de variable que puede usar una función pura (p.x cuenta como p)
+bool AnalisisPureza::nombre(const string& id) const {
+    return !globales.count(id.substr(0, id.find('.')));
+}
+
+bool AnalisisPureza::exp(Exp* e, vector<string>& llama) const {
+    if (!e) return true;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) return nombre(id->value);
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return exp(b->left, llama) && exp(b->right, llama);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return exp(t->condition, llama) && exp(t->trueExp, llama) && exp(t->falseExp, llama);
+    if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        if (!funciones.count(fc->name)) return false;
+        llama.push_back(fc->name);
+        for (Exp* a : fc->arguments) if (!exp(a, llama)) return false;
+        return true;
+    }
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return exp(st->variable, llama) && exp(st->amount, llama);
+    return true;
+}
+
+bool AnalisisPureza::stm(Stm* s, vector<string>& llama) const {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return nombre(a->id) && exp(a->e, llama);
+    if (dynamic_cast<PrintfStm*>(s)) return false;
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) if (!nombre(v)) return false;
+        for (InitData* d : ind->values) {
+            if (d->e && !exp(d->e, llama)) return false;
+            if (d->st) for (Exp* a : d->st->argumentos) if (!exp(a, llama)) return false;
+        }
+        return true;
+    }
+    if (IfStm* i = dynamic_cast<IfStm*>(s))
+        return exp(i->condition, llama) && body(i->thenBody, llama) && body(i->elseBody, llama);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return exp(w->condition, llama) && body(w->body, llama);
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        return (!f->init || stm(f->init, llama)) && exp(f->condition, llama) && exp(f->step, llama) &&
+               body(f->body, llama);
+    }
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return exp(r->e, llama);
+    return true;
+}
+
+bool AnalisisPureza::body(Body* b, vector<string>& llama) const {
+    if (!b) return true;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) if (!nombre(v)) return false;
+    for (InstanceDec* ind : b->intances) if (!stm(ind, llama)) return false;
+    for (Stm* s : b->stmList) if (!stm(s, llama)) return false;
+    return true;
+}
+
+bool AnalisisPureza::candidata(FunDec* fd) {
+    if (fd->id == "main" || !escalar(fd->type)) return false;
+    for (ParamDec* p : fd->params) if (!escalar(p->type) || !nombre(p->id)) return false;
+    return fd->body && body(fd->body, llamadas[fd->id]);
+}
+
+void AnalisisPureza::analizar(Program* program) {
+    globales.clear();
+    typedefs.clear();
+    funciones.clear();
+    llamadas.clear();
+    for (VarDec* vd : program->vdlist) for (const string& v : vd->vars) globales.insert(v);
+    for (InstanceDec* ind : program->intdlist) for (const string& v : ind->vars) globales.insert(v);
+    for (TypedefDec* td : program->tdlist) typedefs[td->alias] = td->typeName;
+    for (FunDec* fd : program->fdlist) funciones[fd->id] = fd;
+
+    puras.clear();
+    for (FunDec* fd : program->fdlist) if (candidata(fd)) puras.insert(fd);
+    // Punto fijo: una llamada a una función impura contagia
+    bool cambio = true;
+    while (cambio) {
+        cambio = false;
+        for (FunDec* fd : program->fdlist) {
+            if (!pura(fd)) continue;
+            for (const string& g : llamadas[fd->id]) {
+                if (!pura(funciones[g])) {
+                    puras.erase(fd);
+                    cambio = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (reporte) {
+        *reporte << "PUREZA:";
+        for (FunDec* fd : program->fdlist) if (pura(fd)) *reporte << " " << fd->id;
+        *reporte << " (" << puras.size() << " de " << program->fdlist.size() << " funciones puras)" << endl;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef PUREZA_H
+#define PUREZA_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  Funciones puras y memoización (--memo)
+//  Una función es pura si su resultado solo depende de sus argumentos y
+//  no tiene otros efectos:
+//    - parámetros y retorno escalares (int, long, unsigned, bool);
+//    - sin printf;
+//    - sin nombrar variables globales (ni para leer ni para escribir);
+//    - solo llama a funciones puras del programa.
+//  Se parte de todas las candidatas y se descartan hasta un punto fijo,
+//  así la recursión (directa o mutua) entre puras sigue siendo pura.
+//  Los intérpretes guardan los resultados de las llamadas a funciones
+//  puras (pura()) en una TablaMemo por función (visitor.h).
+// ===========================================================
+
+class AnalisisPureza {
+public:
+    void analizar(Program* program);
+
+    ostream* reporte = nullptr; // --stats: funciones puras
+
+    // Resultado solo de los argumentos escalares, sin efectos
+    bool pura(FunDec* fd) const { return puras.count(fd) > 0; }
+
+private:
+    unordered_set<FunDec*> puras;
+
+    unordered_set<string> globales;
+    unordered_map<string, string> typedefs;    // alias -> tipo
+    unordered_map<string, FunDec*> funciones;
+    unordered_map<string, vector<string>> llamadas; // Función -> funciones que llama
+
+    bool escalar(const string& type) const;
+    bool nombre(const string& id) const;
+    bool exp(Exp* e, vector<string>& llama) const;
+    bool stm(Stm* s, vector<string>& llama) const;
+    bool body(Body* b, vector<string>& llama) const;
+    bool candidata(FunDec* fd);
+};
+
+#endif // PUREZA_H
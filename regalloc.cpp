@@ -0,0 +1,179 @@
+#include <algorithm>
+#include "regalloc.h"
+#include "asm_buffer.h"
+
+using namespace std;
+
+static const vector<int> CALLEE_SAVED = {RBX, R12, R13, R14, R15};
+static const char* const NOMBRES[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                                      "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+
+// ==========================================
+// Vida de las variables
+// ==========================================
+
+void AsignadorRegistros::aparece(const string& nombre) {
+    // p.x cuenta como aparición de p
+    string var = nombre.substr(0, nombre.find('.'));
+    Intervalo& iv = vida[var];
+    iv.var = var;
+    if (iv.inicio < 0) iv.inicio = pos;
+    iv.fin = pos;
+    for (unordered_set<string>* nombres : bucles) nombres->insert(var);
+    pos++;
+}
+
+void AsignadorRegistros::declara(const string& var, const string& tipo) {
+    declaraciones[var]++;
+    if (tipos->count(tipo)) enMemoria.insert(var);
+    aparece(var);
+}
+
+void AsignadorRegistros::recorrer(Exp* e) {
+    if (!e) return;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        aparece(id->value);
+    } else if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        recorrer(b->left);
+        recorrer(b->right);
+    } else if (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+        recorrer(t->condition);
+        recorrer(t->trueExp);
+        recorrer(t->falseExp);
+    } else if (FcallExp* fc = dynamic_cast<FcallExp*>(e)) {
+        for (Exp* a : fc->arguments) recorrer(a);
+    } else if (StepExp* st = dynamic_cast<StepExp*>(e)) {
+        recorrer(st->variable);
+        recorrer(st->amount);
+    }
+}
+
+// Todo lo que aparece dentro del bucle vive hasta su final
+void AsignadorRegistros::bucle(Exp* cond, Body* body, StepExp* step) {
+    int inicio = pos;
+    unordered_set<string> nombres;
+    bucles.push_back(&nombres);
+    recorrer(cond);
+    recorrer(body);
+    recorrer(step);
+    bucles.pop_back();
+    int fin = pos++;
+    for (const string& var : nombres) {
+        Intervalo& iv = vida[var];
+        iv.inicio = min(iv.inicio, inicio);
+        iv.fin = max(iv.fin, fin);
+    }
+}
+
+void AsignadorRegistros::recorrer(Stm* s) {
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) {
+        recorrer(a->e);
+        aparece(a->id);
+    } else if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* d : ind->values) {
+            if (d->e) recorrer(d->e);
+            if (d->st) for (Exp* a : d->st->argumentos) recorrer(a);
+        }
+        for (const string& v : ind->vars) declara(v, ind->type);
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        recorrer(i->condition);
+        recorrer(i->thenBody);
+        recorrer(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        bucle(w->condition, w->body, nullptr);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) recorrer(f->init);
+        bucle(f->condition, f->body, f->step);
+    } else if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) recorrer(e);
+    } else if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) {
+        recorrer(r->e);
+    }
+}
+
+void AsignadorRegistros::recorrer(Body* b) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) declara(v, vd->type);
+    for (InstanceDec* ind : b->intances) recorrer(ind);
+    for (Stm* s : b->stmList) recorrer(s);
+}
+
+// ==========================================
+// Linear scan
+// ==========================================
+
+void AsignadorRegistros::asignar(FunDec* fd, const unordered_set<string>& tiposStruct) {
+    pos = 0;
+    tipos = &tiposStruct;
+    vida.clear();
+    declaraciones.clear();
+    enMemoria.clear();
+    lista.clear();
+    asignados.clear();
+    regsUsados.clear();
+
+    for (ParamDec* p : fd->params) declara(p->id, p->type);
+    recorrer(fd->body);
+
+    for (auto& par : vida) {
+        const string& var = par.first;
+        if (enMemoria.count(var) || declaraciones[var] != 1) continue;
+        lista.push_back(par.second);
+    }
+    sort(lista.begin(), lista.end(), [](const Intervalo& a, const Intervalo& b) {
+        return a.inicio != b.inicio ? a.inicio < b.inicio : a.var < b.var;
+    });
+
+    vector<int> libres(CALLEE_SAVED.rbegin(), CALLEE_SAVED.rend());
+    vector<Intervalo*> activos; // Ordenados por fin
+    for (Intervalo& iv : lista) {
+        // Liberar los que ya terminaron
+        while (!activos.empty() && activos.front()->fin < iv.inicio) {
+            libres.push_back(activos.front()->registro);
+            activos.erase(activos.begin());
+        }
+        Intervalo* nuevo = &iv;
+        if (libres.empty()) {
+            // Spill: queda en memoria el que termina más tarde
+            Intervalo* ultimo = activos.back();
+            if (ultimo->fin <= iv.fin) continue;
+            iv.registro = ultimo->registro;
+            ultimo->registro = -1;
+            activos.pop_back();
+        } else {
+            iv.registro = libres.back();
+            libres.pop_back();
+        }
+        auto it = lower_bound(activos.begin(), activos.end(), nuevo,
+                              [](Intervalo* a, Intervalo* b) { return a->fin < b->fin; });
+        activos.insert(it, nuevo);
+    }
+
+    for (const Intervalo& iv : lista) {
+        if (iv.registro < 0) continue;
+        asignados[iv.var] = iv.registro;
+    }
+    for (int r : CALLEE_SAVED) {
+        for (const Intervalo& iv : lista) {
+            if (iv.registro == r) {
+                regsUsados.push_back(r);
+                break;
+            }
+        }
+    }
+}
+
+int AsignadorRegistros::registro(const string& var) const {
+    auto it = asignados.find(var);
+    return it == asignados.end() ? -1 : it->second;
+}
+
+void AsignadorRegistros::reporte(const string& funcion, ostream& out) const {
+    out << "Registros " << funcion << ":";
+    for (const Intervalo& iv : lista) {
+        out << " " << iv.var << "[" << iv.inicio << "," << iv.fin << "]->";
+        if (iv.registro < 0) out << "memoria";
+        else out << "%" << NOMBRES[iv.registro];
+    }
+    out << endl;
+}
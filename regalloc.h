@@ -0,0 +1,67 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  Asignación de registros por linear scan (locales escalares)
+//  1. Vida: se numeran las apariciones de cada variable en el orden en
+//     que GenCodeVisitor emite el código; el intervalo va de la primera
+//     a la última. Una variable que aparece dentro de un bucle vive en
+//     todo el bucle (su valor cruza la arista de regreso).
+//  2. Linear scan (Poletto-Sarkar): intervalos por inicio, se liberan los
+//     vencidos y, sin registros libres, se deja en memoria el intervalo
+//     que termina más tarde.
+//  Se usan solo registros callee-saved (%rbx, %r12-%r15): los
+//  caller-saved ya son temporales de las expresiones y de las llamadas,
+//  y así los valores sobreviven a cualquier call sin guardarlos. El
+//  prólogo/epílogo de la función guarda los que se usen.
+//  Quedan en memoria los structs y los nombres declarados más de una vez.
+// ===========================================================
+
+class AsignadorRegistros {
+public:
+    struct Intervalo {
+        string var;
+        int inicio = -1;
+        int fin = -1;
+        int registro = -1; // -1: en memoria (spill)
+    };
+
+    // tiposStruct: nombres de tipos struct (sus variables quedan en memoria)
+    void asignar(FunDec* fd, const unordered_set<string>& tiposStruct);
+
+    // Registro de var, o -1 si vive en memoria
+    int registro(const string& var) const;
+    // Registros callee-saved usados (en orden), para el prólogo/epílogo
+    const vector<int>& usados() const { return regsUsados; }
+    const vector<Intervalo>& intervalos() const { return lista; }
+    void reporte(const string& funcion, ostream& out) const;
+
+private:
+    int pos = 0;
+    unordered_map<string, Intervalo> vida;
+    unordered_map<string, int> declaraciones;
+    unordered_set<string> enMemoria;
+    const unordered_set<string>* tipos = nullptr;
+    vector<unordered_set<string>*> bucles; // Nombres vistos en cada bucle abierto
+    vector<Intervalo> lista;
+    unordered_map<string, int> asignados;
+    vector<int> regsUsados;
+
+    void aparece(const string& var);
+    void declara(const string& var, const string& tipo);
+    void recorrer(Body* b);
+    void recorrer(Stm* s);
+    void recorrer(Exp* e);
+    void bucle(Exp* cond, Body* body, StepExp* step);
+};
+
+#endif // REGALLOC_H
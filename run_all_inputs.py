@@ -3,7 +3,7 @@ import subprocess
 import shutil
 
 # Archivos c++ (incluye TypeChecker y semantic_types si aplican)
-programa = ["main.cpp", "scanner.cpp", "token.cpp", "parser.cpp", "ast.cpp", "visitor.cpp", "TypeChecker.cpp", "struct_registry.cpp"]
+programa = ["main.cpp", "scanner.cpp", "token.cpp", "parser.cpp", "ast.cpp", "visitor.cpp", "TypeChecker.cpp", "struct_registry.cpp", "closure_engine.cpp", "x86_encoder.cpp", "jit.cpp", "native_runner.cpp", "elf_writer.cpp", "asm_buffer.cpp", "peephole.cpp", "regalloc.cpp", "ir.cpp", "ir_codegen.cpp", "constprop.cpp", "cse.cpp", "licm.cpp", "induccion.cpp", "scev.cpp", "desenrollado.cpp", "expansion.cpp", "pila.cpp", "pureza.cpp", "plegado.cpp", "especializacion.cpp"]
 
 # Compilar (comando simple, genera ./a.out)
 compile = ["g++"] + programa
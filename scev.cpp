@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <climits>
+#include "scev.h"
+
+using namespace std;
+
+// Inverso de 3 módulo 2^64: x/3 exacto = x * INVERSO_3
+static const unsigned long INVERSO_3 = 0xAAAAAAAAAAAAAAABUL;
+static const size_t MAX_TERMINOS = 32;
+
+// ==========================================
+// Aritmética de la forma cerrada
+// ==========================================
+
+void EvolucionEscalar::sumas(unsigned long n, unsigned long a, long paso, unsigned long s[3]) {
+    unsigned long p = (unsigned long)paso;
+    unsigned long h = n / 2;
+    unsigned long t1 = h * (2 * (n - h) - 1);        // 0 + 1 + ... + (n-1)
+    unsigned long t2 = t1 * (2 * n - 1) * INVERSO_3; // 0 + 1 + ... + (n-1)^2
+    s[0] = n;
+    s[1] = n * a + p * t1;
+    s[2] = n * a * a + 2 * a * p * t1 + p * p * t2;
+}
+
+long EvolucionEscalar::vueltas(BinaryOp op, long paso, long a, long limite) {
+    switch (op) {
+        case LT_OP: return a < limite ? (limite - a + paso - 1) / paso : 0;
+        case LE_OP: return a <= limite ? (limite - a) / paso + 1 : 0;
+        case GT_OP: return a > limite ? (a - limite - paso - 1) / -paso : 0;
+        default:    return a >= limite ? (a - limite) / -paso + 1 : 0;
+    }
+}
+
+bool EvolucionEscalar::ejecutar(const FormaCerrada& fc, const function<Value*(const string&)>& variable) {
+    // Coeficientes por grado de un polinomio con los valores actuales
+    auto coeficientes = [&](const vector<TerminoPolinomio>& p, unsigned long c[3]) {
+        c[0] = c[1] = c[2] = 0;
+        for (const TerminoPolinomio& t : p) {
+            unsigned long v = (unsigned long)t.constante;
+            for (const string& f : t.factores) {
+                Value* x = variable(f);
+                if (!x || x->kind != Value::INT) return false;
+                v *= (unsigned long)(long)x->i;
+            }
+            c[t.grado] += v;
+        }
+        return true;
+    };
+
+    Value* i = variable(fc.contador);
+    if (!i || i->kind != Value::INT) return false;
+    unsigned long c[3];
+    if (!coeficientes(fc.limite, c)) return false;
+    long a = i->i;
+    long limite = (int)c[0];
+    long n = vueltas(fc.op, fc.paso, a, limite);
+    long fin = a + n * fc.paso;
+    if (fin < INT_MIN || fin > INT_MAX) return false;
+
+    unsigned long s[3];
+    sumas((unsigned long)n, (unsigned long)a, fc.paso, s);
+    vector<pair<Value*, int>> nuevos;
+    for (const Acumulacion& acc : fc.acumulaciones) {
+        Value* v = variable(acc.var);
+        if (!v || v->kind != Value::INT || !coeficientes(acc.terminos, c)) return false;
+        unsigned long delta = c[0] * s[0] + c[1] * s[1] + c[2] * s[2];
+        nuevos.push_back({v, (int)((unsigned long)(long)v->i + delta)});
+    }
+    for (auto& nv : nuevos) *nv.first = Value::make_int(nv.second);
+    *i = Value::make_int((int)fin);
+    return true;
+}
+
+// ==========================================
+// Reconocimiento
+// ==========================================
+
+void EvolucionEscalar::declaraciones(Body* b) {
+    if (!b) return;
+    for (VarDec* vd : b->declarations) for (const string& v : vd->vars) tipos[v] = vd->type;
+    for (InstanceDec* ind : b->intances) declaraciones(ind);
+    for (Stm* s : b->stmList) declaraciones(s);
+}
+
+void EvolucionEscalar::declaraciones(Stm* s) {
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (const string& v : ind->vars) tipos[v] = ind->type;
+    } else if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        declaraciones(i->thenBody);
+        declaraciones(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        declaraciones(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        if (f->init) declaraciones(f->init);
+        declaraciones(f->body);
+    }
+}
+
+bool EvolucionEscalar::esLocalInt(const string& nombre) const {
+    auto it = tipos.find(nombre);
+    return it != tipos.end() && it->second == "int";
+}
+
+// e como polinomio en el contador (grado <= 2)
+bool EvolucionEscalar::polinomio(Exp* e, Polinomio& p) const {
+    p.clear();
+    if (e->cont == 1) {
+        p.push_back({(long)e->valor, {}, 0});
+        return true;
+    }
+    if (e->claseCont >= 0) return false;
+    if (NumberExp* n = dynamic_cast<NumberExp*>(e)) {
+        p.push_back({(long)n->value, {}, 0});
+        return true;
+    }
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        if (id->value == contador) {
+            p.push_back({1, {}, 1});
+            return true;
+        }
+        if (id->value == propio) {
+            p.push_back({1, {propio}, 0});
+            return true;
+        }
+        if (acumuladores.count(id->value) || !esLocalInt(id->value)) return false;
+        p.push_back({1, {id->value}, 0});
+        return true;
+    }
+    BinaryExp* b = dynamic_cast<BinaryExp*>(e);
+    if (!b) return false;
+    Polinomio l, r;
+    if (!polinomio(b->left, l) || !polinomio(b->right, r)) return false;
+    switch (b->op) {
+        case PLUS_OP:
+        case MINUS_OP:
+            p = l;
+            for (TerminoPolinomio t : r) {
+                if (b->op == MINUS_OP) t.constante = (long)(0UL - (unsigned long)t.constante);
+                p.push_back(t);
+            }
+            break;
+        case MUL_OP:
+            for (const TerminoPolinomio& x : l) {
+                for (const TerminoPolinomio& y : r) {
+                    if (x.grado + y.grado > 2) return false;
+                    TerminoPolinomio t = x;
+                    t.constante = (long)((unsigned long)x.constante * (unsigned long)y.constante);
+                    t.factores.insert(t.factores.end(), y.factores.begin(), y.factores.end());
+                    t.grado += y.grado;
+                    p.push_back(t);
+                }
+            }
+            break;
+        default:
+            return false;
+    }
+    return p.size() <= MAX_TERMINOS;
+}
+
+// s = s + P (en cualquier orden de sumandos, P sin s): el lado derecho
+// entero como polinomio en el que s aparece una vez con coeficiente 1
+bool EvolucionEscalar::acumulacion(Stm* s, Acumulacion& a) {
+    AssignStm* as = static_cast<AssignStm*>(s);
+    if (as->e->cont == 1 || as->e->claseCont >= 0) return false;
+    propio = as->id;
+    Polinomio p;
+    bool ok = polinomio(as->e, p);
+    propio.clear();
+    if (!ok) return false;
+    int propios = 0;
+    a.var = as->id;
+    a.terminos.clear();
+    for (const TerminoPolinomio& t : p) {
+        if (find(t.factores.begin(), t.factores.end(), as->id) == t.factores.end()) {
+            a.terminos.push_back(t);
+        } else if (t.constante == 1 && t.factores.size() == 1 && t.grado == 0) {
+            propios++;
+        } else {
+            return false;
+        }
+    }
+    return propios == 1;
+}
+
+bool EvolucionEscalar::reconocer(Exp* cond, Body* body, const string& var, int paso, Stm* ultimo, FormaCerrada& fc) {
+    if (!esLocalInt(var) || paso == 0) return false;
+    if (!body->tdlist.empty() || !body->declarations.empty() || !body->intances.empty()) return false;
+    contador = var;
+    acumuladores.clear();
+    for (Stm* s : body->stmList) {
+        if (s == ultimo) continue;
+        AssignStm* a = dynamic_cast<AssignStm*>(s);
+        if (!a || !esLocalInt(a->id) || a->id == var) return false;
+        acumuladores.insert(a->id);
+    }
+
+    BinaryExp* c = dynamic_cast<BinaryExp*>(cond);
+    if (!c || c->cont == 1 || c->claseCont >= 0) return false;
+    IdExp* id = dynamic_cast<IdExp*>(c->left);
+    if (!id || id->value != var) return false;
+    bool hacia = ((c->op == LT_OP || c->op == LE_OP) && paso > 0) ||
+                 ((c->op == GT_OP || c->op == GE_OP) && paso < 0);
+    Polinomio limite;
+    if (!hacia || !polinomio(c->right, limite)) return false;
+    for (const TerminoPolinomio& t : limite) if (t.grado != 0) return false;
+
+    // Las acumulaciones de una misma variable se suman
+    vector<Acumulacion> acumulaciones;
+    for (Stm* s : body->stmList) {
+        if (s == ultimo) continue;
+        Acumulacion a;
+        if (!acumulacion(s, a)) return false;
+        auto it = acumulaciones.begin();
+        while (it != acumulaciones.end() && it->var != a.var) ++it;
+        if (it == acumulaciones.end()) acumulaciones.push_back(a);
+        else it->terminos.insert(it->terminos.end(), a.terminos.begin(), a.terminos.end());
+    }
+
+    fc.contador = var;
+    fc.paso = paso;
+    fc.op = c->op;
+    fc.limite = limite;
+    fc.acumulaciones = acumulaciones;
+    cerrados++;
+    return true;
+}
+
+void EvolucionEscalar::recorrer(Body* b) {
+    if (!b) return;
+    for (Stm* s : b->stmList) recorrer(s);
+}
+
+void EvolucionEscalar::recorrer(Stm* s) {
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) {
+        recorrer(i->thenBody);
+        recorrer(i->elseBody);
+    } else if (WhileStm* w = dynamic_cast<WhileStm*>(s)) {
+        // while (...) { ...; i = i +/- c; }
+        AssignStm* ultimo = w->body->stmList.empty() ? nullptr : dynamic_cast<AssignStm*>(w->body->stmList.back());
+        BinaryExp* suma = ultimo ? dynamic_cast<BinaryExp*>(ultimo->e) : nullptr;
+        IdExp* id = suma ? dynamic_cast<IdExp*>(suma->left) : nullptr;
+        NumberExp* c = suma ? dynamic_cast<NumberExp*>(suma->right) : nullptr;
+        if (id && c && id->value == ultimo->id && (suma->op == PLUS_OP || suma->op == MINUS_OP)) {
+            int paso = suma->op == PLUS_OP ? c->value : -c->value;
+            FormaCerrada fc;
+            if (reconocer(w->condition, w->body, id->value, paso, ultimo, fc)) formas[w] = std::move(fc);
+        }
+        if (!formas.count(w)) recorrer(w->body);
+    } else if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        IdExp* id = f->step ? dynamic_cast<IdExp*>(f->step->variable) : nullptr;
+        int paso = 0;
+        if (id) {
+            if (f->step->type == StepExp::INCREMENT) paso = 1;
+            else if (f->step->type == StepExp::DECREMENT) paso = -1;
+            else if (NumberExp* n = dynamic_cast<NumberExp*>(f->step->amount)) paso = n->value;
+            else if (f->step->amount->cont == 1) paso = f->step->amount->valor;
+        }
+        FormaCerrada fc;
+        if (paso != 0 && reconocer(f->condition, f->body, id->value, paso, nullptr, fc)) formas[f] = std::move(fc);
+        if (!formas.count(f)) recorrer(f->body);
+    }
+}
+
+void EvolucionEscalar::funcion(FunDec* fd) {
+    tipos.clear();
+    for (ParamDec* p : fd->params) tipos[p->id] = p->type;
+    declaraciones(fd->body);
+    cerrados = 0;
+    recorrer(fd->body);
+    if (reporte) *reporte << "SCEV " << fd->id << ": " << cerrados << " bucles en forma cerrada" << endl;
+}
+
+const FormaCerrada* EvolucionEscalar::forma(Stm* bucle) const {
+    auto it = formas.find(bucle);
+    return it == formas.end() ? nullptr : &it->second;
+}
+
+void EvolucionEscalar::analizar(Program* program) {
+    for (FunDec* fd : program->fdlist) funcion(fd);
+}
@@ -0,0 +1,99 @@
+#ifndef SCEV_H
+#define SCEV_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "visitor.h"
+
+using namespace std;
+
+// Forma cerrada de un bucle de acumulación. Los polinomios están en el
+// contador: cada término es constante * factores * contador^grado, con
+// factores que son locales int que el bucle no escribe
+struct TerminoPolinomio {
+    long constante;
+    vector<string> factores;
+    int grado;                 // 0, 1 o 2
+};
+struct Acumulacion {
+    string var;                        // var = var + polinomio en cada vuelta
+    vector<TerminoPolinomio> terminos;
+};
+struct FormaCerrada {
+    string contador;                   // Avanza 'paso' por vuelta
+    int paso;
+    BinaryOp op;                       // contador <op> limite
+    vector<TerminoPolinomio> limite;   // Solo grado 0
+    vector<Acumulacion> acumulaciones;
+};
+
+// ===========================================================
+//  Evolución escalar y bucles en forma cerrada (--scev)
+//  Reconoce bucles contados cuyo cuerpo solo acumula:
+//      for (i = a; i <op> L; paso) { s = s + P(i); ... }
+//      while (i <op> L) { s = s + P(i); ...; i = i + c; }
+//  con P un polinomio de grado <= 2 en el contador cuyos coeficientes son
+//  constantes y locales int que el bucle no escribe (recurrencias afines
+//  y polinómicas), L invariante y el contador avanzando hacia L (<, <=
+//  con paso positivo; >, >= con paso negativo). Sin llamadas, printf,
+//  return ni declaraciones en el cuerpo: no hay otros efectos.
+//  El número de vueltas N sale de a, L y el paso; con las sumas
+//      S0 = N, S1 = sum(i), S2 = sum(i^2)
+//  (Faulhaber, exactas módulo 2^64: N(N-1)/2 = h(2(N-h)-1) con h = N/2 y
+//  la división entre 3 por el inverso de 3) cada acumulador recibe
+//  c0*S0 + c1*S1 + c2*S2 y el contador su valor final a + N*paso.
+//  La FormaCerrada de cada bucle queda en el pase (forma()); los motores
+//  la ejecutan en lugar de las N vueltas.
+// ===========================================================
+
+class EvolucionEscalar {
+public:
+    void analizar(Program* program);
+
+    ostream* reporte = nullptr; // --stats: bucles en forma cerrada por función
+
+    // Forma cerrada de un WhileStm/ForStm (nullptr: hay que ejecutarlo)
+    const FormaCerrada* forma(Stm* bucle) const;
+
+    // Ejecución en los intérpretes (int de 32 bits). 'variable' da el Value
+    // de un local por nombre; si alguno no es int, o el contador se saldría
+    // de int (el bucle original daría la vuelta), devuelve false y no
+    // escribe nada: hay que ejecutar el bucle.
+    static bool ejecutar(const FormaCerrada& fc, const function<Value*(const string&)>& variable);
+
+    // Sumas S0, S1, S2 de i = a, a+paso, ... (N términos) módulo 2^64
+    static void sumas(unsigned long n, unsigned long a, long paso, unsigned long s[3]);
+    // Vueltas de "i <op> L" desde a, con el paso ya orientado hacia L
+    static long vueltas(BinaryOp op, long paso, long a, long limite);
+
+private:
+    using Polinomio = vector<TerminoPolinomio>;
+
+    unordered_map<Stm*, FormaCerrada> formas;
+
+    unordered_map<string, string> tipos; // Tipo declarado de cada local
+    int cerrados = 0;
+
+    // Bucle en curso
+    string contador;
+    unordered_set<string> acumuladores;
+    string propio; // Acumulador de la sentencia que se analiza
+
+    void declaraciones(Body* b);
+    void declaraciones(Stm* s);
+    bool esLocalInt(const string& nombre) const;
+
+    bool polinomio(Exp* e, Polinomio& p) const;
+    bool acumulacion(Stm* s, Acumulacion& a);
+    bool reconocer(Exp* cond, Body* body, const string& var, int paso, Stm* ultimo, FormaCerrada& fc);
+    void recorrer(Body* b);
+    void recorrer(Stm* s);
+    void funcion(FunDec* fd);
+};
+
+#endif // SCEV_H
@@ -1,11 +1,22 @@
 #include <iostream>
 #include "ast.h"
 #include "visitor.h"
+#include "jit.h"
+#include "ir_codegen.h"
+#include "scev.h"
+#include "cse.h"
+#include "licm.h"
+#include "induccion.h"
+#include "desenrollado.h"
+#include "pureza.h"
+#include "pila.h"
 #include <unordered_map>
 #include <vector>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <climits>
+#include <cstring>
 
 using namespace std;
 
@@ -42,6 +53,183 @@ Value createDefaultValue(const string& type) {
     return Value::make_int(0);
 }
 
+// Convierte los campos escalares de un struct a la clase declarada de cada campo
+static void convertirCampos(Value& v) {
+    auto it = global_struct_defs.find(v.type_name);
+    if (it == global_struct_defs.end()) return;
+    const auto& fields = it->second;
+    for (size_t k = 0; k < fields.size() && k < v.fields.size(); ++k) {
+        Value& campo = v.fields[k];
+        if (campo.kind == Value::STRUCT) {
+            campo.type_name = fields[k].first;
+            convertirCampos(campo);
+        } else {
+            convertirEscalar(campo, kindDeTipo(fields[k].first));
+        }
+    }
+}
+
+Value::Kind kindDeTipo(const string& type) {
+    if (type.find("unsigned") != string::npos || type == "uint") return Value::UNSIGNED;
+    if (type == "bool") return Value::BOOL;
+    if (type == "float" || type == "double") return Value::FLOAT;
+    if (global_struct_defs.find(type) != global_struct_defs.end()) return Value::STRUCT;
+    return Value::INT;
+}
+
+int valorEntero(const Value& v) {
+    switch (v.kind) {
+        case Value::INT:      return v.i;
+        case Value::UNSIGNED: return (int)v.u;
+        case Value::BOOL:     return v.b ? 1 : 0;
+        case Value::FLOAT:    return (int)v.f;
+        default:              return 0; // Un struct completo no tiene vista entera
+    }
+}
+
+void convertirEscalar(Value& v, Value::Kind destino) {
+    if (destino == Value::INT && v.kind == Value::UNSIGNED) v = Value::make_int((int)v.u);
+    else if (destino == Value::UNSIGNED && v.kind == Value::INT) v = Value::make_unsigned((unsigned)v.i);
+}
+
+static bool claseEntera(const Value& v) {
+    return v.kind == Value::INT || v.kind == Value::UNSIGNED || v.kind == Value::BOOL;
+}
+
+static double valorDouble(const Value& v) {
+    if (v.kind == Value::FLOAT) return v.f;
+    if (v.kind == Value::UNSIGNED) return (double)v.u;
+    return (double)valorEntero(v);
+}
+
+// Aritmética y comparaciones con la clase "más ancha" de los operandos:
+// float > unsigned > int (bool cuenta como int). Las comparaciones dan int 0/1.
+Value operarBinaria(BinaryOp op, const Value& l, const Value& r) {
+    if (l.kind == Value::FLOAT || r.kind == Value::FLOAT) {
+        double a = valorDouble(l), b = valorDouble(r);
+        switch (op) {
+            case PLUS_OP:  return Value::make_float(a + b);
+            case MINUS_OP: return Value::make_float(a - b);
+            case MUL_OP:   return Value::make_float(a * b);
+            case DIV_OP:   return Value::make_float(a / b);
+            case GT_OP: return Value::make_int(a > b);
+            case LT_OP: return Value::make_int(a < b);
+            case GE_OP: return Value::make_int(a >= b);
+            case LE_OP: return Value::make_int(a <= b);
+            case EQ_OP: return Value::make_int(a == b);
+            case NE_OP: return Value::make_int(a != b);
+            default:    return Value::make_int(0);
+        }
+    }
+    if (l.kind == Value::UNSIGNED || r.kind == Value::UNSIGNED) {
+        unsigned a = (unsigned)valorEntero(l), b = (unsigned)valorEntero(r);
+        switch (op) {
+            case PLUS_OP:  return Value::make_unsigned(a + b);
+            case MINUS_OP: return Value::make_unsigned(a - b);
+            case MUL_OP:   return Value::make_unsigned(a * b);
+            case DIV_OP:
+                if (b == 0) { cerr << "Error: Div 0" << endl; exit(1); }
+                return Value::make_unsigned(a / b);
+            case GT_OP: return Value::make_int(a > b);
+            case LT_OP: return Value::make_int(a < b);
+            case GE_OP: return Value::make_int(a >= b);
+            case LE_OP: return Value::make_int(a <= b);
+            case EQ_OP: return Value::make_int(a == b);
+            case NE_OP: return Value::make_int(a != b);
+            default:    return Value::make_int(0);
+        }
+    }
+    int a = valorEntero(l), b = valorEntero(r);
+    switch (op) {
+        case PLUS_OP:  return Value::make_int(a + b);
+        case MINUS_OP: return Value::make_int(a - b);
+        case MUL_OP:   return Value::make_int(a * b);
+        case DIV_OP:
+            if (b == 0) { cerr << "Error: Div 0" << endl; exit(1); }
+            return Value::make_int(a / b);
+        case GT_OP: return Value::make_int(a > b);
+        case LT_OP: return Value::make_int(a < b);
+        case GE_OP: return Value::make_int(a >= b);
+        case LE_OP: return Value::make_int(a <= b);
+        case EQ_OP: return Value::make_int(a == b);
+        case NE_OP: return Value::make_int(a != b);
+        default:    return Value::make_int(0);
+    }
+}
+
+// El intérprete opera en 32 bits y el código generado en 64: una operación
+// entera solo se pliega si los dos anchos dan el mismo resultado
+bool mismoAncho(BinaryOp op, const Value& l, const Value& r) {
+    if (!claseEntera(l) || !claseEntera(r) || (op >= GT_OP && op <= NE_OP)) return true;
+    auto ancho64 = [](const Value& v) { return v.kind == Value::UNSIGNED ? (long)v.u : (long)valorEntero(v); };
+    long a = ancho64(l), b = ancho64(r), x;
+    switch (op) {
+        case PLUS_OP:  x = a + b; break;
+        case MINUS_OP: x = a - b; break;
+        case MUL_OP:   x = a * b; break;
+        case DIV_OP:   if (b == 0) return true; x = a / b; break;
+        default:       return true;
+    }
+    return ancho64(operarBinaria(op, l, r)) == x;
+}
+
+Value valorConstante(const Exp* e) {
+    switch (e->claseCont) {
+        case Value::UNSIGNED: return Value::make_unsigned((unsigned)e->valor);
+        case Value::BOOL:     return Value::make_bool(e->valor != 0);
+        case Value::FLOAT:    return Value::make_float(e->valorF);
+        default:              return Value::make_int(e->valor);
+    }
+}
+
+// ==========================================
+// Tabla de memoización
+// ==========================================
+
+TablaMemo::TablaMemo(size_t n) : capacidad(0) {
+    if (!n) return;
+    capacidad = 1;
+    while (capacidad < n) capacidad <<= 1;
+}
+
+size_t TablaMemo::indice(const vector<Value>& args) const {
+    size_t h = 1469598103934665603ULL;
+    for (const Value& v : args) {
+        h ^= (unsigned)valorEntero(v);
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 29;
+    return h & (entradas.size() - 1);
+}
+
+bool TablaMemo::buscar(const vector<Value>& args, int& ret, Value& valor) {
+    if (!capacidad) return false;
+    if (entradas.empty()) entradas.resize(capacidad);
+    const Entrada& e = entradas[indice(args)];
+    bool igual = e.valida;
+    for (size_t k = 0; igual && k < args.size(); ++k) igual = e.args[k] == valorEntero(args[k]);
+    if (!igual) {
+        fallos++;
+        return false;
+    }
+    aciertos++;
+    ret = e.ret;
+    valor = e.valor;
+    return true;
+}
+
+void TablaMemo::guardar(const vector<Value>& args, int ret, const Value& valor) {
+    if (!capacidad) return;
+    if (entradas.empty()) entradas.resize(capacidad);
+    Entrada& e = entradas[indice(args)];
+    if (!e.valida) ocupadas++;
+    e.valida = true;
+    e.args.resize(args.size());
+    for (size_t k = 0; k < args.size(); ++k) e.args[k] = valorEntero(args[k]);
+    e.ret = ret;
+    e.valor = valor;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 //                    SECCIÓN 1: MÉTODOS accept()
 ///////////////////////////////////////////////////////////////////////////////////
@@ -285,6 +473,7 @@ void EvalVisitor::evaluar(Program* program) {
     env.clear();
     env.add_level();
     envfun.clear();
+    bucles.clear();
     global_struct_defs.clear(); 
     return_value = 0;
     returning = false;
@@ -292,34 +481,184 @@ void EvalVisitor::evaluar(Program* program) {
 
     if (program) {
         for (FunDec* fd : program->fdlist) envfun[fd->id] = fd;
+        colaSegura = program->vdlist.empty() && program->intdlist.empty();
         cout << "Interprete:" << endl;
         program->accept(this);
+        if (reporteMemo) {
+            for (FunDec* fd : program->fdlist) {
+                auto it = memos.find(fd);
+                if (it == memos.end()) continue;
+                *reporteMemo << "MEMO " << fd->id << ": " << it->second.aciertos << " aciertos, " << it->second.fallos
+                             << " fallos, " << it->second.ocupadas << " entradas" << endl;
+            }
+        }
     }
     env.clear();
+    memos.clear();
+}
+
+// ----- OPTIMIZACION: Evaluación en compilación (--ctfe) -----
+void EvalVisitor::prepararEvaluacion(Program* program) {
+    env.clear();
+    env.add_level();
+    envfun.clear();
+    bucles.clear();
+    global_struct_defs.clear();
+    for (FunDec* fd : program->fdlist) envfun[fd->id] = fd;
+    for (StructDec* sd : program->strlist) sd->accept(this);
+    colaSegura = program->vdlist.empty() && program->intdlist.empty();
 }
 
+bool EvalVisitor::evaluarLlamada(FunDec* func, const vector<int>& args, long& gasolina, int& ret, Value& valor) {
+    vector<Value> argValues;
+    for (size_t i = 0; i < func->params.size(); ++i) {
+        argValues.push_back(Value::make_int(args[i]));
+        convertirEscalar(argValues.back(), kindDeTipo(func->params[i]->type));
+    }
+    compilando = true;
+    abandonada = false;
+    combustible = gasolina;
+    returning = false;
+    return_value = 0;
+    profundidad = 1;
+    PilaSegmentada::asegurar([&] { ret = ejecutarLlamada(func, argValues); });
+    profundidad = 0;
+    colaPendiente = nullptr;
+    gasolina = combustible > 0 ? combustible : 0;
+    combustible = LONG_MAX;
+    compilando = false;
+    if (abandonada) return false;
+    valor = last_value;
+    return true;
+}
+
+// Error o combustible agotado: se desenrolla hasta evaluarLlamada
+int EvalVisitor::abandonar() {
+    abandonada = true;
+    combustible = 0;  // El llamador tampoco sigue
+    returning = true;
+    last_value = Value::make_int(0);
+    last_value_valid = true;
+    return 0;
+}
+
+// ----- OPTIMIZACION: Quickening -----
+// La primera ejecución de un BinaryExp elige una variante según las clases de
+// operandos que vio (int/int o unsigned). Cada variante opera sin pasar por
+// operarBinaria y tiene una guarda: si aparece otra clase de operando, el nodo
+// se reescribe a la variante genérica. El TypeChecker rechaza la aritmética
+// float: un float solo llega a == y != y va directo a la genérica.
 int EvalVisitor::visit(BinaryExp* exp) {
-    int leftVal = exp->left->accept(this);
-    int rightVal = exp->right->accept(this);
-    int res = 0;
-    switch (exp->op) {
-        case PLUS_OP: res = leftVal + rightVal; break;
-        case MINUS_OP: res = leftVal - rightVal; break;
-        case MUL_OP: res = leftVal * rightVal; break;
-        case DIV_OP: 
-            if (rightVal == 0) { cerr << "Error: Div 0" << endl; exit(1); }
-            res = leftVal / rightVal; break;
-        case GT_OP: res = leftVal > rightVal; break;
-        case LT_OP: res = leftVal < rightVal; break;
-        case GE_OP: res = leftVal >= rightVal; break;
-        case LE_OP: res = leftVal <= rightVal; break;
-        case EQ_OP: res = leftVal == rightVal; break;
-        case NE_OP: res = leftVal != rightVal; break;
-        default: break;
+    if (exp->claseCont >= 0) return devolver(valorConstante(exp)); // --sccp
+    switch (exp->quick) {
+        case Q_BIN_INT: {
+            int leftVal = exp->left->accept(this);
+            if (last_value.kind != Value::INT) break;
+            int rightVal = exp->right->accept(this);
+            if (last_value.kind != Value::INT) {
+                // Guarda fallida con el izquierdo ya evaluado
+                exp->quick = Q_BIN_GENERICA;
+                Value r = std::move(last_value);
+                return binariaGenerica(exp, Value::make_int(leftVal), r);
+            }
+            if (compilando && !mismoAncho(exp->op, Value::make_int(leftVal), Value::make_int(rightVal)))
+                return abandonar();
+            int res = 0;
+            switch (exp->op) {
+                case PLUS_OP: res = leftVal + rightVal; break;
+                case MINUS_OP: res = leftVal - rightVal; break;
+                case MUL_OP: res = leftVal * rightVal; break;
+                case DIV_OP:
+                    if (rightVal == 0) {
+                        if (compilando) return abandonar();
+                        cerr << "Error: Div 0" << endl; exit(1);
+                    }
+                    res = leftVal / rightVal; break;
+                case GT_OP: res = leftVal > rightVal; break;
+                case LT_OP: res = leftVal < rightVal; break;
+                case GE_OP: res = leftVal >= rightVal; break;
+                case LE_OP: res = leftVal <= rightVal; break;
+                case EQ_OP: res = leftVal == rightVal; break;
+                case NE_OP: res = leftVal != rightVal; break;
+                default: break;
+            }
+            last_value = Value::make_int(res);
+            last_value_valid = true;
+            return res;
+        }
+        case Q_BIN_UNSIGNED: {
+            exp->left->accept(this);
+            Value l = std::move(last_value);
+            exp->right->accept(this);
+            // Guarda: algún operando unsigned y ninguno float ni struct
+            if ((l.kind != Value::UNSIGNED && last_value.kind != Value::UNSIGNED) || !claseEntera(l) ||
+                !claseEntera(last_value)) {
+                exp->quick = Q_BIN_GENERICA;
+                return binariaGenerica(exp, l, last_value);
+            }
+            if (compilando && !mismoAncho(exp->op, l, last_value)) return abandonar();
+            unsigned a = (unsigned)valorEntero(l), b = (unsigned)valorEntero(last_value);
+            switch (exp->op) {
+                case PLUS_OP: last_value = Value::make_unsigned(a + b); break;
+                case MINUS_OP: last_value = Value::make_unsigned(a - b); break;
+                case MUL_OP: last_value = Value::make_unsigned(a * b); break;
+                case DIV_OP:
+                    if (b == 0) {
+                        if (compilando) return abandonar();
+                        cerr << "Error: Div 0" << endl; exit(1);
+                    }
+                    last_value = Value::make_unsigned(a / b); break;
+                case GT_OP: last_value = Value::make_int(a > b); break;
+                case LT_OP: last_value = Value::make_int(a < b); break;
+                case GE_OP: last_value = Value::make_int(a >= b); break;
+                case LE_OP: last_value = Value::make_int(a <= b); break;
+                case EQ_OP: last_value = Value::make_int(a == b); break;
+                case NE_OP: last_value = Value::make_int(a != b); break;
+                default: last_value = Value::make_int(0); break;
+            }
+            last_value_valid = true;
+            return valorEntero(last_value);
+        }
+        case Q_BIN_INVARIANTE:
+            // --licm: ya calculado en el preheader (que lo calcula por la genérica)
+            if (licm && exp != preheader) return devolver(invariantes[exp]);
+        case Q_BIN_GENERICA: {
+            exp->left->accept(this);
+            Value l = std::move(last_value);
+            exp->right->accept(this);
+            return binariaGenerica(exp, l, last_value);
+        }
+        default:
+            return especializarBinaria(exp);
     }
-    last_value = Value::make_int(res);
+    // Guarda fallida en el operando izquierdo: despecializar
+    exp->quick = Q_BIN_GENERICA;
+    Value l = std::move(last_value);
+    exp->right->accept(this);
+    return binariaGenerica(exp, l, last_value);
+}
+
+int EvalVisitor::especializarBinaria(BinaryExp* exp) {
+    exp->left->accept(this);
+    Value l = std::move(last_value);
+    exp->right->accept(this);
+    Value::Kind lk = l.kind, rk = last_value.kind;
+    if (lk == Value::INT && rk == Value::INT) exp->quick = Q_BIN_INT;
+    else if (lk == Value::FLOAT || rk == Value::FLOAT) exp->quick = Q_BIN_GENERICA;
+    else if (lk == Value::UNSIGNED || rk == Value::UNSIGNED) exp->quick = Q_BIN_UNSIGNED;
+    else exp->quick = Q_BIN_GENERICA;
+    if (licm && licm->temporal(exp) >= 0) exp->quick = Q_BIN_INVARIANTE;
+    return binariaGenerica(exp, l, last_value);
+}
+
+int EvalVisitor::binariaGenerica(BinaryExp* exp, const Value& l, const Value& r) {
+    // operarBinaria termina el programa al dividir entre cero
+    if (compilando && exp->op == DIV_OP && l.kind != Value::FLOAT && r.kind != Value::FLOAT && valorEntero(r) == 0)
+        return abandonar();
+    if (compilando && !mismoAncho(exp->op, l, r)) return abandonar();
+    last_value = operarBinaria(exp->op, l, r);
     last_value_valid = true;
-    return res;
+    return valorEntero(last_value);
 }
 
 int EvalVisitor::visit(NumberExp* exp) {
@@ -334,19 +673,71 @@ int EvalVisitor::visit(FloatExp* exp) {
     return (int)exp->value;
 }
 
+// Protocolo de valores: el resultado completo de una expresión queda en
+// last_value y el consumidor lo toma por movimiento (sin copiar fields ni
+// type_name). Si el nodo no dejó valor, se usa su resultado entero.
+Value EvalVisitor::tomarValor(int val) {
+    if (!last_value_valid) return Value::make_int(val);
+    last_value_valid = false;
+    return std::move(last_value);
+}
+
+Value EvalVisitor::eval(Exp* e) {
+    last_value_valid = false;
+    int val = e->accept(this);
+    return tomarValor(val);
+}
+
+Value EvalVisitor::eval(InitData* d) {
+    last_value_valid = false;
+    int val = d->accept(this);
+    return tomarValor(val);
+}
+
+int EvalVisitor::devolver(const Value& v) {
+    last_value = v;
+    last_value_valid = true;
+    return valorEntero(v);
+}
+
+// ----- OPTIMIZACION: Quickening -----
+// IdExp se especializa en variable simple (sin buscar '.') o en acceso a campo
+// con los índices ya resueltos; la guarda es el tipo del struct raíz.
 int EvalVisitor::visit(IdExp* exp) {
+    if (exp->claseCont >= 0) return devolver(valorConstante(exp)); // --sccp
+    if (exp->quick == Q_ID_INVARIANTE && licm && exp != preheader) return devolver(invariantes[exp]); // --licm
+    if (exp->quick == Q_ID_SIMPLE) {
+        Value* v = env.lookup_ptr(exp->value);
+        if (v) return devolver(*v);
+        return devolver(env.lookup(exp->value)); // Advertencia + valor por defecto
+    }
+    if (exp->quick == Q_ID_CAMPO) {
+        size_t pos = exp->value.find('.');
+        Value* v = env.lookup_ptr(exp->value.substr(0, pos));
+        if (v && v->kind == Value::STRUCT && v->type_name == exp->structCache) {
+            const Value* cur = v;
+            for (int idx : exp->indices) cur = &cur->fields[idx];
+            return devolver(*cur);
+        }
+        exp->quick = Q_ID_GENERICO;
+    }
+    if (exp->quick == Q_NUEVO) {
+        exp->quick = (exp->value.find('.') == string::npos) ? Q_ID_SIMPLE : Q_ID_CAMPO;
+        if (licm && licm->temporal(exp) >= 0) exp->quick = Q_ID_INVARIANTE;
+        exp->indices.clear();
+    }
+    return idGenerico(exp);
+}
+
+int EvalVisitor::idGenerico(IdExp* exp) {
     string name = exp->value;
     size_t pos = name.find('.');
     
     // CASO 1: Variable simple (sin puntos)
     if (pos == string::npos) {
-        Value v = env.lookup(name);
-        last_value = v;
-        last_value_valid = true;
-        if (v.kind == Value::INT) return v.i;
-        if (v.kind == Value::UNSIGNED) return (int)v.u;
-        if (v.kind == Value::BOOL) return v.b ? 1 : 0;
-        return 0; // Si es un struct completo, retornamos 0 (el valor viaja en last_value)
+        Value* v = env.lookup_ptr(name);
+        if (v) return devolver(*v);
+        return devolver(env.lookup(name));
     } 
     
     // CASO 2: Acceso a Struct (p.x, rect.centro.y)
@@ -356,20 +747,22 @@ int EvalVisitor::visit(IdExp* exp) {
     while (getline(ss, token, '.')) parts.push_back(token);
 
     // Obtener la variable raíz
-    if (!env.check(parts[0])) {
+    Value* root = env.lookup_ptr(parts[0]);
+    if (!root) {
         cerr << "Error: Variable '" << parts[0] << "' no encontrada." << endl;
         exit(1);
     }
-    Value v = env.lookup(parts[0]);
+    const Value* v = root;
+    vector<int> indices;
 
     // Navegar por los campos
     for (size_t i = 1; i < parts.size(); ++i) {
-        if (v.kind != Value::STRUCT) { 
+        if (v->kind != Value::STRUCT) { 
             cerr << "Error: '" << parts[i-1] << "' no es un struct." << endl; 
             exit(1); 
         }
         
-        string structName = v.type_name;
+        string structName = v->type_name;
         string fieldName = parts[i];
         
         // Verificar definición del struct
@@ -394,16 +787,18 @@ int EvalVisitor::visit(IdExp* exp) {
         
         // Calcular índice y avanzar
         int index = distance(fields.begin(), it);
-        v = v.fields[index];
+        indices.push_back(index);
+        v = &v->fields[index];
+    }
+
+    // Guardar la resolución para la variante especializada
+    if (exp->quick == Q_ID_CAMPO) {
+        exp->indices = indices;
+        exp->structCache = root->type_name;
     }
 
     // Retornar el valor final
-    last_value = v;
-    last_value_valid = true;
-    if (v.kind == Value::INT) return v.i;
-    if (v.kind == Value::UNSIGNED) return (int)v.u;
-    if (v.kind == Value::BOOL) return v.b ? 1 : 0;
-    return 0;
+    return devolver(*v);
 }
 
 int EvalVisitor::visit(BoolExp* exp) {
@@ -419,39 +814,137 @@ int EvalVisitor::visit(FcallExp* fcall) {
     FunDec* func = envfun[fcall->name];
 
     vector<Value> argValues;
+    argValues.reserve(func->params.size());
     for (size_t i = 0; i < func->params.size(); ++i) {
-        last_value_valid = false;
-        int val = fcall->arguments[i]->accept(this);
-        Value v = last_value_valid ? last_value : Value::make_int(val);
-        argValues.push_back(v);
+        argValues.push_back(eval(fcall->arguments[i]));
+        convertirEscalar(argValues.back(), kindDeTipo(func->params[i]->type));
     }
 
-    env.add_level();
-    for (size_t i = 0; i < func->params.size(); ++i) {
-        env.add_var(func->params[i]->id, argValues[i]);
+    if (maxRecursion > 0 && profundidad >= maxRecursion) {
+        if (compilando) return abandonar();
+        cerr << "Error: límite de recursión excedido (" << maxRecursion << " llamadas anidadas) al llamar a "
+             << func->id << endl;
+        cout.flush();
+        exit(1);
     }
-    
+    // ----- OPTIMIZACION: Memoización (--memo) -----
+    TablaMemo* memo = nullptr;
+    vector<Value> clave;
+    int ret = 0;
+    if (capacidadMemo && pureza && pureza->pura(func)) {
+        memo = &memos.try_emplace(func, capacidadMemo).first->second;
+        if (memo->buscar(argValues, ret, last_value)) {
+            last_value_valid = true;
+            return ret;
+        }
+        clave = argValues;
+    }
+
+    profundidad++;
+    PilaSegmentada::asegurar([&] { ret = ejecutarLlamada(func, argValues); });
+    profundidad--;
+    if (memo) memo->guardar(clave, ret, last_value);
+    return ret;
+}
+
+// Ejecuta func con sus argumentos ya convertidos. Las llamadas en cola
+// que programe su return se ejecutan aquí mismo, una tras otra; el tipo
+// de la función llamada originalmente convierte el resultado final
+int EvalVisitor::ejecutarLlamada(FunDec* func, vector<Value>& argValues) {
+    FunDec* llamada = func;
+    FunDec* funcionLlamador = funcionActual;
+    long* saltosLlamador = saltosActual;
+    bool nativo = false;
+    int ret = 0;
     return_struct_valid = false;
-    func->body->accept(this);
-    
-    int ret = return_value;
-    env.remove_level();
-    
-    // Si hubo retorno de struct explícito, úsalo
-    if (return_struct_valid) {
-        last_value = return_struct;
+    while (true) {
+        // ----- OPTIMIZACION: Ejecución por niveles -----
+        // Función caliente: se llama a su código nativo en lugar de interpretarla
+        if (jit) {
+            TieredJit::Perfil* perfil = jit->perfil(func);
+            perfil->llamadas++;
+            if (jit->preparar(func, perfil)) {
+                vector<long> nativos;
+                for (const Value& v : argValues) nativos.push_back(valorEntero(v));
+                ret = (int)TieredJit::invocar(perfil->entrada, nativos);
+                nativo = true;
+                break;
+            }
+            saltosActual = &perfil->saltos;
+        }
+
+        env.add_level();
+        for (size_t i = 0; i < func->params.size(); ++i) {
+            env.add_var(func->params[i]->id, std::move(argValues[i]));
+        }
+        funcionActual = func;
+        func->body->accept(this);
+        ret = return_value;
+        env.remove_level();
+
+        if (!colaPendiente) break;
+        func = colaPendiente;
+        colaPendiente = nullptr;
+        argValues = std::move(argsCola);
+        returning = false;
+        return_value = 0;
+    }
+    saltosActual = saltosLlamador;
+    funcionActual = funcionLlamador;
+
+    // Si hubo retorno de struct explícito, úsalo (un float solo si la
+    // función llamada originalmente también es float)
+    Value::Kind clase = kindDeTipo(llamada->type);
+    if (return_struct_valid && (return_struct.kind == Value::STRUCT || clase == Value::FLOAT)) {
+        last_value = std::move(return_struct);
         last_value_valid = true;
         return_struct_valid = false; // Limpiar flag
     } else {
+        return_struct_valid = false;
         last_value = Value::make_int(ret);
+        if (clase == Value::FLOAT) last_value = Value::make_float(ret);
+        else if (!nativo || func != llamada) convertirEscalar(last_value, clase);
         last_value_valid = true;
     }
-    
+
     returning = false;
     return_value = 0;
     return ret;
 }
 
+bool EvalVisitor::terminaEnLlamada(Exp* e) {
+    if (e->claseCont >= 0) return false;
+    if (dynamic_cast<FcallExp*>(e)) return true;
+    TernaryExp* t = dynamic_cast<TernaryExp*>(e);
+    return t && (terminaEnLlamada(t->trueExp) || terminaEnLlamada(t->falseExp));
+}
+
+// Una llamada o un ternario con llamadas en sus ramas (se decide una vez)
+bool EvalVisitor::retornoEnCola(ReturnStm* r) {
+    auto it = retornosEnCola.find(r);
+    if (it == retornosEnCola.end()) it = retornosEnCola.emplace(r, terminaEnLlamada(r->e)).first;
+    return it->second;
+}
+
+// Evalúa los argumentos de una llamada en cola y la deja pendiente para
+// la llamada en curso. false: no se puede (structs en el retorno)
+bool EvalVisitor::programarCola(FcallExp* fcall) {
+    auto it = envfun.find(fcall->name);
+    if (it == envfun.end()) return false;
+    FunDec* func = it->second;
+    if (kindDeTipo(func->type) == Value::STRUCT || kindDeTipo(funcionActual->type) == Value::STRUCT) return false;
+    // Los argumentos pueden hacer otras llamadas: se juntan aparte
+    vector<Value> argValues;
+    argValues.reserve(func->params.size());
+    for (size_t i = 0; i < func->params.size(); ++i) {
+        argValues.push_back(eval(fcall->arguments[i]));
+        convertirEscalar(argValues.back(), kindDeTipo(func->params[i]->type));
+    }
+    argsCola = std::move(argValues);
+    colaPendiente = func;
+    return true;
+}
+
 int EvalVisitor::visit(Program* p) {
     for (StructDec* sd : p->strlist) sd->accept(this);
     for (TypedefDec* td : p->tdlist) td->accept(this);
@@ -483,6 +976,7 @@ int EvalVisitor::visit(StructDec* sd) {
 int EvalVisitor::visit(TypedefDec* td) { return 0; }
 
 int EvalVisitor::visit(TernaryExp* exp) {
+    if (exp->claseCont >= 0) return devolver(valorConstante(exp)); // --sccp
     int cond = exp->condition->accept(this);
     if (cond) {
         return exp->trueExp->accept(this);
@@ -492,10 +986,12 @@ int EvalVisitor::visit(TernaryExp* exp) {
 }
 
 int EvalVisitor::visit(Body* body) {
+    if (--combustible < 0) return abandonar(); // --ctfe
     for (TypedefDec* td : body->tdlist) td->accept(this);
     for (VarDec* vd : body->declarations) vd->accept(this);
     for (InstanceDec* ind : body->intances) ind->accept(this);
     for (Stm* stm : body->stmList) {
+        if (--combustible < 0) return abandonar();
         stm->accept(this);
         if (returning) return return_value;
     }
@@ -513,14 +1009,14 @@ int EvalVisitor::visit(InstanceDec* ind) {
     auto varIt = ind->vars.begin();
     auto valIt = ind->values.begin();
     for (; varIt != ind->vars.end(); ++varIt, ++valIt) {
-        last_value_valid = false;
-        int val = (*valIt)->accept(this);
-        Value v = last_value_valid ? last_value : Value::make_int(val);
-        if ((ind->type.find("unsigned") != string::npos || ind->type == "uint") && v.kind == Value::INT) {
-            v = Value::make_unsigned((unsigned)v.i);
+        Value v = eval(*valIt);
+        if (v.kind == Value::STRUCT) {
+            v.type_name = ind->type;
+            convertirCampos(v);
+        } else {
+            convertirEscalar(v, kindDeTipo(ind->type));
         }
-        if (v.kind == Value::STRUCT) v.type_name = ind->type;
-        env.add_var(*varIt, v);
+        env.add_var(*varIt, std::move(v));
     }
     return 0;
 }
@@ -531,19 +1027,20 @@ int EvalVisitor::visit(Include* inc) { return 0; }
 
 int EvalVisitor::visit(AssignStm* stm) {
     // Evaluar el valor a asignar (RHS)
-    last_value_valid = false;
-    int val = stm->e->accept(this);
-    Value newVal = last_value_valid ? last_value : Value::make_int(val);
+    Value newVal = eval(stm->e);
 
     string name = stm->id;
     size_t dotPos = name.find('.');
 
-    // CASO A: Asignación simple
+    // CASO A: Asignación simple (el destino conserva su clase int/unsigned)
     if (dotPos == string::npos) {
-        if (!env.update(name, newVal)) {
+        Value* dest = env.lookup_ptr(name);
+        if (!dest) {
             cerr << "Error: Asignacion fallida a " << name << endl;
             exit(1);
         }
+        convertirEscalar(newVal, dest->kind);
+        *dest = std::move(newVal);
     } 
     // CASO B: Asignación a Struct (p.x = ...)
     else {
@@ -555,14 +1052,12 @@ int EvalVisitor::visit(AssignStm* stm) {
         }
 
         string rootVar = parts[0];
-        if (!env.check(rootVar)) {
+        // Se modifica el struct en su slot del entorno, sin copiarlo
+        Value* currentVal = env.lookup_ptr(rootVar);
+        if (!currentVal) {
             cerr << "Error: Variable '" << rootVar << "' no encontrada." << endl;
             exit(1);
         }
-        
-        // IMPORTANTE: Copia para modificar
-        Value structVal = env.lookup(rootVar);
-        Value* currentVal = &structVal;
 
         for (size_t i = 1; i < parts.size(); ++i) {
             if (currentVal->kind != Value::STRUCT) {
@@ -596,19 +1091,239 @@ int EvalVisitor::visit(AssignStm* stm) {
             // Asignar o profundizar
             if (i == parts.size() - 1) {
                 // Estamos en el campo final -> Asignar
-                currentVal->fields[index] = newVal;
+                convertirEscalar(newVal, currentVal->fields[index].kind);
+                currentVal->fields[index] = std::move(newVal);
             } else {
                 // Aún falta camino -> Profundizar
                 currentVal = &(currentVal->fields[index]);
             }
         }
+    }
+    return 0;
+}
+
+// ----- OPTIMIZACION: Superinstrucciones de bucle -----
+// Análisis (una vez por bucle) de la forma contada y ejecución fusionada.
+
+static bool esComparacion(BinaryOp op) {
+    return op == LT_OP || op == LE_OP || op == GT_OP || op == GE_OP || op == EQ_OP || op == NE_OP;
+}
+
+static bool variableSimple(Exp* e, string& name) {
+    IdExp* id = dynamic_cast<IdExp*>(e);
+    if (!id || id->value.find('.') != string::npos) return false;
+    name = id->value;
+    return true;
+}
+
+static bool compararEnteros(BinaryOp op, int a, int b) {
+    switch (op) {
+        case LT_OP: return a < b;
+        case LE_OP: return a <= b;
+        case GT_OP: return a > b;
+        case GE_OP: return a >= b;
+        case EQ_OP: return a == b;
+        default:    return a != b;
+    }
+}
+
+// ¿Hay alguna llamada a función? (podría escribir un global por nombre)
+static bool hayLlamada(Exp* e);
+static bool hayLlamada(Body* b);
+
+static bool hayLlamada(Stm* s) {
+    if (!s) return false;
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return hayLlamada(a->e);
+    if (PrintfStm* p = dynamic_cast<PrintfStm*>(s)) {
+        for (Exp* e : p->args) if (hayLlamada(e)) return true;
+        return false;
+    }
+    if (ReturnStm* r = dynamic_cast<ReturnStm*>(s)) return hayLlamada(r->e);
+    if (IfStm* i = dynamic_cast<IfStm*>(s))
+        return hayLlamada(i->condition) || hayLlamada(i->thenBody) || hayLlamada(i->elseBody);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return hayLlamada(w->condition) || hayLlamada(w->body);
+    if (ForStm* f = dynamic_cast<ForStm*>(s))
+        return hayLlamada(f->init) || hayLlamada(f->condition) || hayLlamada(f->step) || hayLlamada(f->body);
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s)) {
+        for (InitData* d : ind->values) {
+            if (d->e && hayLlamada(d->e)) return true;
+            if (d->st) for (Exp* e : d->st->argumentos) if (hayLlamada(e)) return true;
+        }
+        return false;
+    }
+    return false;
+}
 
-        // Actualizar la memoria con el struct modificado
-        env.update(rootVar, structVal);
+static bool hayLlamada(Exp* e) {
+    if (!e) return false;
+    if (dynamic_cast<FcallExp*>(e)) return true;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return hayLlamada(b->left) || hayLlamada(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return hayLlamada(t->condition) || hayLlamada(t->trueExp) || hayLlamada(t->falseExp);
+    if (StepExp* st = dynamic_cast<StepExp*>(e)) return hayLlamada(st->amount);
+    return false;
+}
+
+static bool hayLlamada(Body* b) {
+    if (!b) return false;
+    for (InstanceDec* ind : b->intances) if (hayLlamada(ind)) return true;
+    for (Stm* s : b->stmList) if (hayLlamada(s)) return true;
+    return false;
+}
+
+// ¿El cuerpo escribe (o redeclara) la variable? 'omitir' se excluye del análisis
+static bool escribe(Body* b, const string& var, Stm* omitir = nullptr);
+
+static bool escribe(Stm* s, const string& var) {
+    if (!s) return false;
+    if (AssignStm* a = dynamic_cast<AssignStm*>(s)) return a->id == var;
+    if (IfStm* i = dynamic_cast<IfStm*>(s)) return escribe(i->thenBody, var) || escribe(i->elseBody, var);
+    if (WhileStm* w = dynamic_cast<WhileStm*>(s)) return escribe(w->body, var);
+    if (ForStm* f = dynamic_cast<ForStm*>(s)) {
+        IdExp* id = f->step ? dynamic_cast<IdExp*>(f->step->variable) : nullptr;
+        return escribe(f->init, var) || (id && id->value == var) || escribe(f->body, var);
+    }
+    if (InstanceDec* ind = dynamic_cast<InstanceDec*>(s))
+        return find(ind->vars.begin(), ind->vars.end(), var) != ind->vars.end();
+    return false;
+}
+
+static bool escribe(Body* b, const string& var, Stm* omitir) {
+    if (!b) return false;
+    for (VarDec* vd : b->declarations)
+        if (find(vd->vars.begin(), vd->vars.end(), var) != vd->vars.end()) return true;
+    for (InstanceDec* ind : b->intances) if (escribe(ind, var)) return true;
+    for (Stm* s : b->stmList) if (s != omitir && escribe(s, var)) return true;
+    return false;
+}
+
+// Condición "i <op> limite" con limite constante o variable simple
+bool EvalVisitor::condicionContada(Exp* cond, BucleContado& bc) {
+    BinaryExp* b = dynamic_cast<BinaryExp*>(cond);
+    if (!b || !esComparacion(b->op) || !variableSimple(b->left, bc.var)) return false;
+    bc.op = b->op;
+    if (NumberExp* n = dynamic_cast<NumberExp*>(b->right)) {
+        bc.limiteConst = true;
+        bc.limite = n->value;
+        return true;
+    }
+    if (variableSimple(b->right, bc.limiteVar) && bc.limiteVar != bc.var) {
+        bc.limiteConst = false;
+        return true;
+    }
+    return false;
+}
+
+const EvalVisitor::BucleContado& EvalVisitor::analizarFor(ForStm* stm) {
+    auto it = bucles.find(stm);
+    if (it != bucles.end()) return it->second;
+    BucleContado& bc = bucles[stm];
+    if (!stm->step || !condicionContada(stm->condition, bc)) return bc;
+
+    IdExp* id = dynamic_cast<IdExp*>(stm->step->variable);
+    if (!id || id->value != bc.var) return bc;
+    if (stm->step->type == StepExp::INCREMENT) bc.paso = 1;
+    else if (stm->step->type == StepExp::DECREMENT) bc.paso = -1;
+    else if (NumberExp* n = dynamic_cast<NumberExp*>(stm->step->amount)) bc.paso = n->value;
+    else return bc;
+
+    if (escribe(stm->body, bc.var)) return bc;
+    // Un contador que no declara el propio for podría ser global y una llamada escribirlo
+    InstanceDec* init = dynamic_cast<InstanceDec*>(stm->init);
+    bool propio = init && find(init->vars.begin(), init->vars.end(), bc.var) != init->vars.end();
+    if (!propio && hayLlamada(stm->body)) return bc;
+
+    bc.fusionado = true;
+    return bc;
+}
+
+// while (i <op> limite) { ...; i = i + c; }
+const EvalVisitor::BucleContado& EvalVisitor::analizarWhile(WhileStm* stm) {
+    auto it = bucles.find(stm);
+    if (it != bucles.end()) return it->second;
+    BucleContado& bc = bucles[stm];
+    if (!condicionContada(stm->condition, bc) || stm->body->stmList.empty()) return bc;
+
+    AssignStm* ultimo = dynamic_cast<AssignStm*>(stm->body->stmList.back());
+    if (!ultimo || ultimo->id != bc.var) return bc;
+    BinaryExp* suma = dynamic_cast<BinaryExp*>(ultimo->e);
+    string base;
+    if (!suma || (suma->op != PLUS_OP && suma->op != MINUS_OP)) return bc;
+    if (!variableSimple(suma->left, base) || base != bc.var) return bc;
+    NumberExp* n = dynamic_cast<NumberExp*>(suma->right);
+    if (!n) return bc;
+    bc.paso = (suma->op == PLUS_OP) ? n->value : -n->value;
+
+    if (escribe(stm->body, bc.var, ultimo) || hayLlamada(stm->body)) return bc;
+    bc.fusionado = true;
+    return bc;
+}
+
+// Igual que visit(Body), pero sin ejecutar la sentencia 'omitir'
+int EvalVisitor::ejecutarCuerpo(Body* body, Stm* omitir) {
+    if (--combustible < 0) return abandonar(); // --ctfe
+    for (TypedefDec* td : body->tdlist) td->accept(this);
+    for (VarDec* vd : body->declarations) vd->accept(this);
+    for (InstanceDec* ind : body->intances) ind->accept(this);
+    for (Stm* stm : body->stmList) {
+        if (stm == omitir) continue;
+        if (--combustible < 0) return abandonar();
+        stm->accept(this);
+        if (returning) return return_value;
     }
     return 0;
 }
 
+// Compara-y-salta e incremento sobre el slot int del contador. Si el contador
+// o el límite no son int en ejecución, esa iteración usa la ruta normal.
+// Los slots se resuelven una vez: el cuerpo solo agrega y quita niveles por
+// encima de los suyos, y lookup_ptr vale mientras exista el nivel.
+void EvalVisitor::bucleFusionado(const BucleContado& bc, Exp* cond, Body* body, StepExp* step, Stm* pasoFinal) {
+    Value* v = env.lookup_ptr(bc.var);
+    Value* l = bc.limiteConst ? nullptr : env.lookup_ptr(bc.limiteVar);
+    while (true) {
+        bool seguir;
+        if (v && v->kind == Value::INT && (bc.limiteConst || (l && l->kind == Value::INT)))
+            seguir = compararEnteros(bc.op, v->i, bc.limiteConst ? bc.limite : l->i);
+        else
+            seguir = cond->accept(this) != 0;
+        if (!seguir) break;
+
+        env.add_level(); ejecutarCuerpo(body, pasoFinal); env.remove_level();
+        if (returning) break;
+        if (saltosActual) ++*saltosActual;
+
+        if (v && v->kind == Value::INT) {
+            if (compilando && !mismoAncho(PLUS_OP, *v, Value::make_int(bc.paso))) {
+                abandonar();
+                break;
+            }
+            v->i += bc.paso;
+        } else if (step) {
+            step->accept(this);
+        } else if (pasoFinal) {
+            pasoFinal->accept(this);
+        }
+    }
+}
+
+// Preheader: cada invariante se evalúa por su ruta normal (sin leer su valor)
+void EvalVisitor::calcularInvariantes(Stm* bucle, vector<Value>& tapados) {
+    for (Exp* e : licm->invariantes(bucle)) {
+        preheader = e;
+        Value v = eval(e);
+        preheader = nullptr;
+        Value& valor = invariantes[e];
+        tapados.push_back(std::move(valor));
+        valor = std::move(v);
+    }
+}
+
+void EvalVisitor::restaurarInvariantes(Stm* bucle, vector<Value>& tapados) {
+    const vector<Exp*>& lista = licm->invariantes(bucle);
+    for (size_t i = 0; i < lista.size(); ++i) invariantes[lista[i]] = std::move(tapados[i]);
+}
+
 int EvalVisitor::visit(IfStm* stm) {
     if (stm->condition->accept(this)) {
         env.add_level(); stm->thenBody->accept(this); env.remove_level();
@@ -618,51 +1333,104 @@ int EvalVisitor::visit(IfStm* stm) {
     return 0;
 }
 
+// Bucle en forma cerrada (--scev): las variables se leen y escriben en el entorno
+bool EvalVisitor::formaCerrada(Stm* bucle) {
+    // Al compilar se ejecuta el bucle: la forma cerrada no detecta desbordes
+    const FormaCerrada* fc = scev && !compilando ? scev->forma(bucle) : nullptr;
+    return fc && EvolucionEscalar::ejecutar(*fc, [this](const string& var) { return env.lookup_ptr(var); });
+}
+
 int EvalVisitor::visit(WhileStm* stm) {
-    while (stm->condition->accept(this)) {
-        env.add_level(); stm->body->accept(this); env.remove_level();
-        if (returning) return return_value;
+    if (formaCerrada(stm)) return 0;
+    vector<Value> tapados;
+    if (licm) calcularInvariantes(stm, tapados);
+    const BucleContado& bc = analizarWhile(stm);
+    if (bc.fusionado) {
+        bucleFusionado(bc, stm->condition, stm->body, nullptr, stm->body->stmList.back());
+    } else {
+        while (stm->condition->accept(this)) {
+            env.add_level(); stm->body->accept(this); env.remove_level();
+            if (returning) break;
+            if (saltosActual) ++*saltosActual;
+        }
     }
-    return 0;
+    if (licm) restaurarInvariantes(stm, tapados);
+    return returning ? return_value : 0;
 }
 
 int EvalVisitor::visit(ForStm* stm) {
+    const BucleContado& bc = analizarFor(stm);
     env.add_level();
     if (stm->init) stm->init->accept(this);
-    while (stm->condition->accept(this)) {
-        env.add_level(); stm->body->accept(this); env.remove_level();
-        if (returning) break;
-        if (stm->step) stm->step->accept(this);
+    if (formaCerrada(stm)) {
+        env.remove_level();
+        return 0;
+    }
+    vector<Value> tapados;
+    if (licm) calcularInvariantes(stm, tapados);
+    if (bc.fusionado) {
+        bucleFusionado(bc, stm->condition, stm->body, stm->step, nullptr);
+    } else {
+        while (stm->condition->accept(this)) {
+            env.add_level(); stm->body->accept(this); env.remove_level();
+            if (returning) break;
+            if (saltosActual) ++*saltosActual;
+            if (stm->step) stm->step->accept(this);
+        }
     }
+    if (licm) restaurarInvariantes(stm, tapados);
     env.remove_level();
     return 0;
 }
 
+// ----- OPTIMIZACION: Quickening -----
+// StepExp se especializa para contadores int; un unsigned (u otra clase) lo
+// reescribe a la variante genérica, que respeta la clase del valor.
 int EvalVisitor::visit(StepExp* step) {
-    IdExp* id = dynamic_cast<IdExp*>(step->variable);
-    if (!id) return 0;
-    Value v = env.lookup(id->value);
-    int val = v.i;
-    if (step->type == StepExp::INCREMENT) val++;
-    else if (step->type == StepExp::DECREMENT) val--;
-    else if (step->type == StepExp::COMPOUND) val += step->amount->accept(this);
-    env.update(id->value, Value::make_int(val));
+    if (step->quick == Q_NUEVO) {
+        if (!dynamic_cast<IdExp*>(step->variable)) return 0;
+        step->quick = Q_PASO_INT;
+    }
+    IdExp* id = static_cast<IdExp*>(step->variable);
+    Value* v = env.lookup_ptr(id->value);
+    if (!v) { env.lookup(id->value); return 0; }
+
+    if (step->quick == Q_PASO_INT && v->kind == Value::INT) {
+        long val = v->i;
+        if (step->type == StepExp::INCREMENT) val++;
+        else if (step->type == StepExp::DECREMENT) val--;
+        else if (step->type == StepExp::COMPOUND) {
+            val += step->amount->accept(this);
+            v = env.lookup_ptr(id->value); // La expresión pudo crear niveles nuevos
+        }
+        if (compilando && val != (int)val) return abandonar();
+        *v = Value::make_int((int)val);
+        return 0;
+    }
+    step->quick = Q_PASO_GENERICO;
+    Value actual = *v;
+    Value delta = Value::make_int(1);
+    if (step->type == StepExp::DECREMENT) delta = Value::make_int(-1);
+    else if (step->type == StepExp::COMPOUND) {
+        delta = eval(step->amount);
+    }
+    if (compilando && !mismoAncho(PLUS_OP, actual, delta)) return abandonar();
+    Value nuevo = operarBinaria(PLUS_OP, actual, delta);
+    convertirEscalar(nuevo, actual.kind);
+    env.update(id->value, nuevo);
     return 0;
 }
 
 int EvalVisitor::visit(PrintfStm* stm) {
     string fmt = stm->format;
     vector<Value> args;
-    for (Exp* e : stm->args) {
-        last_value_valid = false;
-        int val = e->accept(this);
-        args.push_back(last_value_valid ? last_value : Value::make_int(val));
-    }
+    args.reserve(stm->args.size());
+    for (Exp* e : stm->args) args.push_back(eval(e));
     int argIdx = 0;
     for (size_t i = 0; i < fmt.size(); i++) {
         if (fmt[i] == '%' && argIdx < args.size()) {
-            Value v = args[argIdx++];
-            if (i+1 < fmt.size() && fmt[i+1] == 'd') { cout << v.i; i++; }
+            const Value& v = args[argIdx++];
+            if (i+1 < fmt.size() && fmt[i+1] == 'd') { cout << (v.kind == Value::FLOAT ? v.i : valorEntero(v)); i++; }
             else if (i+1 < fmt.size() && fmt[i+1] == 'u') { 
                 if (v.kind == Value::UNSIGNED) cout << v.u; else cout << (unsigned)v.i;
                 i++; 
@@ -691,11 +1459,26 @@ int EvalVisitor::visit(ReturnStm* r) {
         last_value_valid = false;
         return_struct_valid = false; // Reset
 
-        return_value = r->e->accept(this); // Evalúa
+        Exp* e = r->e;
+        if (colaSegura && profundidad > 0 && retornoEnCola(r)) {
+            // La rama elegida de un ternario también está en cola
+            while (TernaryExp* t = dynamic_cast<TernaryExp*>(e)) {
+                if (t->claseCont >= 0) break;
+                e = t->condition->accept(this) ? t->trueExp : t->falseExp;
+            }
+            FcallExp* fcall = dynamic_cast<FcallExp*>(e);
+            if (fcall && fcall->claseCont < 0 && programarCola(fcall)) {
+                returning = true;
+                return 0;
+            }
+        }
+        return_value = e->accept(this); // Evalúa
         
-        // Si el resultado fue un struct, guárdalo en la variable específica
-        if (last_value_valid && last_value.kind == Value::STRUCT) {
-            return_struct = last_value;
+        // Si el resultado fue un struct o un float, guárdalo en la variable
+        // específica: return_value solo es la vista entera
+        if (last_value_valid && (last_value.kind == Value::STRUCT || last_value.kind == Value::FLOAT)) {
+            return_struct = std::move(last_value);
+            last_value_valid = false;
             return_struct_valid = true;
         }
     }
@@ -705,12 +1488,9 @@ int EvalVisitor::visit(ReturnStm* r) {
 
 int EvalVisitor::visit(StructInit* si) {
     vector<Value> fields;
-    for (Exp* e : si->argumentos) {
-        last_value_valid = false;
-        int val = e->accept(this);
-        fields.push_back(last_value_valid ? last_value : Value::make_int(val));
-    }
-    last_value = Value::make_struct(fields);
+    fields.reserve(si->argumentos.size());
+    for (Exp* e : si->argumentos) fields.push_back(eval(e));
+    last_value = Value::make_struct(std::move(fields));
     last_value_valid = true;
     return 0;
 }
@@ -734,22 +1514,32 @@ int GenCodeVisitor::getMemory(string name) {
 }
 
 void GenCodeVisitor::generar(Program* program) {
+    generarCodigo(program);
+    emitirTexto(codigo, out);
+}
+
+void GenCodeVisitor::generarCodigo(Program* program) {
     if (program) program->accept(this);
 }
 
 int GenCodeVisitor::visit(Program* p) {
-    out << ".data" << endl;
-    out << "print_fmt_int: .string \"%ld\\n\"" << endl;
+    codigo.directiva(".data");
+    codigo.definir(codigo.etiqueta("print_fmt_int"));
+    codigo.directiva(".string \"%ld\\n\"");
     
-    out << ".text" << endl;
-    out << ".global main" << endl;
+    codigo.directiva(".text");
+    codigo.directiva(".global main");
 
     // Structs (offsets)
     for (auto s : p->strlist) s->accept(this);
     // Funciones
-    for (FunDec* fd : p->fdlist) fd->accept(this);
+    for (FunDec* fd : p->fdlist) funciones[fd->id] = fd;
+    for (FunDec* fd : p->fdlist) {
+        if (generadorIR && generadorIR->generar(fd, codigo)) continue;
+        fd->accept(this);
+    }
     
-    out << ".section .note.GNU-stack,\"\",@progbits" << endl;
+    codigo.directiva(".section .note.GNU-stack,\"\",@progbits");
     return 0;
 }
 
@@ -767,43 +1557,195 @@ int GenCodeVisitor::visit(StructDec* sd) {
 
 int GenCodeVisitor::visit(TypedefDec* td) { return 0; }
 
+// -------------------- IF-CONVERSION (--cmov) --------------------
+// Se puede calcular aunque no se elija: sin llamadas, ++/-- ni divisiones
+bool GenCodeVisitor::sinEfectos(Exp* e) {
+    if (e->cont == 1 || temporalLicm(e) >= 0 || temporalIv(e) >= 0 || cseListo(e)) return true;
+    if (dynamic_cast<NumberExp*>(e) || dynamic_cast<BoolExp*>(e) || dynamic_cast<FloatExp*>(e)) return true;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) return !structSizes.count(varTypes[id->value]);
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        switch (b->op) {
+            case PLUS_OP: case MINUS_OP: case MUL_OP:
+            case GT_OP: case LT_OP: case GE_OP: case LE_OP: case EQ_OP: case NE_OP:
+                return sinEfectos(b->left) && sinEfectos(b->right);
+            default:
+                return false;
+        }
+    }
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return sinEfectos(t->condition) && sinEfectos(t->trueExp) && sinEfectos(t->falseExp);
+    return false;
+}
+
+// Operaciones de más por calcular la rama aunque no se elija: los
+// operandos directos no cuestan, un ternario anidado suma su comparación
+int GenCodeVisitor::costoRama(Exp* e) {
+    Operando op;
+    if (operandoDirecto(e, op)) return 0;
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) return 1 + costoRama(b->left) + costoRama(b->right);
+    if (TernaryExp* t = dynamic_cast<TernaryExp*>(e))
+        return 2 + costoRama(t->condition) + costoRama(t->trueExp) + costoRama(t->falseExp);
+    return 1;
+}
+
+// f nulo: la rama falsa es el valor actual de la variable (if sin else)
+bool GenCodeVisitor::convertible(Exp* t, Exp* f) {
+    if (umbralSeleccion < 0 || !sinEfectos(t) || (f && !sinEfectos(f))) return false;
+    return costoRama(t) + (f ? costoRama(f) : 0) <= umbralSeleccion;
+}
+
+// Rama de un if que solo asigna una variable escalar (no campos ni structs)
+AssignStm* GenCodeVisitor::asignacionUnica(Body* b) {
+    if (!b || !b->declarations.empty() || !b->intances.empty() || b->stmList.size() != 1) return nullptr;
+    AssignStm* a = dynamic_cast<AssignStm*>(b->stmList.front());
+    if (!a || a->id.find('.') != string::npos || structSizes.count(varTypes[a->id])) return nullptr;
+    return a;
+}
+
+// %rax = cond ? t : f. Las ramas que no son operandos directos se calculan
+// antes y esperan en la pila; una comparación entre operandos directos se
+// hace al final y cmovcc usa la condición contraria. Si no, la condición
+// se calcula primero (puede tener llamadas: se evalúa igual que con saltos)
+void GenCodeVisitor::seleccionar(Exp* cond, Exp* t, Exp* f, Operando sino) {
+    selecciones++;
+    Operando opT, opF = sino, izq, der;
+    bool directoT = operandoDirecto(t, opT);
+    bool directoF = !f || operandoDirecto(f, opF);
+    BinaryExp* cmp = dynamic_cast<BinaryExp*>(cond);
+    bool comparacion = cmp && cmp->op >= GT_OP && cmp->op <= NE_OP && temporalLicm(cond) < 0 && temporalIv(cond) < 0 &&
+                       !cseListo(cond) && operandoDirecto(cmp->left, izq) && operandoDirecto(cmp->right, der);
+    bool apilada = false;
+    if (!comparacion) {
+        cond->accept(this);
+        apilada = !directoT || !directoF;
+        if (apilada) codigo.ins(Op::PUSHQ, opReg(RAX));
+    }
+    if (!directoT) {
+        t->accept(this);
+        codigo.ins(Op::PUSHQ, opReg(RAX));
+    }
+    if (!directoF) {
+        f->accept(this);
+        codigo.ins(Op::PUSHQ, opReg(RAX));
+    }
+
+    Op mover = Op::CMOVE; // Elige f si la condición es falsa
+    if (comparacion) {
+        if (izq.tipo != Operando::REG) {
+            codigo.ins(Op::MOVQ, izq, opReg(RCX));
+            izq = opReg(RCX);
+        }
+        codigo.ins(Op::CMPQ, der, izq);
+        mover = cmp->op == LT_OP ? Op::CMOVGE : cmp->op == LE_OP ? Op::CMOVG : cmp->op == GT_OP ? Op::CMOVLE :
+                cmp->op == GE_OP ? Op::CMOVL : cmp->op == EQ_OP ? Op::CMOVNE : Op::CMOVE;
+    }
+    // pop y mov no tocan las banderas
+    if (!directoF) {
+        codigo.ins(Op::POPQ, opReg(RDX));
+        opF = opReg(RDX);
+    }
+    if (!directoT) codigo.ins(Op::POPQ, opReg(RAX));
+    if (apilada) {
+        codigo.ins(Op::POPQ, opReg(RCX));
+        codigo.ins(Op::CMPQ, opImm(0), opReg(RCX));
+    } else if (!comparacion) {
+        codigo.ins(Op::CMPQ, opImm(0), opReg(RAX));
+    }
+    if (opF.tipo == Operando::IMM) {
+        codigo.ins(Op::MOVQ, opF, opReg(RDX));
+        opF = opReg(RDX);
+    }
+    if (directoT) codigo.ins(Op::MOVQ, opT, opReg(RAX));
+    codigo.ins(mover, opF, opReg(RAX));
+}
+
 // -------------------- IF TERNARIO OPTIMIZADO --------------------
 int GenCodeVisitor::visit(TernaryExp* exp) {
+    if (exp->cont == 1) {
+        codigo.ins(Op::MOVQ, opImm(exp->valor), opReg(RAX));
+        return 0;
+    }
     // Optimización: Si la condición es constante, solo generamos la rama necesaria
     if (exp->condition->cont == 1) {
         if (exp->condition->valor != 0) exp->trueExp->accept(this);
         else exp->falseExp->accept(this);
         return 0;
     }
+    // Ramas baratas y sin efectos: cmovcc en lugar de saltos
+    if (convertible(exp->trueExp, exp->falseExp)) {
+        seleccionar(exp->condition, exp->trueExp, exp->falseExp);
+        return 0;
+    }
     int id = count_ternary++;
-    string labelFalse = "ternary_" + to_string(id) + "_false";
-    string labelEnd = "ternary_" + to_string(id) + "_end";
+    int labelFalse = codigo.etiqueta("ternary_" + to_string(id) + "_false");
+    int labelEnd = codigo.etiqueta("ternary_" + to_string(id) + "_end");
     // 1. Evaluar condición (BinaryExp pone 0 o 1 en %rax)
     exp->condition->accept(this);
-    out << "    cmpq $0, %rax" << endl;
-    out << "    je " << labelFalse << endl; // Si es 0 (Falso), salta
+    codigo.ins(Op::CMPQ, opImm(0), opReg(RAX));
+    codigo.ins(Op::JE, opEtiqueta(labelFalse)); // Si es 0 (Falso), salta
+    unordered_set<int> listos = cseListos; // Cada rama solo ve lo calculado antes del ternario
     // 2. Caso Verdadero
     exp->trueExp->accept(this);
-    out << "    jmp " << labelEnd << endl;
+    codigo.ins(Op::JMP, opEtiqueta(labelEnd));
+    cseListos = listos;
     // 3. Caso Falso
-    out << labelFalse << ":" << endl;
+    codigo.definir(labelFalse);
     exp->falseExp->accept(this);
+    cseListos = listos;
     // 4. Fin
-    out << labelEnd << ":" << endl;
+    codigo.definir(labelEnd);
     return 0;
 }
 
 int GenCodeVisitor::visit(FunDec* fd) {
     nombreFuncion = fd->id;
+    funcionActual = fd;
+    colaPropias = 0;
+    colaHermanas = 0;
+    selecciones = 0;
     memoria.clear();
     varTypes.clear();
     offset = 0; 
 
-    out << fd->id << ":" << endl;
-    out << "    pushq %rbp" << endl;
-    out << "    movq %rsp, %rbp" << endl;
+    if (usarRegistros) {
+        unordered_set<string> tiposStruct;
+        for (auto& s : structSizes) tiposStruct.insert(s.first);
+        asignador.asignar(fd, tiposStruct);
+        if (reporteRegistros) asignador.reporte(fd->id, *reporteRegistros);
+    }
+
+    codigo.definir(codigo.etiqueta(fd->id));
+    codigo.ins(Op::PUSHQ, opReg(RBP));
+    codigo.ins(Op::MOVQ, opReg(RSP), opReg(RBP));
+
+    // Marco: parámetros, locales (incluye bloques anidados e init de for:
+    // todos tienen slot propio) y los callee-saved que use el linear scan
+    int espacioParams = 0;
+    for (ParamDec* p : fd->params) espacioParams += structSizes.count(p->type) ? structSizes[p->type] : 8;
+    int espacioLocales = fd->body ? espacioDeclarado(fd->body) : 0;
+    vector<int> guardados;
+    if (usarRegistros) guardados = asignador.usados();
+    baseGuardados = -8 - espacioParams - espacioLocales;
+    baseCse = baseGuardados - 8 * (int)guardados.size();
+    int temporalesCse = numeracion ? numeracion->temporales(fd) : 0;
+    baseLicm = baseCse - 8 * temporalesCse;
+    int temporalesLicm = licm ? licm->temporales(fd) : 0;
+    baseIv = baseLicm - 8 * temporalesLicm;
+    cseListos.clear();
+    int totalStack = (8 + espacioParams + espacioLocales + 8 * (int)guardados.size() +
+                      8 * temporalesCse + 8 * temporalesLicm + 8 * (iv ? iv->temporales(fd) : 0) + 15) & ~15;
+    // Con registros asignados se guardan antes de que los parámetros los ocupen
+    if (!guardados.empty() || llamadasCola) {
+        codigo.ins(Op::SUBQ, opImm(totalStack), opReg(RSP));
+        for (size_t k = 0; k < guardados.size(); ++k)
+            codigo.ins(Op::MOVQ, opReg(guardados[k]), opMem(RBP, baseGuardados - 8 * (long)k));
+    }
+    guardadosActual = guardados;
+    // Destino de las llamadas en cola a sí misma: los argumentos llegan en
+    // registros como en una llamada y se vuelven a copiar a los parámetros
+    if (llamadasCola) codigo.definir(codigo.etiqueta(".cola_" + nombreFuncion));
 
-    vector<string> regs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+    vector<Reg> regs = {RDI, RSI, RDX, RCX, R8, R9};
     
     offset = -8;
     for (size_t i = 0; i < fd->params.size(); ++i) {
@@ -823,7 +1765,7 @@ int GenCodeVisitor::visit(FunDec* fd) {
                 int structSize = structSizes[pType];
                 cerr << "DEBUG FunDec: param " << pName << " is STRUCT " << pType << " size=" << structSize << endl;
                 // regs[i] contiene la dirección del struct
-                out << "    movq " << regs[i] << ", %rax" << endl;  // Dirección en %rax
+                codigo.ins(Op::MOVQ, opReg(regs[i]), opReg(RAX));  // Dirección en %rax
                 
                 // Copiar cada campo en orden de offset: 0, 8, 16, ...
                 vector<pair<int, string>> orderedFields;
@@ -838,42 +1780,55 @@ int GenCodeVisitor::visit(FunDec* fd) {
                     string fieldName = p.second;
                     // Convertir a offset negativo para stack que crece hacia abajo
                     int negOffset = -fieldStructOffset;
-                    out << "    movq " << negOffset << "(%rax), %rcx" << endl;
-                    out << "    movq %rcx, " << fieldStackOffset << "(%rbp)" << endl;
+                    codigo.ins(Op::MOVQ, opMem(RAX, negOffset), opReg(RCX));
+                    codigo.ins(Op::MOVQ, opReg(RCX), opMem(RBP, fieldStackOffset));
                     fieldStackOffset -= 8;
                 }
             } else {
-                out << "    movq " << regs[i] << ", " << offset << "(%rbp)" << endl;
+                codigo.ins(Op::MOVQ, opReg(regs[i]), ubicacion(pName));
             }
         }
         offset -= paramSize;  // Reducir por el tamaño del parámetro, no siempre 8
     }
 
-    // Calcular locales
-    int espacioLocales = 0;
-    if (fd->body) {
-        for (VarDec* vd : fd->body->declarations) {
-            int size = 8;
-            if (structSizes.count(vd->type)) size = structSizes[vd->type];
-            espacioLocales += vd->vars.size() * size;
-        }
-        for (InstanceDec* ind : fd->body->intances) {
-            int size = 8;
-            if (structSizes.count(ind->type)) size = structSizes[ind->type];
-            espacioLocales += ind->vars.size() * size;
-        }
-    }
-    int totalStack = ((-offset) + espacioLocales + 15) & ~15; 
-    out << "    subq $" << totalStack << ", %rsp" << endl;
+    if (guardados.empty() && !llamadasCola) codigo.ins(Op::SUBQ, opImm(totalStack), opReg(RSP));
 
     fd->body->accept(this);
-
-    out << ".end_" << nombreFuncion << ":" << endl;
-    out << "    leave" << endl;
-    out << "    ret" << endl;
+    if (reporteCola) {
+        *reporteCola << "TCO " << fd->id << ": " << colaPropias << " llamadas en cola a sí misma, " << colaHermanas
+                     << " a otras funciones" << endl;
+    }
+    if (reporteSeleccion) *reporteSeleccion << "CMOV " << fd->id << ": " << selecciones << " selecciones sin saltos" << endl;
+
+    // Sin return explícito el intérprete devuelve 0
+    if (enteros32) codigo.ins(Op::MOVQ, opImm(0), opReg(RAX));
+    codigo.definir(codigo.etiqueta(".end_" + nombreFuncion));
+    for (size_t k = 0; k < guardados.size(); ++k)
+        codigo.ins(Op::MOVQ, opMem(RBP, baseGuardados - 8 * (long)k), opReg(guardados[k]));
+    codigo.ins(Op::LEAVE);
+    codigo.ins(Op::RET);
     return 0;
 }
 
+int GenCodeVisitor::espacioDeclarado(Body* body) {
+    int total = 0;
+    auto tam = [&](const string& type) { return structSizes.count(type) ? structSizes[type] : 8; };
+    for (VarDec* vd : body->declarations) total += vd->vars.size() * tam(vd->type);
+    for (InstanceDec* ind : body->intances) total += ind->vars.size() * tam(ind->type);
+    for (Stm* stm : body->stmList) {
+        if (IfStm* i = dynamic_cast<IfStm*>(stm)) {
+            total += espacioDeclarado(i->thenBody);
+            if (i->elseBody) total += espacioDeclarado(i->elseBody);
+        } else if (WhileStm* w = dynamic_cast<WhileStm*>(stm)) {
+            total += espacioDeclarado(w->body);
+        } else if (ForStm* f = dynamic_cast<ForStm*>(stm)) {
+            if (InstanceDec* ind = dynamic_cast<InstanceDec*>(f->init)) total += ind->vars.size() * tam(ind->type);
+            total += espacioDeclarado(f->body);
+        }
+    }
+    return total;
+}
+
 int GenCodeVisitor::visit(Body* body) {
     for (VarDec* vd : body->declarations) vd->accept(this);
     for (InstanceDec* ind : body->intances) ind->accept(this);
@@ -891,7 +1846,8 @@ int GenCodeVisitor::visit(VarDec* vd) {
         
         // Inicializar memoria a 0 (limpieza)
         for(int k=0; k<typeSize; k+=8) {
-            out << "    movq $0, " << (offset - k) << "(%rbp)" << endl; 
+            if (structSizes.count(vd->type)) codigo.ins(Op::MOVQ, opImm(0), opMem(RBP, offset - k));
+            else codigo.ins(Op::MOVQ, opImm(0), ubicacion(var));
         }
         
         // Reservar espacio en el stack map
@@ -923,20 +1879,20 @@ int GenCodeVisitor::visit(InstanceDec* ind) {
                     for (int j = 0; j < call->arguments.size(); j++) {
                         Exp* arg = call->arguments[j];
                         arg->accept(this);
-                        out << "    pushq %rax" << endl;
+                        codigo.ins(Op::PUSHQ, opReg(RAX));
                     }
                     
-                    vector<string> regs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+                    vector<Reg> regs = {RDI, RSI, RDX, RCX, R8, R9};
                     for (int i = call->arguments.size() - 1; i >= 0; --i) {
                         if (i < 6) {
-                            out << "    popq " << regs[i] << endl;
+                            codigo.ins(Op::POPQ, opReg(regs[i]));
                         }
                     }
-                    out << "    movl $0, %eax" << endl;
-                    out << "    call " << call->name << endl;
+                    codigo.ins(Op::MOVL, opImm(0), opReg(RAX, 32));
+                    codigo.ins(Op::CALL, opEtiqueta(codigo.etiqueta(call->name)));
                     
                     // Recibir struct retornado en %rax + %rdx (+ más registros si necesario)
-                    vector<string> retRegs = {"%rax", "%rdx", "%rcx", "%rsi", "%r8", "%r9"};
+                    vector<Reg> retRegs = {RAX, RDX, RCX, RSI, R8, R9};
                     int regIdx = 0;
                     int fieldStackOffset = offset;
                     
@@ -948,7 +1904,7 @@ int GenCodeVisitor::visit(InstanceDec* ind) {
                     
                     for (auto& p : orderedFields) {
                         if (regIdx < retRegs.size()) {
-                            out << "    movq " << retRegs[regIdx] << ", " << fieldStackOffset << "(%rbp)" << endl;
+                            codigo.ins(Op::MOVQ, opReg(retRegs[regIdx]), opMem(RBP, fieldStackOffset));
                             regIdx++;
                         }
                         fieldStackOffset -= 8;
@@ -956,7 +1912,7 @@ int GenCodeVisitor::visit(InstanceDec* ind) {
                 } else {
                     // Expresión normal que retorna struct (menos común)
                     init->e->accept(this);
-                    out << "    movq %rax, " << offset << "(%rbp)" << endl;
+                    codigo.ins(Op::MOVQ, opReg(RAX), opMem(RBP, offset));
                 }
             } else if (init->st) {
                 // Caso: Punto p = {1, 2};
@@ -964,7 +1920,7 @@ int GenCodeVisitor::visit(InstanceDec* ind) {
                 for (Exp* arg : init->st->argumentos) {
                     arg->accept(this);
                     int dest = offset + (fieldIdx * -8);
-                    out << "    movq %rax, " << dest << "(%rbp)" << endl;
+                    codigo.ins(Op::MOVQ, opReg(RAX), opMem(RBP, dest));
                     fieldIdx++;
                 }
             }
@@ -972,7 +1928,10 @@ int GenCodeVisitor::visit(InstanceDec* ind) {
             // --- INICIALIZACIÓN BÁSICA (int, uint, float) ---
             if (init->e) {
                 init->e->accept(this); // Evalúa expresión -> %rax
-                out << "    movq %rax, " << offset << "(%rbp)" << endl;
+                codigo.ins(Op::MOVQ, opReg(RAX), ubicacion(var));
+            } else if (ubicacion(var).tipo == Operando::REG) {
+                // Sin inicializar: el registro podría traer el valor de otra variable
+                codigo.ins(Op::MOVQ, opImm(0), ubicacion(var));
             }
         }
         
@@ -983,6 +1942,15 @@ int GenCodeVisitor::visit(InstanceDec* ind) {
 }
 
 int GenCodeVisitor::visit(IdExp* exp) {
+    // Constante propagada (--sccp): inmediato en lugar de la carga
+    if (exp->cont == 1) {
+        codigo.ins(Op::MOVQ, opImm(exp->valor), opReg(RAX));
+        return 0;
+    }
+    if (temporalLicm(exp) >= 0) {
+        codigo.ins(Op::MOVQ, slotLicm(exp), opReg(RAX));
+        return 0;
+    }
     string name = exp->value;
     size_t dotPos = name.find('.');
     
@@ -994,7 +1962,7 @@ int GenCodeVisitor::visit(IdExp* exp) {
         int relative = structLayouts[type][fieldName]; 
         int finalOffset = baseOffset - relative;
         cerr << "DEBUG IdExp: " << varName << "." << fieldName << " -> offset: " << finalOffset << endl;
-        out << "    movq " << finalOffset << "(%rbp), %rax" << endl;
+        codigo.ins(Op::MOVQ, opMem(RBP, finalOffset), opReg(RAX));
     } else {
         int off = getMemory(name);
         string type = varTypes[name];
@@ -1003,7 +1971,7 @@ int GenCodeVisitor::visit(IdExp* exp) {
             cerr << " (STRUCT size=" << structSizes[type] << ")";
         }
         cerr << endl;
-        out << "    movq " << off << "(%rbp), %rax" << endl;
+        codigo.ins(Op::MOVQ, ubicacion(name), opReg(RAX));
     }
     return 0;
 }
@@ -1022,7 +1990,7 @@ int GenCodeVisitor::visit(AssignStm* stm) {
         string type = varTypes[varName];
         int relative = structLayouts[type][fieldName]; 
         int finalOffset = baseOffset - relative;
-        out << "    movq %rax, " << finalOffset << "(%rbp)" << endl;
+        codigo.ins(Op::MOVQ, opReg(RAX), opMem(RBP, finalOffset));
     } else {
         // Asignación a variable completa
         string type = varTypes[name];
@@ -1039,45 +2007,309 @@ int GenCodeVisitor::visit(AssignStm* stm) {
             }
             sort(orderedFields.begin(), orderedFields.end());
             
-            vector<string> retRegs = {"%rax", "%rdx", "%rcx", "%rsi", "%r8", "%r9"};
+            vector<Reg> retRegs = {RAX, RDX, RCX, RSI, R8, R9};
             int regIdx = 0;
             int fieldStackOffset = baseOffset;
             for (auto& p : orderedFields) {
                 if (regIdx < retRegs.size()) {
-                    out << "    movq " << retRegs[regIdx] << ", " << fieldStackOffset << "(%rbp)" << endl;
+                    codigo.ins(Op::MOVQ, opReg(retRegs[regIdx]), opMem(RBP, fieldStackOffset));
                     regIdx++;
                 }
                 fieldStackOffset -= 8;
             }
         } else {
             // Valor simple
-            int off = getMemory(name);
-            out << "    movq %rax, " << off << "(%rbp)" << endl;
+            getMemory(name);
+            codigo.ins(Op::MOVQ, opReg(RAX), ubicacion(name));
         }
     }
     return 0;
 }int GenCodeVisitor::visit(NumberExp* exp) {
-    out << "    movq $" << exp->value << ", %rax" << endl;
+    codigo.ins(Op::MOVQ, opImm(exp->value), opReg(RAX));
     return 0;
 }
 
 int GenCodeVisitor::visit(FloatExp* exp) {
     // Para floats de 64 bits (double), cargamos la representación como entero de 64 bits
     // usando la representación binaria del double
-    unsigned long long bits = *(unsigned long long*)(&exp->value);
-    out << "    movabsq $0x" << hex << bits << dec << ", %rax" << endl;
+    unsigned long long bits;
+    memcpy(&bits, &exp->value, sizeof bits);
+    codigo.ins(Op::MOVABSQ, opImm((long)bits), opReg(RAX));
     return 0;
 }
 
 int GenCodeVisitor::visit(BoolExp* exp) {
-    out << "    movq $" << (exp->value ? 1 : 0) << ", %rax" << endl;
+    codigo.ins(Op::MOVQ, opImm(exp->value ? 1 : 0), opReg(RAX));
     return 0;
 }
 
+// ----- OPTIMIZACION: Sethi-Ullman con registros -----
+// Temporales: ni %rax ni %rdx (idivq los usa) ni callee-saved
+static const vector<int> REGISTROS_TEMPORALES = {RCX, RSI, RDI, R8, R9, R10, R11};
+
+int GenCodeVisitor::offsetDe(const string& name) {
+    size_t dotPos = name.find('.');
+    if (dotPos == string::npos) return getMemory(name);
+    string varName = name.substr(0, dotPos);
+    return getMemory(varName) - structLayouts[varTypes[varName]][name.substr(dotPos + 1)];
+}
+
+Operando GenCodeVisitor::ubicacion(const string& name) {
+    if (usarRegistros) {
+        int r = asignador.registro(name);
+        if (r >= 0) return opReg(r);
+    }
+    return opMem(RBP, offsetDe(name));
+}
+
+bool GenCodeVisitor::arbolSimple(Exp* e) {
+    if (e->cont == 1 || temporalLicm(e) >= 0 || temporalIv(e) >= 0) return true;
+    if (dynamic_cast<NumberExp*>(e) || dynamic_cast<BoolExp*>(e) || dynamic_cast<FloatExp*>(e)) return true;
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) return !structSizes.count(varTypes[id->value]);
+    if (BinaryExp* b = dynamic_cast<BinaryExp*>(e)) {
+        switch (b->op) {
+            case PLUS_OP: case MINUS_OP: case MUL_OP: case DIV_OP:
+            case GT_OP: case LT_OP: case GE_OP: case LE_OP: case EQ_OP: case NE_OP:
+                return arbolSimple(b->left) && arbolSimple(b->right);
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+// Registros que necesita e según su etiqueta et; la división necesita
+// siempre dos (el divisor no puede ser inmediato)
+int GenCodeVisitor::necesita(Exp* e, bool derecho) {
+    if (e->hoja == 1 || e->cont == 1 || temporalLicm(e) >= 0 || temporalIv(e) >= 0 || cseListo(e)) return derecho ? 0 : 1;
+    BinaryExp* b = dynamic_cast<BinaryExp*>(e);
+    int n = e->et;
+    if (b && b->op == DIV_OP) n = max(n, 2);
+    return n;
+}
+
+// Hoja usable como operando fuente: $k (32 bits) o slot de memoria
+bool GenCodeVisitor::operandoDirecto(Exp* e, Operando& op) {
+    if (e->cont == 1 && !dynamic_cast<FloatExp*>(e)) {
+        op = opImm(e->valor);
+        return true;
+    }
+    if (temporalLicm(e) >= 0) {
+        op = slotLicm(e);
+        return true;
+    }
+    if (temporalIv(e) >= 0) {
+        op = slotIv(temporalIv(e));
+        return true;
+    }
+    if (cseListo(e)) {
+        op = slotCse(e);
+        return true;
+    }
+    if (IdExp* id = dynamic_cast<IdExp*>(e)) {
+        op = ubicacion(id->value);
+        return true;
+    }
+    return false;
+}
+
+void GenCodeVisitor::cargarHoja(Exp* e, int r) {
+    if (FloatExp* f = dynamic_cast<FloatExp*>(e)) {
+        unsigned long long bits;
+        memcpy(&bits, &f->value, sizeof bits);
+        codigo.ins(Op::MOVABSQ, opImm((long)bits), opReg(r));
+        return;
+    }
+    Operando op;
+    operandoDirecto(e, op);
+    codigo.ins(Op::MOVQ, op, opReg(r));
+}
+
+int GenCodeVisitor::temporalCse(Exp* e) const {
+    return numeracion ? numeracion->temporal(e) : -1;
+}
+
+bool GenCodeVisitor::cseListo(Exp* e) const {
+    int k = temporalCse(e);
+    return k >= 0 && cseListos.count(k);
+}
+
+Operando GenCodeVisitor::slotCse(Exp* e) const {
+    return opMem(RBP, baseCse - 8 * temporalCse(e));
+}
+
+int GenCodeVisitor::temporalLicm(Exp* e) const {
+    return licm && e != preheader ? licm->temporal(e) : -1;
+}
+
+Operando GenCodeVisitor::slotLicm(Exp* e) const {
+    return opMem(RBP, baseLicm - 8 * licm->temporal(e));
+}
+
+// Preheader: cada invariante se calcula con su propio código (sin leer su
+// temporal) y queda en su temporal
+void GenCodeVisitor::calcularInvariantes(Stm* bucle) {
+    if (!licm) return;
+    for (Exp* e : licm->invariantes(bucle)) {
+        preheader = e;
+        e->accept(this);
+        preheader = nullptr;
+        codigo.ins(Op::MOVQ, opReg(RAX), slotLicm(e));
+    }
+}
+
+int GenCodeVisitor::temporalIv(Exp* e) const {
+    return iv ? iv->temporal(e) : -1;
+}
+
+const ContadorEliminado* GenCodeVisitor::contadorEliminado(ForStm* stm) const {
+    return iv ? iv->contador(stm) : nullptr;
+}
+
+Operando GenCodeVisitor::slotIv(int temporal) const {
+    return opMem(RBP, baseIv - 8 * temporal);
+}
+
+Operando GenCodeVisitor::factorIv(const InduccionDerivada& d) {
+    if (NumberExp* n = dynamic_cast<NumberExp*>(d.factor)) return opImm(n->value);
+    if (d.factor->cont == 1) return opImm(d.factor->valor);
+    return ubicacion(static_cast<IdExp*>(d.factor)->value);
+}
+
+// Preheader: temporal = base * factor
+void GenCodeVisitor::iniciarInducciones(Stm* bucle) {
+    if (!iv) return;
+    for (const InduccionDerivada& d : iv->inducciones(bucle)) {
+        codigo.ins(Op::MOVQ, ubicacion(d.base), opReg(RAX));
+        codigo.ins(Op::IMULQ, factorIv(d), opReg(RAX));
+        if (enteros32) codigo.ins(Op::MOVSLQ, opReg(RAX, 32), opReg(RAX));
+        codigo.ins(Op::MOVQ, opReg(RAX), slotIv(d.temporal));
+    }
+}
+
+// Donde avanza la base: temporal += factor * paso (suma en lugar de imulq)
+void GenCodeVisitor::avanzarInducciones(Stm* bucle) {
+    if (!iv) return;
+    for (const InduccionDerivada& d : iv->inducciones(bucle)) {
+        Operando factor = factorIv(d);
+        codigo.ins(Op::MOVQ, slotIv(d.temporal), opReg(RAX));
+        if (factor.tipo == Operando::IMM) codigo.ins(Op::ADDQ, opImm(factor.imm * d.paso), opReg(RAX));
+        else codigo.ins(d.paso > 0 ? Op::ADDQ : Op::SUBQ, factor, opReg(RAX));
+        if (enteros32) codigo.ins(Op::MOVSLQ, opReg(RAX, 32), opReg(RAX));
+        codigo.ins(Op::MOVQ, opReg(RAX), slotIv(d.temporal));
+    }
+}
+
+// Subárbol con clase de valor: se carga si ya está calculado; si no, se
+// calcula y se guarda en su temporal
+void GenCodeVisitor::generarSubarbol(Exp* e, const vector<int>& regs) {
+    if (cseListo(e)) {
+        codigo.ins(Op::MOVQ, slotCse(e), opReg(regs[0]));
+        return;
+    }
+    generarArbol(e, regs);
+    int k = temporalCse(e);
+    if (k >= 0) {
+        codigo.ins(Op::MOVQ, opReg(regs[0]), slotCse(e));
+        cseListos.insert(k);
+    }
+}
+
+void GenCodeVisitor::generarArbol(Exp* e, const vector<int>& regs) {
+    BinaryExp* b = dynamic_cast<BinaryExp*>(e);
+    if (!b || e->cont == 1 || temporalLicm(e) >= 0 || temporalIv(e) >= 0) {
+        cargarHoja(e, regs[0]);
+        return;
+    }
+    int l = necesita(b->left, false);
+    int r = necesita(b->right, true);
+    int n = (int)regs.size();
+    Operando fuente;
+
+    if (r == 0 && b->op != DIV_OP && operandoDirecto(b->right, fuente)) {
+        // Hoja derecha como operando directo
+        generarSubarbol(b->left, regs);
+    } else if (l >= r && r < n) {
+        // Izquierdo más pesado: primero él, el derecho en los registros restantes
+        generarSubarbol(b->left, regs);
+        generarSubarbol(b->right, vector<int>(regs.begin() + 1, regs.end()));
+        fuente = opReg(regs[1]);
+    } else if (r > l && l < n) {
+        // Derecho más pesado: primero él (en regs[1]), luego el izquierdo sin tocar regs[1]
+        vector<int> regsDer = regs;
+        swap(regsDer[0], regsDer[1]);
+        generarSubarbol(b->right, regsDer);
+        vector<int> regsIzq = {regs[0]};
+        regsIzq.insert(regsIzq.end(), regs.begin() + 2, regs.end());
+        generarSubarbol(b->left, regsIzq);
+        fuente = opReg(regs[1]);
+    } else {
+        // Ambos exceden los registros: spill del derecho a la pila
+        generarSubarbol(b->right, regs);
+        codigo.ins(Op::PUSHQ, opReg(regs[0]));
+        generarSubarbol(b->left, regs);
+        codigo.ins(Op::POPQ, opReg(regs[1]));
+        fuente = opReg(regs[1]);
+    }
+
+    Operando dest = opReg(regs[0]);
+    switch (b->op) {
+        case PLUS_OP:  codigo.ins(Op::ADDQ, fuente, dest); break;
+        case MINUS_OP: codigo.ins(Op::SUBQ, fuente, dest); break;
+        case MUL_OP:   codigo.ins(Op::IMULQ, fuente, dest); break;
+        case DIV_OP:
+            codigo.ins(Op::MOVQ, dest, opReg(RAX));
+            codigo.ins(Op::CQO);
+            codigo.ins(Op::IDIVQ, fuente);
+            codigo.ins(Op::MOVQ, opReg(RAX), dest);
+            break;
+        default: {
+            Op set = b->op == EQ_OP ? Op::SETE : b->op == NE_OP ? Op::SETNE :
+                     b->op == GT_OP ? Op::SETG : b->op == LT_OP ? Op::SETL :
+                     b->op == GE_OP ? Op::SETGE : Op::SETLE;
+            codigo.ins(Op::CMPQ, fuente, dest);
+            codigo.ins(set, opReg(regs[0], 8));
+            codigo.ins(Op::MOVZBQ, opReg(regs[0], 8), dest);
+            break;
+        }
+    }
+    // Desborde de int como en el intérprete: extender el signo de los 32 bits bajos
+    if (enteros32 && (b->op == PLUS_OP || b->op == MINUS_OP || b->op == MUL_OP)) {
+        codigo.ins(Op::MOVSLQ, opReg(regs[0], 32), dest);
+    }
+}
+
 int GenCodeVisitor::visit(BinaryExp* exp) {
     // OPTIMIZACIÓN: Si la expresión es una constante (constant folding), usar directamente el valor
     if (exp->cont == 1) {
-        out << "    movq $" << exp->valor << ", %rax" << endl;
+        codigo.ins(Op::MOVQ, opImm(exp->valor), opReg(RAX));
+        return 0;
+    }
+    if (temporalLicm(exp) >= 0) {
+        codigo.ins(Op::MOVQ, slotLicm(exp), opReg(RAX));
+        return 0;
+    }
+    if (temporalIv(exp) >= 0) {
+        codigo.ins(Op::MOVQ, slotIv(temporalIv(exp)), opReg(RAX));
+        return 0;
+    }
+    int k = temporalCse(exp);
+    if (k < 0) return generarBinaria(exp);
+    if (cseListos.count(k)) {
+        codigo.ins(Op::MOVQ, slotCse(exp), opReg(RAX));
+        return 0;
+    }
+    generarBinaria(exp);
+    codigo.ins(Op::MOVQ, opReg(RAX), slotCse(exp));
+    cseListos.insert(k);
+    return 0;
+}
+
+int GenCodeVisitor::generarBinaria(BinaryExp* exp) {
+    // Sethi-Ullman con registros: sin memoria intermedia ni pushq/popq
+    if (arbolSimple(exp)) {
+        generarArbol(exp, REGISTROS_TEMPORALES);
+        codigo.ins(Op::MOVQ, opReg(REGISTROS_TEMPORALES[0]), opReg(RAX));
         return 0;
     }
     // MANTENEMOS LA LÓGICA DE SETHI-ULLMAN (Decidir orden basado en 'et')
@@ -1085,37 +2317,37 @@ int GenCodeVisitor::visit(BinaryExp* exp) {
     if (exp->right->et == 0) {
         // Orden: Izquierda -> Derecha
         exp->left->accept(this);
-        out << "    pushq %rax" << endl; 
+        codigo.ins(Op::PUSHQ, opReg(RAX)); 
         exp->right->accept(this);
-        out << "    movq %rax, %rcx" << endl;
-        out << "    popq %rax" << endl;
+        codigo.ins(Op::MOVQ, opReg(RAX), opReg(RCX));
+        codigo.ins(Op::POPQ, opReg(RAX));
     }
     // CASO 2: El hijo izquierdo es más pesado o igual.
     else if (exp->left->et >= exp->right->et) {
         exp->left->accept(this);
-        out << "    pushq %rax" << endl;
+        codigo.ins(Op::PUSHQ, opReg(RAX));
         exp->right->accept(this);
-        out << "    movq %rax, %rcx" << endl;
-        out << "    popq %rax" << endl;
+        codigo.ins(Op::MOVQ, opReg(RAX), opReg(RCX));
+        codigo.ins(Op::POPQ, opReg(RAX));
     }
     // CASO 3: El hijo derecho es más pesado (Optimización real de S-U).
     else {
         exp->right->accept(this);       
-        out << "    pushq %rax" << endl;
+        codigo.ins(Op::PUSHQ, opReg(RAX));
         exp->left->accept(this);
-        out << "    popq %rcx" << endl;
+        codigo.ins(Op::POPQ, opReg(RCX));
     }
 
     // OPERACIONES
     switch (exp->op) {
-        case PLUS_OP: out << "    addq %rcx, %rax" << endl; break;
-        case MUL_OP:  out << "    imulq %rcx, %rax" << endl; break;
+        case PLUS_OP: codigo.ins(Op::ADDQ, opReg(RCX), opReg(RAX)); break;
+        case MUL_OP:  codigo.ins(Op::IMULQ, opReg(RCX), opReg(RAX)); break;
         case MINUS_OP: 
-            out << "    subq %rcx, %rax" << endl; 
+            codigo.ins(Op::SUBQ, opReg(RCX), opReg(RAX)); 
             break;
         case DIV_OP: 
-            out << "    cqo" << endl;
-            out << "    idivq %rcx" << endl;
+            codigo.ins(Op::CQO);
+            codigo.ins(Op::IDIVQ, opReg(RCX));
             break;
             
         // Comparaciones
@@ -1125,23 +2357,102 @@ int GenCodeVisitor::visit(BinaryExp* exp) {
         case LT_OP:
         case GE_OP:
         case LE_OP:
-            out << "    cmpq %rcx, %rax" << endl;
-            if (exp->op == EQ_OP) out << "    sete %al" << endl;
-            if (exp->op == NE_OP) out << "    setne %al" << endl;
-            if (exp->op == GT_OP) out << "    setg %al" << endl;
-            if (exp->op == LT_OP) out << "    setl %al" << endl;
-            if (exp->op == GE_OP) out << "    setge %al" << endl;
-            if (exp->op == LE_OP) out << "    setle %al" << endl;
+            codigo.ins(Op::CMPQ, opReg(RCX), opReg(RAX));
+            if (exp->op == EQ_OP) codigo.ins(Op::SETE, opReg(RAX, 8));
+            if (exp->op == NE_OP) codigo.ins(Op::SETNE, opReg(RAX, 8));
+            if (exp->op == GT_OP) codigo.ins(Op::SETG, opReg(RAX, 8));
+            if (exp->op == LT_OP) codigo.ins(Op::SETL, opReg(RAX, 8));
+            if (exp->op == GE_OP) codigo.ins(Op::SETGE, opReg(RAX, 8));
+            if (exp->op == LE_OP) codigo.ins(Op::SETLE, opReg(RAX, 8));
             
-            out << "    movzbq %al, %rax" << endl;
+            codigo.ins(Op::MOVZBQ, opReg(RAX, 8), opReg(RAX));
             break;
             
         default: break;
     }
+    // Desborde de int como en el intérprete: extender el signo de los 32 bits bajos
+    if (enteros32 && (exp->op == PLUS_OP || exp->op == MINUS_OP || exp->op == MUL_OP)) {
+        codigo.ins(Op::MOVSLQ, opReg(RAX, 32), opReg(RAX));
+    }
     return 0;
 }
 
+// Llamada en cola posible: función del programa con argumentos escalares
+// que caben en registros, sin structs en los retornos
+bool GenCodeVisitor::enCola(FcallExp* call) {
+    if (!llamadasCola || call->cont == 1 || structSizes.count(funcionActual->type)) return false;
+    auto it = funciones.find(call->name);
+    if (it == funciones.end()) return false;
+    FunDec* g = it->second;
+    if (g->params.size() != call->arguments.size() || g->params.size() > 6 || structSizes.count(g->type)) return false;
+    for (ParamDec* p : g->params) if (structSizes.count(p->type)) return false;
+    return true;
+}
+
+// e (o alguna rama de un ternario) termina en una llamada en cola
+bool GenCodeVisitor::hayCola(Exp* e) {
+    if (FcallExp* call = dynamic_cast<FcallExp*>(e)) return enCola(call);
+    TernaryExp* t = dynamic_cast<TernaryExp*>(e);
+    return t && t->cont != 1 && (hayCola(t->trueExp) || hayCola(t->falseExp));
+}
+
+void GenCodeVisitor::retornar(Exp* e) {
+    FcallExp* call = dynamic_cast<FcallExp*>(e);
+    if (call && enCola(call)) {
+        llamadaCola(call);
+        return;
+    }
+    TernaryExp* t = dynamic_cast<TernaryExp*>(e);
+    if (!t || !hayCola(t)) {
+        e->accept(this);
+        codigo.ins(Op::JMP, opEtiqueta(codigo.etiqueta(".end_" + nombreFuncion)));
+        return;
+    }
+    // Cada rama retorna por su cuenta
+    if (t->condition->cont == 1) {
+        retornar(t->condition->valor != 0 ? t->trueExp : t->falseExp);
+        return;
+    }
+    int id = count_ternary++;
+    int labelFalse = codigo.etiqueta("ternary_" + to_string(id) + "_false");
+    t->condition->accept(this);
+    codigo.ins(Op::CMPQ, opImm(0), opReg(RAX));
+    codigo.ins(Op::JE, opEtiqueta(labelFalse));
+    unordered_set<int> listos = cseListos;
+    retornar(t->trueExp);
+    cseListos = listos;
+    codigo.definir(labelFalse);
+    retornar(t->falseExp);
+    cseListos = listos;
+}
+
+void GenCodeVisitor::llamadaCola(FcallExp* call) {
+    FunDec* g = funciones[call->name];
+    for (Exp* arg : call->arguments) {
+        arg->accept(this);
+        codigo.ins(Op::PUSHQ, opReg(RAX));
+    }
+    vector<Reg> regs = {RDI, RSI, RDX, RCX, R8, R9};
+    for (int i = (int)g->params.size() - 1; i >= 0; --i) codigo.ins(Op::POPQ, opReg(regs[i]));
+    if (g == funcionActual) {
+        // Mismo marco: se repite la copia de parámetros y el cuerpo
+        codigo.ins(Op::JMP, opEtiqueta(codigo.etiqueta(".cola_" + nombreFuncion)));
+        colaPropias++;
+        return;
+    }
+    // Marco de esta función fuera: g retorna directamente al que llamó
+    for (size_t k = 0; k < guardadosActual.size(); ++k)
+        codigo.ins(Op::MOVQ, opMem(RBP, baseGuardados - 8 * (long)k), opReg(guardadosActual[k]));
+    codigo.ins(Op::LEAVE);
+    codigo.ins(Op::JMP, opEtiqueta(codigo.etiqueta(g->id)));
+    colaHermanas++;
+}
+
 int GenCodeVisitor::visit(ReturnStm* stm) {
+    if (stm->e && hayCola(stm->e)) {
+        retornar(stm->e);
+        return 0;
+    }
     if (stm->e) {
         stm->e->accept(this);
         
@@ -1162,12 +2473,12 @@ int GenCodeVisitor::visit(ReturnStm* stm) {
                 }
                 sort(orderedFields.begin(), orderedFields.end());
                 
-                vector<string> retRegs = {"%rax", "%rdx", "%rcx", "%rsi", "%r8", "%r9"};
+                vector<Reg> retRegs = {RAX, RDX, RCX, RSI, R8, R9};
                 int regIdx = 0;
                 int fieldStackOffset = varOffset;
                 for (auto& p : orderedFields) {
                     if (regIdx < retRegs.size()) {
-                        out << "    movq " << fieldStackOffset << "(%rbp), " << retRegs[regIdx] << endl;
+                        codigo.ins(Op::MOVQ, opMem(RBP, fieldStackOffset), opReg(retRegs[regIdx]));
                         regIdx++;
                     }
                     fieldStackOffset -= 8;
@@ -1175,7 +2486,7 @@ int GenCodeVisitor::visit(ReturnStm* stm) {
             }
         }
     }
-    out << "    jmp .end_" << nombreFuncion << endl;
+    codigo.ins(Op::JMP, opEtiqueta(codigo.etiqueta(".end_" + nombreFuncion)));
     return 0;
 }
 
@@ -1192,60 +2503,287 @@ int GenCodeVisitor::visit(IfStm* stm) {
         }
         return 0;
     }
-    // CASO 2: La condición es DINÁMICA (Normal)
+    // CASO 2: Una sola asignación a la misma variable en cada rama (--cmov)
+    AssignStm* entonces = asignacionUnica(stm->thenBody);
+    AssignStm* sino = stm->elseBody ? asignacionUnica(stm->elseBody) : nullptr;
+    if (entonces && (!stm->elseBody || (sino && sino->id == entonces->id)) &&
+        convertible(entonces->e, sino ? sino->e : nullptr)) {
+        getMemory(entonces->id);
+        seleccionar(stm->condition, entonces->e, sino ? sino->e : nullptr, ubicacion(entonces->id));
+        codigo.ins(Op::MOVQ, opReg(RAX), ubicacion(entonces->id));
+        return 0;
+    }
+    // CASO 3: La condición es DINÁMICA (Normal)
     int id = count_if++;
-    string labelElse = "if_" + to_string(id) + "_else";
-    string labelEnd = "if_" + to_string(id) + "_end";
+    int labelElse = codigo.etiqueta("if_" + to_string(id) + "_else");
+    int labelEnd = codigo.etiqueta("if_" + to_string(id) + "_end");
     stm->condition->accept(this);
-    out << "    cmpq $0, %rax" << endl;
-    out << "    je " << labelElse << endl;
+    codigo.ins(Op::CMPQ, opImm(0), opReg(RAX));
+    codigo.ins(Op::JE, opEtiqueta(labelElse));
+    unordered_set<int> listos = cseListos;
     // Bloque THEN
     stm->thenBody->accept(this);
-    out << "    jmp " << labelEnd << endl;
+    codigo.ins(Op::JMP, opEtiqueta(labelEnd));
+    cseListos = listos;
     // Bloque ELSE
-    out << labelElse << ":" << endl;
+    codigo.definir(labelElse);
     if (stm->elseBody) {
         stm->elseBody->accept(this);
+        cseListos = listos;
     }
-    out << labelEnd << ":" << endl;
+    codigo.definir(labelEnd);
     return 0;
 }
 
+// Suma de los términos de ese grado: constante * factores
+void GenCodeVisitor::coeficiente(const vector<TerminoPolinomio>& p, int grado, int destino) {
+    codigo.ins(Op::MOVQ, opImm(0), opReg(destino));
+    for (const TerminoPolinomio& t : p) {
+        if (t.grado != grado) continue;
+        bool cabe = t.constante >= INT_MIN && t.constante <= INT_MAX;
+        codigo.ins(cabe ? Op::MOVQ : Op::MOVABSQ, opImm(t.constante), opReg(RAX));
+        for (const string& f : t.factores) codigo.ins(Op::IMULQ, ubicacion(f), opReg(RAX));
+        codigo.ins(Op::ADDQ, opReg(RAX), opReg(destino));
+    }
+}
+
+// a en %rsi, vueltas N en %rdi; sumas S0 = N, S1 en %r8 y S2 en %r11
+// (con T1 = N(N-1)/2 en %r9 y T2 = sum t^2 en %r10), como EvolucionEscalar::sumas
+void GenCodeVisitor::formaCerrada(const FormaCerrada& fc) {
+    int vacio = codigo.etiqueta("scev_" + to_string(count_scev++) + "_vueltas");
+    long p = fc.paso, q = p > 0 ? p : -p;
+
+    codigo.ins(Op::MOVQ, ubicacion(fc.contador), opReg(RSI));
+    coeficiente(fc.limite, 0, R8);
+    codigo.ins(Op::MOVQ, opImm(0), opReg(RDI));
+    codigo.ins(Op::CMPQ, opReg(R8), opReg(RSI));
+    bool sube = fc.op == LT_OP || fc.op == LE_OP;
+    Op salto = fc.op == LT_OP ? Op::JGE : fc.op == LE_OP ? Op::JG : fc.op == GT_OP ? Op::JLE : Op::JL;
+    codigo.ins(salto, opEtiqueta(vacio));
+    codigo.ins(Op::MOVQ, opReg(sube ? R8 : RSI), opReg(RAX));
+    codigo.ins(Op::SUBQ, opReg(sube ? RSI : R8), opReg(RAX));
+    bool estricta = fc.op == LT_OP || fc.op == GT_OP;
+    if (estricta && q > 1) codigo.ins(Op::ADDQ, opImm(q - 1), opReg(RAX));
+    if (q > 1) {
+        codigo.ins(Op::CQO);
+        codigo.ins(Op::MOVQ, opImm(q), opReg(RCX));
+        codigo.ins(Op::IDIVQ, opReg(RCX));
+    }
+    if (!estricta) codigo.ins(Op::INCQ, opReg(RAX));
+    codigo.ins(Op::MOVQ, opReg(RAX), opReg(RDI));
+    codigo.definir(vacio);
+
+    // T1 = h(2(N-h)-1) con h = N/2; T2 = T1(2N-1)/3 con el inverso de 3
+    codigo.ins(Op::MOVQ, opReg(RDI), opReg(RAX));
+    codigo.ins(Op::CQO);
+    codigo.ins(Op::MOVQ, opImm(2), opReg(RCX));
+    codigo.ins(Op::IDIVQ, opReg(RCX));
+    codigo.ins(Op::MOVQ, opReg(RDI), opReg(R9));
+    codigo.ins(Op::SUBQ, opReg(RAX), opReg(R9));
+    codigo.ins(Op::ADDQ, opReg(R9), opReg(R9));
+    codigo.ins(Op::DECQ, opReg(R9));
+    codigo.ins(Op::IMULQ, opReg(RAX), opReg(R9));
+    codigo.ins(Op::MOVQ, opReg(RDI), opReg(R10));
+    codigo.ins(Op::ADDQ, opReg(R10), opReg(R10));
+    codigo.ins(Op::DECQ, opReg(R10));
+    codigo.ins(Op::IMULQ, opReg(R9), opReg(R10));
+    codigo.ins(Op::MOVABSQ, opImm((long)0xAAAAAAAAAAAAAAABUL), opReg(RCX));
+    codigo.ins(Op::IMULQ, opReg(RCX), opReg(R10));
+    // S1 = N*a + p*T1
+    codigo.ins(Op::MOVQ, opReg(RDI), opReg(R8));
+    codigo.ins(Op::IMULQ, opReg(RSI), opReg(R8));
+    codigo.ins(Op::MOVQ, opReg(R9), opReg(RAX));
+    codigo.ins(Op::IMULQ, opImm(p), opReg(RAX));
+    codigo.ins(Op::ADDQ, opReg(RAX), opReg(R8));
+    // S2 = N*a^2 + 2ap*T1 + p^2*T2
+    codigo.ins(Op::MOVQ, opReg(RSI), opReg(R11));
+    codigo.ins(Op::IMULQ, opReg(RSI), opReg(R11));
+    codigo.ins(Op::IMULQ, opReg(RDI), opReg(R11));
+    codigo.ins(Op::MOVQ, opReg(RSI), opReg(RAX));
+    codigo.ins(Op::IMULQ, opImm(2 * p), opReg(RAX));
+    codigo.ins(Op::IMULQ, opReg(R9), opReg(RAX));
+    codigo.ins(Op::ADDQ, opReg(RAX), opReg(R11));
+    codigo.ins(Op::MOVQ, opReg(R10), opReg(RAX));
+    codigo.ins(Op::IMULQ, opImm(p * p), opReg(RAX));
+    codigo.ins(Op::ADDQ, opReg(RAX), opReg(R11));
+
+    // Cada acumulador: += c0*S0 + c1*S1 + c2*S2
+    const int sumas[3] = {RDI, R8, R11};
+    for (const Acumulacion& a : fc.acumulaciones) {
+        codigo.ins(Op::MOVQ, opImm(0), opReg(RDX));
+        for (const TerminoPolinomio& t : a.terminos) {
+            bool cabe = t.constante >= INT_MIN && t.constante <= INT_MAX;
+            codigo.ins(cabe ? Op::MOVQ : Op::MOVABSQ, opImm(t.constante), opReg(RAX));
+            for (const string& f : t.factores) codigo.ins(Op::IMULQ, ubicacion(f), opReg(RAX));
+            codigo.ins(Op::IMULQ, opReg(sumas[t.grado]), opReg(RAX));
+            codigo.ins(Op::ADDQ, opReg(RAX), opReg(RDX));
+        }
+        codigo.ins(Op::MOVQ, ubicacion(a.var), opReg(RAX));
+        codigo.ins(Op::ADDQ, opReg(RDX), opReg(RAX));
+        codigo.ins(Op::MOVQ, opReg(RAX), ubicacion(a.var));
+    }
+    // Contador: a + N*paso
+    codigo.ins(Op::MOVQ, opReg(RDI), opReg(RAX));
+    codigo.ins(Op::IMULQ, opImm(p), opReg(RAX));
+    codigo.ins(Op::ADDQ, opReg(RSI), opReg(RAX));
+    codigo.ins(Op::MOVQ, opReg(RAX), ubicacion(fc.contador));
+}
+
+// Salto de "a <op> b" tras cmpq b, a: si se cumple (cierta) o si no
+static Op saltoComparacion(BinaryOp op, bool cierta) {
+    if (cierta) return op == LT_OP ? Op::JL : op == LE_OP ? Op::JLE : op == GT_OP ? Op::JG : Op::JGE;
+    return op == LT_OP ? Op::JGE : op == LE_OP ? Op::JG : op == GT_OP ? Op::JLE : Op::JL;
+}
+
+// Rotación y desenrollado decididos para el bucle (por defecto, como está)
+BucleDesenrollado GenCodeVisitor::desenrolladoDe(Stm* bucle) const {
+    const BucleDesenrollado* d = desenrollado ? desenrollado->bucle(bucle) : nullptr;
+    return d ? *d : BucleDesenrollado();
+}
+
+// Salto a destino si la condición vale cierta (true) o no (false)
+void GenCodeVisitor::saltoCondicion(Exp* cond, const ContadorEliminado* contador, bool cierta, int destino) {
+    if (contador) {
+        // Contador eliminado (--iv): la derivada contra el límite escalado
+        Op salto = saltoComparacion(static_cast<BinaryExp*>(cond)->op, cierta);
+        codigo.ins(Op::MOVQ, slotIv(contador->temporal), opReg(RAX));
+        codigo.ins(Op::CMPQ, opImm(contador->limite), opReg(RAX));
+        codigo.ins(salto, opEtiqueta(destino));
+        return;
+    }
+    cond->accept(this);
+    codigo.ins(Op::CMPQ, opImm(0), opReg(RAX));
+    codigo.ins(cierta ? Op::JNE : Op::JE, opEtiqueta(destino));
+}
+
+// Cuerpo + step + avance de las derivadas
+void GenCodeVisitor::vueltaFor(ForStm* stm) {
+    stm->body->accept(this);
+    if (stm->step && !contadorEliminado(stm)) stm->step->accept(this);
+    avanzarInducciones(stm);
+}
+
+// ¿Quedan factor vueltas? contador + (factor-1)*paso <op> límite
+void GenCodeVisitor::caben(ForStm* stm, const BucleDesenrollado& d, bool cierta, int destino) {
+    BinaryExp* cond = static_cast<BinaryExp*>(stm->condition);
+    IdExp* contador = static_cast<IdExp*>(cond->left);
+    Operando limite;
+    if (NumberExp* n = dynamic_cast<NumberExp*>(cond->right)) limite = opImm(n->value);
+    else operandoDirecto(cond->right, limite);
+    Op salto = saltoComparacion(cond->op, cierta);
+    codigo.ins(Op::MOVQ, ubicacion(contador->value), opReg(RAX));
+    codigo.ins(Op::ADDQ, opImm((long)(d.factor - 1) * d.paso), opReg(RAX));
+    codigo.ins(Op::CMPQ, limite, opReg(RAX));
+    codigo.ins(salto, opEtiqueta(destino));
+}
+
 int GenCodeVisitor::visit(WhileStm* stm) {
+    // Condición constante falsa: el bucle no se ejecuta nunca
+    if (stm->condition->cont == 1 && stm->condition->valor == 0) return 0;
+    // En modo JIT (int de 32 bits) se conserva el bucle: el intérprete
+    // tampoco aplica la forma cerrada si el contador desborda
+    const FormaCerrada* fc = scev && !enteros32 ? scev->forma(stm) : nullptr;
+    if (fc) {
+        formaCerrada(*fc);
+        return 0;
+    }
     int id = count_while++;
-    string labelStart = "while_" + to_string(id) + "_start";
-    string labelEnd = "while_" + to_string(id) + "_end";
-
-    out << labelStart << ":" << endl;
+    int labelStart = codigo.etiqueta("while_" + to_string(id) + "_start");
+    int labelEnd = codigo.etiqueta("while_" + to_string(id) + "_end");
+
+    calcularInvariantes(stm);
+    iniciarInducciones(stm);
+    if (desenrolladoDe(stm).rotado) {
+        // Guarda; cuerpo; condición al final. Las dos evaluaciones parten de
+        // lo calculado antes del bucle y dejan listo lo mismo
+        unordered_set<int> antes = cseListos;
+        saltoCondicion(stm->condition, nullptr, false, labelEnd);
+        unordered_set<int> listos = cseListos;
+        codigo.definir(labelStart);
+        stm->body->accept(this);
+        avanzarInducciones(stm);
+        cseListos = antes;
+        saltoCondicion(stm->condition, nullptr, true, labelStart);
+        codigo.definir(labelEnd);
+        cseListos = listos;
+        return 0;
+    }
+    codigo.definir(labelStart);
     
     stm->condition->accept(this);
-    out << "    cmpq $0, %rax" << endl;
-    out << "    je " << labelEnd << endl;
+    codigo.ins(Op::CMPQ, opImm(0), opReg(RAX));
+    codigo.ins(Op::JE, opEtiqueta(labelEnd));
 
+    unordered_set<int> listos = cseListos; // Lo del cuerpo no llega a la salida
     stm->body->accept(this);
+    cseListos = listos;
+    // La última sentencia del cuerpo acaba de avanzar la base
+    avanzarInducciones(stm);
     
-    out << "    jmp " << labelStart << endl;
-    out << labelEnd << ":" << endl;
+    codigo.ins(Op::JMP, opEtiqueta(labelStart));
+    codigo.definir(labelEnd);
     return 0;
 }
 
 int GenCodeVisitor::visit(ForStm* stm) {
     // Init (solo una vez)
     if (stm->init) stm->init->accept(this);
+    if (stm->condition->cont == 1 && stm->condition->valor == 0) return 0;
+    const FormaCerrada* fc = scev && !enteros32 ? scev->forma(stm) : nullptr;
+    if (fc) {
+        formaCerrada(*fc);
+        return 0;
+    }
     int id = count_for++;
-    string labelStart = "for_" + to_string(id) + "_start";
-    string labelEnd = "for_" + to_string(id) + "_end";
-    out << labelStart << ":" << endl;
+    int labelStart = codigo.etiqueta("for_" + to_string(id) + "_start");
+    int labelEnd = codigo.etiqueta("for_" + to_string(id) + "_end");
+    calcularInvariantes(stm);
+    iniciarInducciones(stm);
+    unordered_set<int> antes = cseListos;
+    BucleDesenrollado d = desenrolladoDe(stm);
+    if (d.copiasCompletas >= 0) {
+        // Desenrollado completo: las vueltas son conocidas
+        for (int k = 0; k < d.copiasCompletas; ++k) {
+            cseListos = antes;
+            vueltaFor(stm);
+        }
+        cseListos = antes;
+        return 0;
+    }
+    if (d.factor > 1) {
+        // factor vueltas por iteración mientras quepan; el resto, abajo
+        int labelResto = codigo.etiqueta("for_" + to_string(id) + "_resto");
+        caben(stm, d, false, labelResto);
+        codigo.definir(labelStart);
+        for (int k = 0; k < d.factor; ++k) {
+            cseListos = antes;
+            vueltaFor(stm);
+        }
+        caben(stm, d, true, labelStart);
+        codigo.definir(labelResto);
+        cseListos = antes;
+        labelStart = codigo.etiqueta("for_" + to_string(id) + "_resto_start");
+    }
+    if (d.rotado) {
+        saltoCondicion(stm->condition, contadorEliminado(stm), false, labelEnd);
+        unordered_set<int> listos = cseListos;
+        codigo.definir(labelStart);
+        vueltaFor(stm);
+        cseListos = antes;
+        saltoCondicion(stm->condition, contadorEliminado(stm), true, labelStart);
+        codigo.definir(labelEnd);
+        cseListos = listos;
+        return 0;
+    }
+    codigo.definir(labelStart);
     // Condición
-    stm->condition->accept(this);
-    out << "    cmpq $0, %rax" << endl;
-    out << "    je " << labelEnd << endl;
+    saltoCondicion(stm->condition, contadorEliminado(stm), false, labelEnd);
     // Cuerpo
-    stm->body->accept(this);
-    // Step
-    if (stm->step) stm->step->accept(this);
-    out << "    jmp " << labelStart << endl;
-    out << labelEnd << ":" << endl;
+    unordered_set<int> listos = cseListos;
+    vueltaFor(stm);
+    cseListos = listos;
+    codigo.ins(Op::JMP, opEtiqueta(labelStart));
+    codigo.definir(labelEnd);
     return 0;
 }
 
@@ -1253,34 +2791,41 @@ int GenCodeVisitor::visit(StepExp* step) {
     IdExp* id = dynamic_cast<IdExp*>(step->variable);
     if (!id) return 0;
     
-    int off = getMemory(id->value);
-    out << "    movq " << off << "(%rbp), %rax" << endl;
+    getMemory(id->value);
+    Operando var = ubicacion(id->value);
+    codigo.ins(Op::MOVQ, var, opReg(RAX));
     
-    if (step->type == StepExp::INCREMENT) out << "    incq %rax" << endl;
-    else if (step->type == StepExp::DECREMENT) out << "    decq %rax" << endl;
+    if (step->type == StepExp::INCREMENT) codigo.ins(Op::INCQ, opReg(RAX));
+    else if (step->type == StepExp::DECREMENT) codigo.ins(Op::DECQ, opReg(RAX));
     else if (step->type == StepExp::COMPOUND) {
-        out << "    pushq %rax" << endl;
+        codigo.ins(Op::PUSHQ, opReg(RAX));
         step->amount->accept(this);
-        out << "    movq %rax, %rcx" << endl;
-        out << "    popq %rax" << endl;
-        out << "    addq %rcx, %rax" << endl;
+        codigo.ins(Op::MOVQ, opReg(RAX), opReg(RCX));
+        codigo.ins(Op::POPQ, opReg(RAX));
+        codigo.ins(Op::ADDQ, opReg(RCX), opReg(RAX));
     }
-    out << "    movq %rax, " << off << "(%rbp)" << endl;
+    if (enteros32) codigo.ins(Op::MOVSLQ, opReg(RAX, 32), opReg(RAX));
+    codigo.ins(Op::MOVQ, opReg(RAX), var);
     return 0;
 }
 
 int GenCodeVisitor::visit(PrintfStm* stm) {
     for (Exp* e : stm->args) {
         e->accept(this);
-        out << "    movq %rax, %rsi" << endl;
-        out << "    leaq print_fmt_int(%rip), %rdi" << endl;
-        out << "    movl $0, %eax" << endl;
-        out << "    call printf@PLT" << endl;
+        codigo.ins(Op::MOVQ, opReg(RAX), opReg(RSI));
+        codigo.ins(Op::LEAQ, opRip(codigo.etiqueta("print_fmt_int")), opReg(RDI));
+        codigo.ins(Op::MOVL, opImm(0), opReg(RAX, 32));
+        codigo.ins(Op::CALL, opSimbolo("printf@PLT"));
     }
     return 0;
 }
 
 int GenCodeVisitor::visit(FcallExp* exp) {
+    // Evaluada al compilar (--ctfe): inmediato en lugar de la llamada
+    if (exp->cont == 1) {
+        codigo.ins(Op::MOVQ, opImm(exp->valor), opReg(RAX));
+        return 0;
+    }
     if (exp->name == "crearPunto") return 0;
     
     cerr << "DEBUG FcallExp: " << exp->name << " with " << exp->arguments.size() << " args" << endl;
@@ -1303,7 +2848,7 @@ int GenCodeVisitor::visit(FcallExp* exp) {
             if (structSizes.count(type)) {
                 int baseOffset = getMemory(varName);
                 cerr << "    Loading struct address: " << baseOffset << "(%rbp)" << endl;
-                out << "    leaq " << baseOffset << "(%rbp), %rax" << endl;
+                codigo.ins(Op::LEAQ, opMem(RBP, baseOffset), opReg(RAX));
             } else {
                 arg->accept(this);
             }
@@ -1311,18 +2856,19 @@ int GenCodeVisitor::visit(FcallExp* exp) {
             cerr << "other" << endl;
             arg->accept(this);
         }
-        out << "    pushq %rax" << endl;
+        codigo.ins(Op::PUSHQ, opReg(RAX));
     }
     
-    vector<string> regs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+    vector<Reg> regs = {RDI, RSI, RDX, RCX, R8, R9};
+    vector<string> nombresRegs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
     for (int i = exp->arguments.size() - 1; i >= 0; --i) {
         if (i < 6) {
-            cerr << "  popq " << regs[i] << endl;
-            out << "    popq " << regs[i] << endl;
+            cerr << "  popq " << nombresRegs[i] << endl;
+            codigo.ins(Op::POPQ, opReg(regs[i]));
         }
     }
-    out << "    movl $0, %eax" << endl;
-    out << "    call " << exp->name << endl;
+    codigo.ins(Op::MOVL, opImm(0), opReg(RAX, 32));
+    codigo.ins(Op::CALL, opEtiqueta(codigo.etiqueta(exp->name)));
     return 0;
 }
 
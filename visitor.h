@@ -2,9 +2,13 @@
 #define VISITOR_H
 #include "ast.h"
 #include "environment.h"
+#include "asm_buffer.h"
+#include "regalloc.h"
+#include <climits>
 #include <list>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 
 using namespace std;
@@ -24,8 +28,69 @@ struct Value {
     static Value make_bool(bool v) { Value x; x.kind = BOOL; x.b = v; return x; }
     static Value make_float(double v) { Value x; x.kind = FLOAT; x.f = v; return x; }
     static Value make_struct(const std::vector<Value>& f, const std::string& tname = std::string()) { Value x; x.kind = STRUCT; x.fields = f; x.type_name = tname; return x; }
+    static Value make_struct(std::vector<Value>&& f, const std::string& tname = std::string()) { Value x; x.kind = STRUCT; x.fields = std::move(f); x.type_name = tname; return x; }
 };
 
+// Helpers de semántica tipada compartidos por los motores del intérprete
+Value createDefaultValue(const string& type);
+// Clase de valor que produce un tipo declarado (misma regla que createDefaultValue)
+Value::Kind kindDeTipo(const string& type);
+// Vista entera de un valor escalar (lo que devuelve accept() en EvalVisitor)
+int valorEntero(const Value& v);
+// Conversión int <-> unsigned al almacenar en un destino de la clase dada (como en C)
+void convertirEscalar(Value& v, Value::Kind destino);
+// Operación binaria según las clases de los operandos: int, unsigned o float
+Value operarBinaria(BinaryOp op, const Value& l, const Value& r);
+// Si operarBinaria (32 bits) da lo mismo que la operación en 64 bits del
+// código generado; solo entonces se puede plegar al compilar
+bool mismoAncho(BinaryOp op, const Value& l, const Value& r);
+// Constante anotada por la propagación (--sccp) en e (e->claseCont >= 0)
+Value valorConstante(const Exp* e);
+
+// Entradas por función con --memo (--memo=N para otro tamaño)
+static const size_t CAPACIDAD_MEMO = 65536;
+
+// Caché acotada de resultados de una función pura: tabla de asignación
+// directa (potencia de 2) indexada por el hash de los argumentos; una
+// colisión reemplaza la entrada anterior. Se reserva en el primer uso
+class TablaMemo {
+public:
+    explicit TablaMemo(size_t n = 0); // n entradas, redondeado a potencia de 2
+
+    // Resultado guardado para estos argumentos (vista entera y Value)
+    bool buscar(const vector<Value>& args, int& ret, Value& valor);
+    void guardar(const vector<Value>& args, int ret, const Value& valor);
+
+    long aciertos = 0;
+    long fallos = 0;
+    long ocupadas = 0;
+
+private:
+    struct Entrada {
+        bool valida = false;
+        vector<int> args;
+        int ret = 0;
+        Value valor;
+    };
+    size_t capacidad;
+    vector<Entrada> entradas;
+
+    size_t indice(const vector<Value>& args) const;
+};
+
+class TieredJit;
+class GeneradorIR;
+class NumeradorValores;
+class ExtractorInvariantes;
+class ReductorInducciones;
+struct InduccionDerivada;
+struct ContadorEliminado;
+class EvolucionEscalar;
+struct TerminoPolinomio;
+struct FormaCerrada;
+class DesenrolladorBucles;
+class AnalisisPureza;
+struct BucleDesenrollado;
 class BinaryExp;
 class NumberExp;
 class FloatExp;
@@ -122,9 +187,125 @@ private:
     // Último valor evaluado (útil para inicializadores de struct)
     Value last_value;
     bool last_value_valid = false;
-    // Para capturar struct devueltos por funciones
+    // Para capturar struct (y float) devueltos por funciones
     Value return_struct;
     bool return_struct_valid = false;
+
+    // Variantes de quickening (valor de Exp::quick)
+    enum Quick {
+        Q_NUEVO = 0,                               // Aún no ejecutado
+        Q_BIN_INT, Q_BIN_UNSIGNED, Q_BIN_GENERICA, // BinaryExp
+        Q_BIN_INVARIANTE,                          // BinaryExp (--licm)
+        Q_ID_SIMPLE, Q_ID_CAMPO, Q_ID_GENERICO,    // IdExp
+        Q_ID_INVARIANTE,                           // IdExp (--licm)
+        Q_PASO_INT, Q_PASO_GENERICO                // StepExp
+    };
+    int especializarBinaria(BinaryExp* exp);
+    int binariaGenerica(BinaryExp* exp, const Value& l, const Value& r);
+    int idGenerico(IdExp* exp);
+    int devolver(const Value& v);
+    // Evalúa una expresión y entrega su Value por movimiento
+    Value tomarValor(int val);
+    Value eval(Exp* e);
+    Value eval(InitData* d);
+
+    // ----- OPTIMIZACION: Superinstrucciones de bucle -----
+    // Bucle contado "i <op> limite; i += paso" cuyo contador no se escribe en
+    // el cuerpo: se ejecuta comparando e incrementando el slot directamente.
+    struct BucleContado {
+        bool fusionado = false;
+        string var;              // Contador
+        BinaryOp op = LT_OP;     // Comparación de la condición
+        bool limiteConst = true;
+        int limite = 0;          // Límite constante
+        string limiteVar;        // o variable límite (se relee cada iteración)
+        int paso = 0;            // Incremento por iteración
+    };
+    unordered_map<Stm*, BucleContado> bucles;
+    static bool condicionContada(Exp* cond, BucleContado& bc);
+    const BucleContado& analizarFor(ForStm* stm);
+    const BucleContado& analizarWhile(WhileStm* stm);
+    void bucleFusionado(const BucleContado& bc, Exp* cond, Body* body, StepExp* step, Stm* pasoFinal);
+    int ejecutarCuerpo(Body* body, Stm* omitir);
+
+    // ----- OPTIMIZACION: Movimiento de invariantes (--licm) -----
+    // invariantes[e] es el valor de e en la vuelta del bucle en curso. El
+    // preheader tapa los valores anteriores y la salida del bucle los
+    // repone, así que una llamada (o recursión) dentro del bucle no pisa
+    // los del llamador. Los invariantes se especializan a Q_*_INVARIANTE la
+    // primera vez que se ejecutan (en el preheader, que los calcula por la
+    // ruta genérica mientras son su 'preheader')
+    const ExtractorInvariantes* licm = nullptr;
+    unordered_map<Exp*, Value> invariantes;
+    Exp* preheader = nullptr;
+    void calcularInvariantes(Stm* bucle, vector<Value>& tapados);
+    void restaurarInvariantes(Stm* bucle, vector<Value>& tapados);
+
+    // ----- OPTIMIZACION: Forma cerrada (--scev) -----
+    // Si el bucle tiene forma cerrada y sus variables son int, la aplica
+    // en lugar de iterar; false: hay que ejecutar el bucle
+    const EvolucionEscalar* scev = nullptr;
+    bool formaCerrada(Stm* bucle);
+
+    // ----- OPTIMIZACION: Ejecución por niveles (tiered) -----
+    TieredJit* jit = nullptr;
+    long* saltosActual = nullptr;   // Contador de back-edges de la función en curso
+
+    // ----- Recursión profunda -----
+    // "return g(...)" programa la llamada en cola: la llamada en curso la
+    // ejecuta al retornar reemplazando su nivel del entorno (trampolín),
+    // sin anidar. Con variables globales no se hace: el entorno busca en
+    // todos los niveles y g vería los locales del llamador. Las demás
+    // llamadas corren sobre la pila segmentada (pila.h) y las limita
+    // maxRecursion.
+    FunDec* funcionActual = nullptr;
+    FunDec* colaPendiente = nullptr;
+    vector<Value> argsCola;
+    bool colaSegura = false;
+    int profundidad = 0;
+    int maxRecursion = 0;           // Llamadas anidadas permitidas (0: sin límite)
+    unordered_map<ReturnStm*, bool> retornosEnCola; // terminaEnLlamada de cada return ya visto
+    static bool terminaEnLlamada(Exp* e);
+    bool retornoEnCola(ReturnStm* r);
+    bool programarCola(FcallExp* fcall);
+    int ejecutarLlamada(FunDec* func, vector<Value>& argValues);
+
+    // ----- OPTIMIZACION: Memoización (--memo) -----
+    // Resultados de las llamadas (no en cola) a funciones puras
+    size_t capacidadMemo = 0;
+    const AnalisisPureza* pureza = nullptr;
+    ostream* reporteMemo = nullptr;
+    unordered_map<FunDec*, TablaMemo> memos;
+
+    // ----- OPTIMIZACION: Evaluación en compilación (--ctfe) -----
+    // Cada cuerpo que se ejecuta gasta una unidad de combustible y cada
+    // sentencia otra. Al agotarse, o ante un error que en ejecución
+    // terminaría el programa (división entre cero, límite de recursión), o
+    // una operación entera que desborda 32 bits (el generador la haría en
+    // 64), la evaluación se abandona: returning desenrolla todas las llamadas
+    long combustible = LONG_MAX;
+    bool compilando = false;
+    bool abandonada = false;
+    int abandonar();
+public:
+    // Con un TieredJit, las funciones calientes pasan a código nativo
+    void usarJit(TieredJit* j) { jit = j; }
+    // Con --licm, los invariantes de cada bucle se calculan en su preheader
+    void usarInvariantes(const ExtractorInvariantes* e) { licm = e; }
+    // Con --scev, los bucles de acumulación se aplican en forma cerrada
+    void usarFormasCerradas(const EvolucionEscalar* e) { scev = e; }
+    void limitarRecursion(int n) { maxRecursion = n; }
+    // Memoiza las funciones que el análisis da por puras
+    void memoizar(size_t capacidad, const AnalisisPureza* puras, ostream* reporte) {
+        capacidadMemo = capacidad;
+        pureza = puras;
+        reporteMemo = reporte;
+    }
+    // Evaluación en compilación de llamadas a funciones puras: prepararEvaluacion
+    // registra funciones y structs; evaluarLlamada descuenta lo gastado de
+    // gasolina y da false si la llamada se abandonó
+    void prepararEvaluacion(Program* program);
+    bool evaluarLlamada(FunDec* func, const vector<int>& args, long& gasolina, int& ret, Value& valor);
 public:
     //EvalVisitor(Environment* environment) : env(environment), return_value(0), returning(false) {}
     //virtual ~EvalVisitor() {}
@@ -156,10 +337,14 @@ public:
     int visit(TernaryExp* exp) override;
 };
 
+// Costo máximo de las ramas con --cmov (--cmov=N para otro umbral)
+static const int COSTO_SELECCION = 4;
+
 // --- GENCODE VISITOR ---
 class GenCodeVisitor : public Visitor {
 private:
     std::ostream& out;
+    AsmBuffer codigo; // Instrucciones generadas (se emiten al final)
     
     // Gestión de Memoria
     unordered_map<string, int> memoria; // Offset base de variables
@@ -177,16 +362,139 @@ private:
     int count_while = 0;
     int count_for = 0;
     int count_ternary = 0;
+    int count_scev = 0;
     
     // Helpers
     int getMemory(string name);
+    int espacioDeclarado(Body* body);
+    int offsetDe(const string& name); // Variable o campo (p.x)
+    Operando ubicacion(const string& name); // Registro asignado o slot en la pila
+
+    // ----- OPTIMIZACION: Linear scan (locales escalares en registros) -----
+    AsignadorRegistros asignador;
+    int baseGuardados = 0; // Offset del área donde se guardan los callee-saved
+
+    // ----- OPTIMIZACION: Sethi-Ullman con registros -----
+    // Árboles sin llamadas ni ternarios se evalúan en registros temporales
+    // (regs[0] es el destino); solo se hace spill si se agotan
+    bool arbolSimple(Exp* e);
+    int necesita(Exp* e, bool derecho);
+    bool operandoDirecto(Exp* e, Operando& op);
+    void cargarHoja(Exp* e, int r);
+    void generarArbol(Exp* e, const vector<int>& regs);
+
+    // ----- OPTIMIZACION: Numeración de valores (--cse) -----
+    // Un BinaryExp con clase (temporalCse) guarda su resultado en el temporal
+    // de la clase; si ya se guardó en un camino dominante se carga de ahí.
+    // cseListos sigue el orden de emisión con ámbitos por rama y bucle
+    int baseCse = 0;
+    unordered_set<int> cseListos;
+    int temporalCse(Exp* e) const;
+    bool cseListo(Exp* e) const;
+    Operando slotCse(Exp* e) const;
+    void generarSubarbol(Exp* e, const vector<int>& regs);
+    int generarBinaria(BinaryExp* exp);
+
+    // ----- OPTIMIZACION: Movimiento de invariantes (--licm) -----
+    // Los invariantes del bucle se calculan en el preheader y se guardan en
+    // su temporal (temporalLicm); dentro del bucle son hojas de memoria
+    int baseLicm = 0;
+    Exp* preheader = nullptr; // Invariante que el preheader está calculando
+    int temporalLicm(Exp* e) const;
+    Operando slotLicm(Exp* e) const;
+    void calcularInvariantes(Stm* bucle);
+
+    // ----- OPTIMIZACION: Reducción de fuerza (--iv) -----
+    // Las multiplicaciones base * factor con temporalIv leen el temporal de
+    // su variable de inducción derivada, que el bucle inicializa en el
+    // preheader y hace avanzar junto con la base
+    int baseIv = 0;
+    int temporalIv(Exp* e) const;
+    const ContadorEliminado* contadorEliminado(ForStm* stm) const;
+    Operando slotIv(int temporal) const;
+    Operando factorIv(const InduccionDerivada& d);
+    void iniciarInducciones(Stm* bucle);
+    void avanzarInducciones(Stm* bucle);
+
+    // ----- OPTIMIZACION: Forma cerrada (--scev) -----
+    // El bucle se reemplaza por el cálculo de sus vueltas y de las sumas de
+    // potencias del contador (en %rsi, %rdi, %r8-%r11: libres entre sentencias)
+    void coeficiente(const vector<TerminoPolinomio>& p, int grado, int destino);
+    void formaCerrada(const FormaCerrada& fc);
+
+    // ----- OPTIMIZACION: Rotación y desenrollado (--rotate, --unroll) -----
+    // Bucle rotado: la condición se evalúa antes de entrar y al final del
+    // cuerpo (salto condicional hacia atrás). Los desenrollados repiten
+    // cuerpo + step; cada copia solo reutiliza lo calculado antes del bucle
+    BucleDesenrollado desenrolladoDe(Stm* bucle) const;
+    void saltoCondicion(Exp* cond, const ContadorEliminado* contador, bool cierta, int destino);
+    void vueltaFor(ForStm* stm);
+    void caben(ForStm* stm, const BucleDesenrollado& d, bool cierta, int destino);
+
+    // ----- OPTIMIZACION: Llamadas en cola (--tco) -----
+    // "return f(...)" a una función con argumentos escalares en registros:
+    // a sí misma, se salta con los argumentos en registros a la copia de
+    // parámetros del prólogo (.cola_f); a otra, se restaura el marco
+    // (leave) y se salta a ella, que retorna directamente al que llamó
+    unordered_map<string, FunDec*> funciones;
+    FunDec* funcionActual = nullptr;
+    vector<int> guardadosActual;
+    int colaPropias = 0;
+    int colaHermanas = 0;
+    bool enCola(FcallExp* call);
+    bool hayCola(Exp* e);
+    void retornar(Exp* e);
+    void llamadaCola(FcallExp* call);
+
+    // ----- OPTIMIZACION: If-conversion (--cmov) -----
+    // Ternarios e if/else que solo asignan una variable escalar se generan
+    // sin saltos: se calculan las dos ramas y cmovcc elige. Solo si las
+    // ramas no tienen efectos ni pueden fallar (sin llamadas, ++/--, ni
+    // divisiones) y su costo total no pasa del umbral
+    int selecciones = 0;
+    bool sinEfectos(Exp* e);
+    int costoRama(Exp* e);
+    bool convertible(Exp* t, Exp* f);
+    AssignStm* asignacionUnica(Body* b);
+    void seleccionar(Exp* cond, Exp* t, Exp* f, Operando sino = Operando());
 
 public:
+    // Modo JIT: aritmética int de 32 bits (como EvalVisitor) y retorno 0 por defecto
+    bool enteros32 = false;
+    // Locales escalares en registros callee-saved (linear scan)
+    bool usarRegistros = false;
+    ostream* reporteRegistros = nullptr; // --stats: asignación por función
+    // Llamadas en cola como saltos entre las funciones conocidas (las del
+    // programa, o las de la unidad con conocerFunciones)
+    bool llamadasCola = false;
+    void conocerFunciones(const vector<FunDec*>& fds) { for (FunDec* fd : fds) funciones[fd->id] = fd; }
+    ostream* reporteCola = nullptr; // --stats: llamadas en cola por función
+    // If-conversion: costo máximo de las dos ramas de una selección (-1: no)
+    int umbralSeleccion = -1;
+    ostream* reporteSeleccion = nullptr; // --stats: selecciones por función
+    // --backend=ir: las funciones que el IR puede bajar se generan desde él
+    GeneradorIR* generadorIR = nullptr;
+    // --cse: clases de valor numeradas sobre el AST
+    const NumeradorValores* numeracion = nullptr;
+    // --licm: invariantes de cada bucle
+    const ExtractorInvariantes* licm = nullptr;
+    // --iv: variables de inducción derivadas de cada bucle
+    const ReductorInducciones* iv = nullptr;
+    // --scev: bucles de acumulación en forma cerrada
+    const EvolucionEscalar* scev = nullptr;
+    // --rotate/--unroll: bucles rotados y desenrollados
+    const DesenrolladorBucles* desenrollado = nullptr;
+
     // Inicializamos los contadores en 0
     GenCodeVisitor(std::ostream& out) : out(out), offset(-8), count_if(0), count_while(0), count_for(0), count_ternary(0) {}
     virtual ~GenCodeVisitor() {}
 
+    // Genera el programa y escribe el .s en out
     void generar(Program* program); 
+    // Solo construye el buffer (para los emisores binarios)
+    void generarCodigo(Program* program);
+    const AsmBuffer& buffer() const { return codigo; }
+    AsmBuffer& buffer() { return codigo; }
 
     int visit(BinaryExp* exp) override;
     int visit(NumberExp* exp) override;
@@ -0,0 +1,397 @@
+#include <cstring>
+#include <sys/mman.h>
+#include "x86_encoder.h"
+
+using namespace std;
+
+// Código de condición de jcc / setcc / cmovcc
+static int condicion(Op op) {
+    switch (op) {
+        case Op::JE: case Op::SETE: case Op::CMOVE: return 0x4;
+        case Op::JNE: case Op::SETNE: case Op::CMOVNE: return 0x5;
+        case Op::JL: case Op::SETL: case Op::CMOVL: return 0xC;
+        case Op::JGE: case Op::SETGE: case Op::CMOVGE: return 0xD;
+        case Op::JLE: case Op::SETLE: case Op::CMOVLE: return 0xE;
+        case Op::JG: case Op::SETG: case Op::CMOVG: return 0xF;
+        default: return -1;
+    }
+}
+
+static string recortar(const string& s) {
+    size_t a = s.find_first_not_of(" \t\r");
+    if (a == string::npos) return "";
+    size_t b = s.find_last_not_of(" \t\r");
+    return s.substr(a, b - a + 1);
+}
+
+static bool cabeEn32(long v) {
+    return v >= -2147483648L && v <= 2147483647L;
+}
+
+// ==========================================
+// Emisión de bytes
+// ==========================================
+
+void X86Encoder::imm32(long v) {
+    for (int k = 0; k < 4; ++k) byte((uint8_t)((unsigned long)v >> (8 * k)));
+}
+
+void X86Encoder::imm64(long v) {
+    for (int k = 0; k < 8; ++k) byte((uint8_t)((unsigned long)v >> (8 * k)));
+}
+
+void X86Encoder::rex(bool w, int reg, int rm) {
+    uint8_t r = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+    if (r != 0x40) byte(r);
+}
+
+void X86Encoder::modrmReg(int reg, int rm) {
+    byte((uint8_t)(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// [base + disp32]; rsp/r12 como base necesitan byte SIB
+void X86Encoder::modrmMem(int reg, const Operando& mem) {
+    byte((uint8_t)(0x80 | ((reg & 7) << 3) | (mem.reg & 7)));
+    if ((mem.reg & 7) == 4) byte(0x24);
+    imm32(mem.imm);
+}
+
+void X86Encoder::rel32(const string& etiq, bool llamada) {
+    string simbolo = etiq;
+    size_t plt = simbolo.find("@PLT");
+    if (plt != string::npos) simbolo = simbolo.substr(0, plt);
+    parches.push_back({bytes.size(), simbolo, llamada});
+    imm32(0);
+}
+
+// ==========================================
+// Ensamblado
+// ==========================================
+
+long X86Encoder::etiqueta(const string& nombre) const {
+    auto it = etiquetas.find(nombre);
+    return it == etiquetas.end() ? -1 : (long)it->second;
+}
+
+long X86Encoder::etiquetaDatos(const string& nombre) const {
+    auto it = etiquetasDatos.find(nombre);
+    return it == etiquetasDatos.end() ? -1 : (long)it->second;
+}
+
+bool X86Encoder::ensamblar(const string& texto) {
+    AsmBuffer buf;
+    if (!buf.leerTexto(texto, err)) return false;
+    return ensamblar(buf);
+}
+
+bool X86Encoder::ensamblar(const AsmBuffer& buf) {
+    bytes.clear();
+    bytesDatos.clear();
+    enDatos = false;
+    etiquetas.clear();
+    etiquetasDatos.clear();
+    simbolosGlobales.clear();
+    parches.clear();
+    err.clear();
+
+    for (const Instr& i : buf.instrs) {
+        if (i.op == Op::ETIQUETA) {
+            const string& nombre = buf.nombre(i.a.etiqueta);
+            if (enDatos) etiquetasDatos[nombre] = bytesDatos.size();
+            else etiquetas[nombre] = bytes.size();
+            continue;
+        }
+        bool ok = i.op == Op::DIRECTIVA ? directiva(i.texto) : (!enDatos && instruccion(i, buf));
+        if (!ok) {
+            if (err.empty()) {
+                err = i.op == Op::DIRECTIVA ? "directiva no soportada: " + i.texto
+                                            : string("instruccion no soportada: ") + mnemonico(i.op);
+            }
+            return false;
+        }
+    }
+
+    // Resolver los rel32 hacia .text; el resto queda pendiente para el enlazador
+    vector<Pendiente> resto;
+    for (const Pendiente& p : parches) {
+        auto it = etiquetas.find(p.simbolo);
+        if (it == etiquetas.end()) {
+            resto.push_back(p);
+            continue;
+        }
+        long rel = (long)it->second - (long)(p.pos + 4);
+        for (int k = 0; k < 4; ++k) bytes[p.pos + k] = (uint8_t)((unsigned long)rel >> (8 * k));
+    }
+    parches = resto;
+    return true;
+}
+
+bool X86Encoder::enlazarLocal(const unordered_map<string, uint64_t>& externos, vector<uint8_t>& imagen) {
+    imagen = bytes;
+
+    // Stubs de los externos llamados
+    unordered_map<string, size_t> stubs;
+    for (const Pendiente& p : parches) {
+        if (!p.llamada || etiquetasDatos.count(p.simbolo) || stubs.count(p.simbolo)) continue;
+        auto it = externos.find(p.simbolo);
+        if (it == externos.end()) {
+            err = "simbolo no definido: " + p.simbolo;
+            return false;
+        }
+        stubs[p.simbolo] = imagen.size();
+        imagen.push_back(0x49); imagen.push_back(0xBB);           // movabsq $dir, %r11
+        for (int k = 0; k < 8; ++k) imagen.push_back((uint8_t)(it->second >> (8 * k)));
+        imagen.push_back(0x41); imagen.push_back(0xFF); imagen.push_back(0xE3); // jmp *%r11
+    }
+
+    // .data alineada a 16 detrás del código
+    while (imagen.size() % 16) imagen.push_back(0xCC);
+    size_t baseDatos = imagen.size();
+    imagen.insert(imagen.end(), bytesDatos.begin(), bytesDatos.end());
+
+    for (const Pendiente& p : parches) {
+        size_t destino;
+        auto d = etiquetasDatos.find(p.simbolo);
+        if (d != etiquetasDatos.end()) destino = baseDatos + d->second;
+        else if (p.llamada) destino = stubs[p.simbolo];
+        else {
+            err = "referencia rip-relativa a simbolo externo: " + p.simbolo;
+            return false;
+        }
+        long rel = (long)destino - (long)(p.pos + 4);
+        for (int k = 0; k < 4; ++k) imagen[p.pos + k] = (uint8_t)((unsigned long)rel >> (8 * k));
+    }
+    return true;
+}
+
+// ==========================================
+// Memoria ejecutable
+// ==========================================
+
+void* cargarEnMemoria(const vector<uint8_t>& imagen) {
+    size_t tam = imagen.empty() ? 1 : imagen.size();
+    void* mem = mmap(nullptr, tam, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return nullptr;
+    memcpy(mem, imagen.data(), imagen.size());
+    if (mprotect(mem, tam, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, tam);
+        return nullptr;
+    }
+    return mem;
+}
+
+void liberarMemoria(void* mem, size_t tam) {
+    if (mem) munmap(mem, tam ? tam : 1);
+}
+
+// .text/.data/.section, .global y .string; el resto de directivas se ignora
+bool X86Encoder::directiva(const string& l) {
+    if (l == ".text") { enDatos = false; return true; }
+    if (l == ".data") { enDatos = true; return true; }
+    if (l.rfind(".section", 0) == 0) {
+        // Solo marcas como .note.GNU-stack: no contienen código ni datos
+        enDatos = l.find(".text") == string::npos;
+        return true;
+    }
+    if (l.rfind(".global", 0) == 0 || l.rfind(".globl", 0) == 0) {
+        simbolosGlobales.push_back(recortar(l.substr(l.find_first_of(" \t"))));
+        return true;
+    }
+    if (l.rfind(".string", 0) == 0 || l.rfind(".asciz", 0) == 0) {
+        size_t a = l.find('"'), b = l.rfind('"');
+        if (!enDatos || a == string::npos || b <= a) return false;
+        for (size_t k = a + 1; k < b; ++k) {
+            char c = l[k];
+            if (c == '\\' && k + 1 < b) {
+                char e = l[++k];
+                c = (e == 'n') ? '\n' : (e == 't') ? '\t' : (e == '0') ? '\0' : e;
+            }
+            bytesDatos.push_back((uint8_t)c);
+        }
+        bytesDatos.push_back(0);
+        return true;
+    }
+    return true;
+}
+
+
+bool X86Encoder::instruccion(const Instr& i, const AsmBuffer& buf) {
+    const Operando& a = i.a;
+    const Operando& b = i.b;
+    auto tipos = [&](Operando::Tipo ta) { return a.tipo == ta && b.tipo == Operando::NINGUNO; };
+    auto tipos2 = [&](Operando::Tipo ta, Operando::Tipo tb) { return a.tipo == ta && b.tipo == tb; };
+    bool reg64a = a.tipo == Operando::REG && a.bits == 64;
+    bool reg64b = b.tipo == Operando::REG && b.bits == 64;
+
+    switch (i.op) {
+        // Sin operandos
+        case Op::RET:     byte(0xC3); return true;
+        case Op::LEAVE:   byte(0xC9); return true;
+        case Op::CQO:     byte(0x48); byte(0x99); return true;
+        case Op::SYSCALL: byte(0x0F); byte(0x05); return true;
+
+        // Saltos y llamadas: etiquetas del buffer o símbolos externos
+        case Op::JMP: case Op::CALL:
+        case Op::JE: case Op::JNE: case Op::JL: case Op::JLE: case Op::JG: case Op::JGE: {
+            string destino;
+            if (tipos(Operando::ETIQUETA)) destino = buf.nombre(a.etiqueta);
+            else if (tipos(Operando::SIMBOLO)) destino = a.simbolo;
+            else return false;
+            if (i.op == Op::JMP) byte(0xE9);
+            else if (i.op == Op::CALL) byte(0xE8);
+            else { byte(0x0F); byte((uint8_t)(0x80 | condicion(i.op))); }
+            rel32(destino, true);
+            return true;
+        }
+
+        // Un registro de 64 bits
+        case Op::PUSHQ: case Op::POPQ: case Op::INCQ: case Op::DECQ:
+        case Op::NEGQ: case Op::IDIVQ: case Op::DIVQ: {
+            if (!tipos(Operando::REG) || !reg64a) return false;
+            int r = a.reg;
+            switch (i.op) {
+                case Op::PUSHQ: rex(false, 0, r); byte((uint8_t)(0x50 | (r & 7))); break;
+                case Op::POPQ:  rex(false, 0, r); byte((uint8_t)(0x58 | (r & 7))); break;
+                case Op::INCQ:  rex(true, 0, r); byte(0xFF); modrmReg(0, r); break;
+                case Op::DECQ:  rex(true, 0, r); byte(0xFF); modrmReg(1, r); break;
+                case Op::NEGQ:  rex(true, 0, r); byte(0xF7); modrmReg(3, r); break;
+                case Op::IDIVQ: rex(true, 0, r); byte(0xF7); modrmReg(7, r); break;
+                default:        rex(true, 0, r); byte(0xF7); modrmReg(6, r); break;
+            }
+            return true;
+        }
+
+        // setcc sobre un registro de 8 bits
+        case Op::SETE: case Op::SETNE: case Op::SETL: case Op::SETLE: case Op::SETG: case Op::SETGE:
+            if (!tipos(Operando::REG) || a.bits != 8) return false;
+            // %spl..%dil necesitan REX aunque esté vacío (sin él serían %ah..%bh)
+            if (a.reg >= 4 && a.reg < 8) byte(0x40);
+            else rex(false, 0, a.reg);
+            byte(0x0F); byte((uint8_t)(0x90 | condicion(i.op))); modrmReg(0, a.reg);
+            return true;
+
+        // cmovcc r/m64, %r64
+        case Op::CMOVE: case Op::CMOVNE: case Op::CMOVL: case Op::CMOVLE: case Op::CMOVG: case Op::CMOVGE:
+            if (tipos2(Operando::REG, Operando::REG) && reg64a && reg64b) {
+                rex(true, b.reg, a.reg); byte(0x0F); byte((uint8_t)(0x40 | condicion(i.op))); modrmReg(b.reg, a.reg);
+                return true;
+            }
+            if (tipos2(Operando::MEM, Operando::REG) && reg64b && cabeEn32(a.imm)) {
+                rex(true, b.reg, a.reg); byte(0x0F); byte((uint8_t)(0x40 | condicion(i.op))); modrmMem(b.reg, a);
+                return true;
+            }
+            return false;
+
+        // Extensiones
+        case Op::MOVZBQ:
+            if (!tipos2(Operando::REG, Operando::REG) || a.bits != 8 || !reg64b) return false;
+            rex(true, b.reg, a.reg); byte(0x0F); byte(0xB6); modrmReg(b.reg, a.reg);
+            return true;
+        case Op::MOVSLQ:
+            if (!tipos2(Operando::REG, Operando::REG) || a.bits != 32 || !reg64b) return false;
+            rex(true, b.reg, a.reg); byte(0x63); modrmReg(b.reg, a.reg);
+            return true;
+
+        // movb $imm8 / %r8 -> memoria
+        case Op::MOVB:
+            if (tipos2(Operando::IMM, Operando::MEM) && cabeEn32(b.imm)) {
+                rex(false, 0, b.reg); byte(0xC6); modrmMem(0, b); byte((uint8_t)a.imm);
+                return true;
+            }
+            if (tipos2(Operando::REG, Operando::MEM) && a.bits == 8 && cabeEn32(b.imm)) {
+                rex(false, a.reg, b.reg); byte(0x88); modrmMem(a.reg, b);
+                return true;
+            }
+            return false;
+
+        // movl $imm, %r32
+        case Op::MOVL:
+            if (!tipos2(Operando::IMM, Operando::REG) || b.bits != 32) return false;
+            rex(false, 0, b.reg); byte((uint8_t)(0xB8 | (b.reg & 7))); imm32(a.imm);
+            return true;
+
+        // movabsq $imm64, %r64
+        case Op::MOVABSQ:
+            if (!tipos2(Operando::IMM, Operando::REG) || !reg64b) return false;
+            rex(true, 0, b.reg); byte((uint8_t)(0xB8 | (b.reg & 7))); imm64(a.imm);
+            return true;
+
+        case Op::MOVQ:
+            if (tipos2(Operando::REG, Operando::REG) && reg64a && reg64b) {
+                rex(true, a.reg, b.reg); byte(0x89); modrmReg(a.reg, b.reg);
+                return true;
+            }
+            if (tipos2(Operando::IMM, Operando::REG) && reg64b) {
+                if (cabeEn32(a.imm)) {
+                    rex(true, 0, b.reg); byte(0xC7); modrmReg(0, b.reg); imm32(a.imm);
+                } else {
+                    rex(true, 0, b.reg); byte((uint8_t)(0xB8 | (b.reg & 7))); imm64(a.imm);
+                }
+                return true;
+            }
+            if (tipos2(Operando::MEM, Operando::REG) && reg64b && cabeEn32(a.imm)) {
+                rex(true, b.reg, a.reg); byte(0x8B); modrmMem(b.reg, a);
+                return true;
+            }
+            if (tipos2(Operando::REG, Operando::MEM) && reg64a && cabeEn32(b.imm)) {
+                rex(true, a.reg, b.reg); byte(0x89); modrmMem(a.reg, b);
+                return true;
+            }
+            if (tipos2(Operando::IMM, Operando::MEM) && cabeEn32(a.imm) && cabeEn32(b.imm)) {
+                rex(true, 0, b.reg); byte(0xC7); modrmMem(0, b); imm32(a.imm);
+                return true;
+            }
+            return false;
+
+        case Op::LEAQ:
+            if (tipos2(Operando::RIP, Operando::REG) && reg64b) {
+                rex(true, b.reg, 0); byte(0x8D); byte((uint8_t)(0x05 | ((b.reg & 7) << 3)));
+                rel32(buf.nombre(a.etiqueta), false);
+                return true;
+            }
+            if (tipos2(Operando::MEM, Operando::REG) && reg64b && cabeEn32(a.imm)) {
+                rex(true, b.reg, a.reg); byte(0x8D); modrmMem(b.reg, a);
+                return true;
+            }
+            return false;
+
+        case Op::IMULQ:
+            if (tipos2(Operando::REG, Operando::REG) && reg64a && reg64b) {
+                rex(true, b.reg, a.reg); byte(0x0F); byte(0xAF); modrmReg(b.reg, a.reg);
+                return true;
+            }
+            if (tipos2(Operando::MEM, Operando::REG) && reg64b && cabeEn32(a.imm)) {
+                rex(true, b.reg, a.reg); byte(0x0F); byte(0xAF); modrmMem(b.reg, a);
+                return true;
+            }
+            // imulq $imm, %r  ==  imul r, r, imm32
+            if (tipos2(Operando::IMM, Operando::REG) && reg64b && cabeEn32(a.imm)) {
+                rex(true, b.reg, b.reg); byte(0x69); modrmReg(b.reg, b.reg); imm32(a.imm);
+                return true;
+            }
+            return false;
+
+        // Aritmética/comparación: opcode r/m,reg y extensión del grupo 0x81
+        case Op::ADDQ: case Op::SUBQ: case Op::CMPQ: {
+            int opRR = i.op == Op::ADDQ ? 0x01 : i.op == Op::SUBQ ? 0x29 : 0x39;
+            int ext = i.op == Op::ADDQ ? 0 : i.op == Op::SUBQ ? 5 : 7;
+            if (tipos2(Operando::REG, Operando::REG) && reg64a && reg64b) {
+                rex(true, a.reg, b.reg); byte((uint8_t)opRR); modrmReg(a.reg, b.reg);
+                return true;
+            }
+            // Fuente en memoria: opcode reg,r/m (= opRR + 2)
+            if (tipos2(Operando::MEM, Operando::REG) && reg64b && cabeEn32(a.imm)) {
+                rex(true, b.reg, a.reg); byte((uint8_t)(opRR + 2)); modrmMem(b.reg, a);
+                return true;
+            }
+            if (tipos2(Operando::IMM, Operando::REG) && reg64b && cabeEn32(a.imm)) {
+                rex(true, 0, b.reg); byte(0x81); modrmReg(ext, b.reg); imm32(a.imm);
+                return true;
+            }
+            return false;
+        }
+
+        default:
+            return false;
+    }
+}
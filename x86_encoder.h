@@ -0,0 +1,83 @@
+#ifndef X86_ENCODER_H
+#define X86_ENCODER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "asm_buffer.h"
+
+using namespace std;
+
+// ===========================================================
+//  Ensamblador mínimo x86-64 (sintaxis AT&T)
+//  Emisor binario del AsmBuffer que construye GenCodeVisitor: lo
+//  traduce a código máquina sin invocar as/ld. Cubre solo el subconjunto
+//  de instrucciones que usa el generador; ante cualquier otra cosa
+//  ensamblar() devuelve false y error() explica qué no se pudo codificar.
+//  Produce dos secciones (.text y .data). Los saltos entre etiquetas de
+//  .text se resuelven al ensamblar; las referencias a .data y a símbolos
+//  externos (printf@PLT) quedan en pendientes() para el enlazador
+//  (en memoria o ELF).
+// ===========================================================
+
+class X86Encoder {
+public:
+    // Referencia rel32 sin resolver dentro de .text
+    struct Pendiente {
+        size_t pos;        // Offset del campo de 32 bits en .text
+        string simbolo;    // Sin el sufijo @PLT
+        bool llamada;      // call/jmp (true) o dirección rip-relativa (false)
+    };
+
+    // Codifica el buffer completo
+    bool ensamblar(const AsmBuffer& buf);
+    // Lee el texto AT&T a un buffer y lo codifica
+    bool ensamblar(const string& texto);
+
+    const vector<uint8_t>& codigo() const { return bytes; }
+    const vector<uint8_t>& datos() const { return bytesDatos; }
+    const vector<Pendiente>& pendientes() const { return parches; }
+    // Offset de la etiqueta dentro de .text, o -1 si no existe
+    long etiqueta(const string& nombre) const;
+    // Offset de la etiqueta dentro de .data, o -1 si no existe
+    long etiquetaDatos(const string& nombre) const;
+    const unordered_map<string, size_t>& etiquetasTexto() const { return etiquetas; }
+    const unordered_map<string, size_t>& etiquetasDeDatos() const { return etiquetasDatos; }
+    // Etiquetas globales (.global) en orden de aparición
+    const vector<string>& globales() const { return simbolosGlobales; }
+    const string& error() const { return err; }
+
+    // Enlazado en memoria: imagen = .text + stubs de externos + .data.
+    // Cada externo se alcanza con un stub "movabsq $dir, %r11; jmp *%r11",
+    // así la imagen puede cargarse en cualquier dirección.
+    bool enlazarLocal(const unordered_map<string, uint64_t>& externos, vector<uint8_t>& imagen);
+
+private:
+    vector<uint8_t> bytes;
+    vector<uint8_t> bytesDatos;
+    bool enDatos = false;
+    unordered_map<string, size_t> etiquetas;
+    unordered_map<string, size_t> etiquetasDatos;
+    vector<string> simbolosGlobales;
+    vector<Pendiente> parches;
+    string err;
+
+    bool directiva(const string& l);
+    bool instruccion(const Instr& i, const AsmBuffer& buf);
+
+    void byte(uint8_t b) { bytes.push_back(b); }
+    void imm32(long v);
+    void imm64(long v);
+    void rex(bool w, int reg, int rm);
+    void modrmReg(int reg, int rm);
+    void modrmMem(int reg, const Operando& mem);
+    void rel32(const string& etiq, bool llamada);
+};
+
+// Copia una imagen enlazada a memoria ejecutable (mmap + mprotect, W^X).
+// Devuelve nullptr si el sistema no lo permite.
+void* cargarEnMemoria(const vector<uint8_t>& imagen);
+void liberarMemoria(void* mem, size_t tam);
+
+#endif // X86_ENCODER_H